@@ -19,6 +19,7 @@ Descrition:
 #include "bookm.h"
 #include "synh.h"
 #include "edinterf.h"
+#include "savew.h"
 #include "block.h"
 
 /* ************************************************************************
@@ -723,6 +724,8 @@ BOOLEAN InsertCharacterBlockPrim(TFile *pFile, const TBlock *pBlock)
   if (pFile->bReadOnly || pFile->bForceReadOnly)
     return FALSE;
 
+  LinesChanged(pFile, pFile->nRow);  /* cached page data is no longer valid */
+
   /*
   Check the current cursor position and examine the size
   of the two portions a line should be split to -- nPrefixSize, nSuffixSize
@@ -932,7 +935,7 @@ static void CalcBlockEndPosition(const TBlock *pBlock,
    Parameters:
      nCol = -1 directs the function to use the current cursor position.
 */
-static BOOLEAN InsertCharacterBlock(TFile *pFile, const TBlock *pBlock, int nCol, int nRow)
+BOOLEAN InsertCharacterBlock(TFile *pFile, const TBlock *pBlock, int nCol, int nRow)
 {
   int nUndoEntry;
   TBlock *pBlockCopy;
@@ -1290,6 +1293,8 @@ BOOLEAN InsertColumnBlockPrim(TFile *pFile, const TBlock *pBlockPattern)
   if (pFile->bReadOnly || pFile->bForceReadOnly)
     return FALSE;
 
+  LinesChanged(pFile, pFile->nRow);  /* cached page data is no longer valid */
+
   ASSERT(pFile->pCurPos != NULL);
   ASSERT(INDEX_IN_LINE(pFile, pFile->nRow, pFile->pCurPos) >= 0);
 
@@ -1659,6 +1664,8 @@ BOOLEAN DeleteCharacterBlockPrim(TFile *pFile,
   if (pFile->bReadOnly || pFile->bForceReadOnly)
     return FALSE;
 
+  LinesChanged(pFile, nStartLine);  /* cached page data is no longer valid */
+
   pFile->lnattr = GetEOLStatus(pFile, nStartLine);
 
   /*
@@ -1946,6 +1953,8 @@ BOOLEAN DeleteColumnBlockPrim(TFile *pFile,
   if (pFile->bReadOnly || pFile->bForceReadOnly)
     return FALSE;
 
+  LinesChanged(pFile, nStartLine);  /* cached page data is no longer valid */
+
   /*
   Calc the size of the block where to compose the lines
   after deleting the column block area
@@ -2617,6 +2626,38 @@ void EndBlockExtend(TFile *pFile)
     MarkBlockEnd(pFile);
 }
 
+/* ************************************************************************
+   Function: CopyCurrentLine
+   Description:
+     Moves the text of the current line to a block of its own.
+     While the file is stored in background the text that is being
+     written must not be changed in place, see StoreFile(). Without
+     memory for the copy waits for the writer instead.
+*/
+static void CopyCurrentLine(TFile *pFile)
+{
+  TLine *pLine;
+  char *pBlock;
+
+  ASSERT(pFile->pSaveJob != NULL);
+
+  pLine = GetLine(pFile, pFile->nRow);
+  pBlock = AllocateTBlock(pLine->nLen + DEFAULT_EOL_SIZE);
+  if (pBlock == NULL)
+  {
+    SaveJobWait(pFile->pSaveJob);
+    return;
+  }
+  memcpy(pBlock, pLine->pLine, pLine->nLen + 1);
+  AddBlockLink(&pFile->blist, pBlock);
+  IncRef(pBlock, 1);  /* Update the file block reference counter */
+
+  pFile->pCurPos = pBlock + (pFile->pCurPos - pLine->pLine);
+  DecRef(pLine->pFileBlock, 1);
+  pLine->pLine = pBlock;
+  pLine->pFileBlock = pBlock;
+}
+
 /* ************************************************************************
    Function: ReplaceTextPrim
    Description:
@@ -2643,6 +2684,10 @@ void ReplaceTextPrim(TFile *pFile, const char *pText, char *pOldText)
   ASSERT(strchr(pFile->pCurPos, '\0') - pFile->pCurPos >= (int)strlen(pText));
 
   nLen = strlen(pText);
+  LinesChanged(pFile, pFile->nRow);  /* cached page data is no longer valid */
+
+  if (pFile->pSaveJob != NULL)
+    CopyCurrentLine(pFile);
 
   for (i = 0; i < nLen; ++i)
   {
@@ -59,6 +59,7 @@ BOOLEAN DeleteCharacterBlockPrim(TFile *pFile,
   int nStartLine, int nStartPos, int nEndLine, int nEndPos);
 BOOLEAN DeleteCharacterBlock(TFile *pFile,
   int nStartLine, int nStartPos, int nEndLine, int nEndPos);
+BOOLEAN InsertCharacterBlock(TFile *pFile, const TBlock *pBlock, int nCol, int nRow);
 BOOLEAN DeleteColumnBlock(TFile *pFile,
   int nStartLine, int nStartPos, int nEndLine, int nEndPos);
 
@@ -55,6 +55,8 @@ void Rearrange(TFile *pFile, int nNumberOfLines, int *pLines)
       nStartLine = pLines[i];
   }
 
+  LinesChanged(pFile, nStartLine);  /* cached page data is no longer valid */
+
 #define MARK INT_MIN
 
   for (i = 0; i < nNumberOfLines; ++i)
@@ -119,6 +121,8 @@ void RevertRearrange(TFile *pFile, int nNumberOfLines, int *pLines)
       nStartLine = pLines[i];
   }
 
+  LinesChanged(pFile, nStartLine);  /* cached page data is no longer valid */
+
   for (i = 0; i < nNumberOfLines; ++i)
     pLines[i] |= MARK;
 
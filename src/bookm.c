@@ -108,6 +108,7 @@ void InitBMSet(TBookmarksSet *pBMSet, const char *sTitle)
   pBMSet->psEndOfFile = NULL;
   pBMSet->Viewer.bReadOnly = TRUE;
   pBMSet->bViewDirty = TRUE;
+  pBMSet->nVersion = 0;
   pBMSet->pViewerInterface = NULL;
   pBMSet->pfnActivateBookmark = NULL;
   pBMSet->pActivateBookmarksCtx = NULL;
@@ -438,6 +439,7 @@ _file_exists:
     pMark = (TMarkLocation *)(pMark->bmlink.Flink);
   }
   INSERT_TAIL_LIST(&pMark->bmlink, &pNewMark->bmlink);
+  ++pSet->nVersion;
 
   /* Calculate the nOffset field of the newly inserted bookmark */
   pNewMark->nOffset = nRow - nCalcRow;
@@ -552,6 +554,8 @@ void BMListRemoveBookmark(TMarkLocation *pMark)
   REMOVE_ENTRY_LIST(&pMark->bmlink);
 
   ((TBookmarksSet *)(pMark->pSet))->bViewDirty = TRUE;
+
+  ++((TBookmarksSet *)(pMark->pSet))->nVersion;
   if ((pMark->nOptions & BOOKM_STATIC) == 0)
     s_free(pMark->psContent);
   ASSERT(BMList.PgHeap.pageLen == 40);
@@ -725,6 +729,7 @@ void BMListUpdate(TFile *pFile, int nRow, int nLinesInserted)
     pMark->bRemoved = TRUE;
     pMark->bLastAction = TRUE;
     ((TBookmarksSet *)(pMark->pSet))->bViewDirty = TRUE;
+    ++((TBookmarksSet *)(pMark->pSet))->nVersion;
     while (!END_OF_LIST(&BMList.bmlist, &pMark->bmlink) &&
       pMark->pFileName == pFileName)
     {
@@ -741,6 +746,7 @@ void BMListUpdate(TFile *pFile, int nRow, int nLinesInserted)
       pMark->nOffset = 0;
       pMark->bRemoved = TRUE;
       ((TBookmarksSet *)(pMark->pSet))->bViewDirty = TRUE;
+      ++((TBookmarksSet *)(pMark->pSet))->nVersion;
     }
   }
 
@@ -753,6 +759,7 @@ void BMListUpdate(TFile *pFile, int nRow, int nLinesInserted)
   pMark->nOffset -= nAfterLastBookm;
 _exit:
   ((TBookmarksSet *)(pMark->pSet))->bViewDirty = TRUE;
+  ++((TBookmarksSet *)(pMark->pSet))->nVersion;
   pMark->bLastAction = TRUE;
 
   /*
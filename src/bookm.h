@@ -110,6 +110,7 @@ typedef struct _BookmarksSet
   TView stView;  /* To be inserted in a container */
   TListRoot blist;  /* The bookmarks contents can be stored as a list of TBlocks */
   BOOLEAN bViewDirty;  /* Indicates if the view file should be regenerated */
+  int nVersion;  /* Incremented when a bookmark is inserted or removed */
   BOOLEAN (*pfnActivateBookmark)(TMarkLocation *pMark, int nRow, void *pContext);
   void *pActivateBookmarksCtx;
   void *disp;
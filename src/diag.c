@@ -128,6 +128,8 @@ static void DiagParameters(dispc_t *disp)
 {
   PrintString(disp, "Parameters:\nModulePath: %s\nINIFile: %s\nMasterINIFile: %s\n",
     sModulePath, sINIFileName, sMasterINIFileName);
+  PrintString(disp, "~Frames:~ %lu rendered, %lu dropped (MaxFrameRate: %d)\n",
+    nFramesRendered, nFramesDropped, nMaxFrameRate);
 }
 
 /* ************************************************************************
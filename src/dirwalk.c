@@ -0,0 +1,540 @@
+/*
+
+File: dirwalk.c
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Directory walking for Find in Files. Skips the directories of
+  the version control systems, honours the ignore files and detects
+  binary files.
+
+  On UNIX a directory is read through a file descriptor, the type of
+  an entry is taken from d_type and only the entries of unknown type
+  and the symbolic links are stat()-ed, relative to the descriptor.
+  Elsewhere find_open()/find_file() are used.
+
+  The ignore files (.gitignore, .ignore) support a subset of the git
+  rules: comments, '!' to negate, a trailing '/' for directories only
+  and a pattern with a '/' is relative to the directory of the ignore
+  file. A leading "**" is ignored. The rules of the parent directories
+  are checked first, the last matching rule wins.
+
+  The functions are called by the workers of searchw.c and use only
+  malloc()/free().
+
+*/
+
+#include "global.h"
+#include "maxpath.h"
+#include "wlimits.h"
+#include "l1def.h"
+#include "dirwalk.h"
+
+#ifdef UNIX
+#include <fcntl.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#else
+#include "findf.h"
+#endif
+
+/* directories of the version control systems */
+static const char *VCSDirs[] = {".git", ".svn", ".hg"};
+
+static const char *IgnoreFiles[] = {".gitignore", ".ignore"};
+
+#define IGNORE_NEGATE 1
+#define IGNORE_DIR_ONLY 2
+#define IGNORE_ANCHORED 4  /* matched against the path, not the name */
+
+typedef struct DirIgnoreRule
+{
+  int nFlags;
+  const char *psPattern;  /* points in pText */
+} TDirIgnoreRule;
+
+struct DirIgnore
+{
+  const TDirIgnore *pParent;
+  char *pText;  /* the contents of the ignore files */
+  int nDirLen;  /* the directory of the ignore files is a prefix of the path */
+  int nNumRules;
+  TDirIgnoreRule *pRules;
+};
+
+struct DirWalk
+{
+  char sDir[_MAX_PATH];
+  #ifdef UNIX
+  DIR *dir;
+  #else
+  struct FF_DAT *ff_dat;
+  struct findfilestruct ff;
+  #endif
+};
+
+/* ************************************************************************
+   Function: IsVCSDir
+   Description:
+*/
+static BOOLEAN IsVCSDir(const char *psName)
+{
+  int i;
+
+  for (i = 0; i < _countof(VCSDirs); ++i)
+    if (strcmp(psName, VCSDirs[i]) == 0)
+      return TRUE;
+  return FALSE;
+}
+
+/* ************************************************************************
+   Function: DirWalkOpen
+   Description:
+     Starts reading a directory, psDir should end with a slash.
+   Returns:
+     NULL -- the directory can not be read.
+*/
+TDirWalk *DirWalkOpen(const char *psDir)
+{
+  TDirWalk *pWalk;
+  #ifdef UNIX
+  int nFd;
+  #else
+  char sBuf[_MAX_PATH];
+  #endif
+
+  if (strlen(psDir) >= _MAX_PATH)
+    return NULL;
+  pWalk = malloc(sizeof(TDirWalk));
+  if (pWalk == NULL)
+    return NULL;
+  strcpy(pWalk->sDir, psDir);
+
+  #ifdef UNIX
+  nFd = open(psDir, O_RDONLY | O_DIRECTORY);
+  if (nFd == -1)
+    goto _fail;
+  pWalk->dir = fdopendir(nFd);
+  if (pWalk->dir == NULL)
+  {
+    close(nFd);
+    goto _fail;
+  }
+  #else
+  if (strlen(psDir) + strlen(sAllMask) >= _MAX_PATH)
+    goto _fail;
+  strcpy(sBuf, psDir);
+  strcat(sBuf, sAllMask);  /* "*.*" */
+  pWalk->ff_dat = find_open(sBuf, FFIND_DIRS | FFIND_FILES);
+  if (pWalk->ff_dat == NULL)
+    goto _fail;
+  #endif
+  return pWalk;
+
+_fail:
+  free(pWalk);
+  return NULL;
+}
+
+/* ************************************************************************
+   Function: DirWalkNext
+   Description:
+     Gets the next directory or regular file. Skips "." and "..",
+     the directories of the version control systems and anything that
+     is neither a directory nor a regular file (devices, pipes).
+     *ppsName is valid until the next call.
+   Returns:
+     FALSE -- no more entries.
+*/
+BOOLEAN DirWalkNext(TDirWalk *pWalk, const char **ppsName, BOOLEAN *pbDir)
+{
+  #ifdef UNIX
+  struct dirent *de;
+  struct stat statbuf;
+
+  while ((de = readdir(pWalk->dir)) != NULL)
+  {
+    if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+      continue;
+    switch (de->d_type)
+    {
+      case DT_DIR:
+        *pbDir = TRUE;
+        break;
+      case DT_REG:
+        *pbDir = FALSE;
+        break;
+      case DT_LNK:
+      case DT_UNKNOWN:
+        if (fstatat(dirfd(pWalk->dir), de->d_name, &statbuf, 0) != 0)
+          continue;
+        if (S_ISDIR(statbuf.st_mode))
+          *pbDir = TRUE;
+        else
+          if (S_ISREG(statbuf.st_mode))
+            *pbDir = FALSE;
+          else
+            continue;
+        break;
+      default:
+        continue;
+    }
+    if (*pbDir && IsVCSDir(de->d_name))
+      continue;
+    *ppsName = de->d_name;
+    return TRUE;
+  }
+  return FALSE;
+  #else
+  while (find_file(pWalk->ff_dat, &pWalk->ff) == 0)
+  {
+    if (strcmp(pWalk->ff.filename, ".") == 0 ||
+      strcmp(pWalk->ff.filename, "..") == 0)
+      continue;
+    *pbDir = pWalk->ff.mode == FFIND_DIRS;
+    if (*pbDir && IsVCSDir(pWalk->ff.filename))
+      continue;
+    *ppsName = pWalk->ff.filename;
+    return TRUE;
+  }
+  return FALSE;
+  #endif
+}
+
+/* ************************************************************************
+   Function: DirWalkStat
+   Description:
+     Gets the time and the size of an entry of the directory.
+*/
+BOOLEAN DirWalkStat(TDirWalk *pWalk, const char *psName, struct stat *pStat)
+{
+  #ifdef UNIX
+  return fstatat(dirfd(pWalk->dir), psName, pStat, 0) == 0;
+  #else
+  ASSERT(strcmp(psName, pWalk->ff.filename) == 0);
+  *pStat = pWalk->ff.st;  /* find_file() has done it already */
+  return TRUE;
+  #endif
+}
+
+/* ************************************************************************
+   Function: DirWalkClose
+   Description:
+*/
+void DirWalkClose(TDirWalk *pWalk)
+{
+  if (pWalk == NULL)
+    return;
+  #ifdef UNIX
+  closedir(pWalk->dir);
+  #else
+  find_close(pWalk->ff_dat);
+  #endif
+  free(pWalk);
+}
+
+/* ************************************************************************
+   Function: ReadIgnoreFile
+   Description:
+     Appends the contents of an ignore file of the directory to
+     *ppText, followed by a new line.
+*/
+static void ReadIgnoreFile(TDirWalk *pWalk, const char *psName,
+  char **ppText, int *pnLen)
+{
+  char *pNewText;
+  int nRead;
+  #ifdef UNIX
+  int nFd;
+  #else
+  char sPath[_MAX_PATH];
+  FILE *f;
+  #endif
+
+  pNewText = realloc(*ppText, *pnLen + MAX_IGNORE_FILE_SIZE + 2);
+  if (pNewText == NULL)
+    return;
+  *ppText = pNewText;
+
+  #ifdef UNIX
+  nFd = openat(dirfd(pWalk->dir), psName, O_RDONLY);
+  if (nFd == -1)
+    return;
+  nRead = read(nFd, *ppText + *pnLen, MAX_IGNORE_FILE_SIZE);
+  close(nFd);
+  #else
+  if (strlen(pWalk->sDir) + strlen(psName) >= _MAX_PATH)
+    return;
+  strcpy(sPath, pWalk->sDir);
+  strcat(sPath, psName);
+  f = fopen(sPath, READ_BINARY_FILE);
+  if (f == NULL)
+    return;
+  nRead = fread(*ppText + *pnLen, 1, MAX_IGNORE_FILE_SIZE, f);
+  fclose(f);
+  #endif
+
+  if (nRead <= 0)
+    return;
+  *pnLen += nRead;
+  (*ppText)[(*pnLen)++] = '\n';
+  (*ppText)[*pnLen] = '\0';
+}
+
+/* ************************************************************************
+   Function: ParseIgnoreRules
+   Description:
+     Splits the text of the ignore files in rules.
+*/
+static BOOLEAN ParseIgnoreRules(TDirIgnore *pIgnore)
+{
+  TDirIgnoreRule *pRule;
+  char *p;
+  char *pLine;
+  char *pEnd;
+  int nMaxRules;
+
+  nMaxRules = 1;
+  for (p = pIgnore->pText; *p != '\0'; ++p)
+    if (*p == '\n')
+      ++nMaxRules;
+  pIgnore->pRules = malloc(nMaxRules * sizeof(TDirIgnoreRule));
+  if (pIgnore->pRules == NULL)
+    return FALSE;
+
+  pLine = pIgnore->pText;
+  while (*pLine != '\0')
+  {
+    p = strchr(pLine, '\n');
+    *p = '\0';
+    pEnd = p;
+    p = pLine;
+    pLine = pEnd + 1;
+
+    while (pEnd > p && (*(pEnd - 1) == '\r' || *(pEnd - 1) == ' '))
+      *--pEnd = '\0';
+    if (*p == '\0' || *p == '#')
+      continue;
+
+    pRule = &pIgnore->pRules[pIgnore->nNumRules];
+    pRule->nFlags = 0;
+    if (*p == '!')
+    {
+      pRule->nFlags |= IGNORE_NEGATE;
+      ++p;
+    }
+    if (*p == '\\')  /* "\#" or "\!" */
+      ++p;
+    if (pEnd > p && *(pEnd - 1) == '/')
+    {
+      pRule->nFlags |= IGNORE_DIR_ONLY;
+      *--pEnd = '\0';
+    }
+    if (strncmp(p, "**/", 3) == 0)
+      p += 3;
+    else
+      if (strchr(p, '/') != NULL)
+        pRule->nFlags |= IGNORE_ANCHORED;
+    if (*p == '/')
+      ++p;
+    if (*p == '\0')
+      continue;
+    pRule->psPattern = p;
+    ++pIgnore->nNumRules;
+  }
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: DirWalkLoadIgnore
+   Description:
+     Loads the ignore files of the directory. The new rules are
+     checked after the rules of pParent.
+   Returns:
+     NULL -- the directory has no ignore files, pParent applies.
+*/
+TDirIgnore *DirWalkLoadIgnore(TDirWalk *pWalk, const TDirIgnore *pParent)
+{
+  TDirIgnore *pIgnore;
+  char *pText;
+  int nLen;
+  int i;
+
+  pText = NULL;
+  nLen = 0;
+  for (i = 0; i < _countof(IgnoreFiles); ++i)
+    ReadIgnoreFile(pWalk, IgnoreFiles[i], &pText, &nLen);
+  if (nLen == 0)
+  {
+    free(pText);
+    return NULL;
+  }
+
+  pIgnore = malloc(sizeof(TDirIgnore));
+  if (pIgnore == NULL)
+  {
+    free(pText);
+    return NULL;
+  }
+  pIgnore->pParent = pParent;
+  pIgnore->pText = pText;
+  pIgnore->nDirLen = strlen(pWalk->sDir);
+  pIgnore->nNumRules = 0;
+  pIgnore->pRules = NULL;
+  if (!ParseIgnoreRules(pIgnore))
+  {
+    DirIgnoreDispose(pIgnore);
+    return NULL;
+  }
+  return pIgnore;
+}
+
+/* ************************************************************************
+   Function: MatchPattern
+   Description:
+*/
+static BOOLEAN MatchPattern(const char *psPattern, const char *psText,
+  BOOLEAN bPath)
+{
+  #ifdef UNIX
+  return fnmatch(psPattern, psText, bPath ? FNM_PATHNAME : 0) == 0;
+  #else
+  return match_wildarg(psText, psPattern);
+  #endif
+}
+
+/* ************************************************************************
+   Function: MatchRules
+   Description:
+*/
+static BOOLEAN MatchRules(const TDirIgnore *pIgnore, const char *psPath,
+  const char *psName, BOOLEAN bDir, BOOLEAN bIgnored)
+{
+  const TDirIgnoreRule *pRule;
+  const char *psRelPath;
+  int i;
+
+  if (pIgnore->pParent != NULL)
+    bIgnored = MatchRules(pIgnore->pParent, psPath, psName, bDir, bIgnored);
+
+  ASSERT((int)strlen(psPath) >= pIgnore->nDirLen);
+  psRelPath = psPath + pIgnore->nDirLen;
+  for (i = 0; i < pIgnore->nNumRules; ++i)
+  {
+    pRule = &pIgnore->pRules[i];
+    if ((pRule->nFlags & IGNORE_DIR_ONLY) != 0 && !bDir)
+      continue;
+    if ((pRule->nFlags & IGNORE_ANCHORED) != 0)
+    {
+      if (!MatchPattern(pRule->psPattern, psRelPath, TRUE))
+        continue;
+    }
+    else
+      if (!MatchPattern(pRule->psPattern, psName, FALSE))
+        continue;
+    bIgnored = (pRule->nFlags & IGNORE_NEGATE) == 0;
+  }
+  return bIgnored;
+}
+
+/* ************************************************************************
+   Function: DirIgnoreMatch
+   Description:
+     Checks whether an entry is excluded by the ignore files.
+     psPath is the full path of the entry, without a trailing slash
+     for a directory.
+*/
+BOOLEAN DirIgnoreMatch(const TDirIgnore *pIgnore, const char *psPath,
+  BOOLEAN bDir)
+{
+  const char *psName;
+
+  if (pIgnore == NULL)
+    return FALSE;
+  psName = strrchr(psPath, PATH_SLASH_CHAR);
+  if (psName == NULL)
+    psName = psPath;
+  else
+    ++psName;
+  return MatchRules(pIgnore, psPath, psName, bDir, FALSE);
+}
+
+/* ************************************************************************
+   Function: DirIgnoreDispose
+   Description:
+     Disposes the rules of a single directory, not of the parents.
+*/
+void DirIgnoreDispose(TDirIgnore *pIgnore)
+{
+  if (pIgnore == NULL)
+    return;
+  free(pIgnore->pRules);
+  free(pIgnore->pText);
+  free(pIgnore);
+}
+
+/* ************************************************************************
+   Function: IsBinaryText
+   Description:
+     A file with a zero in the first MAX_BINARY_SNIFF bytes is
+     considered binary (object files, archives, images).
+*/
+BOOLEAN IsBinaryText(const char *pBuf, long nLen)
+{
+  if (nLen > MAX_BINARY_SNIFF)
+    nLen = MAX_BINARY_SNIFF;
+  return memchr(pBuf, '\0', nLen) != NULL;
+}
+
+/* ************************************************************************
+   Function: IsBinaryFile
+   Description:
+     Reads the start of a file to check whether it is binary.
+*/
+BOOLEAN IsBinaryFile(const char *psFile)
+{
+  char Buf[MAX_BINARY_SNIFF];
+  FILE *f;
+  long nLen;
+
+  f = fopen(psFile, READ_BINARY_FILE);
+  if (f == NULL)
+    return FALSE;  /* the caller reports the error */
+  nLen = fread(Buf, 1, sizeof(Buf), f);
+  fclose(f);
+  return IsBinaryText(Buf, nLen);
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -94,6 +94,10 @@ enum disp_error
   DISP_FONT_STYLE_OVERFLOW,
   /*! no more space in palette table */
   DISP_PALETTE_FULL,
+  /*! the terminal can't be set in raw mode */
+  DISP_VT_MODE_SETUP_FAILURE,
+  /*! the script of events for the headless display can't be loaded */
+  DISP_HEADLESS_SCRIPT_FAILURE,
 };
 
 void disp_error_get(dispc_t *disp, enum disp_error *code,
@@ -171,6 +175,7 @@ void disp_write(dispc_t *disp,
 void disp_flex_write(dispc_t *disp,
                      const char *s, int x, int y, int attr1, int attr2);
 void disp_fill(dispc_t *disp, char c, int attr, int x, int y, int count);
+void disp_scroll_rows(dispc_t *disp, int y, int h, int n);
 
 struct disp_cursor_param
 {
@@ -239,9 +244,11 @@ enum event_type
   EVENT_MOUSE,
   EVENT_RESIZE,
   EVENT_TIMER_5SEC,
-  EVENT_CLIPBOARD_PASTE,
+  EVENT_CLIPBOARD_PASTE,  /* e.pdata: asciiz text */
   EVENT_CLIPBOARD_CLEAR,
   EVENT_CLIPBOARD_COPY_REQUESTED,
+  EVENT_TIMER_TICK,
+  EVENT_WATCH_FD,
   EVENT_USR
 };
 
@@ -321,6 +328,7 @@ struct disp_event
 };
 
 int disp_event_read(dispc_t *disp, disp_event_t *event);
+int disp_event_pending(dispc_t *disp);
 void disp_event_clear(disp_event_t *event);
 int  disp_event_is_valid(const disp_event_t *event);
 
@@ -337,6 +345,39 @@ struct disp_elapsed_time
 
 void disp_elapsed_time_get(dispc_t *disp, disp_elapsed_time_t *t);
 void disp_elapsed_time_set(dispc_t *disp, const disp_elapsed_time_t *t);
+unsigned long disp_get_tick_ms(dispc_t *disp);
+
+/* interval of EVENT_TIMER_TICK in miliseconds */
+#define DISP_TICK_TIME 100
+
+void disp_set_tick(dispc_t *disp, int tick_enabled);
+
+void disp_set_watch_fd(dispc_t *disp, int fd);
+
+/*
+Only in the headless implementation (disp_headless.c): scripted events
+instead of a keyboard and statistics of the frames, for benchmarks and
+tests that run without a terminal
+*/
+typedef struct disp_headless_stats disp_headless_stats_t;
+
+struct disp_headless_stats
+{
+  unsigned long events;  /* scripted events delivered */
+  unsigned long frames;  /* event reads that found changes of the screen */
+  unsigned long cells_changed;
+  unsigned long rows_changed;
+  unsigned long scrolls;
+  unsigned long render_us;  /* from an event until the next read, total */
+  unsigned long max_render_us;
+};
+
+int  disp_headless_put_event(dispc_t *disp, const disp_event_t *event);
+int  disp_headless_put_key(dispc_t *disp, unsigned long key, int count);
+int  disp_headless_put_text(dispc_t *disp, const char *text);
+int  disp_headless_load_script(dispc_t *disp, const char *file_name);
+void disp_headless_get_stats(dispc_t *disp, disp_headless_stats_t *stats);
+void disp_headless_reset_stats(dispc_t *disp);
 
 /*!
 @}
@@ -359,6 +400,15 @@ disp_win_g.c -- WIN32 GUI emulation functions. It includes disp_common.c
 
 disp_ncurs.c -- ncurses functions. It includes disp_common.c
 
+disp_vt.c -- VT/ANSI terminal functions, without ncurses. It includes
+disp_common.c
+
+disp_headless.c -- in-memory screen and scripted events, for benchmarks
+and tests. It includes disp_common.c
+
+disp_select.c -- with DISP_SELECT, disp_ncurs.c and disp_vt.c are built
+together and it forwards the calls to the one chosen at startup
+
 Depends:
 
 disp depends only on standard libraries
@@ -67,9 +67,14 @@ static unsigned long s_disp_pal_compose_rgb(const dispc_t *disp,
 static void s_disp_validate_rect(dispc_t *disp,
                                  int x, int y,
                                  int w, int h);
+static int s_disp_scroll_rows(dispc_t *disp, int y, int h, int n);
 static void s_disp_done(dispc_t *disp);
 static void s_disp_wnd_set_title(dispc_t *disp, const char *title);
+static void s_disp_set_tick(dispc_t *disp);
+static void s_disp_set_watch_fd(dispc_t *disp);
 static int s_disp_process_events(dispc_t *disp);
+static int s_disp_input_is_pending(dispc_t *disp);
+static unsigned long s_disp_get_tick_ms(void);
 
 /*!
 @brief Returns the size of the dispc (display) object
@@ -249,6 +254,8 @@ static void s_disp_free_char_buf(dispc_t *disp)
 
   if (disp->char_buf != NULL)
     my_free(disp->char_buf);
+  if (disp->damage_start != NULL)
+    my_free(disp->damage_start);
 }
 
 /*!
@@ -325,6 +332,7 @@ static void s_disp_alloc_char_buf(dispc_t *disp)
 {
   int required_size;
   int char_buf_size;
+  int i;
 
   required_size = disp->geom_param.height * disp->geom_param.width;
   char_buf_size = disp->buf_height * disp->buf_width;
@@ -337,13 +345,102 @@ static void s_disp_alloc_char_buf(dispc_t *disp)
   {
     if (disp->char_buf != NULL)
       s_disp_free(disp, disp->char_buf);
+    if (disp->damage_start != NULL)
+      s_disp_free(disp, disp->damage_start);
 
     disp->char_buf = s_disp_malloc(disp, required_size * sizeof(disp_char_t));
     ASSERT(disp->char_buf != NULL);  /* malloc should've a the safety buffer */
 
+    /* start and end of the damage of each row in a single block */
+    disp->damage_start =
+      s_disp_malloc(disp, disp->geom_param.height * 2 * sizeof(int));
+    ASSERT(disp->damage_start != NULL);
+    disp->damage_end = disp->damage_start + disp->geom_param.height;
+
     disp->buf_height = disp->geom_param.height;
     disp->buf_width = disp->geom_param.width;
+
+    /* the new char_buf is yet to be filled, nothing to flush */
+    for (i = 0; i < disp->buf_height; ++i)
+      disp->damage_start[i] = -1;
+    disp->has_damage = 0;
+  }
+}
+
+/*!
+@brief Adds a span of a row to the damage of the screen buffer
+
+The span is sent to the screen by s_disp_flush_damage() once per frame,
+repeated changes of a row until then produce a single output.
+
+@param disp  a display object
+@param x     first column that has changed
+@param y     row
+@param w     number of columns
+*/
+static void s_disp_damage(dispc_t *disp, int x, int y, int w)
+{
+  ASSERT(VALID_DISP(disp));
+  ASSERT(y >= 0 && y < disp->buf_height);
+  ASSERT(w > 0);
+  ASSERT(x >= 0 && x + w <= disp->buf_width);
+
+  disp->paint_is_suspended = 0;
+  disp->has_damage = 1;
+
+  if (disp->damage_start[y] == -1)
+  {
+    disp->damage_start[y] = x;
+    disp->damage_end[y] = x + w - 1;
+    return;
+  }
+
+  if (x < disp->damage_start[y])
+    disp->damage_start[y] = x;
+  if (x + w - 1 > disp->damage_end[y])
+    disp->damage_end[y] = x + w - 1;
+}
+
+/*!
+@brief Sends the damaged spans of the screen buffer to the screen
+
+Called once per frame, before waiting for the next event. Only the changed
+span of each changed row is passed to the platform.
+
+@param disp  a display object
+*/
+static void s_disp_flush_damage(dispc_t *disp)
+{
+  int y;
+  int x;
+  int w;
+  int height;
+
+  ASSERT(VALID_DISP(disp));
+
+  if (!disp->has_damage)
+    return;
+
+  /* the window may have shrunk after the damage */
+  height = disp->geom_param.height;
+  if (height > disp->buf_height)
+    height = disp->buf_height;
+
+  for (y = 0; y < disp->buf_height; ++y)
+  {
+    if (disp->damage_start[y] == -1)
+      continue;
+
+    x = disp->damage_start[y];
+    w = disp->damage_end[y] - x + 1;
+    if (x + w > disp->geom_param.width)
+      w = disp->geom_param.width - x;
+    if (y < height && w > 0)
+      s_disp_validate_rect(disp, x, y, w, 1);
+
+    disp->damage_start[y] = -1;
   }
+  disp->has_damage = 0;
 }
 
 /*!
@@ -775,12 +872,72 @@ void disp_put_block(dispc_t *disp,
       /*debug_trace("put_block %d:%d len %d (-%d)\n", x, y + ln, w,
                   w - range_num_chars);*/
 
-      /* Invalidate only the range that has changed */
-      s_disp_validate_rect(disp, x + range_start, y, range_num_chars, h);
+      /* Only the range of this line that has changed */
+      s_disp_damage(disp, x + range_start, y + ln, range_num_chars);
     }
   }
 }
 
+/*!
+@brief Scrolls rows of the screen
+
+Moves the content of rows y to y + h - 1 by n rows, up when n is positive
+and down when n is negative. The terminal does this with its scroll region,
+only the rows exposed by the scroll are to be sent afterwards. The exposed
+rows keep their old content and are marked as changed, the caller is to put
+the new text there.
+
+@param disp  a display object
+@param y     first row of the region
+@param h     number of rows in the region
+@param n     rows to scroll by, less than h
+*/
+void disp_scroll_rows(dispc_t *disp, int y, int h, int n)
+{
+  disp_char_t *char_ln;
+  int w;
+  int exposed_y;
+  int i;
+
+  ASSERT(VALID_DISP(disp));
+  ASSERT(y >= 0 && h > 0 && y + h <= disp->geom_param.height);
+  ASSERT(n != 0 && abs(n) < h);
+
+  w = disp->geom_param.width;
+  char_ln = s_disp_buf_access(disp, 0, y);
+
+  /* the platform scrolls what is already on the screen */
+  s_disp_flush_damage(disp);
+
+  if (!s_disp_scroll_rows(disp, y, h, n))
+  {
+    /* no scroll on this platform, send the whole region */
+    for (i = 0; i < h; ++i)
+      s_disp_damage(disp, 0, y + i, w);
+    return;
+  }
+
+  if (n > 0)
+  {
+    for (i = 0; i < h - n; ++i)
+      memcpy(char_ln + i * disp->buf_width,
+             char_ln + (i + n) * disp->buf_width, w * sizeof(disp_char_t));
+    exposed_y = y + h - n;
+  }
+  else
+  {
+    for (i = h - 1; i >= -n; --i)
+      memcpy(char_ln + i * disp->buf_width,
+             char_ln + (i + n) * disp->buf_width, w * sizeof(disp_char_t));
+    exposed_y = y;
+    n = -n;
+  }
+
+  /* the screen shows blanks there, whatever is put must be sent */
+  for (i = 0; i < n; ++i)
+    s_disp_damage(disp, 0, exposed_y + i, w);
+}
+
 /*!
 @brief Gets the text from a rectangle window area
 
@@ -875,7 +1032,7 @@ void disp_write(dispc_t *disp,
   if (range_start != -1)
   {
     range_num_chars = range_end - range_start + 1;
-    s_disp_validate_rect(disp, x + range_start, y, range_num_chars, 1);
+    s_disp_damage(disp, x + range_start, y, range_num_chars);
   }
 
   /*debug_trace("write %d:%d len %d (-%d)\n", x, y, len,
@@ -960,7 +1117,7 @@ void disp_flex_write(dispc_t *disp,
   if (range_start != -1)
   {
     range_num_chars = range_end - range_start + 1;
-    s_disp_validate_rect(disp, x + range_start, y, range_num_chars, 1);
+    s_disp_damage(disp, x + range_start, y, range_num_chars);
   }
 
   /*debug_trace("flex_write %d:%d len %d (-%d)\n", x, y, display_len,
@@ -1028,7 +1185,7 @@ void disp_fill(dispc_t *disp, char c, int attr, int x, int y, int count)
   if (range_start != -1)
   {
     range_num_chars = range_end - range_start + 1;
-    s_disp_validate_rect(disp, x + range_start, y, range_num_chars, 1);
+    s_disp_damage(disp, x + range_start, y, range_num_chars);
   }
 
   /*debug_trace("fill %d:%d len %d (-%d)\n", x, y, count,
@@ -1166,11 +1323,42 @@ int disp_event_read(dispc_t *disp, disp_event_t *event)
     if (s_disp_ev_q_get(disp, event))
       return 1;
 
+    s_disp_flush_damage(disp);  /* the frame is complete */
     if (!s_disp_process_events(disp))
       return 0;
   }
 }
 
+/*!
+@brief Checks whether disp_event_read() has an event without waiting
+
+The caller can skip painting the screen while more input is coming.
+
+@param disp  a dispc object
+@return 1 an event is in the queue or input is waiting
+@return 0 disp_event_read() would wait
+*/
+int disp_event_pending(dispc_t *disp)
+{
+  ASSERT(VALID_DISP(disp));
+
+  if (disp->ev_c > 0)
+    return 1;
+  return s_disp_input_is_pending(disp);
+}
+
+/*!
+@brief Gets a time in miliseconds, to measure intervals
+
+@param disp  a dispc object
+@return miliseconds from an unspecified moment, wraps around
+*/
+unsigned long disp_get_tick_ms(dispc_t *disp)
+{
+  DISP_REFERENCE(*disp);
+  return s_disp_get_tick_ms();
+}
+
 /*!
 @brief just a safety wrap of strcat
 */
@@ -1298,3 +1486,112 @@ void disp_elapsed_time_set(dispc_t *disp, const disp_elapsed_time_t *t)
   disp->time_elapsed = t->total_seconds;
 }
 
+/*!
+@brief turns on or off the EVENT_TIMER_TICK events
+
+While enabled, disp_event_read() returns EVENT_TIMER_TICK every
+DISP_TICK_TIME miliseconds when there are no other events. This is
+for a background activity that needs to report its progress on the
+screen without blocking the event loop.
+
+The calls are counted, more activities can run at the same time and
+the events stop after each one has turned its ticks off.
+
+@param disp          a dispc object
+@param tick_enabled  1 -- send EVENT_TIMER_TICK, 0 -- stop
+*/
+void disp_set_tick(dispc_t *disp, int tick_enabled)
+{
+  ASSERT(VALID_DISP(disp));
+
+  if (tick_enabled)
+    ++disp->tick_users;
+  else
+  {
+    ASSERT(disp->tick_users > 0);
+    --disp->tick_users;
+  }
+  if (disp->tick_enabled == (disp->tick_users > 0))
+    return;
+  disp->tick_enabled = disp->tick_users > 0;
+  s_disp_set_tick(disp);
+}
+
+/*!
+@brief arms a file descriptor to be watched by the event loop
+
+When data can be read from the descriptor disp_event_read() returns
+EVENT_WATCH_FD once, the descriptor is then not watched until this
+function is called again. The caller reads the data and arms the
+descriptor again. This way an event dropped by a nested event loop
+(a dialog box) can not keep the event loop busy.
+
+The descriptor is watched only on the platforms that wait for
+the console input by select().
+
+@param disp  a dispc object
+@param fd    descriptor to watch, -1 to stop watching
+*/
+void disp_set_watch_fd(dispc_t *disp, int fd)
+{
+  ASSERT(VALID_DISP(disp));
+
+  disp->watch_fd = fd;
+  disp->watch_fd_armed = fd >= 0;
+  s_disp_set_watch_fd(disp);
+}
+
+#ifdef DISP_SELECT_PREFIX
+/*
+The API of this implementation for disp_select.c, the names are
+renamed by disp_select_p.h
+*/
+const disp_backend_t DISP_SELECT_NAME(backend) =
+{
+  DISP_SELECT_STR(DISP_SELECT_PREFIX),
+  disp_obj_size,
+  disp_init,
+  disp_done,
+  disp_error_get,
+  disp_error_clear,
+  disp_set_safemem_proc,
+  disp_wnd_set_param,
+  disp_wnd_get_param,
+  disp_wnd_get_width,
+  disp_wnd_get_height,
+  disp_set_resize_handler,
+  disp_pal_get_standard,
+  disp_pal_compose_rgb,
+  disp_pal_add,
+  disp_pal_free,
+  disp_cbuf_reset,
+  disp_cbuf_mark_invalid,
+  disp_cbuf_put_char,
+  disp_cbuf_put_attr,
+  disp_cbuf_put_char_attr,
+  disp_calc_rect_size,
+  disp_put_block,
+  disp_get_block,
+  disp_write,
+  disp_flex_write,
+  disp_fill,
+  disp_scroll_rows,
+  disp_cursor_hide,
+  disp_cursor_goto_xy,
+  disp_cursor_get_xy,
+  disp_cursor_get_param,
+  disp_cursor_restore_param,
+  disp_wnd_set_title,
+  disp_event_read,
+  disp_event_pending,
+  disp_event_clear,
+  disp_event_is_valid,
+  disp_get_key_name,
+  disp_elapsed_time_get,
+  disp_elapsed_time_set,
+  disp_get_tick_ms,
+  disp_set_tick,
+  disp_set_watch_fd
+};
+#endif
+
@@ -0,0 +1,870 @@
+/*!
+@file disp_headless.c
+@brief [disp] Headless in-memory implementation of the console API
+
+@section a Header
+
+File: disp_headless.c\n
+COPYING: Full text of the copyrights statement at the bottom of the file\n
+Project: WW text editor\n
+Started: 18th October, 2026\n
+
+
+@section b Module disp
+
+Module disp is a standalone library that abstracts the access to
+console output for WIN32 console, WIN32 GUI, ncurses and X11.
+
+This is an implementation of the API described in disp.h that needs
+no terminal. The screen is a grid of disp_char_t in memory and the
+events come from a script, the editor can be run by benchmarks and
+tests with the same input every time.
+
+s_disp_validate_rect() copies char_buf to the screen and counts the
+cells that change. The time from delivering an event until the next
+disp_event_read() is what the caller took to handle the event and to
+paint, it goes in the statistics together with the cells changed in
+between, see disp_headless_get_stats().
+
+The script is filled by disp_headless_put_event(), disp_headless_put_key()
+and disp_headless_put_text() or is loaded from a file by
+disp_headless_load_script(). When the environment variable
+DISP_HEADLESS_SCRIPT names a file, s_disp_init() loads it and
+disp_done() prints the statistics to stderr.
+
+After the end of the script disp_event_read() returns 0, the caller
+should leave its event loop.
+
+
+@section c Compile time definitions
+
+D_ASSERT -- External assert() replacement function can be supplied in the form
+of a define -- D_ASSERT. It must conform to the standard C library
+prototype of assert.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#include "disp.h"
+#include "disp_headless_p.h"
+
+/* The top level API, platform independent part */
+#include "disp_common.c"
+
+#define DISP_FONT_STYLE_BITS (DISP_FONT_ITALIC | DISP_FONT_BOLD | DISP_FONT_UNDERLINE | DISP_FONT_REVERSE)
+
+/*!
+@brief Adds an entry to the palette table
+
+@param disp a dispc object
+@param color       foreground color, from s_disp_pal_get_standard() or
+                   s_disp_pal_compose_rgb()
+@param background  background color
+@param font_style      bit mask for font style
+@param *palette_id     returns here a handle to palette entry
+@return 0 error, disp->code & disp->error_msg are set
+*/
+static int s_disp_pal_add(dispc_t *disp,
+                 unsigned int color, unsigned int background,
+                 unsigned font_style, int *palette_id)
+{
+  int i;
+
+  /* check: only valid bits are set */
+  ASSERT((font_style & DISP_FONT_STYLE_BITS) == font_style);
+  ASSERT(palette_id != NULL);
+
+  for (i = 0; i < DISP_COUNTOF(disp->palette); ++i)
+  {
+    if (disp->palette[i].in_use)
+      continue;
+    if (i == DISP_HEADLESS_UNKNOWN_ATTR)
+      break;  /* reserved to mark the cells never painted */
+    disp->palette[i].in_use = 1;
+    disp->palette[i].color = color;
+    disp->palette[i].background = background;
+    disp->palette[i].font_style = font_style;
+    *palette_id = i;
+    return 1;
+  }
+
+  /* no space in the palette table */
+  disp->code = DISP_PALETTE_FULL;
+  snprintf(disp->error_msg, sizeof(disp->error_msg),
+           "no more entries available in the palette table");
+  return 0;
+}
+
+/*!
+@brief Disposes of one palette entry.
+
+@param disp        a dispc object
+@param palette_id  id of palette entry from disp_pal_add()
+*/
+static void s_disp_pal_free(dispc_t *disp, int palette_id)
+{
+  disp->palette[palette_id].in_use = 0;
+}
+
+/*!
+@brief Finds if specific palette entry is within range
+
+@param disp        a dispc object
+@param palette_id  palette ID of display attribute
+*/
+static int s_disp_palette_id_is_valid(const dispc_t *disp, int palette_id)
+{
+  DISP_REFERENCE(disp);
+  return (palette_id < DISP_COUNTOF(disp->palette) && palette_id >= 0);
+}
+
+/*!
+@brief Platform dependent color
+
+@param disp   a dispc object
+@param color  one of the original 16 DOS colors
+
+@returns platrorm dependent color value
+*/
+static unsigned long s_disp_pal_get_standard(const dispc_t *disp, int color)
+{
+  DISP_REFERENCE(disp);
+  ASSERT(color >= 0);
+  ASSERT(color <= 0x0f);
+
+  return color;
+}
+
+/*!
+@brief  Platform dependent color
+
+For RGB of standard 16 DOS colors use disp_pal_standard().
+
+@param disp   a dispc object
+@param r      red component
+@param g      green component
+@param b      blue component
+
+@returns platrorm dependent color value
+*/
+static unsigned long s_disp_pal_compose_rgb(const dispc_t *disp,
+                                            int r, int g, int b)
+{
+  DISP_REFERENCE(disp);
+
+  return DISP_HEADLESS_RGB | ((r & 0xff) << 16) | ((g & 0xff) << 8) | (b & 0xff);
+}
+
+/*!
+@brief Allocates the screen for the current window size (headless)
+
+The screen can't be allocated at s_disp_init() time for the same reason
+as char_buf, see s_disp_alloc_char_buf().
+
+@param disp  a dispc object
+@return 0 out of memory
+*/
+static int s_disp_alloc_screen(dispc_t *disp)
+{
+  disp_char_t *new_screen;
+  int i;
+
+  if (disp->screen != NULL
+      && disp->screen_width == disp->geom_param.width
+      && disp->screen_height == disp->geom_param.height)
+    return 1;
+
+  new_screen = s_disp_malloc(disp, disp->geom_param.width *
+                                   disp->geom_param.height *
+                                   sizeof(disp_char_t));
+  if (new_screen == NULL)
+    return 0;
+  if (disp->screen != NULL)
+    s_disp_free(disp, disp->screen);
+  disp->screen = new_screen;
+  disp->screen_width = disp->geom_param.width;
+  disp->screen_height = disp->geom_param.height;
+
+  for (i = 0; i < disp->screen_width * disp->screen_height; ++i)
+  {
+    disp->screen[i].c = ' ';
+    disp->screen[i].a = DISP_HEADLESS_UNKNOWN_ATTR;
+  }
+  return 1;
+}
+
+/*!
+@brief Updates area of the screen with data from the screen buffer (headless)
+
+Counts the cells that change for the frame statistics.
+
+@param disp  a dispc object
+@param x    upper left corner coordinates of the destination rectangle
+@param y    upper left corner coordinates of the destination rectangle
+@param w    rectangle geometry
+@param h    rectangle geometry
+*/
+static void s_disp_validate_rect(dispc_t *disp,
+                                 int x, int y,
+                                 int w, int h)
+{
+  disp_char_t *char_ln;
+  disp_char_t *screen_ln;
+  int i;
+  int j;
+  int n;
+
+  ASSERT(VALID_DISP(disp));
+  ASSERT(x >= 0);
+  ASSERT(y >= 0);
+  ASSERT(w > 0);
+  ASSERT(h > 0);
+  ASSERT(w <= disp->geom_param.width);
+  ASSERT(h <= disp->geom_param.height);
+
+  disp->paint_is_suspended = 0;
+
+  if (!s_disp_alloc_screen(disp))
+    return;
+
+  for (i = 0; i < h; ++i)
+  {
+    char_ln = s_disp_buf_access(disp, x, y + i);
+    screen_ln = disp->screen + (y + i) * disp->screen_width + x;
+
+    n = 0;
+    for (j = 0; j < w; ++j)
+    {
+      if (disp_char_equal(char_ln[j], screen_ln[j]))
+        continue;
+      screen_ln[j] = char_ln[j];
+      ++n;
+    }
+
+    if (n > 0)
+    {
+      disp->frame_cells += n;
+      ++disp->frame_rows;
+    }
+  }
+}
+
+/*!
+@brief Scrolls rows of the screen (headless)
+
+@param disp  a dispc object
+@param y     first row of the region
+@param h     number of rows in the region
+@param n     rows to scroll by, positive is up
+@return 1 the rows are scrolled
+*/
+static int s_disp_scroll_rows(dispc_t *disp, int y, int h, int n)
+{
+  disp_char_t *region;
+  int exposed_y;
+  int i;
+
+  if (!s_disp_alloc_screen(disp))
+    return 0;
+  ASSERT(y + h <= disp->screen_height);
+
+  region = disp->screen + y * disp->screen_width;
+  if (n > 0)
+  {
+    memmove(region, region + n * disp->screen_width,
+            (h - n) * disp->screen_width * sizeof(disp_char_t));
+    exposed_y = h - n;
+  }
+  else
+  {
+    memmove(region - n * disp->screen_width, region,
+            (h + n) * disp->screen_width * sizeof(disp_char_t));
+    exposed_y = 0;
+  }
+  region += exposed_y * disp->screen_width;
+  for (i = 0; i < abs(n) * disp->screen_width; ++i)
+    region[i].a = DISP_HEADLESS_UNKNOWN_ATTR;
+
+  ++disp->frame_scrolls;
+  return 1;
+}
+
+/*!
+@brief Makes the caret visible or invisible (headless)
+
+@param disp              a dispc object
+@param caret_is_visible  new state of the caret
+*/
+static void s_disp_show_cursor(dispc_t *disp, int caret_is_visible)
+{
+  disp->cursor_is_visible = caret_is_visible;
+}
+
+/*!
+@brief Sets the caret on a specific position (headless)
+
+@param disp  a display object
+@param x     coordinates in character units
+@param y     coordinates in character units
+*/
+static void s_disp_set_cursor_pos(dispc_t *disp, int x, int y)
+{
+  disp->cursor_x = x;
+  disp->cursor_y = y;
+}
+
+/*!
+@brief Gets a time in microseconds, for the frame statistics (headless)
+*/
+static unsigned long s_disp_get_time_us(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (unsigned long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*!
+@brief Gets a time in miliseconds, to measure intervals (headless)
+*/
+static unsigned long s_disp_get_tick_ms(void)
+{
+  return s_disp_get_time_us() / 1000;
+}
+
+/*!
+@brief Checks for input without waiting (headless)
+
+The scripted events are delivered as if typed one by one, the caller
+paints a frame for each of them.
+
+@param disp  a dispc object
+@return 0 always
+*/
+static int s_disp_input_is_pending(dispc_t *disp)
+{
+  DISP_REFERENCE(disp);
+  return 0;
+}
+
+/*!
+@brief Adds the frame since the last event to the statistics (headless)
+
+@param disp  a dispc object
+*/
+static void s_disp_end_frame(dispc_t *disp)
+{
+  unsigned long render_us;
+
+  if (disp->render_is_timed)
+  {
+    render_us = s_disp_get_time_us() - disp->event_time_us;
+    disp->stats.render_us += render_us;
+    if (render_us > disp->stats.max_render_us)
+      disp->stats.max_render_us = render_us;
+    disp->render_is_timed = 0;
+  }
+
+  if (disp->frame_cells > 0 || disp->frame_scrolls > 0)
+    ++disp->stats.frames;
+  disp->stats.cells_changed += disp->frame_cells;
+  disp->stats.rows_changed += disp->frame_rows;
+  disp->stats.scrolls += disp->frame_scrolls;
+  disp->frame_cells = 0;
+  disp->frame_rows = 0;
+  disp->frame_scrolls = 0;
+}
+
+/*!
+@brief Delivers the next event of the script (headless)
+
+EVENT_TIMER_TICK goes between the scripted events while the ticks are
+enabled, a background activity moves one step for each event.
+
+At the end of the script disp_event_read() returns 0. A nested event
+loop (a menu, a dialog box) doesn't check for that, for it every other
+read is an Esc key until it closes and the top level loop gets its 0.
+
+@param disp  a dispc object
+@return 0 the end of the script
+@return 1 an event is in the queue
+*/
+static int s_disp_process_events(dispc_t *disp)
+{
+  disp_event_t ev;
+
+  s_disp_end_frame(disp);
+
+  disp_event_clear(&ev);
+  if (disp->tick_enabled && disp->tick_is_due)
+  {
+    disp->tick_is_due = 0;
+    ev.t.code = EVENT_TIMER_TICK;
+  }
+  else if (disp->script_pos < disp->script_len)
+  {
+    disp->tick_is_due = 1;
+    ev = disp->script[disp->script_pos++];
+  }
+  else
+  {
+    if (disp->script_end_reads++ % 2 == 0)
+      return 0;
+    ev.t.code = EVENT_KEY;
+    ev.e.kbd.scan_code_only = kbEsc;
+    ev.e.kbd.shift_state = 0;
+    ev.e.kbd.key = KEY(0, kbEsc);
+  }
+
+  s_disp_ev_q_put(disp, &ev);
+  ++disp->stats.events;
+  disp->render_is_timed = 1;
+  disp->event_time_us = s_disp_get_time_us();
+  return 1;
+}
+
+/*!
+@brief Finds the scan code of a key by its name (headless)
+
+@param name  key name as given by disp_get_key_name(), without the
+             shift state
+@return the scan code
+@return 0 unknown name
+*/
+static int s_disp_key_scan_code(const char *name)
+{
+  int i;
+
+  if (strcmp(name, "F11") == 0)
+    return kbF11;
+  if (strcmp(name, "F12") == 0)
+    return kbF12;
+  for (i = 0; i < DISP_COUNTOF(key_names); ++i)
+    if (strcmp(name, key_names[i]) == 0)
+      return i + 1;
+  return 0;
+}
+
+/*!
+@brief Converts a character into the key that types it (headless)
+
+@param c  the character, '\\n' is Enter and '\\t' is Tab
+@return the key as in disp_event_t.e.kbd.key
+*/
+static unsigned long s_disp_char_key(char c)
+{
+  static const char shifted[] = "!@#$%^&*()_+{}:\"~|<>?";
+  static const char unshifted[] = "1234567890-=[];'`\\,./";
+  const char *p;
+  char name[2];
+  int shift_state;
+  int scan_code;
+
+  switch (c)
+  {
+    case '\n':
+      return KEY(0, kbEnter);
+    case '\t':
+      return KEY(0, kbTab);
+    case ' ':
+      return KEY(0, kbSpace) | ' ';
+  }
+
+  shift_state = 0;
+  name[0] = (char)toupper((unsigned char)c);
+  name[1] = '\0';
+  if (isupper((unsigned char)c))
+    shift_state = kbShift;
+  p = c != '\0' ? strchr(shifted, c) : NULL;
+  if (p != NULL)
+  {
+    name[0] = unshifted[p - shifted];
+    shift_state = kbShift;
+  }
+
+  scan_code = s_disp_key_scan_code(name);
+  if (scan_code == 0)  /* not on the keyboard, only the ASCII code */
+    return (unsigned char)c;
+  return KEY(shift_state, scan_code) | (unsigned char)c;
+}
+
+/*!
+@brief Converts a key name into a key (headless)
+
+The name is as given by disp_get_key_name(), "Ctrl+Shift+End".
+A letter without Ctrl or Alt is typed as a character.
+
+@param name  the name of the key
+@return the key as in disp_event_t.e.kbd.key
+@return 0 unknown name
+*/
+static unsigned long s_disp_parse_key(const char *name)
+{
+  int shift_state;
+  int scan_code;
+
+  shift_state = 0;
+  for (;;)
+  {
+    if (strncmp(name, "Ctrl+", 5) == 0)
+      shift_state |= kbCtrl;
+    else if (strncmp(name, "Alt+", 4) == 0)
+      shift_state |= kbAlt;
+    else if (strncmp(name, "Shift+", 6) == 0)
+      shift_state |= kbShift;
+    else
+      break;
+    name = strchr(name, '+') + 1;
+  }
+
+  if (isalpha((unsigned char)name[0]) && name[1] == '\0'
+      && (shift_state & (kbCtrl | kbAlt)) == 0)
+  {
+    if (shift_state & kbShift)
+      return s_disp_char_key((char)toupper((unsigned char)name[0]));
+    return s_disp_char_key((char)tolower((unsigned char)name[0]));
+  }
+
+  scan_code = s_disp_key_scan_code(name);
+  if (scan_code == 0)
+    return 0;
+  return KEY(shift_state, scan_code);
+}
+
+/*!
+@brief Converts the escapes \\n, \\t and \\\\ of a script line (headless)
+
+@param dest  receives the text, at least as big as src
+@param src   text from the script
+*/
+static void s_disp_unescape(char *dest, const char *src)
+{
+  while (*src != '\0')
+  {
+    if (*src == '\\' && src[1] != '\0')
+    {
+      ++src;
+      if (*src == 'n')
+        *dest++ = '\n';
+      else if (*src == 't')
+        *dest++ = '\t';
+      else
+        *dest++ = *src;
+      ++src;
+      continue;
+    }
+    *dest++ = *src++;
+  }
+  *dest = '\0';
+}
+
+/*!
+@brief Adds an event at the end of the script (headless)
+
+The script is kept with the libc's malloc(), it can be filled before
+disp_set_safemem_proc() is called.
+
+@param disp   a dispc object
+@param event  the event to copy in the script
+@return 0 out of memory, disp->code & disp->error_msg are set
+*/
+int disp_headless_put_event(dispc_t *disp, const disp_event_t *event)
+{
+  disp_event_t *new_script;
+  int new_size;
+
+  ASSERT(VALID_DISP(disp));
+
+  if (disp->script_len == disp->script_size)
+  {
+    new_size = disp->script_size == 0 ? 256 : disp->script_size * 2;
+    new_script = realloc(disp->script, new_size * sizeof(disp_event_t));
+    if (new_script == NULL)
+    {
+      disp->code = DISP_HEADLESS_SCRIPT_FAILURE;
+      snprintf(disp->error_msg, sizeof(disp->error_msg),
+               "no memory for %d events of the script", new_size);
+      return 0;
+    }
+    disp->script = new_script;
+    disp->script_size = new_size;
+  }
+
+  disp->script[disp->script_len++] = *event;
+  disp->script_end_reads = 0;  /* the script goes on */
+  return 1;
+}
+
+/*!
+@brief Adds key events at the end of the script (headless)
+
+@param disp   a dispc object
+@param key    combined scan code, shift state and ASCII code
+@param count  number of times the key is pressed
+@return 0 out of memory, disp->code & disp->error_msg are set
+*/
+int disp_headless_put_key(dispc_t *disp, unsigned long key, int count)
+{
+  disp_event_t ev;
+  int i;
+
+  disp_event_clear(&ev);
+  ev.t.code = EVENT_KEY;
+  ev.e.kbd.scan_code_only = SCANCODE(key);
+  ev.e.kbd.shift_state = SH_STATE(key);
+  ev.e.kbd.key = key;
+
+  for (i = 0; i < count; ++i)
+    if (!disp_headless_put_event(disp, &ev))
+      return 0;
+  return 1;
+}
+
+/*!
+@brief Adds the keys that type a text at the end of the script (headless)
+
+@param disp  a dispc object
+@param text  the text, '\\n' is Enter and '\\t' is Tab
+@return 0 out of memory, disp->code & disp->error_msg are set
+*/
+int disp_headless_put_text(dispc_t *disp, const char *text)
+{
+  for (; *text != '\0'; ++text)
+    if (!disp_headless_put_key(disp, s_disp_char_key(*text), 1))
+      return 0;
+  return 1;
+}
+
+/*!
+@brief Loads a script of events from a file (headless)
+
+A line of the file is one of:
+
+text <characters> -- keys to type the characters, the escapes \\n
+(Enter), \\t (Tab) and \\\\ are converted\n
+key <name> [count] -- a key by its name as given by disp_get_key_name(),
+"key Ctrl+End", "key Down 100"\n
+# comment
+
+@param disp       a dispc object
+@param file_name  the script file
+@return 0 failure, disp->code & disp->error_msg are set
+*/
+int disp_headless_load_script(dispc_t *disp, const char *file_name)
+{
+  FILE *f;
+  char line[1024];
+  char text[1024];
+  char name[64];
+  unsigned long key;
+  int count;
+  int line_num;
+  int r;
+
+  ASSERT(VALID_DISP(disp));
+
+  f = fopen(file_name, "r");
+  if (f == NULL)
+  {
+    disp->code = DISP_HEADLESS_SCRIPT_FAILURE;
+    snprintf(disp->error_msg, sizeof(disp->error_msg),
+             "failed to open the script %s", file_name);
+    snprintf(disp->os_error_msg, sizeof(disp->os_error_msg),
+             "%s", strerror(errno));
+    return 0;
+  }
+
+  r = 1;
+  line_num = 0;
+  while (r && fgets(line, sizeof(line), f) != NULL)
+  {
+    ++line_num;
+    line[strcspn(line, "\r\n")] = '\0';
+
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+
+    if (strncmp(line, "text ", 5) == 0)
+    {
+      s_disp_unescape(text, line + 5);
+      r = disp_headless_put_text(disp, text);
+      continue;
+    }
+
+    count = 1;
+    key = 0;
+    if (strncmp(line, "key ", 4) == 0
+        && sscanf(line + 4, "%63s %d", name, &count) >= 1)
+      key = s_disp_parse_key(name);
+    if (key == 0 || count < 1)
+    {
+      disp->code = DISP_HEADLESS_SCRIPT_FAILURE;
+      snprintf(disp->error_msg, sizeof(disp->error_msg),
+               "%s:%d: invalid line of the script", file_name, line_num);
+      r = 0;
+      break;
+    }
+    r = disp_headless_put_key(disp, key, count);
+  }
+
+  fclose(f);
+  return r;
+}
+
+/*!
+@brief Gets the statistics of the frames (headless)
+
+A frame is counted when the screen has changed between two reads of
+events. The render time of an event is from when disp_event_read()
+delivered it until disp_event_read() is called again.
+
+@param disp   a dispc object
+@param stats  receives the statistics
+*/
+void disp_headless_get_stats(dispc_t *disp, disp_headless_stats_t *stats)
+{
+  ASSERT(VALID_DISP(disp));
+
+  *stats = disp->stats;
+}
+
+/*!
+@brief Resets the statistics of the frames (headless)
+
+To measure only a part of the script, after the setup.
+
+@param disp  a dispc object
+*/
+void disp_headless_reset_stats(dispc_t *disp)
+{
+  ASSERT(VALID_DISP(disp));
+
+  memset(&disp->stats, 0, sizeof(disp->stats));
+}
+
+/*!
+@brief initial setup of display (headless)
+
+The size of the screen is from the window parameters, 80x25 when
+they don't have it.
+
+@param disp a dispc object
+@returns true for success
+@returns false for failure and error messages and code are set
+*/
+static int s_disp_init(dispc_t *disp)
+{
+  const char *script_name;
+
+  if (disp->geom_param.width <= 0 || disp->geom_param.height <= 0)
+  {
+    disp->geom_param.width = 80;
+    disp->geom_param.height = 25;
+  }
+
+  script_name = getenv("DISP_HEADLESS_SCRIPT");
+  if (script_name != NULL && *script_name != '\0')
+  {
+    if (!disp_headless_load_script(disp, script_name))
+      return 0;
+    disp->print_stats = 1;
+  }
+
+  return 1;
+}
+
+/*!
+@brief platform specific disp cleanup (headless)
+
+@param disp  a display object
+*/
+static void s_disp_done(dispc_t *disp)
+{
+  const disp_headless_stats_t *st;
+
+  if (disp->print_stats)
+  {
+    s_disp_end_frame(disp);
+    st = &disp->stats;
+    fprintf(stderr,
+            "disp_headless: %lu events, %lu frames, %lu cells, %lu rows, "
+            "%lu scrolls, render %lu us (max %lu us)\n",
+            st->events, st->frames, st->cells_changed, st->rows_changed,
+            st->scrolls, st->render_us, st->max_render_us);
+  }
+
+  if (disp->screen != NULL)
+    s_disp_free(disp, disp->screen);
+  free(disp->script);
+}
+
+/*!
+@brief Turns on or off the EVENT_TIMER_TICK (headless)
+
+s_disp_process_events() checks disp->tick_enabled between the scripted
+events, nothing more to be done here.
+
+@param disp    a dispc object
+*/
+static void s_disp_set_tick(dispc_t *disp)
+{
+}
+
+/*!
+@brief Watches a file descriptor (headless)
+
+There is no waiting, the descriptor is not watched.
+
+@param disp    a dispc object
+*/
+static void s_disp_set_watch_fd(dispc_t *disp)
+{
+}
+
+/*!
+@brief Changes the title of the window (headless)
+
+@param disp    a dispc object
+@param title   a string for the title
+*/
+static void s_disp_wnd_set_title(dispc_t *disp, const char *title)
+{
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -0,0 +1,257 @@
+/*!
+@file disp_headless_p.h
+@brief [disp] Headless in-memory implementation of the console API
+
+Private definitions specific to the headless implementation of the
+console API.
+
+@section a Header
+
+File: disp_headless_p.h\n
+COPYING: Full text of the copyrights statement at the bottom of the file\n
+Project: WW text editor\n
+Started: 18th October, 2026\n
+
+
+@section b Module disp
+
+Module disp is a standalone library that abstracts the access to
+console output for WIN32 console, WIN32 GUI, ncurses and X11.
+
+These are private data structures, function prototypes and definitions
+specific to the headless implementation of the console API.
+
+
+@section c Compile time definitions
+
+D_ASSERT -- External assert() replacement function can be supplied in the form
+of a define -- D_ASSERT. It must conform to the standard C library
+prototype of assert.
+
+DISP_MAX_PAL -- default is 128, increase for more palette entries
+
+*/
+
+#ifndef DISP_HEADLESS_P_H
+#define DISP_HEADLESS_P_H
+
+#define DISP_EVENT_QUEUE_SIZE 32
+
+struct disp_char
+{
+  char c;
+  unsigned char a;
+};
+
+#define disp_char_equal(c1, c2) (((c1).c == (c2).c) && ((c1).a == (c2).a))
+
+typedef struct disp_char disp_char_t;
+
+/*
+Colors as returned by s_disp_pal_get_standard() and
+s_disp_pal_compose_rgb(): a DOS color 0..15 or a 24-bit RGB value
+with DISP_HEADLESS_RGB set
+*/
+#define DISP_HEADLESS_RGB 0x01000000
+
+struct disp_pal
+{
+  int in_use;
+  unsigned long color;
+  unsigned long background;
+  unsigned font_style;  /* DISP_FONT_BOLD | DISP_FONT_UNDERLINE ... */
+};
+
+typedef struct disp_pal disp_pal_t;
+
+/* a cell of the screen that has never been painted */
+#define DISP_HEADLESS_UNKNOWN_ATTR 0xff
+
+struct dispc
+{
+  #ifdef _DEBUG
+  char *string_id;
+  #endif
+
+  enum disp_error code;
+  char error_msg[MAX_DISP_ERROR_MSG_LEN];
+  char os_error_msg[MAX_DISP_ERROR_MSG_LEN];
+
+  disp_wnd_param_t geom_param;
+
+  disp_char_t *char_buf;
+  int buf_height;
+  int buf_width;
+  /*
+  damage: the span of each row of char_buf changed since the last
+  flush, see s_disp_flush_damage()
+  */
+  int *damage_start;  /* -1 -- the row is unchanged */
+  int *damage_end;
+  int has_damage;
+
+  int caption_height;
+  int border_width;
+  int cursor_is_visible;
+  int window_holds_focus;
+  int paint_is_suspended;  /* wait for the first put_text */
+
+  int cursor_x;
+  int cursor_y;
+
+  void (*handle_resize)(disp_event_t *ev, void *ctx);
+  void *handle_resize_ctx;
+
+  int last_width;
+  int last_height;
+  int last_x;
+  int last_y;
+
+  disp_pal_t palette[DISP_MAX_PAL];
+
+  /*
+  The screen: what a terminal would show after the last flush
+  */
+  disp_char_t *screen;
+  int screen_width;
+  int screen_height;
+
+  /*
+  The script: events for disp_event_read() in the order they are
+  delivered. Kept with the libc's malloc(), it can be filled before
+  disp_set_safemem_proc()
+  */
+  disp_event_t *script;
+  int script_len;
+  int script_size;
+  int script_pos;
+  int script_end_reads;  /* disp_event_read() calls past the end */
+  int tick_is_due;  /* EVENT_TIMER_TICK goes between the scripted events */
+  int print_stats;  /* the script is from DISP_HEADLESS_SCRIPT */
+
+  /*
+  Statistics of the frames, frame_cells, frame_rows and frame_scrolls
+  are the changes since the last event was delivered
+  */
+  disp_headless_stats_t stats;
+  unsigned long frame_cells;
+  unsigned long frame_rows;
+  unsigned long frame_scrolls;
+  int render_is_timed;  /* an event is out, until the next read */
+  unsigned long event_time_us;  /* when the event was delivered */
+
+  unsigned int ev_c;
+  unsigned int ev_h;
+  unsigned int ev_t;
+  disp_event_t ev_q[DISP_EVENT_QUEUE_SIZE];
+  int ctrl_is_released;
+
+  /*
+  elapsed time
+  */
+  int time_elapsed;
+  int hours;
+  int minutes;
+  int seconds;
+  int win32_timer_id;
+  int tick_enabled;  /* send EVENT_TIMER_TICK */
+  int tick_users;  /* disp_set_tick() calls to enable */
+  int idle_time;
+  int watch_fd;
+  int watch_fd_armed;
+
+  /*
+  memory manager
+  */
+  void *(*safe_malloc)(size_t size);
+  void (*safe_free)(void *buf);
+};
+
+struct disp_char_buf
+{
+  #ifdef _DEBUG
+  unsigned char magic_byte;
+  #define DISP_CHAR_BUF_MAGIC 0x63
+  #endif
+
+  int max_characters;
+
+  disp_char_t cbuf[0];
+};
+
+/* To be used in ASSERT()! */
+#ifdef _DEBUG
+int disp_is_valid(const dispc_t *disp);
+#define VALID_DISP(disp) (disp_is_valid(disp))
+#else
+#define VALID_DISP(disp) (1)
+#endif
+
+/*
+External assert() replacement function can be supplied in the form
+of a define -- D_ASSERT. It must conform to the standard C library
+prototype of assert.
+*/
+#ifdef _DEBUG
+
+#ifdef D_ASSERT
+
+/* Link to external assert() replacement */
+extern void D_ASSERT(const char *cond, const char *name, unsigned int line);
+#define D_ASSERT_WRAP(x) (void)((x) || (D_ASSERT(#x, __FILE__, __LINE__), 0))
+#define ASSERT(x) D_ASSERT_WRAP(x)
+
+#else
+
+/* Fall back to standard C assert */
+#include <assert.h>
+#define ASSERT(x) assert(x)
+
+#endif
+
+#else
+
+#define ASSERT(x)
+
+#endif  /* ifdef _DEBUG */
+
+#ifdef _UNICODE
+#  define _T( x )     L ## x
+#else
+#  define _T( x )     x
+#endif
+
+#endif  /* ifndef DISP_HEADLESS_P_H */
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -90,6 +90,13 @@ struct dispc
   disp_char_t *char_buf;
   int buf_height;
   int buf_width;
+  /*
+  damage: the span of each row of char_buf changed since the last
+  flush, see s_disp_flush_damage()
+  */
+  int *damage_start;  /* -1 -- the row is unchanged */
+  int *damage_end;
+  int has_damage;
 
   int caption_height;
   int border_width;
@@ -110,6 +117,15 @@ struct dispc
 
   disp_pal_t palette[DISP_MAX_PAL];
   disp_attr_t color_pairs[DISP_MAX_NCURS_ATTR];
+  /*
+  COLOR_PAIR() | attr_mask of each palette entry, set by s_disp_pal_add(),
+  s_disp_validate_rect() ORs it with the character
+  */
+  chtype pal_attr[DISP_MAX_PAL];
+
+  /* a row for mvaddchnstr(), kept between the calls */
+  chtype *ncurs_buf;
+  int ncurs_buf_width;
 
   unsigned int ev_c;
   unsigned int ev_h;
@@ -125,6 +141,19 @@ struct dispc
   int minutes;
   int seconds;
   int win32_timer_id;
+  int tick_enabled;  /* send EVENT_TIMER_TICK */
+  int tick_users;  /* disp_set_tick() calls to enable */
+  int idle_time;  /* towards EVENT_TIMER_5SEC, kept over EVENT_TIMER_TICK */
+  int watch_fd;  /* send EVENT_WATCH_FD when readable */
+  int watch_fd_armed;
+
+  /*
+  bracketed paste: the text between ESC[200~ and ESC[201~, sent as
+  one EVENT_CLIPBOARD_PASTE
+  */
+  char *paste_buf;
+  int paste_len;
+  int paste_size;
 
   /*
   memory manager
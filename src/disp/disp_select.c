@@ -0,0 +1,332 @@
+/*!
+@file disp_select.c
+@brief [disp] Runtime selection between the terminal implementations
+
+@section a Header
+
+File: disp_select.c\n
+COPYING: Full text of the copyrights statement at the bottom of the file\n
+Project: WW text editor\n
+Started: 18th October, 2026\n
+
+
+@section b Module disp
+
+Module disp is a standalone library that abstracts the access to
+console output for WIN32 console, WIN32 GUI, ncurses and X11.
+
+This is an implementation of the API described in disp.h that forwards
+each call to the ncurses (disp_ncurs.c) or the VT/ANSI (disp_vt.c)
+implementation. Both are built into the program, the environment
+variable DISP_BACKEND chooses one at startup:
+
+DISP_BACKEND=vt -- the VT/ANSI terminal implementation\n
+DISP_BACKEND=ncurs -- ncurses, also when the variable is not set\n
+
+The choice is made at the first call, normally disp_obj_size(), and
+stays for the life of the program.
+
+
+@section c Compile time definitions
+
+DISP_SELECT -- this file is built only with the runtime selection, see
+disp_select_p.h
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "disp_select_p.h"
+
+static const disp_backend_t *s_backend;
+
+/*!
+@brief Returns the implementation chosen by DISP_BACKEND (select)
+*/
+static const disp_backend_t *s_disp_backend(void)
+{
+  const char *name;
+
+  if (s_backend == NULL)
+  {
+    name = getenv("DISP_BACKEND");
+    if (name != NULL && strcmp(name, vt_disp_backend.name) == 0)
+      s_backend = &vt_disp_backend;
+    else
+      s_backend = &ncurs_disp_backend;
+  }
+  return s_backend;
+}
+
+/*
+The API of disp.h, see disp_common.c for the descriptions
+*/
+
+int disp_obj_size(void)
+{
+  return s_disp_backend()->obj_size();
+}
+
+int disp_init(const disp_wnd_param_t *wnd_param, void *disp_obj)
+{
+  return s_disp_backend()->init(wnd_param, disp_obj);
+}
+
+void disp_done(dispc_t *disp)
+{
+  s_disp_backend()->done(disp);
+}
+
+void disp_error_get(dispc_t *disp, enum disp_error *code,
+                    char **error, char **os_error)
+{
+  s_disp_backend()->error_get(disp, code, error, os_error);
+}
+
+void disp_error_clear(dispc_t *disp)
+{
+  s_disp_backend()->error_clear(disp);
+}
+
+void disp_set_safemem_proc(dispc_t *disp,
+                           void *(*safe_malloc)(size_t size),
+                           void (*safe_free)(void *buf))
+{
+  s_disp_backend()->set_safemem_proc(disp, safe_malloc, safe_free);
+}
+
+void disp_wnd_set_param(dispc_t *disp, const disp_wnd_param_t *wnd_param)
+{
+  s_disp_backend()->wnd_set_param(disp, wnd_param);
+}
+
+void disp_wnd_get_param(const dispc_t *disp, disp_wnd_param_t *wnd_param)
+{
+  s_disp_backend()->wnd_get_param(disp, wnd_param);
+}
+
+int disp_wnd_get_width(const dispc_t *disp)
+{
+  return s_disp_backend()->wnd_get_width(disp);
+}
+
+int disp_wnd_get_height(const dispc_t *disp)
+{
+  return s_disp_backend()->wnd_get_height(disp);
+}
+
+void disp_set_resize_handler(dispc_t *disp,
+                             void (*handle_resize)(struct disp_event *ev,
+                                                   void *ctx),
+                             void *handle_resize_ctx)
+{
+  s_disp_backend()->set_resize_handler(disp, handle_resize, handle_resize_ctx);
+}
+
+unsigned long disp_pal_get_standard(const dispc_t *disp, int color)
+{
+  return s_disp_backend()->pal_get_standard(disp, color);
+}
+
+unsigned long disp_pal_compose_rgb(const dispc_t *disp, int r, int g, int b)
+{
+  return s_disp_backend()->pal_compose_rgb(disp, r, g, b);
+}
+
+int disp_pal_add(dispc_t *disp,
+                 unsigned long rgb_color, unsigned long rgb_background,
+                 unsigned font_style, int *palette_id)
+{
+  return s_disp_backend()->pal_add(disp, rgb_color, rgb_background,
+                                   font_style, palette_id);
+}
+
+void disp_pal_free(dispc_t *disp, int palette_id)
+{
+  s_disp_backend()->pal_free(disp, palette_id);
+}
+
+void disp_cbuf_reset(const dispc_t *disp, disp_char_buf_t *cbuf,
+                     int max_characters)
+{
+  s_disp_backend()->cbuf_reset(disp, cbuf, max_characters);
+}
+
+void disp_cbuf_mark_invalid(const dispc_t *disp, disp_char_buf_t *cbuf)
+{
+  s_disp_backend()->cbuf_mark_invalid(disp, cbuf);
+}
+
+void disp_cbuf_put_char(const dispc_t *disp,
+                        disp_char_buf_t *dest_buf, int index, char c)
+{
+  s_disp_backend()->cbuf_put_char(disp, dest_buf, index, c);
+}
+
+void disp_cbuf_put_attr(const dispc_t *disp,
+                        disp_char_buf_t *dest_buf, int index, int attr)
+{
+  s_disp_backend()->cbuf_put_attr(disp, dest_buf, index, attr);
+}
+
+void disp_cbuf_put_char_attr(const dispc_t *disp,
+                             disp_char_buf_t *dest_buf,
+                             int index, int c, int attr)
+{
+  s_disp_backend()->cbuf_put_char_attr(disp, dest_buf, index, c, attr);
+}
+
+int disp_calc_rect_size(const dispc_t *disp, int width, int height)
+{
+  return s_disp_backend()->calc_rect_size(disp, width, height);
+}
+
+void disp_put_block(dispc_t *disp,
+                    int x, int y, int w, int h, const disp_char_buf_t *buf)
+{
+  s_disp_backend()->put_block(disp, x, y, w, h, buf);
+}
+
+void disp_get_block(const dispc_t *disp,
+                    int x, int y, int w, int h, disp_char_buf_t *buf)
+{
+  s_disp_backend()->get_block(disp, x, y, w, h, buf);
+}
+
+void disp_write(dispc_t *disp,
+                const char *s, int x, int y, int attr)
+{
+  s_disp_backend()->write(disp, s, x, y, attr);
+}
+
+void disp_flex_write(dispc_t *disp,
+                     const char *s, int x, int y, int attr1, int attr2)
+{
+  s_disp_backend()->flex_write(disp, s, x, y, attr1, attr2);
+}
+
+void disp_fill(dispc_t *disp, char c, int attr, int x, int y, int count)
+{
+  s_disp_backend()->fill(disp, c, attr, x, y, count);
+}
+
+void disp_scroll_rows(dispc_t *disp, int y, int h, int n)
+{
+  s_disp_backend()->scroll_rows(disp, y, h, n);
+}
+
+void disp_cursor_hide(dispc_t *disp)
+{
+  s_disp_backend()->cursor_hide(disp);
+}
+
+void disp_cursor_goto_xy(dispc_t *disp, int x, int y)
+{
+  s_disp_backend()->cursor_goto_xy(disp, x, y);
+}
+
+void disp_cursor_get_xy(dispc_t *disp, int *x, int *y)
+{
+  s_disp_backend()->cursor_get_xy(disp, x, y);
+}
+
+void disp_cursor_get_param(dispc_t *disp,
+                           disp_cursor_param_t *cparam)
+{
+  s_disp_backend()->cursor_get_param(disp, cparam);
+}
+
+void disp_cursor_restore_param(dispc_t *disp,
+                               const disp_cursor_param_t *cparam)
+{
+  s_disp_backend()->cursor_restore_param(disp, cparam);
+}
+
+void disp_wnd_set_title(dispc_t *disp, const char *title)
+{
+  s_disp_backend()->wnd_set_title(disp, title);
+}
+
+int disp_event_read(dispc_t *disp, disp_event_t *event)
+{
+  return s_disp_backend()->event_read(disp, event);
+}
+
+int disp_event_pending(dispc_t *disp)
+{
+  return s_disp_backend()->event_pending(disp);
+}
+
+void disp_event_clear(disp_event_t *event)
+{
+  s_disp_backend()->event_clear(event);
+}
+
+int disp_event_is_valid(const disp_event_t *event)
+{
+  return s_disp_backend()->event_is_valid(event);
+}
+
+void disp_get_key_name(dispc_t *disp,
+  unsigned long key, char *key_name_buf, int buf_size)
+{
+  s_disp_backend()->get_key_name(disp, key, key_name_buf, buf_size);
+}
+
+void disp_elapsed_time_get(dispc_t *disp, disp_elapsed_time_t *t)
+{
+  s_disp_backend()->elapsed_time_get(disp, t);
+}
+
+void disp_elapsed_time_set(dispc_t *disp, const disp_elapsed_time_t *t)
+{
+  s_disp_backend()->elapsed_time_set(disp, t);
+}
+
+unsigned long disp_get_tick_ms(dispc_t *disp)
+{
+  return s_disp_backend()->get_tick_ms(disp);
+}
+
+void disp_set_tick(dispc_t *disp, int tick_enabled)
+{
+  s_disp_backend()->set_tick(disp, tick_enabled);
+}
+
+void disp_set_watch_fd(dispc_t *disp, int fd)
+{
+  s_disp_backend()->set_watch_fd(disp, fd);
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -0,0 +1,221 @@
+/*!
+@file disp_select_p.h
+@brief [disp] Runtime selection between the terminal implementations
+
+Private definitions for building more than one implementation of the
+console API into the program and choosing one of them at startup.
+
+@section a Header
+
+File: disp_select_p.h\n
+COPYING: Full text of the copyrights statement at the bottom of the file\n
+Project: WW text editor\n
+Started: 18th October, 2026\n
+
+
+@section b Module disp
+
+Module disp is a standalone library that abstracts the access to
+console output for WIN32 console, WIN32 GUI, ncurses and X11.
+
+Each implementation is compiled with DISP_SELECT_PREFIX defined and
+includes this file before disp.h. Its API functions are then renamed
+from disp_xxx to <prefix>_disp_xxx and disp_common.c fills with them
+the table <prefix>_disp_backend. disp_select.c implements disp.h by
+calling through the table of the implementation chosen at startup.
+
+
+@section c Compile time definitions
+
+DISP_SELECT -- build the program with the runtime selection.
+
+DISP_SELECT_PREFIX -- defined by an implementation before it includes
+this file, ncurs or vt.
+
+*/
+
+#ifndef DISP_SELECT_P_H
+#define DISP_SELECT_P_H
+
+#ifdef DISP_SELECT_PREFIX
+
+#define DISP_SELECT_NAME2(prefix, name) prefix##_disp_##name
+#define DISP_SELECT_NAME1(prefix, name) DISP_SELECT_NAME2(prefix, name)
+#define DISP_SELECT_NAME(name) DISP_SELECT_NAME1(DISP_SELECT_PREFIX, name)
+#define DISP_SELECT_STR2(x) #x
+#define DISP_SELECT_STR(x) DISP_SELECT_STR2(x)
+
+#define disp_obj_size              DISP_SELECT_NAME(obj_size)
+#define disp_init                  DISP_SELECT_NAME(init)
+#define disp_done                  DISP_SELECT_NAME(done)
+#define disp_error_get             DISP_SELECT_NAME(error_get)
+#define disp_error_clear           DISP_SELECT_NAME(error_clear)
+#define disp_set_safemem_proc      DISP_SELECT_NAME(set_safemem_proc)
+#define disp_wnd_set_param         DISP_SELECT_NAME(wnd_set_param)
+#define disp_wnd_get_param         DISP_SELECT_NAME(wnd_get_param)
+#define disp_wnd_get_width         DISP_SELECT_NAME(wnd_get_width)
+#define disp_wnd_get_height        DISP_SELECT_NAME(wnd_get_height)
+#define disp_set_resize_handler    DISP_SELECT_NAME(set_resize_handler)
+#define disp_pal_get_standard      DISP_SELECT_NAME(pal_get_standard)
+#define disp_pal_compose_rgb       DISP_SELECT_NAME(pal_compose_rgb)
+#define disp_pal_add               DISP_SELECT_NAME(pal_add)
+#define disp_pal_free              DISP_SELECT_NAME(pal_free)
+#define disp_cbuf_reset            DISP_SELECT_NAME(cbuf_reset)
+#define disp_cbuf_mark_invalid     DISP_SELECT_NAME(cbuf_mark_invalid)
+#define disp_cbuf_put_char         DISP_SELECT_NAME(cbuf_put_char)
+#define disp_cbuf_put_attr         DISP_SELECT_NAME(cbuf_put_attr)
+#define disp_cbuf_put_char_attr    DISP_SELECT_NAME(cbuf_put_char_attr)
+#define disp_calc_rect_size        DISP_SELECT_NAME(calc_rect_size)
+#define disp_put_block             DISP_SELECT_NAME(put_block)
+#define disp_get_block             DISP_SELECT_NAME(get_block)
+#define disp_write                 DISP_SELECT_NAME(write)
+#define disp_flex_write            DISP_SELECT_NAME(flex_write)
+#define disp_fill                  DISP_SELECT_NAME(fill)
+#define disp_scroll_rows           DISP_SELECT_NAME(scroll_rows)
+#define disp_cursor_hide           DISP_SELECT_NAME(cursor_hide)
+#define disp_cursor_goto_xy        DISP_SELECT_NAME(cursor_goto_xy)
+#define disp_cursor_get_xy         DISP_SELECT_NAME(cursor_get_xy)
+#define disp_cursor_get_param      DISP_SELECT_NAME(cursor_get_param)
+#define disp_cursor_restore_param  DISP_SELECT_NAME(cursor_restore_param)
+#define disp_wnd_set_title         DISP_SELECT_NAME(wnd_set_title)
+#define disp_event_read            DISP_SELECT_NAME(event_read)
+#define disp_event_pending         DISP_SELECT_NAME(event_pending)
+#define disp_event_clear           DISP_SELECT_NAME(event_clear)
+#define disp_event_is_valid        DISP_SELECT_NAME(event_is_valid)
+#define disp_get_key_name          DISP_SELECT_NAME(get_key_name)
+#define disp_elapsed_time_get      DISP_SELECT_NAME(elapsed_time_get)
+#define disp_elapsed_time_set      DISP_SELECT_NAME(elapsed_time_set)
+#define disp_get_tick_ms           DISP_SELECT_NAME(get_tick_ms)
+#define disp_set_tick              DISP_SELECT_NAME(set_tick)
+#define disp_set_watch_fd          DISP_SELECT_NAME(set_watch_fd)
+#define disp_is_valid              DISP_SELECT_NAME(is_valid)
+
+#endif  /* ifdef DISP_SELECT_PREFIX */
+
+#include "disp.h"
+
+/*
+The API functions of one implementation, in the order of disp.h
+*/
+typedef struct disp_backend disp_backend_t;
+
+struct disp_backend
+{
+  const char *name;
+
+  int  (*obj_size)(void);
+  int  (*init)(const disp_wnd_param_t *wnd_param, void *disp_obj);
+  void (*done)(dispc_t *disp);
+
+  void (*error_get)(dispc_t *disp, enum disp_error *code,
+                    char **error, char **os_error);
+  void (*error_clear)(dispc_t *disp);
+
+  void (*set_safemem_proc)(dispc_t *disp,
+                           void *(*safe_malloc)(size_t size),
+                           void (*safe_free)(void *buf));
+
+  void (*wnd_set_param)(dispc_t *disp, const disp_wnd_param_t *wnd_param);
+  void (*wnd_get_param)(const dispc_t *disp, disp_wnd_param_t *wnd_param);
+  int  (*wnd_get_width)(const dispc_t *disp);
+  int  (*wnd_get_height)(const dispc_t *disp);
+
+  void (*set_resize_handler)(dispc_t *disp,
+                             void (*handle_resize)(struct disp_event *ev,
+                                                   void *ctx),
+                             void *handle_resize_ctx);
+
+  unsigned long (*pal_get_standard)(const dispc_t *disp, int color);
+  unsigned long (*pal_compose_rgb)(const dispc_t *disp, int r, int g, int b);
+  int  (*pal_add)(dispc_t *disp,
+                  unsigned long rgb_color, unsigned long rgb_background,
+                  unsigned font_style, int *palette_id);
+  void (*pal_free)(dispc_t *disp, int palette_id);
+
+  void (*cbuf_reset)(const dispc_t *disp, disp_char_buf_t *cbuf,
+                     int max_characters);
+  void (*cbuf_mark_invalid)(const dispc_t *disp, disp_char_buf_t *cbuf);
+  void (*cbuf_put_char)(const dispc_t *disp,
+                        disp_char_buf_t *dest_buf, int index, char c);
+  void (*cbuf_put_attr)(const dispc_t *disp,
+                        disp_char_buf_t *dest_buf, int index, int attr);
+  void (*cbuf_put_char_attr)(const dispc_t *disp,
+                             disp_char_buf_t *dest_buf,
+                             int index, int c, int attr);
+
+  int  (*calc_rect_size)(const dispc_t *disp, int width, int height);
+
+  void (*put_block)(dispc_t *disp,
+                    int x, int y, int w, int h, const disp_char_buf_t *buf);
+  void (*get_block)(const dispc_t *disp,
+                    int x, int y, int w, int h, disp_char_buf_t *buf);
+
+  void (*write)(dispc_t *disp, const char *s, int x, int y, int attr);
+  void (*flex_write)(dispc_t *disp,
+                     const char *s, int x, int y, int attr1, int attr2);
+  void (*fill)(dispc_t *disp, char c, int attr, int x, int y, int count);
+  void (*scroll_rows)(dispc_t *disp, int y, int h, int n);
+
+  void (*cursor_hide)(dispc_t *disp);
+  void (*cursor_goto_xy)(dispc_t *disp, int x, int y);
+  void (*cursor_get_xy)(dispc_t *disp, int *x, int *y);
+  void (*cursor_get_param)(dispc_t *disp, disp_cursor_param_t *cparam);
+  void (*cursor_restore_param)(dispc_t *disp,
+                               const disp_cursor_param_t *cparam);
+
+  void (*wnd_set_title)(dispc_t *disp, const char *title);
+
+  int  (*event_read)(dispc_t *disp, disp_event_t *event);
+  int  (*event_pending)(dispc_t *disp);
+  void (*event_clear)(disp_event_t *event);
+  int  (*event_is_valid)(const disp_event_t *event);
+
+  void (*get_key_name)(dispc_t *disp,
+                       unsigned long key, char *key_name_buf, int buf_size);
+
+  void (*elapsed_time_get)(dispc_t *disp, disp_elapsed_time_t *t);
+  void (*elapsed_time_set)(dispc_t *disp, const disp_elapsed_time_t *t);
+  unsigned long (*get_tick_ms)(dispc_t *disp);
+
+  void (*set_tick)(dispc_t *disp, int tick_enabled);
+
+  void (*set_watch_fd)(dispc_t *disp, int fd);
+};
+
+extern const disp_backend_t ncurs_disp_backend;
+extern const disp_backend_t vt_disp_backend;
+
+#endif  /* ifndef DISP_SELECT_P_H */
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
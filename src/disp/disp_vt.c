@@ -0,0 +1,908 @@
+/*!
+@file disp_vt.c
+@brief [disp] VT/ANSI terminal implementation of the console API
+
+@section a Header
+
+File: disp_vt.c\n
+COPYING: Full text of the copyrights statement at the bottom of the file\n
+Project: WW text editor\n
+Started: 18th October, 2026\n
+
+
+@section b Module disp
+
+Module disp is a standalone library that abstracts the access to
+console output for WIN32 console, WIN32 GUI, ncurses and X11.
+
+This is an implementation of the API described in disp.h that writes
+VT100/ANSI escape sequences directly to the terminal, without ncurses.
+
+The backend keeps in term_buf a copy of what the terminal shows.
+s_disp_validate_rect() compares char_buf against it and only the cells
+that differ are sent, with the shortest cursor motion and only the SGR
+parameters that change. The output of a frame is collected in out_buf
+and sent with one write() by s_disp_refresh().
+
+Colors: the 16 DOS colors map to the ANSI colors 30..37 and 90..97,
+s_disp_pal_compose_rgb() gives 24-bit colors (SGR 38;2;r;g;b).
+
+
+@section c Compile time definitions
+
+D_ASSERT -- External assert() replacement function can be supplied in the form
+of a define -- D_ASSERT. It must conform to the standard C library
+prototype of assert.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <errno.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <sys/time.h>
+
+#ifdef DISP_SELECT
+/* built together with the other terminal implementation */
+#define DISP_SELECT_PREFIX vt
+#include "disp_select_p.h"
+#endif
+#include "disp.h"
+#include "disp_vt_p.h"
+
+/* The top level API, platform independent part */
+#include "disp_common.c"
+
+#define DISP_FONT_STYLE_BITS (DISP_FONT_ITALIC | DISP_FONT_BOLD | DISP_FONT_UNDERLINE | DISP_FONT_REVERSE)
+
+/*!
+@brief Appends to the output of the frame (vt)
+
+On out of memory the output is dropped and the next s_disp_refresh()
+paints the whole screen again.
+
+@param disp  a dispc object
+@param s     characters to send
+@param len   number of characters
+*/
+static void s_disp_out(dispc_t *disp, const char *s, int len)
+{
+  char *new_buf;
+  int new_size;
+
+  if (disp->out_failed)
+    return;
+
+  if (disp->out_len + len > disp->out_size)
+  {
+    new_size = disp->out_size == 0 ? 16384 : disp->out_size * 2;
+    while (new_size < disp->out_len + len)
+      new_size *= 2;
+    new_buf = s_disp_malloc(disp, new_size);
+    if (new_buf == NULL)
+    {
+      disp->out_failed = 1;
+      disp->out_len = 0;
+      return;
+    }
+    if (disp->out_buf != NULL)
+    {
+      memcpy(new_buf, disp->out_buf, disp->out_len);
+      s_disp_free(disp, disp->out_buf);
+    }
+    disp->out_buf = new_buf;
+    disp->out_size = new_size;
+  }
+
+  memcpy(disp->out_buf + disp->out_len, s, len);
+  disp->out_len += len;
+}
+
+/*!
+@brief Appends a string to the output of the frame (vt)
+
+@param disp  a dispc object
+@param s     asciiz string
+*/
+static void s_disp_out_str(dispc_t *disp, const char *s)
+{
+  s_disp_out(disp, s, strlen(s));
+}
+
+/*!
+@brief Writes to the terminal (vt)
+
+@param s     characters to send
+@param len   number of characters
+*/
+static void s_disp_write(const char *s, int len)
+{
+  int pos;
+  int r;
+
+  pos = 0;
+  while (pos < len)
+  {
+    r = write(STDOUT_FILENO, s + pos, len - pos);
+    if (r < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;  /* the terminal is gone */
+    }
+    pos += r;
+  }
+}
+
+/*!
+@brief Writes a string to the terminal (vt)
+
+@param s     asciiz string
+*/
+static void s_disp_write_str(const char *s)
+{
+  s_disp_write(s, strlen(s));
+}
+
+/*!
+@brief Sends the output of the frame to the terminal with one write() (vt)
+
+@param disp  a dispc object
+*/
+static void s_disp_out_flush(dispc_t *disp)
+{
+  s_disp_write(disp->out_buf, disp->out_len);
+  disp->out_len = 0;
+}
+
+/*!
+@brief Adds new entry to the palette
+
+@param disp a dispc object
+@param color       foreground color, from s_disp_pal_get_standard() or
+                   s_disp_pal_compose_rgb()
+@param background  background color
+@param font_style      bit mask for font style
+@param *palette_id     returns here a handle to palette entry
+@return 0 error, disp->code & disp->error_msg are set
+*/
+static int s_disp_pal_add(dispc_t *disp,
+                 unsigned int color, unsigned int background,
+                 unsigned font_style, int *palette_id)
+{
+  int i;
+
+  /* check: only valid bits are set */
+  ASSERT((font_style & DISP_FONT_STYLE_BITS) == font_style);
+  ASSERT(palette_id != NULL);
+
+  for (i = 0; i < DISP_COUNTOF(disp->palette); ++i)
+  {
+    if (disp->palette[i].in_use)
+      continue;
+    if (i == DISP_VT_UNKNOWN_ATTR)
+      break;  /* reserved to mark term_buf cells */
+    disp->palette[i].in_use = 1;
+    disp->palette[i].color = color;
+    disp->palette[i].background = background;
+    disp->palette[i].font_style = font_style;
+    *palette_id = i;
+    return 1;
+  }
+
+  /* no space in the palette table */
+  disp->code = DISP_PALETTE_FULL;
+  snprintf(disp->error_msg, sizeof(disp->error_msg),
+           "no more entries available in the palette table");
+  return 0;
+}
+
+/*!
+@brief Disposes of one palette entry.
+
+@param disp        a dispc object
+@param palette_id  id of palette entry from disp_pal_add()
+*/
+static void s_disp_pal_free(dispc_t *disp, int palette_id)
+{
+  disp->palette[palette_id].in_use = 0;
+  if (disp->term_attr == palette_id)
+    disp->term_attr = -1;
+}
+
+/*!
+@brief Finds if specific palette entry is within range
+
+@param disp        a dispc object
+@param palette_id  palette ID of display attribute
+*/
+static int s_disp_palette_id_is_valid(const dispc_t *disp, int palette_id)
+{
+  DISP_REFERENCE(disp);
+  return (palette_id < DISP_COUNTOF(disp->palette) && palette_id >= 0);
+}
+
+/*!
+@brief Platform dependent color
+
+@param disp   a dispc object
+@param color  one of the original 16 DOS colors
+
+@returns platrorm dependent color value
+*/
+static unsigned long s_disp_pal_get_standard(const dispc_t *disp, int color)
+{
+  DISP_REFERENCE(disp);
+  ASSERT(color >= 0);
+  ASSERT(color <= 0x0f);
+
+  return color;  /* mapped to ANSI colors in s_disp_sgr_color() */
+}
+
+/*!
+@brief  Platform dependent color
+
+For RGB of standard 16 DOS colors use disp_pal_standard().
+
+@param disp   a dispc object
+@param r      red component
+@param g      green component
+@param b      blue component
+
+@returns platrorm dependent color value
+*/
+static unsigned long s_disp_pal_compose_rgb(const dispc_t *disp,
+                                            int r, int g, int b)
+{
+  DISP_REFERENCE(disp);
+
+  return DISP_VT_RGB | ((r & 0xff) << 16) | ((g & 0xff) << 8) | (b & 0xff);
+}
+
+/*!
+@brief Composes the SGR parameter of a color (vt)
+
+@param buf            receives the parameter, without separators
+@param color          DOS color or DISP_VT_RGB
+@param is_background  color is for the background
+*/
+static void s_disp_sgr_color(char *buf, unsigned long color, int is_background)
+{
+  /* Use PC color as index to get ANSI color number */
+  static const unsigned char PC_TO_ANSI[8] = {0, 4, 2, 6, 1, 5, 3, 7};
+
+  if (color & DISP_VT_RGB)
+  {
+    sprintf(buf, "%d;2;%lu;%lu;%lu", is_background ? 48 : 38,
+            (color >> 16) & 0xff, (color >> 8) & 0xff, color & 0xff);
+    return;
+  }
+
+  ASSERT(color <= 0x0f);
+  if (color >= 8)  /* the bright colors */
+    sprintf(buf, "%d", (is_background ? 100 : 90) + PC_TO_ANSI[color - 8]);
+  else
+    sprintf(buf, "%d", (is_background ? 40 : 30) + PC_TO_ANSI[color]);
+}
+
+/*!
+@brief Sends the SGR parameters to switch to a palette entry (vt)
+
+Only the parameters that differ from disp->term_attr are sent. When a
+font style has to be turned off, SGR 0 resets all and the entry is
+sent complete.
+
+@param disp  a dispc object
+@param a     palette entry
+*/
+static void s_disp_set_attr(dispc_t *disp, int a)
+{
+  static const struct
+  {
+    unsigned font_style;
+    const char *sgr;
+  } styles[] =
+  {
+    {DISP_FONT_BOLD, "1"},
+    {DISP_FONT_ITALIC, "3"},
+    {DISP_FONT_UNDERLINE, "4"},
+    {DISP_FONT_REVERSE, "7"}
+  };
+  const disp_pal_t *new_pal;
+  const disp_pal_t *old_pal;
+  char buf[128];
+  char *p;
+  int reset;
+  int i;
+
+  if (disp->term_attr == a)
+    return;
+
+  ASSERT(a < DISP_COUNTOF(disp->palette));
+  ASSERT(disp->palette[a].in_use);
+  new_pal = &disp->palette[a];
+  old_pal = NULL;
+  if (disp->term_attr != -1)
+    old_pal = &disp->palette[disp->term_attr];
+  reset = old_pal == NULL
+          || (old_pal->font_style & ~new_pal->font_style) != 0;
+
+  strcpy(buf, "\033[");
+  p = buf + 2;
+  if (reset)
+  {
+    *p++ = '0';
+    *p++ = ';';
+  }
+  for (i = 0; i < DISP_COUNTOF(styles); ++i)
+  {
+    if ((new_pal->font_style & styles[i].font_style) == 0)
+      continue;
+    if (!reset && (old_pal->font_style & styles[i].font_style) != 0)
+      continue;
+    strcpy(p, styles[i].sgr);
+    p += strlen(p);
+    *p++ = ';';
+  }
+  if (reset || old_pal->color != new_pal->color)
+  {
+    s_disp_sgr_color(p, new_pal->color, 0);
+    p += strlen(p);
+    *p++ = ';';
+  }
+  if (reset || old_pal->background != new_pal->background)
+  {
+    s_disp_sgr_color(p, new_pal->background, 1);
+    p += strlen(p);
+    *p++ = ';';
+  }
+  if (p[-1] == ';')
+    --p;
+  *p++ = 'm';
+  s_disp_out(disp, buf, p - buf);
+  disp->term_attr = a;
+}
+
+/*!
+@brief Maps a character of char_buf to what is sent to the terminal (vt)
+
+@param disp  a dispc object
+@param c     character from char_buf
+*/
+static char s_disp_vt_char(const dispc_t *disp, char c)
+{
+  unsigned char uc;
+
+  uc = (unsigned char)c;
+  if (uc < 0x20 || uc == 0x7f)
+    return '?';  /* control characters would move the cursor */
+  if (uc >= 0x80 && disp->utf8)
+    return '?';  /* a byte of a UTF-8 sequence, the width is unknown */
+  return c;
+}
+
+/*!
+@brief Moves the terminal cursor with the shortest sequence (vt)
+
+@param disp  a dispc object
+@param x     destination
+@param y     destination
+*/
+static void s_disp_move(dispc_t *disp, int x, int y)
+{
+  disp_char_t *term_ln;
+  char buf[32];
+  int i;
+
+  if (disp->term_y == y && disp->term_x == x)
+    return;
+
+  if (disp->term_y == y && disp->term_x >= 0)
+  {
+    /*
+    A short gap in the same row: send again what the terminal already
+    shows, if it is in the current SGR
+    */
+    if (x > disp->term_x && x - disp->term_x <= 4)
+    {
+      term_ln = disp->term_buf + y * disp->term_width;
+      for (i = disp->term_x; i < x; ++i)
+        if (term_ln[i].a != disp->term_attr)
+          break;
+      if (i == x)
+      {
+        for (i = disp->term_x; i < x; ++i)
+          buf[i - disp->term_x] = s_disp_vt_char(disp, term_ln[i].c);
+        s_disp_out(disp, buf, x - disp->term_x);
+        disp->term_x = x;
+        return;
+      }
+    }
+
+    if (x == 0)
+      strcpy(buf, "\r");
+    else if (x > disp->term_x)
+      sprintf(buf, "\033[%dC", x - disp->term_x);
+    else
+      sprintf(buf, "\033[%dG", x + 1);
+  }
+  else if (disp->term_y >= 0 && y == disp->term_y + 1 && x == 0)
+    strcpy(buf, "\r\n");  /* y is not the last row, no scroll */
+  else if (disp->term_y >= 0 && disp->term_x == x)
+    sprintf(buf, "\033[%dd", y + 1);
+  else if (x == 0)
+    sprintf(buf, "\033[%dH", y + 1);
+  else
+    sprintf(buf, "\033[%d;%dH", y + 1, x + 1);
+
+  s_disp_out_str(disp, buf);
+  disp->term_x = x;
+  disp->term_y = y;
+}
+
+/*!
+@brief Forgets what the terminal shows, the next frame paints everything (vt)
+
+@param disp  a dispc object
+*/
+static void s_disp_term_buf_invalidate(dispc_t *disp)
+{
+  int i;
+
+  for (i = 0; i < disp->term_width * disp->term_height; ++i)
+  {
+    disp->term_buf[i].c = ' ';
+    disp->term_buf[i].a = DISP_VT_UNKNOWN_ATTR;
+  }
+  disp->term_x = -1;
+  disp->term_y = -1;
+  disp->term_attr = -1;
+}
+
+/*!
+@brief Allocates term_buf for the current window size (vt)
+
+term_buf can't be allocated at s_disp_init() time for the same reason as
+char_buf, see s_disp_alloc_char_buf().
+
+@param disp  a dispc object
+@return 0 out of memory
+*/
+static int s_disp_alloc_term_buf(dispc_t *disp)
+{
+  disp_char_t *new_buf;
+
+  if (disp->term_buf != NULL
+      && disp->term_width == disp->geom_param.width
+      && disp->term_height == disp->geom_param.height)
+    return 1;
+
+  new_buf = s_disp_malloc(disp, disp->geom_param.width *
+                                disp->geom_param.height * sizeof(disp_char_t));
+  if (new_buf == NULL)
+    return 0;
+  if (disp->term_buf != NULL)
+    s_disp_free(disp, disp->term_buf);
+  disp->term_buf = new_buf;
+  disp->term_width = disp->geom_param.width;
+  disp->term_height = disp->geom_param.height;
+  s_disp_term_buf_invalidate(disp);
+  return 1;
+}
+
+/*!
+@brief Counts the blanks that can be erased instead of written (vt)
+
+The terminal erases with the background color of the current SGR (bce),
+only the palette entries without underline and reverse qualify.
+
+@param disp     a dispc object
+@param char_ln  characters from char_buf
+@param w        number of characters in char_ln
+@return number of blanks at the start of char_ln with the same attribute
+*/
+static int s_disp_count_blanks(const dispc_t *disp,
+                               const disp_char_t *char_ln, int w)
+{
+  int n;
+
+  if (char_ln[0].c != ' ' ||
+      (disp->palette[char_ln[0].a].font_style &
+       (DISP_FONT_UNDERLINE | DISP_FONT_REVERSE)) != 0)
+    return 0;
+
+  for (n = 1; n < w; ++n)
+    if (!disp_char_equal(char_ln[n], char_ln[0]))
+      break;
+  return n;
+}
+
+/*!
+@brief Updates area of the screen with data from the screen buffer (vt)
+
+@param disp  a dispc object
+@param x    upper left corner coordinates of the destination rectangle
+@param y    upper left corner coordinates of the destination rectangle
+@param w    rectangle geometry
+@param h    rectangle geometry
+*/
+static void s_disp_validate_rect(dispc_t *disp,
+                                 int x, int y,
+                                 int w, int h)
+{
+  disp_char_t *char_ln;
+  disp_char_t *term_ln;
+  int i;
+  int j;
+  int k;
+  int n;
+  char c;
+  char buf[16];
+
+  ASSERT(VALID_DISP(disp));
+  ASSERT(x >= 0);
+  ASSERT(y >= 0);
+  ASSERT(w > 0);
+  ASSERT(h > 0);
+  ASSERT(w <= disp->geom_param.width);
+  ASSERT(h <= disp->geom_param.height);
+
+  disp->paint_is_suspended = 0;
+
+  if (!s_disp_alloc_term_buf(disp))
+    return;
+
+  for (i = 0; i < h; ++i)
+  {
+    char_ln = s_disp_buf_access(disp, x, y + i);
+    term_ln = disp->term_buf + (y + i) * disp->term_width + x;
+
+    for (j = 0; j < w; ++j)
+    {
+      if (disp_char_equal(char_ln[j], term_ln[j]))
+        continue;  /* already on the screen */
+
+      s_disp_move(disp, x + j, y + i);
+      s_disp_set_attr(disp, char_ln[j].a);
+
+      /*
+      Blanks to the end of the row: EL. A long run of blanks: ECH,
+      the cursor stays.
+      */
+      n = s_disp_count_blanks(disp, char_ln + j,
+                              disp->term_width - (x + j));
+      if (n == disp->term_width - (x + j) && n > 3)
+      {
+        s_disp_out_str(disp, "\033[K");
+        for (k = 0; k < n; ++k)
+          term_ln[j + k] = char_ln[j + k];
+        break;
+      }
+      if (n > 8)
+      {
+        if (n > w - j)
+          n = w - j;
+        sprintf(buf, "\033[%dX", n);
+        s_disp_out_str(disp, buf);
+        for (k = 0; k < n; ++k)
+          term_ln[j + k] = char_ln[j + k];
+        j += n - 1;
+        continue;
+      }
+
+      c = s_disp_vt_char(disp, char_ln[j].c);
+      s_disp_out(disp, &c, 1);
+      term_ln[j] = char_ln[j];
+
+      ++disp->term_x;
+      if (disp->term_x == disp->term_width)
+      {
+        /* the terminals differ where the cursor is after the last column */
+        disp->term_x = -1;
+        disp->term_y = -1;
+      }
+    }
+  }
+}
+
+/*!
+@brief Scrolls rows of the screen with a scroll region (vt)
+
+@param disp  a dispc object
+@param y     first row of the region
+@param h     number of rows in the region
+@param n     rows to scroll by, positive is up
+@return 1 the rows are scrolled
+*/
+static int s_disp_scroll_rows(dispc_t *disp, int y, int h, int n)
+{
+  disp_char_t *region;
+  int exposed_y;
+  int i;
+  char buf[48];
+
+  if (!s_disp_alloc_term_buf(disp))
+    return 0;
+  ASSERT(y + h <= disp->term_height);
+
+  if (n > 0)
+    sprintf(buf, "\033[%d;%dr\033[%dS\033[r", y + 1, y + h, n);
+  else
+    sprintf(buf, "\033[%d;%dr\033[%dT\033[r", y + 1, y + h, -n);
+  s_disp_out_str(disp, buf);
+  disp->term_x = 0;  /* DECSTBM moves the cursor home */
+  disp->term_y = 0;
+
+  /* term_buf follows what the terminal did */
+  region = disp->term_buf + y * disp->term_width;
+  if (n > 0)
+  {
+    memmove(region, region + n * disp->term_width,
+            (h - n) * disp->term_width * sizeof(disp_char_t));
+    exposed_y = h - n;
+  }
+  else
+  {
+    memmove(region - n * disp->term_width, region,
+            (h + n) * disp->term_width * sizeof(disp_char_t));
+    exposed_y = 0;
+  }
+  region += exposed_y * disp->term_width;
+  for (i = 0; i < abs(n) * disp->term_width; ++i)
+    region[i].a = DISP_VT_UNKNOWN_ATTR;
+
+  return 1;
+}
+
+/*!
+@brief Makes the caret visible or invisible (vt)
+
+Sent to the terminal by s_disp_refresh() with the end of the frame.
+
+@param disp              a dispc object
+@param caret_is_visible  new state of the caret
+*/
+static void s_disp_show_cursor(dispc_t *disp, int caret_is_visible)
+{
+  disp->cursor_is_visible = caret_is_visible;
+}
+
+/*!
+@brief Reads one character from the console without waiting (vt)
+
+@param disp  a dispc object
+@return the character
+@return -1 no character
+*/
+static int s_disp_getch(dispc_t *disp)
+{
+  unsigned char c;
+
+  DISP_REFERENCE(disp);
+  if (read(STDIN_FILENO, &c, 1) != 1)
+    return -1;
+  return c;
+}
+
+/*!
+@brief Sends the changes of the screen to the terminal (vt)
+
+The caret goes at its place and the output of the whole frame is sent
+with one write().
+
+@param disp  a dispc object
+*/
+static void s_disp_refresh(dispc_t *disp)
+{
+  if (disp->out_failed && disp->term_buf != NULL)
+  {
+    /* some output was lost, paint everything */
+    disp->out_failed = 0;
+    s_disp_term_buf_invalidate(disp);
+    s_disp_out_str(disp, "\033[0m\033[2J");
+    if (disp->char_buf != NULL)
+      s_disp_validate_rect(disp, 0, 0,
+                           disp->geom_param.width, disp->geom_param.height);
+  }
+
+  if (disp->cursor_is_visible != disp->term_cursor_is_visible)
+  {
+    s_disp_out_str(disp, disp->cursor_is_visible ? "\033[?25h" : "\033[?25l");
+    disp->term_cursor_is_visible = disp->cursor_is_visible;
+  }
+  if (disp->cursor_is_visible)
+    s_disp_move(disp, disp->cursor_x, disp->cursor_y);
+
+  s_disp_out_flush(disp);
+}
+
+/* Keyboard input, common with the other terminal backends */
+#include "disp_tty_in.c"
+
+/*!
+@brief Finds if the terminal decodes UTF-8 from the locale variables (vt)
+*/
+static int s_disp_locale_is_utf8(void)
+{
+  const char *s;
+
+  s = getenv("LC_ALL");
+  if (s == NULL || *s == '\0')
+    s = getenv("LC_CTYPE");
+  if (s == NULL || *s == '\0')
+    s = getenv("LANG");
+  if (s == NULL)
+    return 0;
+  return strstr(s, "UTF-8") != NULL || strstr(s, "utf-8") != NULL
+         || strstr(s, "UTF8") != NULL || strstr(s, "utf8") != NULL;
+}
+
+/*!
+@brief initial setup of display (vt)
+
+@param disp a dispc object
+@returns true for success
+@returns false for failure and error messages and code are set
+*/
+static int s_disp_init(dispc_t *disp)
+{
+  struct termios t;
+  struct winsize ws;
+
+  if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)
+      || tcgetattr(STDIN_FILENO, &disp->saved_termios) != 0)
+  {
+    disp->code = DISP_VT_MODE_SETUP_FAILURE;
+    snprintf(disp->error_msg, sizeof(disp->error_msg),
+             "standard input and output must be a terminal");
+    return 0;
+  }
+
+  /* no echo, no line editing, no signals and no flow control */
+  t = disp->saved_termios;
+  t.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+  t.c_oflag &= ~OPOST;
+  t.c_cflag |= CS8;
+  t.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+  t.c_cc[VMIN] = 0;  /* read() doesn't wait for keys */
+  t.c_cc[VTIME] = 0;
+  if (tcsetattr(STDIN_FILENO, TCSADRAIN, &t) != 0)
+  {
+    disp->code = DISP_VT_MODE_SETUP_FAILURE;
+    snprintf(disp->error_msg, sizeof(disp->error_msg),
+             "failed to set the terminal in raw mode");
+    snprintf(disp->os_error_msg, sizeof(disp->os_error_msg),
+             "%s", strerror(errno));
+    return 0;
+  }
+
+  disp->geom_param.width = 80;
+  disp->geom_param.height = 24;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0
+      && ws.ws_col > 0 && ws.ws_row > 0)
+  {
+    disp->geom_param.width = ws.ws_col;
+    disp->geom_param.height = ws.ws_row;
+  }
+
+  disp->utf8 = s_disp_locale_is_utf8();
+  disp->term_x = -1;
+  disp->term_y = -1;
+  disp->term_attr = -1;
+  disp->term_cursor_is_visible = 1;
+
+  /*
+  alternate screen, clear it, and pasted text comes between
+  ESC[200~ and ESC[201~. Not in out_buf, the memory handlers are
+  established after s_disp_init()
+  */
+  s_disp_write_str("\033[?1049h\033[0m\033[H\033[2J\033[?2004h");
+
+  return 1;
+}
+
+/*!
+@brief platform specific disp cleanup (vt)
+
+@param disp  a display object
+*/
+static void s_disp_done(dispc_t *disp)
+{
+  s_disp_out_flush(disp);
+  s_disp_write_str("\033[0m\033[?25h\033[?2004l\033[?1049l");
+  tcsetattr(STDIN_FILENO, TCSADRAIN, &disp->saved_termios);
+
+  if (disp->term_buf != NULL)
+    s_disp_free(disp, disp->term_buf);
+  if (disp->out_buf != NULL)
+    s_disp_free(disp, disp->out_buf);
+  if (disp->paste_buf != NULL)
+    s_disp_free(disp, disp->paste_buf);
+}
+
+/*!
+@brief Sets the caret on a specific position (vt)
+
+Sent to the terminal by s_disp_refresh() with the end of the frame.
+
+@param disp  a display object
+@param x     coordinates in character units
+@param y     coordinates in character units
+*/
+static void s_disp_set_cursor_pos(dispc_t *disp, int x, int y)
+{
+  disp->cursor_x = x;
+  disp->cursor_y = y;
+}
+
+/*!
+@brief Turns on or off the EVENT_TIMER_TICK (vt)
+
+s_disp_process_events() checks disp->tick_enabled on each time-out,
+nothing more to be done here.
+
+@param disp    a dispc object
+*/
+static void s_disp_set_tick(dispc_t *disp)
+{
+}
+
+/*!
+@brief Watches a file descriptor (vt)
+
+s_disp_process_events() adds the descriptor to the select() while
+disp->watch_fd_armed, nothing more to be done here.
+
+@param disp    a dispc object
+*/
+static void s_disp_set_watch_fd(dispc_t *disp)
+{
+}
+
+/*!
+@brief Changes the title of the window (vt)
+
+@param disp    a dispc object
+@param title   a string for the title
+*/
+static void s_disp_wnd_set_title(dispc_t *disp, const char *title)
+{
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -386,6 +386,22 @@ static void s_disp_validate_rect(dispc_t *disp,
   s_disp_invalidate_rect(disp, &area);
 }
 
+/*!
+@brief Scrolls rows of the screen (win32 GUI)
+
+Painting the window is fast enough, the rows are repainted instead.
+
+@param disp  a dispc object
+@param y     first row of the region
+@param h     number of rows in the region
+@param n     rows to scroll by, positive is up
+@return 0 the rows are to be repainted
+*/
+static int s_disp_scroll_rows(dispc_t *disp, int y, int h, int n)
+{
+  return 0;
+}
+
 /*!
 @brief Waits for event from the display window. (win32 GUI)
 
@@ -412,6 +428,28 @@ static int s_disp_process_events(dispc_t *disp)
   return 1;
 }
 
+/*!
+@brief Checks for a message without waiting (win32 GUI)
+
+@param disp  a dispc object
+@return 1 keyboard or mouse message waiting
+*/
+static int s_disp_input_is_pending(dispc_t *disp)
+{
+  MSG msg;
+
+  DISP_REFERENCE(disp);
+  return PeekMessage(&msg, NULL, 0, 0, PM_NOREMOVE) != 0;
+}
+
+/*!
+@brief Gets a time in miliseconds (win32 GUI)
+*/
+static unsigned long s_disp_get_tick_ms(void)
+{
+  return GetTickCount();
+}
+
 /*!
 @brief Makes the caret visible or invisible (win32 GUI)
 
@@ -999,6 +1037,8 @@ s_disp_wnd_proc(HWND hWnd,
     case WM_TIMER:
       disp_event_clear(&ev);
       ev.t.code = EVENT_TIMER_5SEC;
+      if (wParam == 2)
+        ev.t.code = EVENT_TIMER_TICK;
       s_disp_ev_q_put(disp, &ev);
       break;
 
@@ -1171,6 +1211,37 @@ static int s_disp_init(dispc_t *disp)
 static void s_disp_done(dispc_t *disp)
 {
   KillTimer(disp->wnd, disp->win32_timer_id);
+  if (disp->win32_tick_timer_id != 0)
+    KillTimer(disp->wnd, disp->win32_tick_timer_id);
+}
+
+/*!
+@brief Turns on or off the EVENT_TIMER_TICK (win32 GUI)
+
+@param disp    a dispc object
+*/
+static void s_disp_set_tick(dispc_t *disp)
+{
+  if (disp->win32_tick_timer_id != 0)
+  {
+    KillTimer(disp->wnd, disp->win32_tick_timer_id);
+    disp->win32_tick_timer_id = 0;
+  }
+  if (disp->tick_enabled)
+    disp->win32_tick_timer_id = SetTimer(disp->wnd, 2, DISP_TICK_TIME, NULL);
+}
+
+/*!
+@brief Watches a file descriptor (win32 GUI)
+
+There are no descriptors to select() on in the message loop, the
+watch is not supported.
+
+@param disp    a dispc object
+*/
+static void s_disp_set_watch_fd(dispc_t *disp)
+{
+  disp->watch_fd_armed = 0;
 }
 
 /*!
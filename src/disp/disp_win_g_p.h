@@ -94,6 +94,13 @@ struct dispc
   disp_char_t *char_buf;
   int buf_height;
   int buf_width;
+  /*
+  damage: the span of each row of char_buf changed since the last
+  flush, see s_disp_flush_damage()
+  */
+  int *damage_start;  /* -1 -- the row is unchanged */
+  int *damage_end;
+  int has_damage;
 
   int caption_height;
   int border_width;
@@ -131,6 +138,11 @@ struct dispc
   int minutes;
   int seconds;
   int win32_timer_id;
+  int tick_enabled;  /* send EVENT_TIMER_TICK */
+  int tick_users;  /* disp_set_tick() calls to enable */
+  int watch_fd;  /* not watched on win32 */
+  int watch_fd_armed;
+  int win32_tick_timer_id;
 
   /*
   memory manager
@@ -927,10 +927,19 @@ BOOLEAN EnterLn(const char *sPrompt, char *sInputString, int nMaxLen,
     {
       disp_event_read(disp, &ev);
     }
-    while (ev.t.code != EVENT_KEY);
+    while (ev.t.code != EVENT_KEY && ev.t.code != EVENT_CLIPBOARD_PASTE);
     Key = ev.e.kbd.key;
     VALIDATE_HEAP();
 
+    if (ev.t.code == EVENT_CLIPBOARD_PASTE)
+    {
+      /* Only the first line of the pasted text */
+      strncpy(sResult, ev.e.pdata, nMaxLen - 1);
+      sResult[nMaxLen - 1] = '\0';
+      sResult[strcspn(sResult, "\r\n")] = '\0';
+      goto _paste;
+    }
+
 
     switch (Key)
     {
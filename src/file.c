@@ -50,6 +50,7 @@ void InitEmptyFile(TFile *pFile)
   pFile->sTitle[0] = '\0';
   pFile->nType = -1;
   pFile->sRecoveryFileName[0] = '\0';
+  pFile->pRecoveryJournal = NULL;
   pFile->nCopy = 0;
   pFile->sMsg[0] = '\0';
   pFile->nFileSize = 0;
@@ -62,6 +63,11 @@ void InitEmptyFile(TFile *pFile)
   pFile->pCurPos = NULL;  /* no current position */
   pFile->nTopLine = 0;
   pFile->nWrtEdge = 0;
+  pFile->nPageTopLine = -1;
+  pFile->nPageWrtEdge = 0;
+  pFile->nPageY = 0;
+  pFile->nPageHeight = 0;
+  pFile->pPageRows = NULL;
   pFile->nNumberOfLines = 0;
   pFile->bBlock = FALSE;  /* no	block */
   pFile->nStartLine = -1;  /* invalid */
@@ -73,6 +79,7 @@ void InitEmptyFile(TFile *pFile)
   pFile->bRecoveryStored = FALSE;
   pFile->bFileNameChanged = FALSE;
   pFile->bForceNewRecoveryFile = FALSE;
+  pFile->nRecoveryError = 0;
   pFile->bForceReadOnly = FALSE;
   pFile->bReadOnly = FALSE;
   pFile->bNew = FALSE;
@@ -86,6 +93,12 @@ void InitEmptyFile(TFile *pFile)
   pFile->nUndoLevel = 0;
   pFile->nNumberOfRecords = 0;
   pFile->nUndoIDCounter = 0;
+  pFile->nDiskUndoID = -1;  /* No record is in the disk file */
+  pFile->nUndoMemory = 0;
+  pFile->nUndoSpillSize = 0;
+  pFile->nUndoSpillStart = 0;
+  pFile->fUndoSpill = NULL;
+  pFile->pUndoStatusSpare = NULL;
 
   pFile->LastWriteTime.year = -1;
   pFile->LastWriteTime.month = -1;
@@ -93,6 +106,19 @@ void InitEmptyFile(TFile *pFile)
   pFile->LastWriteTime.hour = -1;
   pFile->LastWriteTime.min = -1;
   pFile->LastWriteTime.sec = -1;
+  pFile->DiskID.nMTime = 0;
+  pFile->DiskID.nMTimeNSec = 0;
+  pFile->DiskID.nInode = 0;
+  pFile->DiskID.nSize = -1;
+  pFile->nWatchWD = -1;
+  pFile->nWatchDirWD = -1;
+  pFile->bCheckDisk = FALSE;
+  pFile->bFollow = FALSE;
+  pFile->bFollowReadOnly = FALSE;
+  pFile->bFollowPartial = FALSE;
+  pFile->nFollowPos = 0;
+  pFile->pSaveJob = NULL;
+  pFile->nSaveUndoID = -1;
 
   pFile->nExpandCol = -1;
   pFile->nExpandRow = -1;
@@ -116,6 +142,8 @@ void InitEmptyFile(TFile *pFile)
   pFile->sEndOfFile = (char *)sEndOfFile;
 
   pFile->nID = ++nID;
+  pFile->nEditVersion = 0;
+  pFile->nEditFirstLine = INT_MAX;
 
   pFile->pBMSetFuncNames = NULL;
   pFile->pBMFuncFindCtx = NULL;
@@ -502,6 +530,245 @@ _exit_point:
   return nExitCode;
 }
 
+/* ************************************************************************
+   Function: LoadFileTailPrim
+   Description:
+     Loads the bytes appended to a file, from pFile->nFollowPos up to
+     nSize, in a new block and adds the lines at the end of pIndex.
+     The lines already in memory are not read again, except the last
+     one if it had no end-of-line marker (bFollowPartial), it is replaced.
+     A CR at the end of the file may be the first half of a CR/LF pair
+     and is left to be read again with the next portion.
+   Returns:
+     0 - Load OK
+     3 - no memory
+     5 - io error
+*/
+int LoadFileTailPrim(TFile *pFile, int nSize)
+{
+  FILE *f;
+  int nExitCode;
+  char *p;
+  char *pEnd;
+  char *pSentinel;
+  char *pBlock;
+  char *pBlockR;
+  char *p2;
+  TLine *pNewLines;
+  TLine *pLine;
+  int nToRead;
+  int nRead;
+  int nNumberOfLines;
+  int nNewLines;
+  int nSizeOfMovedLines;
+  int nMovedLines;
+  int nBlockRefs;
+  int nMarkSize;
+  char *pPartialBlock;
+
+  ASSERT(VALID_PFILE(pFile));
+  ASSERT(pFile->nFollowPos >= 0);
+
+  nToRead = nSize - pFile->nFollowPos;
+  if (nToRead <= 0)
+    return 0;
+
+  nExitCode = 0;
+  pBlockR = NULL;
+  pNewLines = NULL;
+
+  f = fopen(pFile->sFileName, READ_BINARY_FILE);
+  if (f == NULL)
+    return 5;
+  if (fseek(f, pFile->nFollowPos, SEEK_SET) != 0)
+  {
+    fclose(f);
+    return 5;
+  }
+
+  if (!AddBlock(&pFile->blist, nToRead + 3))  /* +3 for ASCIIZ/EOL */
+  {
+    fclose(f);
+    return 3;
+  }
+
+  pBlock = GetLastBlock(&pFile->blist);
+  nRead = fread(pBlock, 1, nToRead, f);
+  fclose(f);
+
+  if (nRead != nToRead)
+  {
+    nExitCode = 5;
+    goto _dispose_pblock;
+  }
+  pBlock[nRead] = '\0';
+  pBlock[nRead + 1] = '\0';
+  pBlock[nRead + 2] = '\0';
+
+  pEnd = pBlock + nRead;
+  if (*(pEnd - 1) == '\r')
+    --pEnd;  /* CR/LF pair may be incomplete */
+
+  nMarkSize = 1;
+  if (pFile->nEOLType == CRLFtype)
+    nMarkSize = 2;
+
+  /*
+  Count the complete lines. A line marked by a single character
+  has no room for a CR/LF marker, in a CR/LF file such lines are
+  moved in a separate block, as LoadFilePrim() does.
+  */
+  nNumberOfLines = 0;
+  nMovedLines = 0;
+  nSizeOfMovedLines = 0;
+  pSentinel = pBlock;  /* Where a line started */
+  for (p = pBlock; p < pEnd; ++p)
+  {
+    if (*p != '\r' && *p != '\n' && *p != '\0')
+      continue;
+    ++nNumberOfLines;
+    if (*p == '\r' && *(p + 1) == '\n')
+      ++p;
+    else
+      if (nMarkSize == 2)
+      {
+        nSizeOfMovedLines += p - pSentinel;
+        ++nMovedLines;
+      }
+    pSentinel = p + 1;
+  }
+
+  nNewLines = nNumberOfLines;
+  if (pEnd > pSentinel)
+    ++nNewLines;  /* A line without end-of-line marker */
+  if (nNewLines == 0)
+    goto _dispose_pblock;  /* Only a CR, read it next time */
+
+  if (nMovedLines > 0)
+  {
+    if (!AddBlock(&pFile->blist, nSizeOfMovedLines + nMovedLines * 2))
+    {
+      nExitCode = 3;
+      goto _dispose_pblock;
+    }
+    pBlockR = GetLastBlock(&pFile->blist);
+  }
+
+  pNewLines = alloc(sizeof(TLine) * nNewLines);
+  if (pNewLines == NULL)
+  {
+    nExitCode = 3;
+    goto _dispose_pblock;
+  }
+
+  /*
+  Separate the portion in ASCIIZ lines.
+  */
+  pLine = pNewLines;
+  p2 = pBlockR;
+  nBlockRefs = 0;
+  pSentinel = pBlock;
+  for (p = pBlock; p < pEnd; ++p)
+  {
+    if (*p != '\r' && *p != '\n' && *p != '\0')
+      continue;
+    pLine->attr = 0;
+    pLine->nLen = p - pSentinel;
+    if (*p == '\r' && *(p + 1) == '\n')
+    {
+      *p = '\0';
+      ++p;
+    }
+    else
+      if (nMarkSize == 2)
+      {
+        memcpy(p2, pSentinel, pLine->nLen);
+        pLine->pLine = p2;
+        pLine->pFileBlock = pBlockR;
+        p2 += pLine->nLen;
+        *p2 = '\0';
+        p2 += nMarkSize;  /* Place to accomodate an end-of-line marker */
+        ++pLine;
+        pSentinel = p + 1;
+        continue;
+      }
+    *p = '\0';
+    pLine->pLine = pSentinel;
+    pLine->pFileBlock = pBlock;
+    ++nBlockRefs;
+    ++pLine;
+    pSentinel = p + 1;
+  }
+  if (pEnd > pSentinel)
+  {
+    *pEnd = '\0';
+    pLine->attr = 0;
+    pLine->nLen = pEnd - pSentinel;
+    pLine->pLine = pSentinel;
+    pLine->pFileBlock = pBlock;
+    ++nBlockRefs;
+  }
+
+  if (pFile->pIndex == NULL)
+  {
+    TArrayInit(pFile->pIndex, nNewLines, FILE_DELTA);
+    if (pFile->pIndex == NULL)
+    {
+      nExitCode = 3;
+      goto _dispose_pblock;
+    }
+  }
+  TArrayInsertGroup(pFile->pIndex, pFile->nNumberOfLines, pNewLines, nNewLines);
+  if (!TArrayStatus(pFile->pIndex))  /* Failed to insert the lines */
+  {
+    TArrayClearStatus(pFile->pIndex);
+    nExitCode = 3;
+    goto _dispose_pblock;
+  }
+  /* The partial last line is replaced, <*** End Of File ***> moves */
+  LinesChanged(pFile,
+    pFile->bFollowPartial ? pFile->nNumberOfLines - 1 : pFile->nNumberOfLines);
+  pFile->nNumberOfLines += nNewLines;
+
+  if (nBlockRefs > 0)
+  {
+    IncRef(pBlock, nBlockRefs);
+  }
+  else
+    DisposeBlock(pBlock);  /* All the lines are in pBlockR */
+  if (pBlockR != NULL)
+  {
+    IncRef(pBlockR, nMovedLines);
+  }
+
+  /*
+  The line that had no end-of-line marker is now
+  part of the portion, remove its previous copy.
+  */
+  if (pFile->bFollowPartial)
+  {
+    ASSERT(pFile->nNumberOfLines > nNewLines);
+    pPartialBlock = pFile->pIndex[pFile->nNumberOfLines - nNewLines - 1].pFileBlock;
+    TArrayDeleteGroup(pFile->pIndex, pFile->nNumberOfLines - nNewLines - 1, 1);
+    --pFile->nNumberOfLines;
+    DecRef(pPartialBlock, 1);
+  }
+
+  pFile->nFollowPos += pSentinel - pBlock;
+  pFile->bFollowPartial = pEnd > pSentinel;
+  pFile->nFileSize = nSize;
+  s_free(pNewLines);
+  return 0;
+
+_dispose_pblock:
+  if (pNewLines != NULL)
+    s_free(pNewLines);
+  DisposeBlock(pBlock);
+  if (pBlockR != NULL)
+    DisposeBlock(pBlockR);
+  return nExitCode;
+}
+
 /* ************************************************************************
    Function: DisposeFile
    Description:
@@ -513,6 +780,8 @@ void DisposeFile(TFile *pFile)
 
   if (pFile->sTooltipBuf != NULL)
     s_free(pFile->sTooltipBuf);
+  if (pFile->pPageRows != NULL)
+    s_free(pFile->pPageRows);
 
   DisposeBlockList(&pFile->blist);
   if (pFile->pIndex != NULL)
@@ -542,6 +811,23 @@ TLine *GetLine(const TFile *pFile, int nLine)
   return &pFile->pIndex[nLine];
 }
 
+/* ************************************************************************
+   Function: LinesChanged
+   Description:
+     To be called on every change of the text. The lines from nLine
+     on may have changed, the cached page data of these lines is no
+     longer valid.
+*/
+void LinesChanged(TFile *pFile, int nLine)
+{
+  ASSERT(VALID_PFILE(pFile));
+  ASSERT(nLine >= 0);
+
+  ++pFile->nEditVersion;
+  if (nLine < pFile->nEditFirstLine)
+    pFile->nEditFirstLine = nLine;
+}
+
 /* ************************************************************************
    Function: LineIsInBlock
    Description:
@@ -65,6 +65,9 @@ typedef struct block
 #define acREARRANGE 4  /* Most likely as result from CmdEditSort() */
 #define acREARRANGEBACK 5  /* Can appear only from a recovery file */
 
+/* nDiskUndoID when an undone record of the disk file was disposed */
+#define UNDO_DISK_LOST (-2)
+
 typedef struct FileStatus
 {
   int nRow;  /* Position of the cursor: Row */
@@ -94,14 +97,16 @@ typedef struct UndoRecord
   #define UNDOREC_MAGIC 0x53
   #endif
 
-  int nUndoBlockID;  /* Consequtive number */
-
-  int nUndoLevel;  /* This is operations nesting level; End of atom indicator */
-  BOOLEAN bUndone;  /* This block was undone by CmdEditUndo() */
-  BOOLEAN bRecoveryStore;  /* This block was stored as item in recovery	file */
+  BYTE nOperation;
+  short nUndoLevel;  /* This is operations nesting level; End of atom indicator */
+  unsigned int bUndone : 1;  /* This block was undone by CmdEditUndo() */
+  unsigned int bRecoveryStore : 1;  /* This block was stored as item in recovery	file */
+  unsigned int bInlineData : 1;  /* pData is kept in Packed[] after the status */
+  unsigned int bStatusOnHeap : 1;  /* Packed[] has a pointer to the status */
+  unsigned int nStatusSize : 8;  /* Bytes of packed status */
+  unsigned int nInlineLen : 8;  /* Bytes of inline text */
 
-  TFileStatus before;  /* File status before performing the action */
-  TFileStatus after;  /* File status after performing the action */
+  int nUndoBlockID;  /* Consequtive number */
 
   /* Data as a result of user action */
   void *pData;
@@ -111,9 +116,23 @@ typedef struct UndoRecord
   int nEndPos;
   WORD blockattr;  /* Used only when loaded from a recovery file */
 
-  int nOperation;
+  int nDataSize;  /* pData bytes counted in TFile.nUndoMemory */
+  long nSpillPos;  /* pData copy in TFile.fUndoSpill, -1 if none */
+
+  /*
+  File status before and after performing the action, packed by
+  PackUndoStatus(). Small single line data follows the status.
+  A status longer than UNDO_PACKED_SIZE is on the heap and
+  Packed[] keeps the pointer.
+  */
+  BYTE Packed[UNDO_PACKED_SIZE];
 } TUndoRecord;
 
+/* pData was moved to the spill file to keep the undo memory limit */
+#define UNDO_DATA_SPILLED(pUndoRec) ((pUndoRec)->pData == NULL && (pUndoRec)->nSpillPos != -1)
+/* The record has data in memory, in Packed[] or in the spill file */
+#define UNDO_HAS_DATA(pUndoRec) ((pUndoRec)->pData != NULL || (pUndoRec)->bInlineData || UNDO_DATA_SPILLED(pUndoRec))
+
 /* To be used in ASSERT()! */
 #ifdef _DEBUG
 #define VALID_PUNDOREC(pUndoRec) (pUndoRec != NULL && pUndoRec->MagicByte == UNDOREC_MAGIC)
@@ -121,6 +140,18 @@ typedef struct UndoRecord
 #define VALID_PUNDOREC(pUndoRec) (1)
 #endif
 
+/*
+Identity of a file on disk, a change of any of the fields
+means the file was changed by another program
+*/
+typedef struct FileID
+{
+  long nMTime;
+  long nMTimeNSec;
+  unsigned long nInode;
+  long nSize;  /* -1 -- no such file */
+} TFileID;
+
 /*
 NOTE:
 Adding fields here should be folowed by a correction of InitEmptyFile().
@@ -152,6 +183,20 @@ typedef struct txtf
 
   TTime LastWriteTime;  /* disk time */
   int nFileSize;  /* File size as stored at the disk in bytes */
+  TFileID DiskID;  /* As loaded or stored by the editor, see filewatch.c */
+  int nWatchWD;  /* inotify watch of the file, -1 if none */
+  int nWatchDirWD;  /* inotify watch of the directory, -1 if none */
+  BOOLEAN bCheckDisk;  /* A change is signaled, DiskID is to be compared */
+
+  /* Follow mode, see FollowFile() */
+  BOOLEAN bFollow;  /* Lines appended on disk are added at the end */
+  BOOLEAN bFollowReadOnly;  /* bForceReadOnly before the follow mode */
+  BOOLEAN bFollowPartial;  /* The last line has no end-of-line marker yet */
+  int nFollowPos;  /* Disk position of the first byte not indexed as a line */
+
+  /* Store in background, see StoreFile() */
+  struct SaveJob *pSaveJob;  /* The store in progress, NULL if none */
+  int nSaveUndoID;  /* The last undo record in the text being stored */
 
   /* Cursor position */
   int nRow;  /* Position of the cursor: Row */
@@ -166,6 +211,13 @@ typedef struct txtf
   int nTopLine;  /* The number of the top line of current page */
   int nWrtEdge;  /* The position of the most left character visible on the scr */
 
+  /* The page as last written on the screen, see ScrollPage() */
+  int nPageTopLine;  /* -1 -- not written yet */
+  int nPageWrtEdge;
+  int nPageY;
+  int nPageHeight;
+  struct PageRows *pPageRows;  /* The rows as last prepared, see nav.c */
+
   int nNumVisibleLines;  /* Specified by TFileView.HandleEvent() */
 
   int nNumberOfLines;  /* The number of the lines in the file */
@@ -196,11 +248,18 @@ typedef struct txtf
   int nUndoLevel;
   int nNumberOfRecords;
   int nUndoIDCounter;
+  int nDiskUndoID;  /* The last record in the disk file, UNDO_DISK_LOST */
+  long nUndoMemory;  /* Bytes taken by the data of the undo records */
+  long nUndoSpillSize;  /* Bytes written in fUndoSpill */
+  int nUndoSpillStart;  /* The records below have no data in memory */
+  FILE *fUndoSpill;  /* Temporary file for the data of the oldest records */
+  BYTE *pUndoStatusSpare;  /* For a status that doesn't fit in TUndoRecord */
 
   BOOLEAN bChanged;  /* File in memory has changed from its disk image */
   BOOLEAN bRecoveryStored;
   BOOLEAN bFileNameChanged;  /* Set by CmdFileSaveAs() */
   BOOLEAN bForceNewRecoveryFile;  /* Set by CmdFileSave() */
+  int nRecoveryError;  /* errno of the last reported recovery failure */
   BOOLEAN bForceReadOnly;  /* If no editing allowed (CmdFileOpenAsReadOnly) */
   BOOLEAN bReadOnly;  /* Copy of the file attribute */
   BOOLEAN bNew;  /* File is created and	as a new file in memory */
@@ -216,6 +275,7 @@ typedef struct txtf
   Recovery file status line (if recovery file discovered during file loading);
   */
   char sRecoveryFileName[_MAX_PATH];  /* Recovery file name and full path */
+  struct RecoveryJournal *pRecoveryJournal;  /* Written by recwrite.c, or NULL */
   int nRecStatFileSize;
   int nRecStatMonth;
   int nRecStatDay;
@@ -225,6 +285,8 @@ typedef struct txtf
   int nRecStatSec;
 
   int nID;  /* for each file a unique ID is maintained */
+  int nEditVersion;  /* Incremented on every change of the text */
+  int nEditFirstLine;  /* First line changed since the page was written */
 
   /*
   Update screen/line request flags
@@ -269,11 +331,13 @@ typedef struct txtf
 
 void InitEmptyFile(TFile *pFile);
 int LoadFilePrim(TFile *pFile);
+int LoadFileTailPrim(TFile *pFile, int nSize);
 void DisposeFile(TFile *pFile);
 
 TLine *GetLine(const TFile *pFile, int nLine);
 #define GetLineText(pFile, nLine)  (GetLine(pFile, nLine)->pLine)
 BOOLEAN LineIsInBlock(const TFile *pFile, int nLine);
+void LinesChanged(TFile *pFile, int nLine);
 
 int StoreFilePrim(const TFile *pFile, int nOutputEOLType);
 
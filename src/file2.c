@@ -22,9 +22,15 @@ Descrition:
 #include "ini2.h"  /* bDontStoreINIFile */
 #include "ini.h"  /* sINIFileName */
 #include "memory.h"
+#include "tblocks.h"
 #include "findf.h"
 #include "doctype.h"
 #include "undo.h"
+#include "block.h"
+#include "linediff.h"
+#include "filewatch.h"
+#include "savew.h"
+#include "bookm.h"
 #include "file2.h"
 
 static int nRecFileCount;  /* Used by ComposeNewRecFileName() */
@@ -350,6 +356,8 @@ BOOLEAN RemoveTopFile(TFileList *pFileList, TMRUList *pMRUList, dispc_t *disp)
   stContext.pstProcessMRUList = pMRUList;  /* Parameter for ProcessFile() call-back func */
   stContext.pstProcessFileList = pFileList;  /* Parameter for ProcessFile() call-back func */
   pFile = RemoveFile(pFileList, ProcessFile, &stContext);
+  StoreFileWait(pFile, disp);
+  FileWatchRelease(pFile);
   DisposeFile(pFile);
   s_free(pFile);
   if (pFileList->nNumberOfFiles == 0)
@@ -375,6 +383,8 @@ void RemoveLastFile(TFileList *pFileList, TMRUList *pMRUList)
   stContext.pstProcessMRUList = pMRUList;  /* Parameter for ProcessFile() call-back func */
   stContext.pstProcessFileList = pFileList;  /* Parameter for ProcessFile() call-back func */
   pFile = RemoveFile(pFileList, ProcessFile, &stContext);
+  StoreFileWait(pFile, NULL);
+  FileWatchRelease(pFile);
   DisposeFile(pFile);
   s_free(pFile);
 }
@@ -564,6 +574,7 @@ void LoadFile(const char *sFileName, TFileList *pFileList, TMRUList *pMRUList,
     /* Above should always succeed on an existing file */
     ASSERT(0);
   }
+  FileWatchFile(pFile);
 
   PrepareFileTitle(pFile, pFileList);
   if (pFile->nCopy == 0)
@@ -812,20 +823,135 @@ TFile *AddNewFile(TFileList *pFileList, dispc_t *disp)
 }
 
 /* ************************************************************************
-   Function: StoreFile
+   Function: MarkFileAsStored
    Description:
-     -- Calls StoreFilePrim() to store file to disk.
-     -- Produces a backup file.
-     -- If the file is new adds the file to the MRU list.
-     -- If the store operation is successfull removes the recovery file.
+     Called after the file in memory is made to match the file on disk.
+     -- Removes the recovery file.
      -- Updates the file parameters (size, data, tame, etc.) as stored at the disk.
      -- Updates the undo list to indicate that the point where the file
      is stored.
+     nUndoID -- the last undo record in the text that is on the disk,
+     the records that follow were added while the file was stored.
+*/
+static void MarkFileAsStored(TFile *pFile, int nUndoID, dispc_t *disp)
+{
+  int i;
+  TUndoRecord *pUndoRec;
+
+  /*
+  Remove the recovery file.
+  */
+  if (FileExists(pFile->sRecoveryFileName))
+  {
+    /* .rec file exists. Remove the .rec file */
+    CloseRecoveryJournal(pFile);
+    if (unlink(pFile->sRecoveryFileName) != 0)
+    {
+      /* unlink failed: display error */
+      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK,
+        pFile->sRecoveryFileName, NULL);
+    }
+    pFile->bRecoveryStored = FALSE;
+    pFile->bForceNewRecoveryFile = TRUE;
+  }
+
+  /*
+  Get the file parameters as store on the disk.
+  NOTE: GetFileParamaters() is supposed to succeed always
+  on a file that was just written or read sucessfully.
+  */
+  if (!GetFileParameters(pFile->sFileName, NULL, &pFile->LastWriteTime,
+    &pFile->nFileSize))
+  {
+    ASSERT(0);
+  }
+  FileWatchFile(pFile);
+
+  /*
+  Prepare undo list pRecoveryStore flag to reflect the fact
+  that the file has just being stored.
+
+  The records up to nUndoID are in the disk file and get
+  bRecoveryStore set, an undone one among them is to be stored
+  in the recovery file as inverted operation. The undone records
+  on top of the list and the records added after nUndoID are
+  not in the disk file.
+  */
+  for (i = pFile->nNumberOfRecords - 1; i >= 0; --i)
+  {
+    pUndoRec = &pFile->pUndoIndex[i];
+    ASSERT(VALID_PUNDOREC(pUndoRec));
+    ASSERT(UNDO_HAS_DATA(pUndoRec));
+    pUndoRec->bRecoveryStore = pUndoRec->nUndoBlockID <= nUndoID;
+  }
+
+  pFile->nDiskUndoID = nUndoID;
+  pFile->nRecoveryError = 0;
+  pFile->bForceNewRecoveryFile = TRUE;
+}
+
+/*
+Save All in progress, see StoreAllBegin()
+*/
+static TFileList *pStoreAllList;  /* NULL -- no Save All in progress */
+static TBookmarksSet *pStoreAllReport;  /* Collects the files not saved */
+static void (*pfnStoreAllShowReport)(void *pCtx);
+static BOOLEAN bStoreAllSubmit;  /* StoreFile() is called by Save All */
+static int nStoreAllFiles;  /* Files passed to the writers */
+static int nStoreAllStored;  /* Files the writers are done with */
+static int nStoreAllFailed;
+
+typedef struct _StoreContext
+{
+  BOOLEAN bStoreAll;  /* Part of Save All */
+  TMRUList *pMRUList;
+  TLine *pLines;  /* Copy of the line index, references the blocks */
+  int nNumberOfLines;
+  int nEditVersion;  /* pFile->nEditVersion at the start of the store */
+  int nOutputEOLType;
+} TStoreContext;
+
+/* ************************************************************************
+   Function: RefLines
+   Description:
+     Increments (bRef is TRUE) or decrements the reference counters of
+     the blocks of the lines. Decrementing disposes the blocks that
+     have no more references.
+*/
+static void RefLines(const TLine *pLines, int nNumberOfLines, BOOLEAN bRef)
+{
+  int i;
+  int nRun;
+
+  for (i = 0; i < nNumberOfLines; i += nRun)
+  {
+    /* The lines of a block are usually next to each other */
+    nRun = 1;
+    while (i + nRun < nNumberOfLines &&
+      pLines[i + nRun].pFileBlock == pLines[i].pFileBlock)
+      ++nRun;
+    if (bRef)
+    {
+      IncRef(pLines[i].pFileBlock, nRun);
+    }
+    else
+      DecRef(pLines[i].pFileBlock, nRun);
+  }
+}
+
+/* ************************************************************************
+   Function: StoreFile
+   Description:
+     -- Produces a backup file.
+     -- Passes a snapshot of the file to the writer (savew.c).
+     The store is completed by StoreFileDone() when the writer is done,
+     the editing continues meanwhile. The snapshot is a copy of the line
+     index, the text blocks are kept by their reference counters. The
+     edit operations put the new text in new blocks, only the overwrite
+     mode writes in place and copies the line first, see ReplaceTextPrim().
 */
 void StoreFile(TFile *pFile, TMRUList *pMRUList, dispc_t *disp)
 {
-  char sBuf[_MAX_PATH + 40];
-  char sShrunkName[_MAX_PATH];
   char sTargetName[_MAX_PATH];
 #ifdef UNIX
   char sTargetFileName[_MAX_PATH];
@@ -834,25 +960,28 @@ void StoreFile(TFile *pFile, TMRUList *pMRUList, dispc_t *disp)
   int nTempLen;
 #endif
   char sBackupName[_MAX_PATH];
-  char sOutput[25];
-  int i;
-  TUndoRecord *pUndoRec;
-  int nOutputEOLType;
+  BOOLEAN bBackupFile;
+  TStoreContext *pContext;
 
   if (pFile->bReadOnly || pFile->bForceReadOnly)
     return;  /* Store nothing when in read-only mode */
 
+  StoreFileWait(pFile, disp);  /* A single store of a file at a time */
+
   /* Show a message that the file saving is in progress */
-  ConsoleMessageProc(disp, NULL, MSG_STATONLY | MSG_INFO, pFile->sFileName, sSaving);
+  if (!bStoreAllSubmit)  /* Save All shows the progress of all the files */
+    ConsoleMessageProc(disp, NULL, MSG_STATONLY | MSG_INFO, pFile->sFileName, sSaving);
 
   /*
   Produce .BAK file
   Don't produce .BAK if the file is new (no old version to preserve)
   Don't produce .BAK if the file is not changed (old .bak version is still valid)
+  The writer renames the file, here is only the name.
   */
+  bBackupFile = FALSE;
+  strcpy(sTargetName, pFile->sFileName);
   if (bBackup && !pFile->bNew && pFile->bChanged)
   {
-    strcpy(sTargetName, pFile->sFileName);
     /*
     Check to see whether the file is a link.
     */
@@ -892,39 +1021,151 @@ _check_for_link:
 #endif  /* ifdef UNIX */
     strcpy(sBackupName, sTargetName);
     ChangeFileNameExtention(sBackupName, sBak);
-    /*
-    Check whether the .bak file exists
-    */
-    if (FileExists(sBackupName))
-    {
-      /* .BAK file exists. Remove the .BAK file	*/
-      if (unlink(sBackupName))
-      {
-        /* unlink failed: display error */
-        ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK, sBackupName, NULL);
-        return;
-      }
-    }
-    if (rename(sTargetName, sBackupName))
-    {
-      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK, pFile->sFileName, NULL);
-      return;
-    }
+    bBackupFile = TRUE;
+  }
+
+  /*
+  Pin the snapshot of the lines.
+  */
+  pContext = alloc(sizeof(TStoreContext));
+  if (pContext == NULL)
+    return;  /* No memory */
+  pContext->bStoreAll = bStoreAllSubmit;
+  pContext->pMRUList = pMRUList;
+  pContext->pLines = NULL;
+  pContext->nNumberOfLines = pFile->nNumberOfLines;
+  pContext->nEditVersion = pFile->nEditVersion;
+  pContext->nOutputEOLType = nFileSaveMode == -1 ? pFile->nEOLType : nFileSaveMode;
+  if (pFile->nNumberOfLines > 0)
+  {
+    pContext->pLines = alloc(sizeof(TLine) * pFile->nNumberOfLines);
+    if (pContext->pLines == NULL)
+      goto _dispose_context;
+    memcpy(pContext->pLines, pFile->pIndex, sizeof(TLine) * pFile->nNumberOfLines);
+    RefLines(pContext->pLines, pContext->nNumberOfLines, TRUE);
+  }
+
+  pFile->pSaveJob = SaveJobSubmit(pFile->sFileName, sTargetName,
+    bBackupFile ? sBackupName : NULL, pContext->pLines,
+    pContext->nNumberOfLines, pContext->nOutputEOLType, pContext);
+  if (pFile->pSaveJob == NULL)
+  {
+    RefLines(pContext->pLines, pContext->nNumberOfLines, FALSE);
+    s_free(pContext->pLines);
+    goto _dispose_context;
+  }
+  pFile->nSaveUndoID = GetLastDoneUndoID(pFile);
+  disp_set_tick(disp, 1);  /* CheckStoredFiles() is to see the result */
+  if (pContext->bStoreAll)
+    ++nStoreAllFiles;
+  return;
+
+_dispose_context:
+  s_free(pContext);
+}
+
+/* ************************************************************************
+   Function: StoreAllReportError
+   Description:
+     Adds a file that Save All failed to store to the report. The
+     first error of a Save All replaces the old contents of the set.
+*/
+static void StoreAllReportError(const char *psFileName, const char *psError)
+{
+  TMarkLocation *pMark;
+
+  if (nStoreAllFailed == 0)
+  {
+    BMListDisposeBMSet(pStoreAllReport);
+    BMListInsert(NULL, 0, 0, -1, sSaveAllErrors, NULL, 0,
+      pStoreAllReport, &pMark, BOOKM_STATIC);
   }
+  BMListInsert(psFileName, 0, 0, -1, psError, NULL, 0,
+    pStoreAllReport, &pMark, BOOKM_STATIC);
+}
 
-  nOutputEOLType = nFileSaveMode == -1 ? pFile->nEOLType : nFileSaveMode;
-  switch (StoreFilePrim(pFile, nOutputEOLType))
+/* ************************************************************************
+   Function: StoreAllProgress
+   Description:
+     Counts a file of Save All that the writers are done with.
+*/
+static void StoreAllProgress(BOOLEAN bFailed, dispc_t *disp)
+{
+  ASSERT(pStoreAllList != NULL);
+
+  ++nStoreAllStored;
+  if (bFailed)
+    ++nStoreAllFailed;
+  if (!bStoreAllSubmit)
+    StoreAllEnd(disp);  /* Update the progress */
+}
+
+/* ************************************************************************
+   Function: StoreFileDone
+   Description:
+     Completes the store of a file after the writer is done.
+     -- Releases the snapshot of the lines.
+     -- Displays the error if the store failed.
+     -- If the file is new adds the file to the MRU list.
+     -- If the store operation is successfull removes the recovery file.
+     -- Updates the file parameters (size, data, tame, etc.) as stored at the disk.
+     -- Updates the undo list to indicate that the point where the file
+     is stored.
+     The file remains changed if it was edited during the store.
+     The errors of a Save All go to the report instead of a message box.
+     disp is NULL when the workspace is disposed, only the snapshot is
+     released then.
+*/
+static void StoreFileDone(TFile *pFile, dispc_t *disp)
+{
+  TStoreContext *pContext;
+  char sBuf[_MAX_PATH + 40];
+  char sShrunkName[_MAX_PATH];
+  char sFailedName[_MAX_PATH];
+  const char *psFailedName;
+  char sOutput[25];
+  int nResult;
+  int nError;
+
+  ASSERT(VALID_PFILE(pFile));
+  ASSERT(pFile->pSaveJob != NULL);
+
+  pContext = SaveJobGetContext(pFile->pSaveJob);
+  nResult = SaveJobGetResult(pFile->pSaveJob, &nError, &psFailedName);
+  strcpy(sFailedName, psFailedName);
+  SaveJobDispose(pFile->pSaveJob);
+  pFile->pSaveJob = NULL;
+
+  if (pContext->pLines != NULL)
+  {
+    RefLines(pContext->pLines, pContext->nNumberOfLines, FALSE);
+    s_free(pContext->pLines);
+  }
+
+  if (disp == NULL)
+    goto _exit;
+  disp_set_tick(disp, 0);
+  pFile->bUpdateStatus = TRUE;
+
+  if (pContext->bStoreAll && nResult != 0)
+    StoreAllReportError(sFailedName, nResult == 2 ? sStoreIncomplete : strerror(nError));
+  switch (nResult)
   {
     case 0:   /* Stored sucessfully */
       break;
     case 1:  /* Failed to open the file for writing */
-      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK, pFile->sFileName, NULL);
-      return;
+    case 4:  /* Failed to remove the old .bak file */
+    case 5:  /* Failed to rename the file to .bak */
+      if (pContext->bStoreAll)
+        goto _exit;
+      errno = nError;
+      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK, sFailedName, NULL);
+      goto _exit;
     case 2:  /* Failed to store whole the file */
+      if (pContext->bStoreAll)
+        goto _exit;
       ConsoleMessageProc(disp, NULL, MSG_ERROR | MSG_OK, pFile->sFileName, sSaveFailed);
-      return;
-    case 3:  /* No memory to convert the file to be stored to disk */
-      return;
+      goto _exit;
     default:
       ASSERT(0);
   }
@@ -941,89 +1182,176 @@ _check_for_link:
   /*
   Prepare a message at the status line
   that the file was successfully stored.
+  Save All shows a single message for all the files.
   */
-  ShrinkPath(pFile->sFileName, sShrunkName, disp_wnd_get_width(disp) - 26, FALSE);
-  sprintf(sBuf, sFileSaved, sShrunkName);
-  strcpy(pFile->sMsg, sBuf);
+  if (!pContext->bStoreAll)
+  {
+    ShrinkPath(pFile->sFileName, sShrunkName, disp_wnd_get_width(disp) - 26, FALSE);
+    sprintf(sBuf, sFileSaved, sShrunkName);
+    strcpy(pFile->sMsg, sBuf);
 
-  /*
-  Indicate whether the file has been converted.
-  */
-  sOutput[0] = '\0';
-  if (nFileSaveMode != -1)  /* If mode is not "auto" */
-    if (pFile->nEOLType != nFileSaveMode)  /* Change of EOL type? */
-      if (pFile->nEOLTypeDisk != nFileSaveMode)
-        sprintf(sOutput, sConverted, sEOLTypes[nFileSaveMode + 1]);
-  strcat(pFile->sMsg, sOutput);
-  pFile->nEOLTypeDisk = nOutputEOLType;  /* File format as stored on disk */
+    /*
+    Indicate whether the file has been converted.
+    */
+    sOutput[0] = '\0';
+    if (nFileSaveMode != -1)  /* If mode is not "auto" */
+      if (pFile->nEOLType != nFileSaveMode)  /* Change of EOL type? */
+        if (pFile->nEOLTypeDisk != nFileSaveMode)
+          sprintf(sOutput, sConverted, sEOLTypes[nFileSaveMode + 1]);
+    strcat(pFile->sMsg, sOutput);
+  }
+  pFile->nEOLTypeDisk = pContext->nOutputEOLType;  /* File format as stored on disk */
 
-  pFile->bChanged = FALSE;
+  if (pFile->nEditVersion == pContext->nEditVersion)
+    pFile->bChanged = FALSE;  /* Not edited while being stored */
   if (pFile->bNew)
   {
     /* As the file exists on disk it is time to put the file in MRU list */
-    AddFileToMRUList(pMRUList, pFile->sFileName, pFile->nCopy, FALSE, TRUE,
+    AddFileToMRUList(pContext->pMRUList, pFile->sFileName, pFile->nCopy, FALSE, TRUE,
       pFile->bForceReadOnly, pFile->nCol, pFile->nRow, pFile->nTopLine, FALSE);
     pFile->bNew = FALSE;
   }
 
-  /*
-  Remove the recovery file.
-  */
-  if (FileExists(pFile->sRecoveryFileName))
-  {
-    /* .rec file exists. Remove the .rec file */
-    if (unlink(pFile->sRecoveryFileName) != 0)
-    {
-      /* unlink failed: display error */
-      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK,
-        pFile->sRecoveryFileName, NULL);
-    }
-    pFile->bRecoveryStored = FALSE;
-    pFile->bForceNewRecoveryFile = TRUE;
-  }
+  MarkFileAsStored(pFile, pFile->nSaveUndoID, disp);
+
+_exit:
+  if (pContext->bStoreAll && disp != NULL)
+    StoreAllProgress(nResult != 0, disp);
+  s_free(pContext);
+}
+
+/* ************************************************************************
+   Function: StoreFileWait
+   Description:
+     Waits for the store of a file in progress and completes it.
+     To be called before anything that disposes the text of the file,
+     replaces the undo list or changes the file name.
+*/
+void StoreFileWait(TFile *pFile, dispc_t *disp)
+{
+  ASSERT(VALID_PFILE(pFile));
+
+  if (pFile->pSaveJob == NULL)
+    return;
+
+  SaveJobWait(pFile->pSaveJob);
+  StoreFileDone(pFile, disp);
+}
+
+/* ************************************************************************
+   Function: CheckStoredFile
+   Description:
+     FileListForEach() call-back, completes the store of a file
+     if the writer is done.
+*/
+static BOOLEAN CheckStoredFile(TFile *pFile, void *pContext)
+{
+  if (pFile->pSaveJob != NULL && SaveJobIsDone(pFile->pSaveJob))
+    StoreFileDone(pFile, pContext);
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: WaitStoredFile
+   Description:
+     FileListForEach() call-back, waits for the store of a file.
+*/
+static BOOLEAN WaitStoredFile(TFile *pFile, void *pContext)
+{
+  StoreFileWait(pFile, pContext);
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: WaitStoredFiles
+   Description:
+     Waits for all the stores in progress and completes them.
+*/
+void WaitStoredFiles(TFileList *pFileList, dispc_t *disp)
+{
+  FileListForEach(pFileList, WaitStoredFile, FALSE, disp);
+}
 
+/* ************************************************************************
+   Function: CheckStoredFiles
+   Description:
+     Completes the stores that the writer is done with. Checked after
+     every event, while a store is in progress EVENT_TIMER_TICK comes.
+*/
+void CheckStoredFiles(TFileList *pFileList, dispc_t *disp)
+{
+  FileListForEach(pFileList, CheckStoredFile, FALSE, disp);
+}
+
+/* ************************************************************************
+   Function: StoreAllBegin
+   Description:
+     Starts a Save All. The StoreFile() calls until StoreAllEnd() pass
+     their files to the writers together, the errors are collected in
+     pReport. pfnShowReport() is called to display pReport if some of
+     the files are not saved.
+*/
+void StoreAllBegin(TFileList *pFileList, TBookmarksSet *pReport,
+  void (*pfnShowReport)(void *pCtx), dispc_t *disp)
+{
   /*
-  Get the file parameters as store on the disk.
-  NOTE: GetFileParamaters() is supposed to succeed always
-  on a file that was just written sucessfully.
+  Complete the stores in progress, the previous Save All too.
+  A file with a store in progress is then a part of this Save All.
   */
-  if (!GetFileParameters(pFile->sFileName, NULL, &pFile->LastWriteTime,
-    &pFile->nFileSize))
-  {
-    ASSERT(0);
-  }
+  WaitStoredFiles(pFileList, disp);
+  ASSERT(pStoreAllList == NULL);
+
+  pStoreAllList = pFileList;
+  pStoreAllReport = pReport;
+  pfnStoreAllShowReport = pfnShowReport;
+  bStoreAllSubmit = TRUE;
+  nStoreAllFiles = 0;
+  nStoreAllStored = 0;
+  nStoreAllFailed = 0;
+}
 
-  /*
-  Prepare undo list pRecoveryStore flag to reflect the fact
-  that the file has just being stored.
+/* ************************************************************************
+   Function: StoreAllEnd
+   Description:
+     Called after the last StoreFile() of a Save All, and again when
+     the writers are done with the last file of it. Shows the progress
+     or the summary.
+*/
+void StoreAllEnd(dispc_t *disp)
+{
+  TFile *pTopFile;
+  void (*pfnShowReport)(void *pCtx);
 
-  Set bRecoveryStored flag to FALSE for the undone blocks.
-  */
-  for (i = pFile->nNumberOfRecords - 1; i >= 0; --i)
+  if (pStoreAllList == NULL)
+    return;  /* Already completed */
+  bStoreAllSubmit = FALSE;
+
+  pTopFile = GetFileListTop(pStoreAllList);
+  if (nStoreAllStored < nStoreAllFiles)
   {
-    pUndoRec = &pFile->pUndoIndex[i];
-    ASSERT(VALID_PUNDOREC(pUndoRec));
-    ASSERT(pUndoRec->pData != NULL);
-    if (pUndoRec->bUndone)
-      pUndoRec->bRecoveryStore = FALSE;
-    else
-      break;
+    if (pTopFile != NULL)
+    {
+      sprintf(pTopFile->sMsg, sSavingFiles, nStoreAllStored, nStoreAllFiles);
+      pTopFile->bUpdateStatus = TRUE;
+    }
+    return;
   }
 
   /*
-  Set bRecoveryStored up to the bottom of the undo list
-  as for these items the disk file has stored the info.
+  All the files are done
   */
-  for (; i >= 0; --i)
+  if (pTopFile != NULL && nStoreAllFiles > 0)
   {
-    pUndoRec = &pFile->pUndoIndex[i];
-    ASSERT(VALID_PUNDOREC(pUndoRec));
-    ASSERT(pUndoRec->pData != NULL);
-    ASSERT(!pUndoRec->bUndone);
-    pUndoRec->bRecoveryStore = TRUE;
+    if (nStoreAllFailed == 0)
+      sprintf(pTopFile->sMsg, sFilesSaved, nStoreAllFiles);
+    else
+      sprintf(pTopFile->sMsg, sFilesNotSaved, nStoreAllFailed, nStoreAllFiles);
+    pTopFile->bUpdateStatus = TRUE;
   }
-
-  pFile->bForceNewRecoveryFile = TRUE;
+  pfnShowReport = pfnStoreAllShowReport;
+  pStoreAllList = NULL;
+  if (nStoreAllFailed > 0)
+    pfnShowReport(NULL);
 }
 
 /* ************************************************************************
@@ -1041,6 +1369,8 @@ void StoreFileAs(char *sFileName, TFile *pFile, TFileList *pFileList,
   ASSERT(sFileName[0] != '\0');
   ASSERT(VALID_PFILE(pFile));
 
+  StoreFileWait(pFile, disp);  /* Complete the store under the old name */
+
   /*
   Mark the old file as closed in the MRU list
   */
@@ -1053,6 +1383,7 @@ void StoreFileAs(char *sFileName, TFile *pFile, TFileList *pFileList,
   if (FileExists(pFile->sRecoveryFileName))
   {
     /* .rec file exists. Remove the .rec file */
+    CloseRecoveryJournal(pFile);
     if (unlink(pFile->sRecoveryFileName) != 0)
     {
       /* unlink failed: display error */
@@ -1088,6 +1419,394 @@ void StoreFileAs(char *sFileName, TFile *pFile, TFileList *pFileList,
     pFile->nType = pDocType->nType;
 }
 
+/* ************************************************************************
+   Function: MapLine
+   Description:
+     Maps a line of the file before a reload to the same place in the
+     file after the reload.
+*/
+static int MapLine(int nLine, const TLineDiffHunk *pHunks, int nNumHunks)
+{
+  int nShift;
+  int i;
+
+  nShift = 0;
+  for (i = 0; i < nNumHunks; ++i)
+  {
+    if (nLine < pHunks[i].nOldLine)
+      break;
+    if (nLine < pHunks[i].nOldLine + pHunks[i].nOldCount)
+    {
+      /* Inside a replaced range */
+      if (nLine - pHunks[i].nOldLine >= pHunks[i].nNewCount)
+        return pHunks[i].nNewLine + pHunks[i].nNewCount;
+      return pHunks[i].nNewLine + nLine - pHunks[i].nOldLine;
+    }
+    nShift += pHunks[i].nNewCount - pHunks[i].nOldCount;
+  }
+  return nLine + nShift;
+}
+
+/* ************************************************************************
+   Function: ReloadFile
+   Description:
+     Makes the file in memory match the file on disk.
+     The file on disk is loaded in a temporary file and is compared
+     line by line with the file in memory. Only the lines that differ
+     are replaced by the block primitives, so the bookmarks and the
+     syntax status of the rest of the lines remain and the reload
+     is a single step that can be undone.
+   Returns:
+     FALSE if the file can not be loaded, a message is displayed.
+*/
+BOOLEAN ReloadFile(TFile *pFile, dispc_t *disp)
+{
+  TFile DiskFile;
+  TLineDiffHunk *pHunks;
+  const TLineDiffHunk *pHunk;
+  int nNumHunks;
+  TBlock *pBlock;
+  int nUndoEntry;
+  BOOLEAN bResult;
+  BOOLEAN bForceReadOnly;
+  int nCol;
+  int nRow;
+  int nTopLine;
+  int i;
+  char sBuf[_MAX_PATH + 40];
+  char sShrunkName[_MAX_PATH];
+
+  ASSERT(VALID_PFILE(pFile));
+
+  StoreFileWait(pFile, disp);
+  ConsoleMessageProc(disp, NULL, MSG_STATONLY | MSG_INFO, pFile->sFileName, sReloading);
+
+  bResult = FALSE;
+  pHunks = NULL;
+  InitEmptyFile(&DiskFile);
+  strcpy(DiskFile.sFileName, pFile->sFileName);
+  switch (LoadFilePrim(&DiskFile))
+  {
+    case 0:  /* Load OK */
+      break;
+    case 3:  /* No memory */
+      ConsoleMessageProc(disp, NULL, MSG_ERROR | MSG_OK, NULL, sNoMemory);
+      bNoMemory = FALSE;
+      goto _exit;
+    case 2:  /* File doesn't exists */
+    case 4:  /* Invalid path -- errno */
+    case 5:  /* Error while reading file -- errno */
+      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK, pFile->sFileName, NULL);
+      goto _exit;
+    default:
+      ASSERT(0);  /* Invalid LoadFilePrim() output */
+      goto _exit;
+  }
+
+  nNumHunks = LineDiff(pFile, &DiskFile, &pHunks);
+  if (nNumHunks < 0)
+  {
+    ConsoleMessageProc(disp, NULL, MSG_ERROR | MSG_OK, NULL, sNoMemory);
+    bNoMemory = FALSE;
+    goto _exit;
+  }
+
+  nCol = pFile->nCol;
+  nRow = MapLine(pFile->nRow, pHunks, nNumHunks);
+  nTopLine = MapLine(pFile->nTopLine, pHunks, nNumHunks);
+
+  /*
+  The disk file decides whether the file is read-only, the user
+  decision to keep the file read-only remains.
+  */
+  bForceReadOnly = pFile->bForceReadOnly;
+  pFile->bForceReadOnly = FALSE;
+  pFile->bReadOnly = FALSE;
+  pFile->nEOLType = DiskFile.nEOLType;
+
+  /*
+  Replace the ranges bottom up, so the line numbers of the
+  ranges above remain valid.
+  */
+  bResult = TRUE;
+  nUndoEntry = UNDO_BLOCK_BEGIN();
+  for (i = nNumHunks - 1; i >= 0; --i)
+  {
+    pHunk = &pHunks[i];
+    if (pHunk->nOldCount > 0)
+    {
+      if (!DeleteCharacterBlock(pFile, pHunk->nOldLine, 0,
+        pHunk->nOldLine + pHunk->nOldCount, -1))
+      {
+        bResult = FALSE;
+        break;
+      }
+    }
+    if (pHunk->nNewCount > 0)
+    {
+      pBlock = MakeACopyOfBlock(&DiskFile, pHunk->nNewLine,
+        pHunk->nNewLine + pHunk->nNewCount, 0, -1, 0);
+      if (pBlock == NULL)
+      {
+        bResult = FALSE;
+        break;
+      }
+      bResult = InsertCharacterBlock(pFile, pBlock, 0, pHunk->nOldLine);
+      DisposeABlock(&pBlock);
+      if (!bResult)
+        break;
+    }
+  }
+  /*
+  Put the cursor back before the end of the undo block, so the
+  status stored for the undo matches and a single Undo reverts.
+  */
+  if (nRow > pFile->nNumberOfLines)
+    nRow = pFile->nNumberOfLines;
+  if (nTopLine > nRow)
+    nTopLine = nRow;
+  pFile->nTopLine = nTopLine;
+  GotoColRow(pFile, nCol, nRow);
+  pFile->bUpdatePage = TRUE;
+
+  /*
+  A failed step removes its own undo record, the steps already
+  done are kept as a single undo step.
+  */
+  UNDO_BLOCK_END(nUndoEntry, TRUE);
+
+  pFile->bForceReadOnly = bForceReadOnly;
+  pFile->bReadOnly = DiskFile.bReadOnly;
+
+  if (!bResult)
+  {
+    ConsoleMessageProc(disp, NULL, MSG_ERROR | MSG_OK, NULL, sNoMemory);
+    bNoMemory = FALSE;
+    goto _exit;
+  }
+
+  ShrinkPath(pFile->sFileName, sShrunkName, disp_wnd_get_width(disp) - 26, FALSE);
+  sprintf(sBuf, sFileReloaded, sShrunkName);
+  strcpy(pFile->sMsg, sBuf);
+
+  pFile->nEOLTypeDisk = DiskFile.nEOLType;
+  pFile->bChanged = FALSE;
+  pFile->bNew = FALSE;
+  MarkFileAsStored(pFile, GetLastDoneUndoID(pFile), disp);
+
+_exit:
+  if (pHunks != NULL)
+    s_free(pHunks);
+  DisposeFile(&DiskFile);
+  return bResult;
+}
+
+/* ************************************************************************
+   Function: FollowFileStart
+   Description:
+     Turns on the follow mode. The lines appended on disk are added at
+     the end of the file as they come, see FollowFile(). The file is
+     read only in this mode and the undo history is dropped, so the
+     lines in memory remain a copy of the start of the disk file.
+*/
+BOOLEAN FollowFileStart(TFile *pFile, dispc_t *disp)
+{
+  FILE *f;
+  int c;
+
+  ASSERT(VALID_PFILE(pFile));
+
+  StoreFileWait(pFile, disp);
+  ASSERT(!pFile->bChanged);
+
+  pFile->nFollowPos = 0;
+  pFile->bFollowPartial = FALSE;
+  if (pFile->DiskID.nSize > 0)
+  {
+    /*
+    Find whether the last line has its end-of-line marker,
+    if not the line is to be read again with the bytes that follow.
+    */
+    c = EOF;
+    f = fopen(pFile->sFileName, READ_BINARY_FILE);
+    if (f != NULL)
+    {
+      if (fseek(f, pFile->DiskID.nSize - 1, SEEK_SET) == 0)
+        c = fgetc(f);
+      fclose(f);
+    }
+    if (c == EOF)
+    {
+      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK, pFile->sFileName, NULL);
+      return FALSE;
+    }
+    pFile->nFollowPos = pFile->DiskID.nSize;
+    if (c != '\n' && c != '\0' && pFile->nNumberOfLines > 0)
+    {
+      pFile->nFollowPos -= GetLine(pFile, pFile->nNumberOfLines - 1)->nLen;
+      if (c == '\r')
+        --pFile->nFollowPos;  /* CR/LF pair may be incomplete */
+      pFile->bFollowPartial = TRUE;
+    }
+  }
+
+  DisposeUndoIndexData(pFile);
+  pFile->nNumberOfRecords = 0;
+
+  pFile->bFollowReadOnly = pFile->bForceReadOnly;
+  pFile->bForceReadOnly = TRUE;
+  pFile->bFollow = TRUE;
+  pFile->bCheckDisk = TRUE;  /* Take what was appended since the load */
+
+  GotoColRow(pFile, 0, pFile->nNumberOfLines);
+  strcpy(pFile->sMsg, sFollowing);
+  pFile->bUpdatePage = TRUE;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: FollowFileStop
+   Description:
+     Turns off the follow mode.
+*/
+void FollowFileStop(TFile *pFile)
+{
+  ASSERT(VALID_PFILE(pFile));
+
+  pFile->bFollow = FALSE;
+  pFile->bForceReadOnly = pFile->bFollowReadOnly;
+  strcpy(pFile->sMsg, sFollowStopped);
+}
+
+/* ************************************************************************
+   Function: FollowFile
+   Description:
+     Adds the lines appended to a file in follow mode. Only the new
+     bytes are read. A file that is truncated or replaced (rotated)
+     is loaded again from its start.
+     The cursor goes along with the end of the file while it is on
+     the last line, the user moves it up to stop the scrolling.
+*/
+static void FollowFile(TFile *pFile, const TFileID *pOldID, dispc_t *disp)
+{
+  BOOLEAN bAtEnd;
+  BOOLEAN bLoadAgain;
+
+  ASSERT(VALID_PFILE(pFile));
+  ASSERT(pFile->bFollow);
+
+  if (pFile->DiskID.nSize == -1)
+  {
+    strcpy(pFile->sMsg, sDeletedOnDisk);
+    return;  /* Waiting for a new file by the same name */
+  }
+
+  bAtEnd = pFile->nRow >= pFile->nNumberOfLines - 1;
+
+  bLoadAgain = pFile->DiskID.nInode != pOldID->nInode ||
+    pFile->DiskID.nSize < pOldID->nSize || pOldID->nSize == -1;
+  if (bLoadAgain)
+  {
+    DisposeBlockList(&pFile->blist);
+    if (pFile->pIndex != NULL)
+      TArrayDispose(pFile->pIndex);
+    pFile->nNumberOfLines = 0;
+    pFile->nFileSize = 0;
+    pFile->nFollowPos = 0;
+    pFile->bFollowPartial = FALSE;
+    pFile->bBlock = FALSE;
+    pFile->pCurPos = NULL;
+    if (pFile->nTopLine > 0)
+      pFile->nTopLine = 0;
+    LinesChanged(pFile, 0);  /* Even if nothing is read in place of them */
+    pFile->bUpdatePage = TRUE;
+    FileWatchFile(pFile);  /* Watch the new inode */
+  }
+
+  switch (LoadFileTailPrim(pFile, (int)pFile->DiskID.nSize))
+  {
+    case 0:  /* Load OK */
+      break;
+    case 3:  /* No memory */
+      FollowFileStop(pFile);
+      ConsoleMessageProc(disp, NULL, MSG_ERROR | MSG_OK, NULL, sNoMemory);
+      bNoMemory = FALSE;
+      break;
+    case 5:  /* Error while reading file -- errno */
+      FollowFileStop(pFile);
+      ConsoleMessageProc(disp, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK, pFile->sFileName, NULL);
+      break;
+    default:
+      ASSERT(0);  /* Invalid LoadFileTailPrim() output */
+  }
+
+  /* The last line might be replaced, pCurPos is to be set again */
+  if (bAtEnd)
+    GotoColRow(pFile, 0, pFile->nNumberOfLines);
+  else
+    GotoColRow(pFile, pFile->nCol, pFile->nRow);
+  if (pFile->nTopLine > pFile->nNumberOfLines)
+    pFile->nTopLine = pFile->nNumberOfLines;
+
+  if (bLoadAgain && pFile->bFollow)
+    strcpy(pFile->sMsg, sFollowLoadedAgain);
+  pFile->bUpdatePage = TRUE;
+}
+
+/* ************************************************************************
+   Function: CheckDiskFile
+   Description:
+     FileListForEach() call-back, checks a file signaled by filewatch.c.
+     A file changed on disk is reloaded, if the file is changed in
+     memory too the user is asked first. A file in follow mode
+     gets only the lines appended.
+*/
+static BOOLEAN CheckDiskFile(TFile *pFile, void *pContext)
+{
+  dispc_t *disp;
+  TFileID OldID;
+
+  disp = pContext;
+  if (pFile->pSaveJob != NULL)
+    return TRUE;  /* The writer is at the file, see StoreFileDone() */
+  OldID = pFile->DiskID;
+  if (!FileWatchCheck(pFile))
+    return TRUE;
+
+  if (pFile->bFollow)
+  {
+    FollowFile(pFile, &OldID, disp);
+    pFile->bUpdateStatus = TRUE;
+    return TRUE;
+  }
+
+  if (pFile->DiskID.nSize == -1)
+  {
+    strcpy(pFile->sMsg, sDeletedOnDisk);
+    pFile->bUpdateStatus = TRUE;
+    return TRUE;
+  }
+
+  if (pFile->bChanged)
+    if (ConsoleMessageProc(disp, NULL, MSG_WARNING | MSG_YESNO,
+      pFile->sFileName, sAskReloadChanged) != 0)
+      return TRUE;
+
+  ReloadFile(pFile, disp);
+  pFile->bUpdateStatus = TRUE;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: CheckDiskFiles
+   Description:
+     Processes the files that filewatch.c found changed on disk.
+*/
+void CheckDiskFiles(TFileList *pFileList, dispc_t *disp)
+{
+  FileListForEach(pFileList, CheckDiskFile, FALSE, disp);
+}
+
 /*
 This software is distributed under the conditions of the BSD style license.
 
@@ -41,9 +41,28 @@ TFile *AddNewFile(TFileList *pFileList, dispc_t *disp);
 
 void StoreFile(TFile *pFile, TMRUList *pMRUList, dispc_t *disp);
 
+void StoreFileWait(TFile *pFile, dispc_t *disp);
+
+void CheckStoredFiles(TFileList *pFileList, dispc_t *disp);
+
+void WaitStoredFiles(TFileList *pFileList, dispc_t *disp);
+
+void StoreAllBegin(TFileList *pFileList, TBookmarksSet *pReport,
+  void (*pfnShowReport)(void *pCtx), dispc_t *disp);
+
+void StoreAllEnd(dispc_t *disp);
+
 void StoreFileAs(char *sFileName, TFile *pFile, TFileList *pFileList,
   TMRUList *pMRUList, TDocType *pDocTypeSet, dispc_t *disp);
 
+BOOLEAN ReloadFile(TFile *pFile, dispc_t *disp);
+
+BOOLEAN FollowFileStart(TFile *pFile, dispc_t *disp);
+
+void FollowFileStop(TFile *pFile);
+
+void CheckDiskFiles(TFileList *pFileList, dispc_t *disp);
+
 #endif /* ifndef FILE2_H */
 
 /*
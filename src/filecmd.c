@@ -23,6 +23,7 @@ Descrition:
 #include "mru.h"
 #include "undo.h"
 #include "bookm.h"
+#include "bookmcmd.h"
 #include "cmdc.h"
 #include "filecmd.h"
 #include "memory.h"
@@ -51,6 +52,7 @@ static void CheckToRemoveRecoveryFile(TFile *pFile, dispc_t *disp)
   if (FileExists(pFile->sRecoveryFileName))
   {
     /* .rec file exists. Remove the .rec file */
+    CloseRecoveryJournal(pFile);
     if (unlink(pFile->sRecoveryFileName) != 0)
     {
       /* unlink failed: display error */
@@ -257,6 +259,9 @@ static BOOLEAN CheckSave(TFile *pFile, void *_pContext)
 
   pContext = _pContext;
   disp = wrkspace_get_disp(pContext->wrkspace);
+  if (!pContext->bCheck && pFile->pSaveJob != NULL)
+    return TRUE;  /* Already passed to the writers by this Save All */
+  StoreFileWait(pFile, disp);  /* bChanged is known after the store */
   if (pFile->bChanged)
   {
     if (!pContext->bCheck)
@@ -289,19 +294,83 @@ _saveafile:
 /* ************************************************************************
    Function: CmdFileSaveAll
    Description:
+     Passes all the changed files to the writers at once. The files
+     that are not saved are listed in the Output window.
 */
 void CmdFileSaveAll(void *pCtx)
 {
   TCheckSaveContext CheckSaveContext;
   int nCurFile;
+  dispc_t *disp;
 
   CheckSaveContext.bCanceled = FALSE;
   CheckSaveContext.bCheck = FALSE;
   CheckSaveContext.wrkspace = CMDC_WRKSPACE(pCtx);
+  disp = wrkspace_get_disp(CheckSaveContext.wrkspace);
 
   nCurFile = GetTopFileNumber(pFilesInMemoryList);
+  StoreAllBegin(pFilesInMemoryList, &stOutput, CmdWindowOutput, disp);
   FileListForEach(pFilesInMemoryList, CheckSave, FALSE, &CheckSaveContext);
   SetTopFileByLoadNumber(pFilesInMemoryList, nCurFile);
+  StoreAllEnd(disp);
+}
+
+/* ************************************************************************
+   Function: CmdFileReload
+   Description:
+     Reloads the current file from disk, asks before discarding changes.
+*/
+void CmdFileReload(void *pCtx)
+{
+  TFile *pFile;
+  dispc_t *disp;
+
+  pFile = CMDC_PFILE(pCtx);
+  disp = wrkspace_get_disp(CMDC_WRKSPACE(pCtx));
+
+  StoreFileWait(pFile, disp);
+  if (pFile->bChanged)
+    if (ConsoleMessageProc(disp, NULL, MSG_WARNING | MSG_YESNO,
+      pFile->sFileName, sAskReload) != 0)
+      return;
+
+  ReloadFile(pFile, disp);
+  pFile->bUpdateStatus = TRUE;
+}
+
+/* ************************************************************************
+   Function: CmdFileFollow
+   Description:
+     Turns on/off the follow mode for the current file, the lines
+     appended on disk are added at the end of the file.
+*/
+void CmdFileFollow(void *pCtx)
+{
+  TFile *pFile;
+  dispc_t *disp;
+
+  pFile = CMDC_PFILE(pCtx);
+  disp = wrkspace_get_disp(CMDC_WRKSPACE(pCtx));
+
+  if (pFile->bFollow)
+  {
+    FollowFileStop(pFile);
+    pFile->bUpdateStatus = TRUE;
+    return;
+  }
+
+  StoreFileWait(pFile, disp);
+  if (pFile->bChanged)
+  {
+    if (ConsoleMessageProc(disp, NULL, MSG_WARNING | MSG_YESNO,
+      pFile->sFileName, sAskReload) != 0)
+      return;
+    if (!ReloadFile(pFile, disp))
+      return;
+  }
+
+  FollowFileStart(pFile, disp);
+  pFile->bUpdateStatus = TRUE;
 }
 
 /* ************************************************************************
@@ -317,6 +386,7 @@ void CmdFileClose(void *pCtx)
   pFile = CMDC_PFILE(pCtx);
   disp = wrkspace_get_disp(CMDC_WRKSPACE(pCtx));
 
+  StoreFileWait(pFile, disp);
   StoreRecoveryRecord(pFile);
 
   strcpy(sExpandedNoname, sNoname);
@@ -337,6 +407,7 @@ void CmdFileClose(void *pCtx)
     {
       case 0:  /* Yes or Enter */
         CmdFileSave(pCtx);
+        StoreFileWait(pFile, disp);
         break;
       case 1:  /* No */
         pFile->bChanged = FALSE;  /* This will remove the recovery file below */
@@ -413,6 +484,7 @@ void CmdFileExit(void *pCtx)
   CheckSaveContext.bCheck = TRUE;
   CheckSaveContext.wrkspace = CMDC_WRKSPACE(pCtx);
   FileListForEach(pFilesInMemoryList, CheckSave, FALSE, &CheckSaveContext);
+  WaitStoredFiles(pFilesInMemoryList, disp);
   if (CheckSaveContext.bCanceled)
     return;
 
@@ -1075,12 +1147,16 @@ void DumpFile(const TFile *pFile, dispc_t* disp)
   PrintString(disp, "    ~read only:~ %s    ~force r/o:~ %s\n", GetBool(pFile->bReadOnly), GetBool(pFile->bForceReadOnly));
   PrintString(disp, "   ~rec stored:~ %s\n", GetBool(pFile->bRecoveryStored));
   PrintString(disp, "  ~undo id cnt:~ %-4d  ~undo records:~ %d\n", pFile->nUndoIDCounter, pFile->nNumberOfRecords);
+  PrintString(disp, "  ~undo memory:~ %ldKB (limit %dKB)  ~records:~ %ldKB  ~spill file:~ %ldKB\n",
+    pFile->nUndoMemory / 1024, nUndoMemoryLimit,
+    (long)(pFile->nNumberOfRecords * sizeof(TUndoRecord) / 1024),
+    pFile->nUndoSpillSize / 1024);
   #ifdef _DEBUG
   if (pFile->pUndoIndex != NULL)
     ASSERT(pFile->nNumberOfRecords == _TArrayCount(pFile->pUndoIndex));
   #endif
 
-  nLines = 17;
+  nLines = 18;
   nRef = DumpBlockList(&pFile->blist, &nLines, &nAllocatedSize, disp);
 
   nActualSize = CalcFileSize(pFile);
@@ -1184,6 +1260,8 @@ void DumpUndoIndex(TFile *pFile, dispc_t *disp)
 {
   int i;
   TUndoRecord *pUndoRec;
+  TFileStatus Before;
+  TFileStatus After;
   char *p;
   DWORD nKey;
   disp_event_t ev;
@@ -1225,18 +1303,21 @@ void DumpUndoIndex(TFile *pFile, dispc_t *disp)
       PrintString(disp, " (UNDONE)");
     PrintString(disp, "\n");
     PrintString(disp, "bRecoveryStore: %s\n", GetBool(pUndoRec->bRecoveryStore));
+    PrintString(disp, "packed status: %d bytes%s\n", pUndoRec->nStatusSize,
+      pUndoRec->bStatusOnHeap ? " (heap)" : "");
+    GetUndoRecordStatus(pUndoRec, &Before, &After);
     PrintString(disp, "------ before[%d]: cursor pos (%d:%d), selection (%d:%d / %d:%d) %d lines ------\n",
       pUndoRec->nUndoBlockID,
-      pUndoRec->before.nCol, pUndoRec->before.nRow,
-      pUndoRec->before.nStartLine, pUndoRec->before.nStartPos,
-      pUndoRec->before.nEndLine, pUndoRec->before.nEndPos,
-      pUndoRec->before.nNumberOfLines);
+      Before.nCol, Before.nRow,
+      Before.nStartLine, Before.nStartPos,
+      Before.nEndLine, Before.nEndPos,
+      Before.nNumberOfLines);
     PrintString(disp, "------ after [%d]: cursor pos (%d:%d), selection (%d:%d / %d:%d) %d lines ------\n",
       pUndoRec->nUndoBlockID,
-      pUndoRec->after.nCol, pUndoRec->after.nRow,
-      pUndoRec->after.nStartLine, pUndoRec->after.nStartPos,
-      pUndoRec->after.nEndLine, pUndoRec->after.nEndPos,
-      pUndoRec->after.nNumberOfLines);
+      After.nCol, After.nRow,
+      After.nStartLine, After.nStartPos,
+      After.nEndLine, After.nEndPos,
+      After.nNumberOfLines);
     PrintString(disp, "press 'b' to dump data\n");
 _waitkey:
     do
@@ -1247,25 +1328,32 @@ _waitkey:
     nKey = ev.e.kbd.key;
     if (nKey == 0xffff)
       goto _waitkey;
-    if (ASC(nKey) == 'b' || ASC(nKey) == 'B')
-      switch (pUndoRec->nOperation)
-      {
-        case acREARRANGE:
-          PrintString(disp, "start line: %d, end line: %d\n", pUndoRec->nStart, pUndoRec->nEnd);
-          DumpRearrangeLines(pUndoRec->pData,
-            pUndoRec->nEnd - pUndoRec->nStart + 1, disp);
-          break;
-        default:
-          if (pUndoRec->pData == NULL)
-            PrintString(disp, "no data\n");
-          else
+    if (UNDO_DATA_SPILLED(pUndoRec))
+      PrintString(disp, "data in the spill file at %ld\n", pUndoRec->nSpillPos);
+    else
+      if (pUndoRec->bInlineData)
+        PrintString(disp, "data in the record: \"%.*s\"\n", (int)pUndoRec->nInlineLen,
+          (const char *)&pUndoRec->Packed[pUndoRec->nStatusSize + 1]);
+      else
+        if (ASC(nKey) == 'b' || ASC(nKey) == 'B')
+          switch (pUndoRec->nOperation)
           {
-            PrintString(disp, "data (%d:%d / %d:%d):\n",
-              pUndoRec->nStart, pUndoRec->nStartPos,
-              pUndoRec->nEnd, pUndoRec->nEndPos);
-            DumpBlock(pUndoRec->pData, 1, disp);
+            case acREARRANGE:
+              PrintString(disp, "start line: %d, end line: %d\n", pUndoRec->nStart, pUndoRec->nEnd);
+              DumpRearrangeLines(pUndoRec->pData,
+                pUndoRec->nEnd - pUndoRec->nStart + 1, disp);
+              break;
+            default:
+              if (pUndoRec->pData == NULL)
+                PrintString(disp, "no data\n");
+              else
+              {
+                PrintString(disp, "data (%d:%d / %d:%d):\n",
+                  pUndoRec->nStart, pUndoRec->nStartPos,
+                  pUndoRec->nEnd, pUndoRec->nEndPos);
+                DumpBlock(pUndoRec->pData, 1, disp);
+              }
           }
-      }
     p = "";
     if (pUndoRec->nUndoLevel == 1)
      p = "--- end of atom ";
@@ -1465,6 +1553,15 @@ void CmdHelpAbout(void *pCtx)
 #ifdef DISP_NCURSES
   PrintString(disp, "DISP_NCURSES\n");
 #endif
+#ifdef DISP_VT
+  PrintString(disp, "DISP_VT\n");
+#endif
+#ifdef DISP_HEADLESS
+  PrintString(disp, "DISP_HEADLESS\n");
+#endif
+#ifdef DISP_SELECT
+  PrintString(disp, "DISP_SELECT\n");
+#endif
 #ifdef DISP_WIN32_GUIEMU
   PrintString(disp, "DISP_WIN32_GUIEMU\n");
 #endif
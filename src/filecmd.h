@@ -28,6 +28,8 @@ void CmdFileSave(void *pCtx);
 void CmdFileSaveAs(void *pCtx);
 void CmdFileSaveAll(void *pCtx);
 void CmdFileClose(void *pCtx);
+void CmdFileReload(void *pCtx);
+void CmdFileFollow(void *pCtx);
 void CmdFileExit(void *pCtx);
 void CmdFileOpenMRU1(void *pCtx);
 void CmdFileOpenMRU2(void *pCtx);
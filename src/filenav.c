@@ -20,6 +20,7 @@ Descrition:
 #include "contain.h"
 #include "fview.h"
 #include "wrkspace.h"
+#include "search.h"  /* DisposePageMatches() */
 
 #define INIT_FILELIST(pFileList)  INITIALIZE_LIST_HEAD(&pFileList->flist)
 
@@ -94,6 +95,7 @@ void DoneFileList(TFileList *pFileList)
   {
     pFileItem = REMOVE_TOP_FILE(pFileList);
     ASSERT(VALID_PFILEITEM(pFileItem));
+    DisposePageMatches(&pFileItem->stFileView.ExtraColorInterf.pMatchCache);
     #ifdef _DEBUG
     pFileItem->MagicByte = 0;
     #endif
@@ -366,6 +368,11 @@ _remove_target:
   BMListDisposeBMSet(&pTargetFile->stFuncNames);
   DoneBMSet(&pTargetFile->stFuncNames);
 
+  /*
+  Dispose of the cached search matches of the view
+  */
+  DisposePageMatches(&pTargetFile->stFileView.ExtraColorInterf.pMatchCache);
+
   /*
   Dispose of the TFileListItem envelope itself
   */
@@ -0,0 +1,430 @@
+/*
+
+File: filewatch.c
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Detection of the changes made to the files on disk by other programs.
+
+  Every file loaded or stored is registered with inotify together
+  with its directory (the directory reports the files replaced by
+  rename, the file itself the changes made through a symbolic link).
+  The inotify descriptor is watched by the disp event loop, which
+  sends EVENT_WATCH_FD when there are notifications to be read.
+  The notifications only mark the files to be checked, a change is
+  confirmed by comparing the time (in nanoseconds), the inode and
+  the size of the file with the ones taken at load or store time.
+
+  The files that can not be watched (no inotify on the platform,
+  the limit of watches reached) are checked on every EVENT_TIMER_5SEC.
+
+*/
+
+#include "global.h"
+#include "memory.h"
+#include "tarray.h"
+#include "wlimits.h"
+#include "filewatch.h"
+
+#ifdef LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+typedef struct Watch
+{
+  int wd;
+  int nRefs;  /* Files using the watch */
+  BOOLEAN bDir;
+} TWatch;
+
+static int nWatchFD = -1;
+static dispc_t *pWatchDisp;
+static TArray(TWatch) pWatches;
+
+#ifdef LINUX
+#define FILE_WATCH_MASK \
+  (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+#define DIR_WATCH_MASK \
+  (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | \
+  IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+#endif
+
+/* ************************************************************************
+   Function: FileWatchInit
+   Description:
+     Opens the inotify descriptor and passes it to the disp event loop.
+     Without it all the files are polled.
+*/
+void FileWatchInit(dispc_t *disp)
+{
+  ASSERT(nWatchFD == -1);
+
+  pWatchDisp = disp;
+  TArrayInit(pWatches, 16, 16);
+  if (pWatches == NULL)
+    return;
+
+#ifdef LINUX
+  nWatchFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (nWatchFD >= 0)
+    disp_set_watch_fd(disp, nWatchFD);
+#endif
+}
+
+/* ************************************************************************
+   Function: FileWatchDone
+   Description:
+*/
+void FileWatchDone(void)
+{
+#ifdef LINUX
+  if (nWatchFD >= 0)
+  {
+    disp_set_watch_fd(pWatchDisp, -1);
+    close(nWatchFD);  /* removes all the watches */
+    nWatchFD = -1;
+  }
+#endif
+  if (pWatches != NULL)
+    TArrayDispose(pWatches);
+  pWatches = NULL;
+}
+
+/* ************************************************************************
+   Function: GetFileID
+   Description:
+     Gets the identity of a file on disk. nSize is -1 if there is
+     no such file.
+*/
+void GetFileID(const char *psFileName, TFileID *pID)
+{
+  struct stat statbuf;
+
+  memset(pID, 0, sizeof(*pID));
+  pID->nSize = -1;
+  if (stat(psFileName, &statbuf) != 0)
+    return;
+
+  pID->nMTime = (long)statbuf.st_mtime;
+#ifdef LINUX
+  pID->nMTimeNSec = (long)statbuf.st_mtim.tv_nsec;
+  pID->nInode = (unsigned long)statbuf.st_ino;
+#endif
+  pID->nSize = (long)statbuf.st_size;
+}
+
+/* ************************************************************************
+   Function: FindWatch
+   Description:
+     Returns the index of wd in pWatches, -1 if not found.
+*/
+static int FindWatch(int wd)
+{
+  int i;
+
+  if (pWatches == NULL)
+    return -1;
+  for (i = 0; i < _TArrayCount(pWatches); ++i)
+    if (pWatches[i].wd == wd)
+      return i;
+  return -1;
+}
+
+/* ************************************************************************
+   Function: AddWatch
+   Description:
+     Adds a watch on psPath, or a reference to an existing watch
+     of the same inode. Returns the watch descriptor, -1 on failure.
+*/
+static int AddWatch(const char *psPath, BOOLEAN bDir)
+{
+#ifdef LINUX
+  int wd;
+  int i;
+  TWatch Watch;
+
+  if (nWatchFD < 0 || pWatches == NULL)
+    return -1;
+
+  wd = inotify_add_watch(nWatchFD, psPath, bDir ? DIR_WATCH_MASK : FILE_WATCH_MASK);
+  if (wd < 0)
+    return -1;
+
+  i = FindWatch(wd);
+  if (i >= 0)
+  {
+    ++pWatches[i].nRefs;
+    return wd;
+  }
+
+  Watch.wd = wd;
+  Watch.nRefs = 1;
+  Watch.bDir = bDir;
+  TArrayAdd(pWatches, Watch);
+  if (!TArrayStatus(pWatches))
+  {
+    TArrayClearStatus(pWatches);
+    inotify_rm_watch(nWatchFD, wd);
+    return -1;
+  }
+  return wd;
+#else
+  return -1;
+#endif
+}
+
+/* ************************************************************************
+   Function: ReleaseWatch
+   Description:
+     Removes a reference to a watch, removes the watch with the
+     last reference.
+*/
+static void ReleaseWatch(int wd)
+{
+  int i;
+
+  i = FindWatch(wd);
+  if (i < 0)
+    return;  /* Already removed by the kernel (IN_IGNORED) */
+  if (--pWatches[i].nRefs > 0)
+    return;
+#ifdef LINUX
+  inotify_rm_watch(nWatchFD, wd);
+#endif
+  TArrayDeleteGroup(pWatches, i, 1);
+}
+
+/* ************************************************************************
+   Function: FileWatchRelease
+   Description:
+     To be called before a file is removed from memory.
+*/
+void FileWatchRelease(TFile *pFile)
+{
+  ASSERT(VALID_PFILE(pFile));
+
+  if (pFile->nWatchWD >= 0)
+    ReleaseWatch(pFile->nWatchWD);
+  if (pFile->nWatchDirWD >= 0)
+    ReleaseWatch(pFile->nWatchDirWD);
+  pFile->nWatchWD = -1;
+  pFile->nWatchDirWD = -1;
+}
+
+/* ************************************************************************
+   Function: FileWatchFile
+   Description:
+     To be called when the file in memory matches the file on disk
+     -- after load, store or reload. Takes the identity of the disk
+     file and watches the file and its directory.
+*/
+void FileWatchFile(TFile *pFile)
+{
+  char sDir[_MAX_PATH];
+  char *p;
+
+  ASSERT(VALID_PFILE(pFile));
+
+  GetFileID(pFile->sFileName, &pFile->DiskID);
+  pFile->bCheckDisk = FALSE;
+
+  /* The name might have changed (Save As), or the inode (replaced) */
+  FileWatchRelease(pFile);
+
+  if (nWatchFD < 0)
+    return;
+
+  if (pFile->DiskID.nSize != -1)
+    pFile->nWatchWD = AddWatch(pFile->sFileName, FALSE);
+
+  strcpy(sDir, pFile->sFileName);
+  p = strrchr(sDir, PATH_SLASH_CHAR);
+  if (p == NULL)
+    return;
+  p[p == sDir ? 1 : 0] = '\0';
+  pFile->nWatchDirWD = AddWatch(sDir, TRUE);
+}
+
+#ifdef LINUX
+typedef struct WatchEventCtx
+{
+  const struct inotify_event *pEvent;
+  BOOLEAN bDir;
+} TWatchEventCtx;
+
+/* ************************************************************************
+   Function: MarkWatchedFile
+   Description:
+     FileListForEach() call-back, marks the files that an inotify
+     event concerns.
+*/
+static BOOLEAN MarkWatchedFile(TFile *pFile, void *pContext)
+{
+  TWatchEventCtx *pCtx;
+  const char *psName;
+
+  pCtx = pContext;
+  if (pCtx->pEvent->mask & IN_Q_OVERFLOW)  /* events lost, check all */
+  {
+    pFile->bCheckDisk = TRUE;
+    return TRUE;
+  }
+
+  if (pCtx->bDir)
+  {
+    if (pFile->nWatchDirWD != pCtx->pEvent->wd || pCtx->pEvent->len == 0)
+      return TRUE;
+    psName = strrchr(pFile->sFileName, PATH_SLASH_CHAR);
+    psName = psName == NULL ? pFile->sFileName : psName + 1;
+    if (strcmp(psName, pCtx->pEvent->name) == 0)
+      pFile->bCheckDisk = TRUE;
+    return TRUE;
+  }
+
+  if (pFile->nWatchWD != pCtx->pEvent->wd)
+    return TRUE;
+  pFile->bCheckDisk = TRUE;
+  if (pCtx->pEvent->mask & IN_IGNORED)
+    pFile->nWatchWD = -1;  /* The kernel removed the watch */
+  return TRUE;
+}
+#endif
+
+/* ************************************************************************
+   Function: FileWatchRead
+   Description:
+     Called on EVENT_WATCH_FD. Reads the inotify notifications and
+     marks the files to be checked. Arms the descriptor for the
+     next notifications.
+*/
+void FileWatchRead(TFileList *pFileList)
+{
+#ifdef LINUX
+  union
+  {
+    struct inotify_event Event;  /* for the alignment */
+    char Buf[4096];
+  } u;
+  const char *p;
+  int nRead;
+  int i;
+  TWatchEventCtx Ctx;
+
+  if (nWatchFD < 0)
+    return;
+
+  while ((nRead = read(nWatchFD, u.Buf, sizeof(u.Buf))) > 0)
+  {
+    for (p = u.Buf; p < u.Buf + nRead;
+      p += sizeof(struct inotify_event) + Ctx.pEvent->len)
+    {
+      Ctx.pEvent = (const struct inotify_event *)p;
+      i = FindWatch(Ctx.pEvent->wd);
+      if (i < 0 && !(Ctx.pEvent->mask & IN_Q_OVERFLOW))
+        continue;
+      Ctx.bDir = i >= 0 && pWatches[i].bDir;
+      FileListForEach(pFileList, MarkWatchedFile, FALSE, &Ctx);
+      if (i >= 0 && (Ctx.pEvent->mask & IN_IGNORED))
+        TArrayDeleteGroup(pWatches, i, 1);
+    }
+  }
+
+  disp_set_watch_fd(pWatchDisp, nWatchFD);
+#endif
+}
+
+/* ************************************************************************
+   Function: MarkPolledFile
+   Description:
+     FileListForEach() call-back, marks the files without watches.
+*/
+static BOOLEAN MarkPolledFile(TFile *pFile, void *pContext)
+{
+  if (pFile->nWatchWD == -1 && pFile->nWatchDirWD == -1 &&
+    pFile->DiskID.nSize != -1)
+    pFile->bCheckDisk = TRUE;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: FileWatchPoll
+   Description:
+     Called on EVENT_TIMER_5SEC. Marks the files that can not be
+     watched to be checked. Arms the inotify descriptor again, in case
+     EVENT_WATCH_FD was dropped by a nested event loop (dialog box).
+*/
+void FileWatchPoll(TFileList *pFileList)
+{
+  FileListForEach(pFileList, MarkPolledFile, FALSE, NULL);
+  if (nWatchFD >= 0)
+    disp_set_watch_fd(pWatchDisp, nWatchFD);
+}
+
+/* ************************************************************************
+   Function: FileWatchCheck
+   Description:
+     Checks a file marked by FileWatchRead() or FileWatchPoll().
+     Returns TRUE if the disk file is changed since the time it was
+     loaded or stored, the new identity is taken, so a change is
+     reported only once.
+*/
+BOOLEAN FileWatchCheck(TFile *pFile)
+{
+  TFileID ID;
+
+  ASSERT(VALID_PFILE(pFile));
+
+  if (!pFile->bCheckDisk)
+    return FALSE;
+  pFile->bCheckDisk = FALSE;
+
+  GetFileID(pFile->sFileName, &ID);
+  if (pFile->nWatchWD == -1 && ID.nSize != -1)
+  {
+    /* Replaced by rename or created, watch the new inode */
+    pFile->nWatchWD = AddWatch(pFile->sFileName, FALSE);
+  }
+
+  if (ID.nMTime == pFile->DiskID.nMTime &&
+    ID.nMTimeNSec == pFile->DiskID.nMTimeNSec &&
+    ID.nInode == pFile->DiskID.nInode &&
+    ID.nSize == pFile->DiskID.nSize)
+    return FALSE;
+  pFile->DiskID = ID;
+  return TRUE;
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -370,7 +370,11 @@ _execute_command2:
         if (pClipboard != NULL)
           DisposeABlock(&pClipboard);
         pClipboard = MakeBlock(ev->e.pdata, 0);
-        PasteAndIndent(GetCurrentFile(), pClipboard);
+        /*
+        The text comes from the terminal with its indentation, paste it
+        as it is in one undo block
+        */
+        Paste(GetCurrentFile(), pClipboard);
         bBlockMarkMode = FALSE;
         /* TODO: implement this function accross platforms and remove #ifdefs */
         #if 0
@@ -400,6 +404,12 @@ _execute_command2:
         #endif
         #endif
         break;
+
+      case EVENT_TIMER_TICK:  /* Background work, see HandleEvent() */
+        break;
+
+      case EVENT_WATCH_FD:  /* Files changed on disk, see HandleEvent() */
+        break;
     }
   }
   else
@@ -682,6 +682,7 @@ _display_on_off_error:
     LoadOption(sKey_SyntaxHighlighting, bSyntaxHighlighting_Opt);
     LoadOption(sKey_MatchPairHighlighting, bMatchPairHighlighting_Opt);
     LoadOption(sKey_IF0Highlighting, bIF0Highlighting_Opt);
+    LoadOption(sKey_HighlightSearchMatches, bHighlightSearchMatches_Opt);
     LoadOption(sKey_AscendingSort, bAscendingSort_Opt);
     LoadOption(sKey_CaseSensitiveSort, bCaseSensitiveSort_Opt);
 
@@ -721,6 +722,26 @@ _display_on_off_error:
       continue;
     }
 
+    if (stricmp(Key, sKey_UndoMemoryLimit) == 0)
+    {
+      bValResult = ValStr(Val, &nVal, 10);
+      if (!bValResult || nVal < 0)
+        DisplayINIFileError(pINIFile, nINILine, ERROR_INVALID_NUMBER, bSilent, disp);
+      else
+        nUndoMemoryLimit_Opt = nVal;
+      continue;
+    }
+
+    if (stricmp(Key, sKey_MaxFrameRate) == 0)
+    {
+      bValResult = ValStr(Val, &nVal, 10);
+      if (!bValResult || nVal < 0)
+        DisplayINIFileError(pINIFile, nINILine, ERROR_INVALID_NUMBER, bSilent, disp);
+      else
+        nMaxFrameRate_Opt = nVal;
+      continue;
+    }
+
     if (stricmp(Key, sKey_FileSaveMode) == 0)
     {
       if (stricmp(Val, sVal_Auto) == 0)
@@ -820,6 +841,9 @@ _failprintf:
   if (!SectionPrintF(pSec, "%s = %s\n", sKey_IF0Highlighting, GetOnOff(bIF0Highlighting_Opt)))
     goto _failprintf;
 
+  if (!SectionPrintF(pSec, "%s = %s\n", sKey_HighlightSearchMatches, GetOnOff(bHighlightSearchMatches_Opt)))
+    goto _failprintf;
+
   if (!SectionPrintF(pSec, "%s = %s\n", sKey_AscendingSort, GetOnOff(bAscendingSort_Opt)))
     goto _failprintf;
 
@@ -832,6 +856,12 @@ _failprintf:
   if (!SectionPrintF(pSec, "%s = %s\n", sKey_CombineUndo, GetOnOff(bCombineUndo_Opt)))
     goto _failprintf;
 
+  if (!SectionPrintF(pSec, "%s = %d\n", sKey_UndoMemoryLimit, nUndoMemoryLimit_Opt))
+    goto _failprintf;
+
+  if (!SectionPrintF(pSec, "%s = %d\n", sKey_MaxFrameRate, nMaxFrameRate_Opt))
+    goto _failprintf;
+
   if (!SectionPrintF(pSec, "%s = %s\n", sKey_StrictCheck, GetOnOff(bStrictCheck_Opt)))
     goto _failprintf;
 
@@ -151,6 +151,8 @@ TCmdDesc Commands[] =  /* All commands in CommandsSet should be described here *
   {cmFileSaveAs, "FileSaveAs", CmdFileSaveAs, "saveas", "Help on (File)~S~ave As"},
   {cmFileSaveAll, "FileSaveAll", CmdFileSaveAll, "saveall", "Help on (File)~S~ave All"},
   {cmFileClose, "FileClose", CmdFileClose, "close", "Help on (File)~C~lose"},
+  {cmFileReload, "FileReload", CmdFileReload, "reload", "Help on (File)Reloa~d~"},
+  {cmFileFollow, "FileFollow", CmdFileFollow, "follow", "Help on (File)Follo~w~"},
   {cmFileExit, "FileExit", CmdFileExit, "exit", "Help on (File)~E~xit"},
   {cmFileOpenMRU1, "FileOpenMRU1", CmdFileOpenMRU1, "recentfiles", "Help on (File)~R~ecent Files"},
   {cmFileOpenMRU2, "FileOpenMRU2", CmdFileOpenMRU2, "recentfiles", "Help on (File)~R~ecent Files"},
@@ -24,6 +24,8 @@ enum CommandsSet {
   cmFileSaveAs,
   cmFileSaveAll,
   cmFileClose,
+  cmFileReload,
+  cmFileFollow,
   cmFileExit,
 
   cmFileOpenMRU1,
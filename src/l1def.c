@@ -95,11 +95,14 @@ const char *sKey_OverwriteBlocks = "OverwriteBlocks";
 const char *sKey_SyntaxHighlighting = "SyntaxHighlighting";
 const char *sKey_MatchPairHighlighting = "MatchPairHighlighting";
 const char *sKey_IF0Highlighting = "IF0Highlighting";
+const char *sKey_HighlightSearchMatches = "HighlightSearchMatches";
 const char *sKey_AscendingSort = "AscendingSort";
 const char *sKey_CaseSensitiveSort = "CaseSensitiveSort";
 const char *sKey_RightMargin = "RightMargin";
 const char *sKey_FileSaveMode = "FileSaveMode";
 const char *sKey_CombineUndo = "CombineUndo";
+const char *sKey_UndoMemoryLimit = "UndoMemoryLimit";
+const char *sKey_MaxFrameRate = "MaxFrameRate";
 const char *sKey_ConsequtiveWinFiles = "ConsequtiveWinFiles";
 const char *sKey_StartWithEmptyFile = "StartWithEmptyFile";
 const char *sKey_Time = "Time";
@@ -151,6 +154,19 @@ const char *sSaving = "Saving (filename)...";
 const char *sFileSaved = "%s saved";
 const char *sConverted = " (converted to %s text format)";
 const char *sSaveFailed = "Failed to save (filename)";
+const char *sSavingFiles = "Saving files: %d of %d stored...";
+const char *sFilesSaved = "%d files saved";
+const char *sFilesNotSaved = "%d of %d files not saved";
+const char *sSaveAllErrors = " save all: files not saved";
+const char *sStoreIncomplete = "failed to store whole the file";
+const char *sReloading = "Reloading (filename)...";
+const char *sFileReloaded = "%s reloaded";
+const char *sAskReload = "(filename) changed. Discard the changes and reload";
+const char *sAskReloadChanged = "(filename) changed on disk. Discard the changes and reload";
+const char *sDeletedOnDisk = "Deleted on disk";
+const char *sFollowing = "Following the end of the file";
+const char *sFollowStopped = "Follow mode is off";
+const char *sFollowLoadedAgain = "Truncated or replaced on disk, loaded again";
 const char *sNoMemoryINI = "No enough memory to process the INI file";
 const char *sINIFormatChanged = "New cfg format - partial conversion supplied";
 const char *sINIFormatIsNew = "The cfg file is of a new unsupported version type.";
@@ -169,7 +185,6 @@ const char *sIncrementalSearch = "Incremental search:";
 const char *sIncrementalSearchBack = "Incremental search (back):";
 const char *sPassedEndOfFile = "<Passed end of file line>";
 const char *sAllFilesClosed = "All files have been closed";
-const char *sNewFileRec = "newfile";
 const char *sEnterLine = "Line:";
 const char *sInvalidNumber = "Invalid number \"%s\"";
 const char *sBlanksRemoved = "%d blank characters removed";
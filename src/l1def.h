@@ -80,11 +80,14 @@ extern const char *sKey_OverwriteBlocks;
 extern const char *sKey_SyntaxHighlighting;
 extern const char *sKey_MatchPairHighlighting;
 extern const char *sKey_IF0Highlighting;
+extern const char *sKey_HighlightSearchMatches;
 extern const char *sKey_AscendingSort;
 extern const char *sKey_CaseSensitiveSort;
 extern const char *sKey_RightMargin;
 extern const char *sKey_FileSaveMode;
 extern const char *sKey_CombineUndo;
+extern const char *sKey_UndoMemoryLimit;
+extern const char *sKey_MaxFrameRate;
 extern const char *sKey_ConsequtiveWinFiles;
 extern const char *sKey_StartWithEmptyFile;
 extern const char *sKey_Time;
@@ -135,6 +138,19 @@ extern const char *sSaving;
 extern const char *sFileSaved;
 extern const char *sConverted;
 extern const char *sSaveFailed;
+extern const char *sSavingFiles;
+extern const char *sFilesSaved;
+extern const char *sFilesNotSaved;
+extern const char *sSaveAllErrors;
+extern const char *sStoreIncomplete;
+extern const char *sReloading;
+extern const char *sFileReloaded;
+extern const char *sAskReload;
+extern const char *sAskReloadChanged;
+extern const char *sDeletedOnDisk;
+extern const char *sFollowing;
+extern const char *sFollowStopped;
+extern const char *sFollowLoadedAgain;
 extern const char *sNoMemoryINI;
 extern const char *sINIFormatChanged;
 extern const char *sINIFormatIsNew;
@@ -154,7 +170,6 @@ extern const char *sIncrementalSearch;
 extern const char *sIncrementalSearchBack;
 extern const char *sPassedEndOfFile;
 extern const char *sAllFilesClosed;
-extern const char *sNewFileRec;
 extern const char *sEnterLine;
 extern const char *sInvalidNumber;
 extern const char *sBlanksRemoved;
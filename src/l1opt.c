@@ -27,10 +27,13 @@ BOOLEAN bOverwriteBlocks = TRUE;
 BOOLEAN bSyntaxHighlighting = TRUE;
 BOOLEAN bMatchPairHighlighting = TRUE;
 BOOLEAN bIF0Highlighting = TRUE;
+BOOLEAN bHighlightSearchMatches = FALSE;
 BOOLEAN bAscendingSort = TRUE;
 BOOLEAN bCaseSensitiveSort = TRUE;
 int nRightMargin = 70;
 BOOLEAN bCombineUndo = TRUE;
+int nUndoMemoryLimit = 16384;  /* KB of undo data per file, 0 -- no limit */
+int nMaxFrameRate = 30;  /* screen updates per second while typing, 0 -- no limit */
 int nFileType = 0;  /* Values defined in doctype.h */
 BOOLEAN bUseTabs = TRUE;
 BOOLEAN bOptimalFill = TRUE;
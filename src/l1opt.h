@@ -48,10 +48,13 @@ extern BOOLEAN bOverwriteBlocks;
 extern BOOLEAN bSyntaxHighlighting;
 extern BOOLEAN bMatchPairHighlighting;
 extern BOOLEAN bIF0Highlighting;
+extern BOOLEAN bHighlightSearchMatches;
 extern BOOLEAN bAscendingSort;
 extern BOOLEAN bCaseSensitiveSort;
 extern int nRightMargin;
 extern BOOLEAN bCombineUndo;
+extern int nUndoMemoryLimit;
+extern int nMaxFrameRate;
 extern int nFileType;  /* Values defined in doctype.h */
 extern BOOLEAN bUseTabs;
 extern BOOLEAN bOptimalFill;
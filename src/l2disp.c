@@ -41,7 +41,6 @@ static int PutText(int nStartX, int nStartY, int nWidth, int nYLine,
   void *x;
   int i;
   int rect_size;
-  int screen_w;
 
   /* allocate some safe output buffer in the stack */
   output_buf_size = MAX_WIN_WIDTH * 3 * sizeof(int);
@@ -57,9 +56,8 @@ static int PutText(int nStartX, int nStartY, int nWidth, int nYLine,
   disp_cbuf_reset(disp, x, rect_size);  /* init char buf */
 
   b = pBuf;
-  screen_w = disp_wnd_get_width(disp);
 
-  for (i = 0; i < screen_w; ++i, ++b)
+  for (i = 0; i < nWidth; ++i, ++b)
     disp_cbuf_put_char_attr(disp, x, i, b->c, GetColor(b->t + nPaletteStart));
 
   disp_put_block(disp, nStartX, nStartY + nYLine, nWidth, 1, x);
@@ -0,0 +1,359 @@
+/*
+
+File: linediff.c
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Line by line difference of two files.
+
+  The lines are compared by a hash first and the text is compared
+  only when the hashes are equal. The common head and tail of the
+  files are skipped, the rest is compared by the O(ND) algorithm of
+  E. Myers in its linear space variant -- the middle snake of a range
+  is found and the algorithm is applied again on the both sides of
+  the snake.
+
+  A range that needs more than MAX_DIFF_COST steps to find its middle
+  snake is considered entirely changed. The result is then not the
+  shortest but it is still a correct edit script.
+
+*/
+
+#include "global.h"
+#include "memory.h"
+#include "linediff.h"
+
+#define MAX_DIFF_COST  4096
+
+typedef struct DiffCtx
+{
+  const TFile *pOld;
+  const TFile *pNew;
+  DWORD *pOldHash;
+  DWORD *pNewHash;
+  char *pOldChanged;
+  char *pNewChanged;
+  int *pFwd;  /* forward furthest x per diagonal, indexed x - y */
+  int *pBwd;  /* backward furthest x per diagonal */
+} TDiffCtx;
+
+/* ************************************************************************
+   Function: HashLines
+   Description:
+     FNV-1a hash of each of the lines of a file.
+*/
+static void HashLines(const TFile *pFile, DWORD *pHash)
+{
+  int i;
+  const TLine *pLine;
+  const unsigned char *p;
+  const unsigned char *pEnd;
+  DWORD h;
+
+  for (i = 0; i < pFile->nNumberOfLines; ++i)
+  {
+    pLine = GetLine(pFile, i);
+    h = 2166136261u;
+    p = (const unsigned char *)pLine->pLine;
+    for (pEnd = p + pLine->nLen; p < pEnd; ++p)
+    {
+      h ^= *p;
+      h *= 16777619u;
+    }
+    pHash[i] = h;
+  }
+}
+
+/* ************************************************************************
+   Function: LinesEqual
+   Description:
+     Compares line x of the old file with line y of the new file.
+*/
+static BOOLEAN LinesEqual(const TDiffCtx *pCtx, int x, int y)
+{
+  const TLine *pLine1;
+  const TLine *pLine2;
+
+  if (pCtx->pOldHash[x] != pCtx->pNewHash[y])
+    return FALSE;
+  pLine1 = GetLine(pCtx->pOld, x);
+  pLine2 = GetLine(pCtx->pNew, y);
+  if (pLine1->nLen != pLine2->nLen)
+    return FALSE;
+  return memcmp(pLine1->pLine, pLine2->pLine, pLine1->nLen) == 0;
+}
+
+/* ************************************************************************
+   Function: FindMiddleSnake
+   Description:
+     Finds the middle snake of the shortest edit script of old lines
+     [xoff, xlim) to new lines [yoff, ylim). The ranges should be
+     non-empty and should have no common head or tail.
+     Returns FALSE if the search is too expensive.
+*/
+static BOOLEAN FindMiddleSnake(TDiffCtx *pCtx, int xoff, int xlim,
+  int yoff, int ylim, int *px, int *py)
+{
+  int *fd = pCtx->pFwd;
+  int *bd = pCtx->pBwd;
+  int dmin = xoff - ylim;  /* the range of the diagonals */
+  int dmax = xlim - yoff;
+  int fmid = xoff - yoff;  /* the starting diagonals */
+  int bmid = xlim - ylim;
+  int fmin = fmid;
+  int fmax = fmid;
+  int bmin = bmid;
+  int bmax = bmid;
+  BOOLEAN bOdd = ((fmid - bmid) & 1) != 0;
+  int c;
+  int d;
+  int x;
+  int y;
+  int tlo;
+  int thi;
+
+  fd[fmid] = xoff;
+  bd[bmid] = xlim;
+
+  for (c = 1; c <= MAX_DIFF_COST; ++c)
+  {
+    /* Extend the forward paths by one edit */
+    if (fmin > dmin)
+      fd[--fmin - 1] = -1;
+    else
+      ++fmin;
+    if (fmax < dmax)
+      fd[++fmax + 1] = -1;
+    else
+      --fmax;
+    for (d = fmax; d >= fmin; d -= 2)
+    {
+      tlo = fd[d - 1];
+      thi = fd[d + 1];
+      x = tlo >= thi ? tlo + 1 : thi;
+      y = x - d;
+      while (x < xlim && y < ylim && LinesEqual(pCtx, x, y))
+      {
+        ++x;
+        ++y;
+      }
+      fd[d] = x;
+      if (bOdd && bmin <= d && d <= bmax && bd[d] <= x)
+      {
+        *px = x;
+        *py = y;
+        return TRUE;
+      }
+    }
+
+    /* Extend the backward paths by one edit */
+    if (bmin > dmin)
+      bd[--bmin - 1] = INT_MAX;
+    else
+      ++bmin;
+    if (bmax < dmax)
+      bd[++bmax + 1] = INT_MAX;
+    else
+      --bmax;
+    for (d = bmax; d >= bmin; d -= 2)
+    {
+      tlo = bd[d - 1];
+      thi = bd[d + 1];
+      x = tlo < thi ? tlo : thi - 1;
+      y = x - d;
+      while (x > xoff && y > yoff && LinesEqual(pCtx, x - 1, y - 1))
+      {
+        --x;
+        --y;
+      }
+      bd[d] = x;
+      if (!bOdd && fmin <= d && d <= fmax && x <= fd[d])
+      {
+        *px = x;
+        *py = y;
+        return TRUE;
+      }
+    }
+  }
+
+  return FALSE;
+}
+
+/* ************************************************************************
+   Function: CompareRange
+   Description:
+     Marks the changed lines of old lines [xoff, xlim) and new
+     lines [yoff, ylim).
+*/
+static void CompareRange(TDiffCtx *pCtx, int xoff, int xlim,
+  int yoff, int ylim)
+{
+  int x;
+  int y;
+
+  /* Skip the common head and tail */
+  while (xoff < xlim && yoff < ylim && LinesEqual(pCtx, xoff, yoff))
+  {
+    ++xoff;
+    ++yoff;
+  }
+  while (xoff < xlim && yoff < ylim && LinesEqual(pCtx, xlim - 1, ylim - 1))
+  {
+    --xlim;
+    --ylim;
+  }
+
+  if (xoff == xlim || yoff == ylim)
+    goto _mark_changed;
+
+  if (!FindMiddleSnake(pCtx, xoff, xlim, yoff, ylim, &x, &y))
+    goto _mark_changed;
+  if ((x == xoff && y == yoff) || (x == xlim && y == ylim))
+    goto _mark_changed;  /* no progress, should not happen */
+
+  CompareRange(pCtx, xoff, x, yoff, y);
+  CompareRange(pCtx, x, xlim, y, ylim);
+  return;
+
+_mark_changed:
+  memset(pCtx->pOldChanged + xoff, 1, xlim - xoff);
+  memset(pCtx->pNewChanged + yoff, 1, ylim - yoff);
+}
+
+/* ************************************************************************
+   Function: LineDiff
+   Description:
+     Compares the lines of pOld and pNew. Stores in *ppHunks an array
+     (to be freed by s_free()) of the ranges of pOld that are to be
+     replaced by ranges of pNew, in ascending order.
+     Returns the number of the hunks or -1 for no memory.
+*/
+int LineDiff(const TFile *pOld, const TFile *pNew, TLineDiffHunk **ppHunks)
+{
+  TDiffCtx Ctx;
+  int nOld;
+  int nNew;
+  int nDiags;
+  int i;
+  int j;
+  int nNumHunks;
+  TLineDiffHunk *pHunks;
+  TLineDiffHunk *pHunk;
+
+  ASSERT(VALID_PFILE(pOld));
+  ASSERT(VALID_PFILE(pNew));
+  ASSERT(ppHunks != NULL);
+
+  nOld = pOld->nNumberOfLines;
+  nNew = pNew->nNumberOfLines;
+  nDiags = nOld + nNew + 3;
+  nNumHunks = -1;
+  memset(&Ctx, 0, sizeof(Ctx));
+  Ctx.pOld = pOld;
+  Ctx.pNew = pNew;
+
+  /* +1 to never ask for 0 bytes */
+  Ctx.pOldHash = alloc(sizeof(DWORD) * (nOld + 1));
+  Ctx.pNewHash = alloc(sizeof(DWORD) * (nNew + 1));
+  Ctx.pOldChanged = alloc(nOld + 1);
+  Ctx.pNewChanged = alloc(nNew + 1);
+  Ctx.pFwd = alloc(sizeof(int) * nDiags);
+  Ctx.pBwd = alloc(sizeof(int) * nDiags);
+  /* at most one hunk more than the number of the unchanged runs */
+  pHunks = alloc(sizeof(TLineDiffHunk) * ((nOld < nNew ? nOld : nNew) + 1));
+  if (Ctx.pOldHash == NULL || Ctx.pNewHash == NULL ||
+    Ctx.pOldChanged == NULL || Ctx.pNewChanged == NULL ||
+    Ctx.pFwd == NULL || Ctx.pBwd == NULL || pHunks == NULL)
+    goto _exit;
+
+  /* the diagonals are in the range -nNew - 1 .. nOld + 1 */
+  Ctx.pFwd += nNew + 1;
+  Ctx.pBwd += nNew + 1;
+
+  HashLines(pOld, Ctx.pOldHash);
+  HashLines(pNew, Ctx.pNewHash);
+  memset(Ctx.pOldChanged, 0, nOld + 1);
+  memset(Ctx.pNewChanged, 0, nNew + 1);
+  CompareRange(&Ctx, 0, nOld, 0, nNew);
+
+  Ctx.pFwd -= nNew + 1;
+  Ctx.pBwd -= nNew + 1;
+
+  /* Collect the runs of changed lines into hunks */
+  nNumHunks = 0;
+  i = 0;
+  j = 0;
+  while (i < nOld || j < nNew)
+  {
+    if (i < nOld && j < nNew && !Ctx.pOldChanged[i] && !Ctx.pNewChanged[j])
+    {
+      ++i;
+      ++j;
+      continue;
+    }
+    pHunk = &pHunks[nNumHunks++];
+    pHunk->nOldLine = i;
+    pHunk->nNewLine = j;
+    while (i < nOld && Ctx.pOldChanged[i])
+      ++i;
+    while (j < nNew && Ctx.pNewChanged[j])
+      ++j;
+    pHunk->nOldCount = i - pHunk->nOldLine;
+    pHunk->nNewCount = j - pHunk->nNewLine;
+    ASSERT(pHunk->nOldCount > 0 || pHunk->nNewCount > 0);
+  }
+  *ppHunks = pHunks;
+  pHunks = NULL;
+
+_exit:
+  if (pHunks != NULL)
+    s_free(pHunks);
+  if (Ctx.pBwd != NULL)
+    s_free(Ctx.pBwd);
+  if (Ctx.pFwd != NULL)
+    s_free(Ctx.pFwd);
+  if (Ctx.pNewChanged != NULL)
+    s_free(Ctx.pNewChanged);
+  if (Ctx.pOldChanged != NULL)
+    s_free(Ctx.pOldChanged);
+  if (Ctx.pNewHash != NULL)
+    s_free(Ctx.pNewHash);
+  if (Ctx.pOldHash != NULL)
+    s_free(Ctx.pOldHash);
+  return nNumHunks;
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
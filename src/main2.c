@@ -35,6 +35,9 @@ Descrition:
 #include "doctype.h"
 #include "file2.h"
 #include "undo.h"
+#include "recwrite.h"
+#include "savew.h"
+#include "filewatch.h"
 #include "blockcmd.h"
 #include "smalledt.h"
 #include "hypertvw.h"
@@ -66,6 +69,8 @@ const char *timebld = __TIME__;
 char sModuleFileName[_MAX_PATH];
 char sModulePath[_MAX_PATH];  /* Always with a trailing slash '\\' */
 BOOLEAN bQuit = FALSE;
+unsigned long nFramesRendered = 0;  /* UpdateDisplay() calls from the main loop */
+unsigned long nFramesDropped = 0;  /* skipped while more input was waiting */
 int nINIVersion = 0;  /* Read what is the config version as read from INI file */
 int prog_argc;
 char **prog_argv;
@@ -395,15 +400,50 @@ void OnKeySetChanged(void)
      A call-back function for FileListForEach().
      Stores recovery record for a specific file.
      Call StoreRecovery() from undo.c
+     A failure is reported once, until the file is saved or the
+     error changes.
 */
 static BOOLEAN StoreRecoveryRecord2(TFile *pFile, void *pContext)
 {
   ASSERT(VALID_PFILE(pFile));
 
   pFile->bRecoveryStored = StoreRecoveryRecord(pFile);
+  if (!pFile->bRecoveryStored && errno != 0 && errno != pFile->nRecoveryError)
+  {
+    pFile->nRecoveryError = errno;
+    ConsoleMessageProc((dispc_t *)pContext, NULL, MSG_ERRNO | MSG_ERROR | MSG_OK,
+      pFile->sRecoveryFileName, NULL);
+  }
   return TRUE;
 }
 
+static time_t nLastRecoveryTime;
+
+/* ************************************************************************
+   Function: CheckRecoveryTimer
+   Description:
+     Stores the recovery records of all the files every nRecoveryTime
+     seconds. Checked after every event, the idle time comes as
+     EVENT_TIMER_5SEC. The records are written to the disk by
+     the recovery writer, the editing is not stopped.
+*/
+static void CheckRecoveryTimer(dispc_t *disp)
+{
+  time_t nNow;
+
+  if (nRecoveryTime <= 0)
+    return;
+
+  nNow = time(NULL);
+  if (nLastRecoveryTime == 0)
+    nLastRecoveryTime = nNow;
+  if (nNow - nLastRecoveryTime < nRecoveryTime)
+    return;
+  nLastRecoveryTime = nNow;
+
+  FileListForEach(pFilesInMemoryList, StoreRecoveryRecord2, FALSE, disp);
+}
+
 #if 0
 /* ************************************************************************
    Function: GetTime
@@ -759,14 +799,16 @@ static void HandleEvent(disp_event_t *ev, void *ctx)
 
   switch (ev->t.code)
   {
-    /*
-    TODO: enable recovery file times
-    case EVENT_RECOVERY_TIMER_EXPIRED:
-      FileListForEach(pFilesInMemoryList, StoreRecoveryRecord2, FALSE, NULL);
+    case EVENT_TIMER_5SEC:
+      FileWatchPoll(pFilesInMemoryList);
       break;
-    */
 
-    case EVENT_TIMER_5SEC:
+    case EVENT_WATCH_FD:
+      FileWatchRead(pFilesInMemoryList);
+      break;
+
+    case EVENT_TIMER_TICK:
+      FindInFilesPoll(disp);
       break;
 
     case EVENT_KEY:
@@ -783,6 +825,8 @@ static void HandleEvent(disp_event_t *ev, void *ctx)
             pfnMouseProc(&ev2, pContext);
             break;
           }
+          if (FindInFilesCancel(disp))
+            break;
           if (HandleEscOnDockedViews())
             break;
         }
@@ -809,6 +853,10 @@ static void HandleEvent(disp_event_t *ev, void *ctx)
   if (GetNumberOfFiles() == 0 && !bQuit)
     ASSERT(0);  /* "noname" file should be displayed when no more files */
 
+  CheckStoredFiles(pFilesInMemoryList, disp);
+  CheckDiskFiles(pFilesInMemoryList, disp);
+  CheckRecoveryTimer(disp);
+
 _exit:
   if (bNoMemory)
   {
@@ -893,6 +941,8 @@ void main2(int argc, char **argv)
   dispc_t *disp;
   disp_wnd_param_t wnd_param;
   handle_event_data_t event_handler_ctx;
+  unsigned long nNow;
+  unsigned long nLastFrameTime;
 
   wrkspace = alloca(wrkspace_obj_size());
   if (!wrkspace_init(wrkspace))
@@ -915,6 +965,13 @@ void main2(int argc, char **argv)
   #endif
   if (!disp_init(&wnd_param, disp))
   {
+    enum disp_error error_code;
+    char *error_msg;
+    char *os_error_msg;
+
+    disp_error_get(disp, &error_code, &error_msg, &os_error_msg);
+    fprintf(stderr, "ww: disp: %d, %s, os: %s\n",
+            error_code, error_msg, os_error_msg);
     ASSERT(0);
     return;  /* fatal init problem, TODO: put a log message */
   }
@@ -937,6 +994,7 @@ void main2(int argc, char **argv)
     return 1;  /* fatal, palette init, TODO: put a log message */
   }
   wrkspace_set_disp(wrkspace, disp);
+  FileWatchInit(disp);
   InstallClipboardMonitor(disp);
   bWrkSpaceInitOK = InitAndRestoreWorkspace(argv,
                                             pMasterINIFile, wrkspace, disp);
@@ -955,6 +1013,7 @@ void main2(int argc, char **argv)
   /*ShowTipsAndTricks();*/ /* temporarely disabled */
   bQuit = FALSE;
   event_handler_ctx.wrkspace = wrkspace;
+  nLastFrameTime = 0;
   disp_set_resize_handler(disp, HandleEvent, &event_handler_ctx);
   while (!bQuit) /* --- Main loop --- */
   {
@@ -962,11 +1021,28 @@ void main2(int argc, char **argv)
     SanityChecks();
     #endif
 
-    UpdateDisplay(wrkspace);
-    disp_event_read(disp, &ev);
+    /*
+    Input that arrives faster than nMaxFrameRate is processed without
+    painting the screen in between. Once the input is idle the screen is
+    always brought up to date before waiting for the next event.
+    */
+    nNow = disp_get_tick_ms(disp);
+    if (nMaxFrameRate == 0
+        || nNow - nLastFrameTime >= (unsigned long)(1000 / nMaxFrameRate)
+        || !disp_event_pending(disp))
+    {
+      UpdateDisplay(wrkspace);
+      nLastFrameTime = nNow;
+      ++nFramesRendered;
+    }
+    else
+      ++nFramesDropped;
+    if (!disp_event_read(disp, &ev))
+      break;  /* the window is gone or the end of a headless script */
     ev.data1 = wrkspace;
     HandleEvent(&ev, &event_handler_ctx);
   }
+  FindInFilesCancel(disp);
   DisposeKeyBlock();
   RemoveTopMRUItem(pMRUFilesList);  /* the mandatory "noname" */
   StoreWorkspace(disp);  /* Store to the INI file */
@@ -976,6 +1052,9 @@ _abort1:
   DocTypesDone();
   DocTypeSnapshotDispose();
   DoneWorkspace();
+  RecoveryWriterDone();
+  SaveWriterDone();
+  FileWatchDone();
   DisposeInfoPagesCache();
   ShowUserScreen();
   DisposeUserScreen();
@@ -25,6 +25,8 @@ extern const char *timebld;
 extern char sModuleFileName[_MAX_PATH];
 extern char sModulePath[_MAX_PATH];  /* Always with a trailing slash '\\' */
 extern BOOLEAN bQuit;
+extern unsigned long nFramesRendered;
+extern unsigned long nFramesDropped;
 extern int nINIVersion;  /* Read what is the config version as read from INI file */
 
 BOOLEAN MoveToFileView(void);
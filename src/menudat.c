@@ -44,6 +44,8 @@ static TMenuItem itFileNew = {cmFileNew, 0, "~N~ew", {0}, 0, 0};
 static TMenuItem itFileOpen = {cmFileOpen, 0, "~O~pen", {0}, 0, 0};
 static TMenuItem itFileOpenAsReadOnly = {cmFileOpenAsReadOnly, 0, "Open As ~R~ead Only", {0}, 0, 0};
 static TMenuItem itFileClose = {cmFileClose, 0, "~C~lose", {0}, 0, 0};
+static TMenuItem itFileReload = {cmFileReload, 0, "Reloa~d~", {0}, 0, 0};
+static TMenuItem itFileFollow = {cmFileFollow, 0, "Follo~w~", {0}, 0, 0};
 static TMenuItem itFileSave = {cmFileSave, 0, "~S~ave", {0}, 0, 0};
 static TMenuItem itFileSaveAs = {cmFileSaveAs, 0, "Save ~A~s", {0}, 0, 0};
 static TMenuItem itFileSaveAll = {cmFileSaveAll, 0, "Save Al~l~", {0}, 0, 0};
@@ -51,7 +53,8 @@ static TMenuItem itFileRecentFiles = {0, 0, "Recent ~F~iles", {0}, 0, 0, "recent
 static TMenuItem itFileExit = {cmFileExit, 0, "E~x~it", {0}, 0, 0};
 static TMenuItem *aFile[] =
 {
-  &itFileNew, &itFileOpen, &itFileOpenAsReadOnly, &itFileClose, &itSep,
+  &itFileNew, &itFileOpen, &itFileOpenAsReadOnly, &itFileReload,
+  &itFileFollow, &itFileClose, &itSep,
   &itFileSave, &itFileSaveAs, &itFileSaveAll, &itSep,
   &itFileRecentFiles, &itSep,
   &itFileExit
@@ -186,6 +189,7 @@ static void ToggleOverwriteBlocks(void);
 static void ToggleSyntax(void);
 static void ToggleMSyntx(void);
 static void ToggleIF0(void);
+static void ToggleSearchMatches(void);
 static void ToggleAscendingSort(void);
 static void ToggleCaseSensitiveSort(void);
 static void InputRecoveryTime(void);
@@ -200,6 +204,7 @@ static TMenuItem itOptionsOverwriteBlocks = {0, 0, "~O~verwrite blocks", {0}, 0,
 static TMenuItem itOptionsSyntax = {0, 0, "Syntax ~h~ighlighting", {0}, 0, ToggleSyntax, "opt_main", "Help on (Options)~M~ain"};
 static TMenuItem itOptionsMSyntx = {0, 0, "Match ~p~air highlighting", {0}, 0, ToggleMSyntx, "opt_main", "Help on (Options)~M~ain"};
 static TMenuItem itOptionsHighlightIF0 = {0, 0, "Highlight #if ~0~ style comments", {0}, 0, ToggleIF0, "opt_main", "Help on (Options)~M~ain"};
+static TMenuItem itOptionsSearchMatches = {0, 0, "Highlight ~s~earch matches", {0}, 0, ToggleSearchMatches, "opt_main", "Help on (Options)~M~ain"};
 static TMenuItem itOptionsRMarg = {0, 0, "Right ~m~arging", {0}, 0, InputRightMargin, "opt_main", "Help on (Options)~M~ain"};
 static TMenuItem itOptionsAscendingSort = {0, 0, "~A~scending sort", {0}, 0, ToggleAscendingSort, "opt_main", "Help on (Options)~M~ain"};
 static TMenuItem itOptionsCaseSensitiveSort = {0, 0, "~C~ase sensitive sort", {0}, 0, ToggleCaseSensitiveSort, "opt_main", "Help on (Options)~M~ain"};
@@ -208,7 +213,8 @@ static TMenuItem itOptionsDocumentTypes4 = {0, 0, NULL, {0}, 0, EditCurrentDocum
 static TMenuItem *aEditOpts[] = {&itOptionsBackup, &itOptionsLastFiles,
   &itOptionsRecoveryTime, &itOptionsPersistentBlocks,
   &itOptionsOverwriteBlocks, &itOptionsSyntax,
-  &itOptionsMSyntx, &itOptionsHighlightIF0, &itOptionsRMarg,
+  &itOptionsMSyntx, &itOptionsHighlightIF0, &itOptionsSearchMatches,
+  &itOptionsRMarg,
   &itOptionsAscendingSort, &itOptionsCaseSensitiveSort,
   &itOptionsSaveAs,
   &itSep,
@@ -568,6 +574,7 @@ static void PrepareEditorOptions(void)
   PrepareOption(&itOptionsSyntax, bSyntaxHighlighting, 6);
   PrepareOption(&itOptionsMSyntx, bMatchPairHighlighting, 6);
   PrepareOption(&itOptionsHighlightIF0, bIF0Highlighting, 6);
+  PrepareOption(&itOptionsSearchMatches, bHighlightSearchMatches, 6);
   PrepareOption(&itOptionsAscendingSort, bAscendingSort, 6);
   PrepareOption(&itOptionsCaseSensitiveSort, bCaseSensitiveSort, 6);
   PrepareRecoveryTime(&itOptionsRecoveryTime, nRecoveryTime);
@@ -668,6 +675,19 @@ static void ToggleIF0(void)
   PrepareOption(&itOptionsHighlightIF0, bIF0Highlighting, 6);
 }
 
+/* ************************************************************************
+   Function: ToggleSearchMatches
+   Description:
+     This is a call-back function called form the main menu.
+*/
+static void ToggleSearchMatches(void)
+{
+  bOptionsChanged = TRUE;
+
+  bHighlightSearchMatches = !bHighlightSearchMatches;
+  PrepareOption(&itOptionsSearchMatches, bHighlightSearchMatches, 6);
+}
+
 /* ************************************************************************
    Function: ToggleAscendingSort
    Description:
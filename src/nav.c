@@ -49,6 +49,304 @@ static void PrepareString(const char *pMsg, int nWidth, char Type, TLineOutput *
   }
 }
 
+/*
+The rows of the page as last prepared by wline(), see WritePage().
+The page remembers what the rows were prepared with. When the page
+moves a few lines the rows are shifted, only the lines that come in
+view or whose look has changed since are prepared again.
+*/
+typedef struct PageRows
+{
+  /* Changes in any of these affect all the rows */
+  int nWrtEdge;
+  int nType;
+  int nTabSize;
+  const char *sEndOfFile;
+  int nNumTooltipLines;
+  const TExtraColorInterf *pExtraColorInterf;
+  int nMarksVersion;
+  BOOLEAN bHighlightSearchMatches;
+  int nSearchGeneration;
+  BOOLEAN bCaseSensitive;
+  BOOLEAN bRegularExpr;
+  int nSearchLines;
+  char sSearch[MAX_SEARCH_STR];
+
+  /* Changes in these affect only the rows of the lines involved */
+  BOOLEAN bBlock;
+  int nStartLine;
+  int nEndLine;
+  int nStartPos;
+  int nEndPos;
+  WORD blockattr;
+  BOOLEAN bShowBlockCursor;
+  int nRow;
+  int nCol;
+  struct { int c, r, l; } hlightareas[6];
+
+  int nTopLine;  /* The line in the first row */
+  int nWidth;
+  int nHeight;
+  int nRowSize;  /* wline() may put a character past nWidth */
+  int *pRowLine;  /* The line prepared in each row, -1 -- none */
+  TLineOutput *pRows;  /* nHeight rows of nRowSize characters */
+} TPageRows;
+
+/* ************************************************************************
+   Function: PrepareLine
+   Description:
+     Prepares a line from a file for output.
+*/
+static void PrepareLine(const TFile *pFile, int nWrtLine, int nWidth,
+  TLineOutput *pBuf, TExtraColorInterf *pExtraColorInterf)
+{
+  if (nWrtLine < pFile->nNumberOfLines)
+    wline(pFile, nWrtLine, nWidth, pBuf, pExtraColorInterf);
+  else
+  {
+    /*
+    There's no line with number nWrtLine.
+    Display <*** End Of File ***> or fill with empty lines.
+    */
+    if (nWrtLine == pFile->nNumberOfLines)
+      PrepareString(pFile->sEndOfFile, nWidth, attrEOF, pBuf);
+    else
+      PrepareString("", nWidth, attrText, pBuf);
+  }
+}
+
+/* ************************************************************************
+   Function: InvalidateRows
+   Description:
+     Marks the rows that hold lines nFromLine..nToLine to be prepared
+     again.
+*/
+static void InvalidateRows(TPageRows *pPageRows, int nFromLine, int nToLine)
+{
+  int i;
+
+  for (i = 0; i < pPageRows->nHeight; ++i)
+  {
+    if (pPageRows->pRowLine[i] >= nFromLine && pPageRows->pRowLine[i] <= nToLine)
+      pPageRows->pRowLine[i] = -1;
+  }
+}
+
+/* ************************************************************************
+   Function: InvalidateBlockRows
+   Description:
+     Marks the rows whose block attributes have changed since the rows
+     were prepared.
+*/
+static void InvalidateBlockRows(TPageRows *pPageRows, const TFile *pFile)
+{
+  if (!pPageRows->bBlock && !pFile->bBlock)
+    return;
+
+  if (pPageRows->bBlock != pFile->bBlock ||
+    pPageRows->blockattr != pFile->blockattr ||
+    ((pFile->blockattr & COLUMN_BLOCK) &&
+      (pPageRows->nStartPos != pFile->nStartPos ||
+      pPageRows->nEndPos != pFile->nEndPos)))
+  {
+    /* The old and the new block lines */
+    if (pPageRows->bBlock)
+      InvalidateRows(pPageRows, pPageRows->nStartLine, pPageRows->nEndLine);
+    if (pFile->bBlock)
+      InvalidateRows(pPageRows, pFile->nStartLine, pFile->nEndLine);
+    return;
+  }
+
+  /* Only the lines between the old and the new edge */
+  if (pPageRows->nStartLine != pFile->nStartLine ||
+    pPageRows->nStartPos != pFile->nStartPos)
+  {
+    InvalidateRows(pPageRows,
+      min(pPageRows->nStartLine, pFile->nStartLine),
+      max(pPageRows->nStartLine, pFile->nStartLine));
+  }
+  if (pPageRows->nEndLine != pFile->nEndLine ||
+    pPageRows->nEndPos != pFile->nEndPos)
+  {
+    InvalidateRows(pPageRows,
+      min(pPageRows->nEndLine, pFile->nEndLine),
+      max(pPageRows->nEndLine, pFile->nEndLine));
+  }
+}
+
+/* ************************************************************************
+   Function: SyncPageRows
+   Description:
+     Marks the rows that need to be prepared again and shifts the rest
+     to the current top line of the page. Then remembers what the rows
+     are to be prepared with.
+*/
+static void SyncPageRows(TPageRows *pPageRows, TFile *pFile,
+  const TSearchContext *pstSearchContext,
+  const TExtraColorInterf *pExtraColorInterf)
+{
+  int nMarksVersion;
+  int nShift;
+  int nHeight;
+  int nRowSize;
+  int i;
+
+  nMarksVersion = 0;
+  if (pExtraColorInterf != NULL)
+    nMarksVersion = pExtraColorInterf->nMarksVersion;
+
+  if (pPageRows->nWrtEdge != pFile->nWrtEdge ||
+    pPageRows->nType != pFile->nType ||
+    pPageRows->nTabSize != nTabSize ||
+    pPageRows->sEndOfFile != pFile->sEndOfFile ||
+    pPageRows->nNumTooltipLines != pFile->nNumTooltipLines ||
+    pFile->nNumTooltipLines != 0 ||  /* tooltips follow the rows, not the lines */
+    pPageRows->pExtraColorInterf != pExtraColorInterf ||
+    pPageRows->nMarksVersion != nMarksVersion ||
+    pPageRows->bHighlightSearchMatches != bHighlightSearchMatches ||
+    pPageRows->nSearchGeneration != pstSearchContext->nGeneration ||
+    pPageRows->bCaseSensitive != pstSearchContext->bCaseSensitive ||
+    pPageRows->bRegularExpr != pstSearchContext->bRegularExpr ||
+    pPageRows->nSearchLines != pstSearchContext->nNumLines ||
+    strcmp(pPageRows->sSearch, pstSearchContext->sSearch) != 0)
+  {
+    for (i = 0; i < pPageRows->nHeight; ++i)
+      pPageRows->pRowLine[i] = -1;
+  }
+  else
+  {
+    /*
+    The text changed from nEditFirstLine on, the rows above it
+    are kept. An edit below the page leaves the page as is.
+    */
+    if (pFile->nEditFirstLine != INT_MAX)
+      InvalidateRows(pPageRows, pFile->nEditFirstLine, INT_MAX);
+
+    InvalidateBlockRows(pPageRows, pFile);
+
+    if (pPageRows->bShowBlockCursor != pFile->bShowBlockCursor ||
+      pPageRows->nRow != pFile->nRow || pPageRows->nCol != pFile->nCol)
+    {
+      if (pPageRows->bShowBlockCursor)
+        InvalidateRows(pPageRows, pPageRows->nRow, pPageRows->nRow);
+      if (pFile->bShowBlockCursor)
+        InvalidateRows(pPageRows, pFile->nRow, pFile->nRow);
+    }
+
+    for (i = 0; i < _countof(pFile->hlightareas); ++i)
+    {
+      if (pPageRows->hlightareas[i].c == pFile->hlightareas[i].c &&
+        pPageRows->hlightareas[i].r == pFile->hlightareas[i].r &&
+        pPageRows->hlightareas[i].l == pFile->hlightareas[i].l)
+        continue;
+      if (pPageRows->hlightareas[i].l != 0)
+        InvalidateRows(pPageRows,
+          pPageRows->hlightareas[i].r, pPageRows->hlightareas[i].r);
+      if (pFile->hlightareas[i].l != 0)
+        InvalidateRows(pPageRows,
+          pFile->hlightareas[i].r, pFile->hlightareas[i].r);
+    }
+  }
+
+  /*
+  Shift the rows that remain on the page
+  */
+  nShift = pFile->nTopLine - pPageRows->nTopLine;
+  nHeight = pPageRows->nHeight;
+  nRowSize = pPageRows->nRowSize;
+  if (nShift >= nHeight || -nShift >= nHeight)
+  {
+    for (i = 0; i < nHeight; ++i)
+      pPageRows->pRowLine[i] = -1;
+  }
+  else
+    if (nShift > 0)
+    {
+      memmove(pPageRows->pRowLine, pPageRows->pRowLine + nShift,
+        (nHeight - nShift) * sizeof(int));
+      memmove(pPageRows->pRows, pPageRows->pRows + nShift * nRowSize,
+        (nHeight - nShift) * nRowSize * sizeof(TLineOutput));
+      for (i = nHeight - nShift; i < nHeight; ++i)
+        pPageRows->pRowLine[i] = -1;
+    }
+    else
+      if (nShift < 0)
+      {
+        memmove(pPageRows->pRowLine - nShift, pPageRows->pRowLine,
+          (nHeight + nShift) * sizeof(int));
+        memmove(pPageRows->pRows - nShift * nRowSize, pPageRows->pRows,
+          (nHeight + nShift) * nRowSize * sizeof(TLineOutput));
+        for (i = 0; i < -nShift; ++i)
+          pPageRows->pRowLine[i] = -1;
+      }
+  pPageRows->nTopLine = pFile->nTopLine;
+
+  pFile->nEditFirstLine = INT_MAX;
+  pPageRows->nWrtEdge = pFile->nWrtEdge;
+  pPageRows->nType = pFile->nType;
+  pPageRows->nTabSize = nTabSize;
+  pPageRows->sEndOfFile = pFile->sEndOfFile;
+  pPageRows->nNumTooltipLines = pFile->nNumTooltipLines;
+  pPageRows->pExtraColorInterf = pExtraColorInterf;
+  pPageRows->nMarksVersion = nMarksVersion;
+  pPageRows->bHighlightSearchMatches = bHighlightSearchMatches;
+  pPageRows->nSearchGeneration = pstSearchContext->nGeneration;
+  pPageRows->bCaseSensitive = pstSearchContext->bCaseSensitive;
+  pPageRows->bRegularExpr = pstSearchContext->bRegularExpr;
+  pPageRows->nSearchLines = pstSearchContext->nNumLines;
+  strcpy(pPageRows->sSearch, pstSearchContext->sSearch);
+
+  pPageRows->bBlock = pFile->bBlock;
+  pPageRows->nStartLine = pFile->nStartLine;
+  pPageRows->nEndLine = pFile->nEndLine;
+  pPageRows->nStartPos = pFile->nStartPos;
+  pPageRows->nEndPos = pFile->nEndPos;
+  pPageRows->blockattr = pFile->blockattr;
+  pPageRows->bShowBlockCursor = pFile->bShowBlockCursor;
+  pPageRows->nRow = pFile->nRow;
+  pPageRows->nCol = pFile->nCol;
+  memcpy(pPageRows->hlightareas, pFile->hlightareas, sizeof(pPageRows->hlightareas));
+}
+
+/* ************************************************************************
+   Function: GetPageRows
+   Description:
+     Returns the rows of the page of a file. Allocates them on first use
+     or when the size of the page changes.
+   Returns:
+     NULL -- no memory, the page is to be prepared row by row.
+*/
+static TPageRows *GetPageRows(TFile *pFile, int nWinWidth, int nWinHeight)
+{
+  TPageRows *pPageRows;
+  int i;
+
+  pPageRows = pFile->pPageRows;
+  if (pPageRows != NULL &&
+    pPageRows->nWidth == nWinWidth && pPageRows->nHeight == nWinHeight)
+    return pPageRows;
+
+  if (pPageRows != NULL)
+    s_free(pPageRows);
+  /* One block, DisposeFile() disposes it with a single s_free() */
+  pPageRows = alloc(sizeof(TPageRows) + nWinHeight * sizeof(int) +
+    nWinHeight * (nWinWidth + 1) * sizeof(TLineOutput));
+  pFile->pPageRows = pPageRows;
+  if (pPageRows == NULL)
+    return NULL;
+
+  memset(pPageRows, 0, sizeof(TPageRows));
+  pPageRows->nTopLine = pFile->nTopLine;
+  pPageRows->nWidth = nWinWidth;
+  pPageRows->nHeight = nWinHeight;
+  pPageRows->nRowSize = nWinWidth + 1;
+  pPageRows->pRowLine = (int *)(pPageRows + 1);
+  pPageRows->pRows = (TLineOutput *)(pPageRows->pRowLine + nWinHeight);
+  for (i = 0; i < nWinHeight; ++i)
+    pPageRows->pRowLine[i] = -1;
+  return pPageRows;
+}
+
 /* ************************************************************************
    Function: WriteLine
    Description:
@@ -72,19 +370,10 @@ static int WriteLine(const TFile *pFile, int nStartX, int nStartY,
 
   nYLine = nWrtLine - pFile->nTopLine;
   ASSERT(nYLine >= 0);
-  if (nWrtLine < pFile->nNumberOfLines)
-    wline(pFile, nWrtLine, nWidth, OutputBuf, pExtraColorInterf);
-  else
-  {
-    /*
-    There's no line with number nWrtLine.
-    Display <*** End Of File ***> or fill with empty lines.
-    */
-    if (nWrtLine == pFile->nNumberOfLines)
-      PrepareString(pFile->sEndOfFile, nWidth, attrEOF, OutputBuf);
-    else
-      PrepareString("", nWidth, attrText, OutputBuf);
-  }
+  /* The row of the page is prepared again when the page is written */
+  if (pFile->pPageRows != NULL)
+    InvalidateRows(pFile->pPageRows, nWrtLine, nWrtLine);
+  PrepareLine(pFile, nWrtLine, nWidth, OutputBuf, pExtraColorInterf);
   return (PutText(nStartX,
                   nStartY, nWidth, nYLine, nPaletteStart, OutputBuf, disp));
 }
@@ -92,7 +381,8 @@ static int WriteLine(const TFile *pFile, int nStartX, int nStartY,
 /* ************************************************************************
    Function: WritePage
    Description:
-     Displays current page.
+     Displays current page. Only the rows that are not kept from
+     the last time the page was written are prepared by wline().
    Parameters:
      nWinHeight - height of a window where the current page should
        be displayed.
@@ -101,14 +391,19 @@ static int WriteLine(const TFile *pFile, int nStartX, int nStartY,
      PutText - call-back functions from Layer2 to actualy put the line
        on the screen.
    Returns:
-     What WriteLine()/PutText() returned as exit code.
+     What PutText() returned as exit code.
 */
-static int WritePage(const TFile *pFile, int nStartX, int nStartY,
+static int WritePage(TFile *pFile, int nStartX, int nStartY,
   int nWinHeight, int nWinWidth, int nPaletteStart,
+  const TSearchContext *pstSearchContext,
   int (*PutText)(int nStartX, int nStartY, int nWidth, int nYLine,
   int nPaletteStart, const TLineOutput *pBuf, dispc_t *disp),
   TExtraColorInterf *pExtraColorInterf, dispc_t *disp)
 {
+  TLineOutput OutputBuf[MAX_WIN_WIDTH];
+  TLineOutput *pBuf;
+  TPageRows *pPageRows;
+  int nWrtLine;
   int i;
   int nResult;
 
@@ -118,16 +413,62 @@ static int WritePage(const TFile *pFile, int nStartX, int nStartY,
       pFile->nTopLine, nWinHeight, NULL, pExtraColorInterf);
   }
 
+  pPageRows = GetPageRows(pFile, nWinWidth, nWinHeight);
+  if (pPageRows != NULL)
+    SyncPageRows(pPageRows, pFile, pstSearchContext, pExtraColorInterf);
+
   for (i = 0; i < nWinHeight; ++i)
   {
-    nResult = WriteLine(pFile, nStartX, nStartY, i + pFile->nTopLine, nWinWidth,
-      nPaletteStart, PutText, pExtraColorInterf, disp);
+    nWrtLine = i + pFile->nTopLine;
+    if (pPageRows != NULL)
+    {
+      pBuf = pPageRows->pRows + i * pPageRows->nRowSize;
+      if (pPageRows->pRowLine[i] != nWrtLine)
+      {
+        PrepareLine(pFile, nWrtLine, nWinWidth, pBuf, pExtraColorInterf);
+        pPageRows->pRowLine[i] = nWrtLine;
+      }
+    }
+    else
+    {
+      pBuf = OutputBuf;
+      PrepareLine(pFile, nWrtLine, nWinWidth, pBuf, pExtraColorInterf);
+    }
+    nResult = PutText(nStartX, nStartY, nWinWidth, i, nPaletteStart, pBuf, disp);
     if (nResult != 0)
       return (nResult);
   }
   return (0);
 }
 
+/* ************************************************************************
+   Function: ScrollPage
+   Description:
+     When the page moved only a few lines since it was last written,
+     scrolls the lines that remain visible to their new place on the
+     screen. WritePage() then sends only the lines that come in view,
+     what was scrolled compares equal to the new output. The terminal
+     scrolls whole rows, the page must be as wide as the screen.
+*/
+static void ScrollPage(TFile *pFile, int nStartX, int nStartY,
+  int nWinHeight, int nWinWidth, dispc_t *disp)
+{
+  int nShift;
+
+  nShift = pFile->nTopLine - pFile->nPageTopLine;
+  if (pFile->nPageTopLine != -1 && nShift != 0 &&
+    nShift < nWinHeight && -nShift < nWinHeight &&
+    pFile->nPageWrtEdge == pFile->nWrtEdge &&
+    pFile->nPageY == nStartY && pFile->nPageHeight == nWinHeight &&
+    nStartX == 0 && nWinWidth == disp_wnd_get_width(disp))
+    disp_scroll_rows(disp, nStartY, nWinHeight, nShift);
+
+  pFile->nPageTopLine = pFile->nTopLine;
+  pFile->nPageWrtEdge = pFile->nWrtEdge;
+  pFile->nPageY = nStartY;
+  pFile->nPageHeight = nWinHeight;
+}
+
 /* ************************************************************************
    Function: FixWrtPos
    Description:
@@ -215,8 +556,12 @@ int UpdatePage(TFile *pFile, int nStartX, int nStartY, int nWinWidth, int nWinHe
   FixPageCorner(pFile, nWinWidth, nWinHeight, pstSearchContext);
   nResult = 0;  /* In case bUpdatePage is FALSE */
   if (pFile->bUpdatePage)
+  {
+    ScrollPage(pFile, nStartX, nStartY, nWinHeight, nWinWidth, disp);
     nResult = WritePage(pFile, nStartX, nStartY,
-      nWinHeight, nWinWidth, nPaletteStart, PutText, pExtraColorInterf, disp);
+      nWinHeight, nWinWidth, nPaletteStart, pstSearchContext,
+      PutText, pExtraColorInterf, disp);
+  }
   if (nResult != 0)
     goto _prepare_xy;
   if (pFile->bUpdateLine)
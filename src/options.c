@@ -50,10 +50,13 @@ BOOLEAN bOverwriteBlocks_Opt;
 BOOLEAN bSyntaxHighlighting_Opt;
 BOOLEAN bMatchPairHighlighting_Opt;
 BOOLEAN bIF0Highlighting_Opt;
+BOOLEAN bHighlightSearchMatches_Opt;
 BOOLEAN bAscendingSort_Opt;
 BOOLEAN bCaseSensitiveSort_Opt;
 int nRightMargin_Opt;
 BOOLEAN bCombineUndo_Opt;
+int nUndoMemoryLimit_Opt;  /* available only by editing .ini file */
+int nMaxFrameRate_Opt;  /* available only by editing .ini file */
 int nRecoveryTime_Opt;
 BOOLEAN bConsequtiveWinFiles_Opt;  /* available only by editing .ini file */
 int nFileSaveMode_Opt;
@@ -80,10 +83,13 @@ void CopyToEditorOptions(void)
   bSyntaxHighlighting = bSyntaxHighlighting_Opt;
   bMatchPairHighlighting = bMatchPairHighlighting_Opt;
   bIF0Highlighting = bIF0Highlighting_Opt;
+  bHighlightSearchMatches = bHighlightSearchMatches_Opt;
   bAscendingSort = bAscendingSort_Opt;
   bCaseSensitiveSort = bCaseSensitiveSort_Opt;
   nRightMargin = nRightMargin_Opt;
   bCombineUndo = bCombineUndo_Opt;
+  nUndoMemoryLimit = nUndoMemoryLimit_Opt;
+  nMaxFrameRate = nMaxFrameRate_Opt;
   nRecoveryTime = nRecoveryTime_Opt;
   bConsequtiveWinFiles = bConsequtiveWinFiles_Opt;
   nFileSaveMode = nFileSaveMode_Opt;
@@ -106,10 +112,13 @@ void CopyFromEditorOptions(void)
   bSyntaxHighlighting_Opt = bSyntaxHighlighting;
   bMatchPairHighlighting_Opt = bMatchPairHighlighting;
   bIF0Highlighting_Opt = bIF0Highlighting;
+  bHighlightSearchMatches_Opt = bHighlightSearchMatches;
   bAscendingSort_Opt = bAscendingSort;
   bCaseSensitiveSort_Opt = bCaseSensitiveSort;
   nRightMargin_Opt = nRightMargin;
   bCombineUndo_Opt = bCombineUndo;
+  nUndoMemoryLimit_Opt = nUndoMemoryLimit;
+  nMaxFrameRate_Opt = nMaxFrameRate;
   nRecoveryTime_Opt = nRecoveryTime;
   bConsequtiveWinFiles_Opt = bConsequtiveWinFiles;
   nFileSaveMode_Opt = nFileSaveMode;
@@ -29,10 +29,13 @@ extern BOOLEAN bOverwriteBlocks_Opt;
 extern BOOLEAN bSyntaxHighlighting_Opt;
 extern BOOLEAN bMatchPairHighlighting_Opt;
 extern BOOLEAN bIF0Highlighting_Opt;
+extern BOOLEAN bHighlightSearchMatches_Opt;
 extern BOOLEAN bAscendingSort_Opt;
 extern BOOLEAN bCaseSensitiveSort_Opt;
 extern int nRightMargin_Opt;
 extern BOOLEAN bCombineUndo_Opt;
+extern int nUndoMemoryLimit_Opt;
+extern int nMaxFrameRate_Opt;
 extern int nRecoveryTime_Opt;
 extern BOOLEAN bConsequtiveWinFiles_Opt;  /* available only by editing .ini file */
 extern int nFileSaveMode_Opt;
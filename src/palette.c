@@ -41,6 +41,7 @@ BYTE BorlandPalette[MAX_PALETTE] =
   0x30,        /* coEdTooltip */
   0x60,        /* coEdBlockCursor */
   0x20,        /* coEdBookmark */
+  0x5f,        /* coEdSearchMatch */
   0x0f, 0x0f,  /* coSmallEOF, coSmallEdText */
   0x70, 0x0f,  /* coSmallEdBlock, coSmallEdNumber */
   0x0f, 0x0f,  /* coSmallEditEdComment, coSmallEditEdReserved */
@@ -51,6 +52,7 @@ BYTE BorlandPalette[MAX_PALETTE] =
   0x10,        /* coSmallEdTooltip */
   0x60,        /* coSmallEdBlockCursor */
   0x02,        /* coSmallEdBookmark */
+  0x5f,        /* coSmallEdSearchMatch */
   0x0a,        /* coEnterLn */
   0x20, 0x0b,  /* coUnchanged, coEnterLnPrompt */
   0x02,	       /* coEnterLnBrace */
@@ -101,6 +103,7 @@ BYTE VCPalette[MAX_PALETTE] =
   0xe0,        /* coEdTooltip */
   0x60,        /* coEdBlockCursor */
   0x02,        /* coEdBookmark */
+  0x5f,        /* coEdSearchMatch */
   0x0f, 0x0f,  /* coSmallEOF, coSmallEdText */
   0x70, 0x0f,  /* coSmallEdBlock, coSmallEdNumber */
   0x0f, 0x0f,  /* coSmallEditEdComment, coSmallEditEdReserved */
@@ -111,6 +114,7 @@ BYTE VCPalette[MAX_PALETTE] =
   0xe0,        /* coSmallEdTooltip */
   0x60,        /* coSmallEdBlockCursor */
   0x02,        /* coSmallEdBookmark */
+  0x5f,        /* coSmallEdSearchMatch */
   0x0a,        /* coEnterLn */
   0x20, 0x0b,  /* coUnchanged, coEnterLnPrompt */
   0x02,	       /* coEnterLnBrace */
@@ -231,6 +235,7 @@ int pal_init(dispc_t *disp)
   PAL_ADD(coEdTooltip, 0x3, 0x0, 0);
   PAL_ADD(coEdBlockCursor, 0x6, 0x0, 0);
   PAL_ADD(coEdBookmark, 0x2, 0x0, 0);
+  PAL_ADD(coEdSearchMatch, 0x5, 0xf, 0);
   PAL_ADD(coSmallEdEOF, 0x0, 0xf, 0);
   PAL_ADD(coSmallEdText, 0x0, 0xf, 0);
   PAL_ADD(coSmallEdBlock, 0x7, 0x0, 0);
@@ -247,6 +252,7 @@ int pal_init(dispc_t *disp)
   PAL_ADD(coSmallEdTooltip, 0x1, 0x0, 0);
   PAL_ADD(coSmallEdBlockCursor, 0x6, 0x0, 0);
   PAL_ADD(coSmallEdBookmark, 0x0, 0x2, 0);
+  PAL_ADD(coSmallEdSearchMatch, 0x5, 0xf, 0);
   PAL_ADD(coEnterLn, 0x0, 0xa, 0);
   PAL_ADD(coUnchanged, 0x2, 0x0, 0);
   PAL_ADD(coEnterLnPrompt, 0x0, 0xb, 0);
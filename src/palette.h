@@ -39,6 +39,7 @@ enum Colors
   coEdTooltip,
   coEdBlockCursor,
   coEdBookmark,
+  coEdSearchMatch,
   coSmallEdEOF,
   coSmallEdText,
   coSmallEdBlock,
@@ -55,6 +56,7 @@ enum Colors
   coSmallEdTooltip,
   coSmallEdBlockCursor,
   coSmallEdBookmark,
+  coSmallEdSearchMatch,
   coEnterLn,
   coUnchanged,
   coEnterLnPrompt,
@@ -0,0 +1,470 @@
+/*
+
+File: recwrite.c
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Background writer of the recovery journals.
+
+  StoreRecoveryRecord() composes the new records of the journal of
+  a file in a buffer and passes the buffer here. A single thread
+  appends the buffers to the journals in the order they come and
+  flushes every buffer to the disk, so a slow disk doesn't stop
+  the editing.
+
+  A buffer that can't be written is cut off from the journal and the
+  following buffers of the same journal are dropped until a new
+  journal is started. So the journal always holds the records up to
+  some point and no gaps. RecoveryJournalGetError() tells the editor
+  about the failure.
+
+  The writer must not touch any editor data, the memory is taken
+  directly from malloc()/free() as the debug heap (heapg.c) is not
+  thread safe. On platforms without threads the buffers are written
+  by the caller.
+
+*/
+
+#include "global.h"
+#include "maxpath.h"
+#include "recwrite.h"
+
+#include <fcntl.h>
+#ifdef WIN32
+#include <io.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#ifdef UNIX
+#include <pthread.h>
+#define RECOVERY_WRITER_THREAD
+#endif
+
+struct RecoveryJournal
+{
+  char sFileName[_MAX_PATH];
+  int nFd;  /* -1 when not open */
+  long nSize;  /* bytes of complete records */
+  int nError;  /* errno of the failed write, 0 if none */
+  int nPending;  /* jobs in the queue or being written */
+};
+
+/* Kinds of jobs */
+#define rjAPPEND  0
+#define rjNEW  1  /* start the journal over */
+#define rjRELEASE  2  /* close the journal */
+#define rjREMOVE  3  /* close and remove the journal */
+
+typedef struct RecoveryJob
+{
+  struct RecoveryJob *pNext;
+  TRecoveryJournal *pJournal;
+  int nKind;
+  BYTE *pData;  /* malloc()-ed */
+  int nSize;
+} TRecoveryJob;
+
+static TRecoveryJob *pFirstJob;
+static TRecoveryJob *pLastJob;
+
+#ifdef RECOVERY_WRITER_THREAD
+static BOOLEAN bWriterStarted;
+static BOOLEAN bWriterQuit;
+static pthread_t WriterThread;
+static pthread_mutex_t WriterLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t JobsReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t JobDone = PTHREAD_COND_INITIALIZER;
+#define LOCK_WRITER()  pthread_mutex_lock(&WriterLock)
+#define UNLOCK_WRITER()  pthread_mutex_unlock(&WriterLock)
+#else
+#define LOCK_WRITER()
+#define UNLOCK_WRITER()
+#endif
+
+/* ************************************************************************
+   Function: RecoveryJournalCreate
+   Description:
+     Prepares a journal to be written in psFileName. Nothing is
+     written until the first buffer comes.
+   Returns:
+     NULL -- no memory.
+*/
+TRecoveryJournal *RecoveryJournalCreate(const char *psFileName)
+{
+  TRecoveryJournal *pJournal;
+
+  pJournal = malloc(sizeof(TRecoveryJournal));
+  if (pJournal == NULL)
+    return NULL;
+  strncpy(pJournal->sFileName, psFileName, _MAX_PATH - 1);
+  pJournal->sFileName[_MAX_PATH - 1] = '\0';
+  pJournal->nFd = -1;
+  pJournal->nSize = 0;
+  pJournal->nError = 0;
+  pJournal->nPending = 0;
+  return pJournal;
+}
+
+/* ************************************************************************
+   Function: OpenJournal
+   Description:
+     Opens the journal for a job. A new journal is created or
+     truncated, an existing one must be there already.
+   Returns:
+     0 or errno.
+*/
+static int OpenJournal(TRecoveryJournal *pJournal, BOOLEAN bNew)
+{
+  struct stat statbuf;
+
+  if (bNew && pJournal->nFd != -1)
+  {
+    close(pJournal->nFd);
+    pJournal->nFd = -1;
+  }
+  if (pJournal->nFd != -1)
+    return 0;
+
+  if (bNew)
+    pJournal->nFd = open(pJournal->sFileName,
+      O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+  else
+    pJournal->nFd = open(pJournal->sFileName,
+      O_WRONLY | O_APPEND | O_BINARY);
+  if (pJournal->nFd == -1)
+    return errno;
+
+  pJournal->nSize = 0;
+  if (!bNew)
+  {
+    if (fstat(pJournal->nFd, &statbuf) != 0)
+      return errno;
+    pJournal->nSize = statbuf.st_size;
+  }
+  return 0;
+}
+
+/* ************************************************************************
+   Function: WriteJournal
+   Description:
+     Appends a buffer to the journal and flushes it to the disk.
+     A buffer that was written only partly is cut off.
+   Returns:
+     0 or errno.
+*/
+static int WriteJournal(TRecoveryJournal *pJournal, const BYTE *pData, int nSize)
+{
+  const BYTE *p;
+  const BYTE *pEnd;
+  int nWritten;
+  int nError;
+
+  pEnd = pData + nSize;
+  for (p = pData; p < pEnd; p += nWritten)
+  {
+    nWritten = write(pJournal->nFd, p, pEnd - p);
+    if (nWritten <= 0)
+    {
+      if (nWritten == -1 && errno == EINTR)
+      {
+        nWritten = 0;
+        continue;
+      }
+      nError = nWritten == -1 ? errno : ENOSPC;
+      #ifdef UNIX
+      if (p != pData)
+        ftruncate(pJournal->nFd, pJournal->nSize);
+      #endif
+      return nError;
+    }
+  }
+
+  #if defined(LINUX)
+  if (fdatasync(pJournal->nFd) != 0)
+    return errno;
+  #elif defined(UNIX)
+  if (fsync(pJournal->nFd) != 0)
+    return errno;
+  #endif
+
+  pJournal->nSize += nSize;
+  return 0;
+}
+
+/* ************************************************************************
+   Function: DoJob
+   Description:
+     Does the disk operations of a job. The journal of a release
+     job is disposed.
+*/
+static void DoJob(TRecoveryJob *pJob)
+{
+  TRecoveryJournal *pJournal;
+  int nError;
+
+  pJournal = pJob->pJournal;
+  switch (pJob->nKind)
+  {
+    case rjNEW:
+    case rjAPPEND:
+      LOCK_WRITER();
+      if (pJob->nKind == rjNEW)
+        pJournal->nError = 0;
+      nError = pJournal->nError;
+      UNLOCK_WRITER();
+      if (nError != 0)
+        break;  /* Keep the journal without gaps */
+      nError = OpenJournal(pJournal, pJob->nKind == rjNEW);
+      if (nError == 0)
+        nError = WriteJournal(pJournal, pJob->pData, pJob->nSize);
+      LOCK_WRITER();
+      pJournal->nError = nError;
+      UNLOCK_WRITER();
+      break;
+
+    case rjRELEASE:
+    case rjREMOVE:
+      if (pJournal->nFd != -1)
+        close(pJournal->nFd);
+      if (pJob->nKind == rjREMOVE)
+        unlink(pJournal->sFileName);
+      free(pJournal);
+      pJournal = NULL;
+      break;
+  }
+  free(pJob->pData);
+
+  LOCK_WRITER();
+  if (pJournal != NULL)
+    --pJournal->nPending;
+  #ifdef RECOVERY_WRITER_THREAD
+  pthread_cond_broadcast(&JobDone);
+  #endif
+  UNLOCK_WRITER();
+}
+
+#ifdef RECOVERY_WRITER_THREAD
+/* ************************************************************************
+   Function: RecoveryWriter
+   Description:
+     Takes the jobs from the queue until RecoveryWriterDone().
+*/
+static void *RecoveryWriter(void *pContext)
+{
+  TRecoveryJob *pJob;
+
+  LOCK_WRITER();
+  while (1)
+  {
+    while (pFirstJob == NULL && !bWriterQuit)
+      pthread_cond_wait(&JobsReady, &WriterLock);
+    pJob = pFirstJob;
+    if (pJob == NULL)
+      break;  /* Quit and nothing more to write */
+    pFirstJob = pJob->pNext;
+    if (pFirstJob == NULL)
+      pLastJob = NULL;
+    UNLOCK_WRITER();
+
+    DoJob(pJob);
+    free(pJob);
+
+    LOCK_WRITER();
+  }
+  UNLOCK_WRITER();
+  return NULL;
+}
+#endif
+
+/* ************************************************************************
+   Function: QueueJob
+   Description:
+     Passes a job to the writer thread. Without a thread or without
+     memory for the job, waits for the journal's jobs in the queue
+     and does the job here.
+*/
+static void QueueJob(TRecoveryJournal *pJournal, int nKind,
+  BYTE *pData, int nSize)
+{
+  TRecoveryJob *pJob;
+  TRecoveryJob stJob;
+
+  LOCK_WRITER();
+  ++pJournal->nPending;
+  UNLOCK_WRITER();
+
+  #ifdef RECOVERY_WRITER_THREAD
+  pJob = malloc(sizeof(TRecoveryJob));
+  if (pJob != NULL)
+  {
+    pJob->pNext = NULL;
+    pJob->pJournal = pJournal;
+    pJob->nKind = nKind;
+    pJob->pData = pData;
+    pJob->nSize = nSize;
+
+    LOCK_WRITER();
+    if (!bWriterStarted)
+    {
+      bWriterQuit = FALSE;
+      if (pthread_create(&WriterThread, NULL, RecoveryWriter, NULL) == 0)
+        bWriterStarted = TRUE;
+    }
+    if (bWriterStarted)
+    {
+      if (pLastJob == NULL)
+        pFirstJob = pJob;
+      else
+        pLastJob->pNext = pJob;
+      pLastJob = pJob;
+      pthread_cond_signal(&JobsReady);
+      UNLOCK_WRITER();
+      return;
+    }
+    UNLOCK_WRITER();
+    free(pJob);
+  }
+
+  LOCK_WRITER();
+  while (pJournal->nPending > 1)
+    pthread_cond_wait(&JobDone, &WriterLock);
+  UNLOCK_WRITER();
+  #endif
+
+  stJob.pNext = NULL;
+  stJob.pJournal = pJournal;
+  stJob.nKind = nKind;
+  stJob.pData = pData;
+  stJob.nSize = nSize;
+  DoJob(&stJob);
+}
+
+/* ************************************************************************
+   Function: RecoveryJournalWrite
+   Description:
+     Passes a buffer of journal records to the writer. bNew -- the
+     journal is started over and the buffer has the beginning of the
+     journal. pData is to be allocated by malloc() and is disposed
+     by the writer.
+*/
+void RecoveryJournalWrite(TRecoveryJournal *pJournal, BOOLEAN bNew,
+  BYTE *pData, int nSize)
+{
+  QueueJob(pJournal, bNew ? rjNEW : rjAPPEND, pData, nSize);
+}
+
+/* ************************************************************************
+   Function: RecoveryJournalGetError
+   Description:
+     Returns the errno of the last write that failed. The writes
+     after the failure are dropped until the journal is started over.
+*/
+int RecoveryJournalGetError(TRecoveryJournal *pJournal)
+{
+  int nError;
+
+  LOCK_WRITER();
+  nError = pJournal->nError;
+  UNLOCK_WRITER();
+  return nError;
+}
+
+/* ************************************************************************
+   Function: RecoveryJournalWait
+   Description:
+     Waits until all the buffers of the journal are written.
+*/
+void RecoveryJournalWait(TRecoveryJournal *pJournal)
+{
+  #ifdef RECOVERY_WRITER_THREAD
+  LOCK_WRITER();
+  while (pJournal->nPending > 0)
+    pthread_cond_wait(&JobDone, &WriterLock);
+  UNLOCK_WRITER();
+  #endif
+}
+
+/* ************************************************************************
+   Function: RecoveryJournalClose
+   Description:
+     Waits for the buffers of the journal, closes it and
+     disposes pJournal.
+*/
+void RecoveryJournalClose(TRecoveryJournal *pJournal)
+{
+  RecoveryJournalWait(pJournal);
+  if (pJournal->nFd != -1)
+    close(pJournal->nFd);
+  free(pJournal);
+}
+
+/* ************************************************************************
+   Function: RecoveryJournalRelease
+   Description:
+     The writer closes the journal after its buffers are written
+     and disposes pJournal. bRemove -- removes the journal file too.
+     pJournal can't be used after the call.
+*/
+void RecoveryJournalRelease(TRecoveryJournal *pJournal, BOOLEAN bRemove)
+{
+  QueueJob(pJournal, bRemove ? rjREMOVE : rjRELEASE, NULL, 0);
+}
+
+/* ************************************************************************
+   Function: RecoveryWriterDone
+   Description:
+     Waits for the writer to complete all the jobs and stops it.
+*/
+void RecoveryWriterDone(void)
+{
+  #ifdef RECOVERY_WRITER_THREAD
+  LOCK_WRITER();
+  if (!bWriterStarted)
+  {
+    UNLOCK_WRITER();
+    return;
+  }
+  bWriterQuit = TRUE;
+  pthread_cond_signal(&JobsReady);
+  UNLOCK_WRITER();
+
+  pthread_join(WriterThread, NULL);
+  bWriterStarted = FALSE;
+  #endif
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
@@ -0,0 +1,58 @@
+/*
+
+File: recwrite.h
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Background writer of the recovery journals.
+
+*/
+
+#ifndef RECWRITE_H
+#define RECWRITE_H
+
+typedef struct RecoveryJournal TRecoveryJournal;
+
+TRecoveryJournal *RecoveryJournalCreate(const char *psFileName);
+void RecoveryJournalWrite(TRecoveryJournal *pJournal, BOOLEAN bNew,
+  BYTE *pData, int nSize);
+int RecoveryJournalGetError(TRecoveryJournal *pJournal);
+void RecoveryJournalWait(TRecoveryJournal *pJournal);
+void RecoveryJournalClose(TRecoveryJournal *pJournal);
+void RecoveryJournalRelease(TRecoveryJournal *pJournal, BOOLEAN bRemove);
+void RecoveryWriterDone(void);
+
+#endif  /* RECWRITE_H */
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
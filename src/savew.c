@@ -0,0 +1,395 @@
+/*
+
+File: savew.c
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Background writer that stores files to disk.
+
+  StoreFile() pins a copy of the line index of the file (the blocks
+  of text are kept alive by their reference counters) and passes it
+  here. A pool of up to MAX_SAVE_WRITERS threads writes the lines to
+  the disk, producing the backup file first, so a slow disk or a network
+  mount doesn't stop the editing. Save All passes all the changed files
+  at once and they are written in parallel. A writer is started only
+  when a job finds no idle one. The editor polls SaveJobIsDone() and
+  completes the store on its own thread.
+
+  The text of the lines is read only, the writer must not touch any
+  other editor data. The memory is taken directly from malloc()/free()
+  as the debug heap (heapg.c) is not thread safe. On platforms without
+  threads the file is written by the caller.
+
+*/
+
+#include "global.h"
+#include "maxpath.h"
+#include "wlimits.h"
+#include "savew.h"
+
+#ifdef UNIX
+#include <pthread.h>
+#define SAVE_WRITER_THREAD
+#endif
+
+#define MAX_SAVE_WRITERS  4
+
+struct SaveJob
+{
+  struct SaveJob *pNext;
+  char sFileName[_MAX_PATH];
+  char sTargetName[_MAX_PATH];  /* The file sFileName links to */
+  char sBackupName[_MAX_PATH];  /* "" -- no backup file */
+  const TLine *pLines;
+  int nNumberOfLines;
+  int nEOLType;
+  void *pContext;
+  BOOLEAN bDone;
+  int nResult;
+  int nError;  /* errno of the failed operation */
+  const char *psFailedName;
+};
+
+static TSaveJob *pFirstJob;
+static TSaveJob *pLastJob;
+
+#ifdef SAVE_WRITER_THREAD
+static int nWriters;  /* Started threads */
+static int nIdleWriters;  /* Threads waiting for a job */
+static int nQueuedJobs;  /* Jobs not yet taken by a writer */
+static BOOLEAN bWriterQuit;
+static pthread_t WriterThreads[MAX_SAVE_WRITERS];
+static pthread_mutex_t WriterLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t JobsReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t JobDone = PTHREAD_COND_INITIALIZER;
+#define LOCK_WRITER()  pthread_mutex_lock(&WriterLock)
+#define UNLOCK_WRITER()  pthread_mutex_unlock(&WriterLock)
+#else
+#define LOCK_WRITER()
+#define UNLOCK_WRITER()
+#endif
+
+/* ************************************************************************
+   Function: WriteLines
+   Description:
+     Writes the lines of a job, each one followed by the end-of-line
+     marker of nEOLType.
+   Returns:
+     0 -- stored sucessfully;
+     1 -- failed to open the file for writing;
+     2 -- failed to store whole the file.
+*/
+static int WriteLines(TSaveJob *pJob)
+{
+  static const char *psEOL[] = {"\r\n", "\n", "\r"};
+  const TLine *pLine;
+  const TLine *pEnd;
+  const char *psLineEnd;
+  int nEOLSize;
+  int nResult;
+  FILE *f;
+
+  ASSERT(pJob->nEOLType >= CRLFtype && pJob->nEOLType <= CRtype);
+
+  psLineEnd = psEOL[pJob->nEOLType];
+  nEOLSize = strlen(psLineEnd);
+
+  f = fopen(pJob->sFileName, WRITE_BINARY_FILE);
+  if (f == NULL)
+    return 1;
+
+  nResult = 0;
+  pEnd = pJob->pLines + pJob->nNumberOfLines;
+  for (pLine = pJob->pLines; pLine < pEnd; ++pLine)
+  {
+    if ((int)fwrite(pLine->pLine, 1, pLine->nLen, f) != pLine->nLen ||
+      (int)fwrite(psLineEnd, 1, nEOLSize, f) != nEOLSize)
+    {
+      nResult = 2;  /* Failed to store whole the file */
+      break;
+    }
+  }
+
+  /* The data of a network file may be rejected only at close */
+  if (fclose(f) != 0 && nResult == 0)
+    nResult = 2;
+  return nResult;
+}
+
+/* ************************************************************************
+   Function: DoJob
+   Description:
+     Produces the backup file and writes the file of a job.
+*/
+static void DoJob(TSaveJob *pJob)
+{
+  int nResult;
+  int nError;
+  const char *psFailedName;
+
+  nResult = 0;
+  psFailedName = pJob->sFileName;
+  if (pJob->sBackupName[0] != '\0')
+  {
+    if (unlink(pJob->sBackupName) != 0 && errno != ENOENT)
+    {
+      nResult = 4;  /* Failed to remove the old backup file */
+      psFailedName = pJob->sBackupName;
+    }
+    else if (rename(pJob->sTargetName, pJob->sBackupName) != 0)
+      nResult = 5;  /* Failed to produce the backup file */
+  }
+  if (nResult == 0)
+    nResult = WriteLines(pJob);
+  nError = errno;
+
+  LOCK_WRITER();
+  pJob->nResult = nResult;
+  pJob->nError = nResult != 0 ? nError : 0;
+  pJob->psFailedName = psFailedName;
+  pJob->bDone = TRUE;
+  #ifdef SAVE_WRITER_THREAD
+  pthread_cond_broadcast(&JobDone);
+  #endif
+  UNLOCK_WRITER();
+}
+
+#ifdef SAVE_WRITER_THREAD
+/* ************************************************************************
+   Function: SaveWriter
+   Description:
+     Takes the jobs from the queue until SaveWriterDone().
+*/
+static void *SaveWriter(void *pContext)
+{
+  TSaveJob *pJob;
+
+  LOCK_WRITER();
+  while (1)
+  {
+    ++nIdleWriters;
+    while (pFirstJob == NULL && !bWriterQuit)
+      pthread_cond_wait(&JobsReady, &WriterLock);
+    --nIdleWriters;
+    pJob = pFirstJob;
+    if (pJob == NULL)
+      break;  /* Quit and nothing more to write */
+    pFirstJob = pJob->pNext;
+    if (pFirstJob == NULL)
+      pLastJob = NULL;
+    --nQueuedJobs;
+    UNLOCK_WRITER();
+
+    DoJob(pJob);
+
+    LOCK_WRITER();
+  }
+  UNLOCK_WRITER();
+  return NULL;
+}
+#endif
+
+/* ************************************************************************
+   Function: SaveJobSubmit
+   Description:
+     Passes a file to the writer to be stored as psFileName.
+     psBackupName -- if not NULL, psTargetName (the file psFileName
+     links to) is renamed to psBackupName first.
+     pLines -- the lines to be stored, they must remain unchanged
+     until the job is done.
+     A new writer is started if the queued jobs outnumber the idle
+     writers. Without a thread the file is written here.
+   Returns:
+     NULL -- no memory.
+*/
+TSaveJob *SaveJobSubmit(const char *psFileName, const char *psTargetName,
+  const char *psBackupName, const TLine *pLines, int nNumberOfLines,
+  int nEOLType, void *pContext)
+{
+  TSaveJob *pJob;
+
+  ASSERT(psFileName != NULL);
+  ASSERT(psBackupName == NULL || psTargetName != NULL);
+
+  pJob = malloc(sizeof(TSaveJob));
+  if (pJob == NULL)
+    return NULL;
+  pJob->pNext = NULL;
+  strcpy(pJob->sFileName, psFileName);
+  pJob->sTargetName[0] = '\0';
+  pJob->sBackupName[0] = '\0';
+  if (psBackupName != NULL)
+  {
+    strcpy(pJob->sTargetName, psTargetName);
+    strcpy(pJob->sBackupName, psBackupName);
+  }
+  pJob->pLines = pLines;
+  pJob->nNumberOfLines = nNumberOfLines;
+  pJob->nEOLType = nEOLType;
+  pJob->pContext = pContext;
+  pJob->bDone = FALSE;
+  pJob->nResult = 0;
+  pJob->nError = 0;
+  pJob->psFailedName = pJob->sFileName;
+
+  #ifdef SAVE_WRITER_THREAD
+  LOCK_WRITER();
+  if (nQueuedJobs + 1 > nIdleWriters && nWriters < MAX_SAVE_WRITERS)
+  {
+    bWriterQuit = FALSE;
+    if (pthread_create(&WriterThreads[nWriters], NULL, SaveWriter, NULL) == 0)
+      ++nWriters;
+  }
+  if (nWriters > 0)
+  {
+    if (pLastJob == NULL)
+      pFirstJob = pJob;
+    else
+      pLastJob->pNext = pJob;
+    pLastJob = pJob;
+    ++nQueuedJobs;
+    pthread_cond_signal(&JobsReady);
+    UNLOCK_WRITER();
+    return pJob;
+  }
+  UNLOCK_WRITER();
+  #endif
+
+  DoJob(pJob);
+  return pJob;
+}
+
+/* ************************************************************************
+   Function: SaveJobIsDone
+   Description:
+     Checks, without waiting, whether the writer has completed a job.
+*/
+BOOLEAN SaveJobIsDone(TSaveJob *pJob)
+{
+  BOOLEAN bDone;
+
+  LOCK_WRITER();
+  bDone = pJob->bDone;
+  UNLOCK_WRITER();
+  return bDone;
+}
+
+/* ************************************************************************
+   Function: SaveJobWait
+   Description:
+     Waits until the writer completes a job.
+*/
+void SaveJobWait(TSaveJob *pJob)
+{
+  #ifdef SAVE_WRITER_THREAD
+  LOCK_WRITER();
+  while (!pJob->bDone)
+    pthread_cond_wait(&JobDone, &WriterLock);
+  UNLOCK_WRITER();
+  #endif
+  ASSERT(pJob->bDone);
+}
+
+/* ************************************************************************
+   Function: SaveJobGetResult
+   Description:
+     Gets the result of a job that is done. *pnError -- errno of the
+     failed operation, *psName -- the file the error refers to.
+   Returns:
+     0 -- stored sucessfully;
+     1 -- failed to open the file for writing;
+     2 -- failed to store whole the file;
+     4 -- failed to remove the old backup file;
+     5 -- failed to rename the file to the backup file.
+*/
+int SaveJobGetResult(TSaveJob *pJob, int *pnError, const char **psName)
+{
+  ASSERT(pJob->bDone);
+
+  if (pnError != NULL)
+    *pnError = pJob->nError;
+  if (psName != NULL)
+    *psName = pJob->psFailedName;
+  return pJob->nResult;
+}
+
+/* ************************************************************************
+   Function: SaveJobGetContext
+   Description:
+*/
+void *SaveJobGetContext(TSaveJob *pJob)
+{
+  return pJob->pContext;
+}
+
+/* ************************************************************************
+   Function: SaveJobDispose
+   Description:
+     Disposes a job that is done.
+*/
+void SaveJobDispose(TSaveJob *pJob)
+{
+  ASSERT(pJob->bDone);
+  free(pJob);
+}
+
+/* ************************************************************************
+   Function: SaveWriterDone
+   Description:
+     Waits for the writers to complete all the jobs and stops them.
+*/
+void SaveWriterDone(void)
+{
+  #ifdef SAVE_WRITER_THREAD
+  int i;
+
+  LOCK_WRITER();
+  if (nWriters == 0)
+  {
+    UNLOCK_WRITER();
+    return;
+  }
+  bWriterQuit = TRUE;
+  pthread_cond_broadcast(&JobsReady);
+  UNLOCK_WRITER();
+
+  for (i = 0; i < nWriters; ++i)
+    pthread_join(WriterThreads[i], NULL);
+  nWriters = 0;
+  ASSERT(nQueuedJobs == 0);
+  #endif
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -18,11 +18,14 @@ Descrition:
 #include "undo.h"
 #include "block.h"
 #include "search.h"
+#include "synh.h"
 
 #define STATIC
 #include "pcre.h"  /* Perl regular expressions library */
 #undef STATIC
 
+static int nSearchGeneration;  /* NewSearch() stamps each new pattern */
+
 /* ************************************************************************
    Function: InitSearchContext
    Description:
@@ -127,6 +130,7 @@ BOOLEAN NewSearch(TSearchContext *pstSearchContext, const char *sText,
   pstSearchContext->nNumLines = nNumLines;
 
   strcpy(pstSearchContext->sSearch, sText);
+  pstSearchContext->nGeneration = ++nSearchGeneration;
 
   if (pstSearchContext->bRegAllocated)
   {
@@ -1327,6 +1331,238 @@ void _CmdIncrementalSearch(TFile *pFile, int nDir, int nWidth,
   nPreISearch_Row = pFile->nRow;
 }
 
+/*
+Search matches of the visible page. The cache is a direct-mapped table
+indexed by line number, this way scrolling reuses the lines that stay on
+the screen and only the newly exposed lines are scanned again.
+*/
+typedef struct PageMatch
+{
+  int nStart;
+  int nEnd;  /* inclusive */
+} TPageMatch;
+
+typedef struct PageMatchLine
+{
+  int nLine;  /* -1 for an empty slot */
+  int nEditVersion;  /* pFile->nEditVersion at the time of the scan */
+  int nNumMatches;
+  TPageMatch Matches[MAX_LINE_MATCHES];
+} TPageMatchLine;
+
+typedef struct PageMatchCache
+{
+  const TFile *pFile;
+  int nFileID;
+  int nGeneration;
+  BOOLEAN bCaseSensitive;
+  BOOLEAN bRegularExpr;
+  char sPattern[MAX_SEARCH_STR];  /* lower case if !bCaseSensitive */
+  int nPatternLen;
+  TPageMatchLine Lines[MAX_PAGE_MATCH_LINES];
+} TPageMatchCache;
+
+/* ************************************************************************
+   Function: ResetPageMatches
+   Description:
+     Invalidates all the cached lines and stores the parameters
+     of the current search pattern.
+*/
+static void ResetPageMatches(TPageMatchCache *pCache, const TFile *pFile,
+  const TSearchContext *pstSearchContext)
+{
+  int i;
+
+  pCache->nFileID = pFile->nID;
+  pCache->nGeneration = pstSearchContext->nGeneration;
+  pCache->bCaseSensitive = pstSearchContext->bCaseSensitive;
+  pCache->bRegularExpr = pstSearchContext->bRegularExpr;
+  strcpy(pCache->sPattern, pstSearchContext->sSearch);
+  if (!pCache->bCaseSensitive)
+    strlwr(pCache->sPattern);
+  pCache->nPatternLen = strlen(pCache->sPattern);
+
+  for (i = 0; i < MAX_PAGE_MATCH_LINES; ++i)
+    pCache->Lines[i].nLine = -1;
+}
+
+/* ************************************************************************
+   Function: ScanLineMatches
+   Description:
+     Collects the positions of all the occurrences of the search pattern
+     in a line of the file.
+*/
+static void ScanLineMatches(TPageMatchCache *pCache, int nLine,
+  const TSearchContext *pstSearchContext, TPageMatchLine *pSlot)
+{
+  const TFile *pFile;
+  char *pText;
+  char *p;
+  char *d;
+  int nLen;
+  int nPos;
+  int nCount;
+  int Offsets[30];
+
+  pFile = pCache->pFile;
+  pSlot->nLine = nLine;
+  pSlot->nEditVersion = pFile->nEditVersion;
+  pSlot->nNumMatches = 0;
+
+  if (nLine >= pFile->nNumberOfLines)
+    return;
+  if (pstSearchContext->nNumLines > 0)
+    return;  /* multiple-line patterns are not highlighted */
+
+  pText = GetLineText(pFile, nLine);
+  nLen = GetLine(pFile, nLine)->nLen;
+
+  if (pCache->bRegularExpr)
+  {
+    if (!pstSearchContext->bRegAllocated)
+      return;
+    nPos = 0;
+    while (nPos <= nLen && pSlot->nNumMatches < MAX_LINE_MATCHES)
+    {
+      nCount = pcre_exec(pstSearchContext->pstRegExprData, NULL,
+        pText, nLen, nPos, 0, Offsets, _countof(Offsets));
+      if (nCount < 0)
+        break;
+      if (Offsets[0] == Offsets[1])  /* a position only, nothing to show */
+      {
+        nPos = Offsets[1] + 1;
+        continue;
+      }
+      pSlot->Matches[pSlot->nNumMatches].nStart = Offsets[0];
+      pSlot->Matches[pSlot->nNumMatches].nEnd = Offsets[1] - 1;
+      ++pSlot->nNumMatches;
+      nPos = Offsets[1];
+    }
+    return;
+  }
+
+  if (pCache->nPatternLen == 0)
+    return;
+
+  p = pText;
+  while (pText + nLen - p >= pCache->nPatternLen &&
+    pSlot->nNumMatches < MAX_LINE_MATCHES)
+  {
+    d = pCache->sPattern;
+    nPos = 0;
+    if (pCache->bCaseSensitive)
+    {
+      while (d[nPos] != '\0' && p[nPos] == d[nPos])
+        ++nPos;
+    }
+    else
+    {
+      while (d[nPos] != '\0' && tolower((BYTE)p[nPos]) == (BYTE)d[nPos])
+        ++nPos;
+    }
+    if (d[nPos] != '\0')
+    {
+      ++p;
+      continue;
+    }
+    pSlot->Matches[pSlot->nNumMatches].nStart = p - pText;
+    pSlot->Matches[pSlot->nNumMatches].nEnd = p - pText + pCache->nPatternLen - 1;
+    ++pSlot->nNumMatches;
+    p += pCache->nPatternLen;
+  }
+}
+
+/* ************************************************************************
+   Function: PreparePageMatches
+   Description:
+     Called before a page of a file is displayed. Allocates the match
+     cache on first use, drops it entirely when the file or the search
+     pattern differ from what was cached and scans only the lines of
+     the page that are not in the cache or were edited since.
+*/
+void PreparePageMatches(const TFile *pFile, int nTopLine, int nWinHeight,
+  const TSearchContext *pstSearchContext, void **ppMatchCache)
+{
+  TPageMatchCache *pCache;
+  TPageMatchLine *pSlot;
+  int nLine;
+
+  ASSERT(VALID_PFILE(pFile));
+  ASSERT(VALID_PSEARCHCTX(pstSearchContext));
+  ASSERT(ppMatchCache != NULL);
+
+  pCache = *ppMatchCache;
+  if (pCache == NULL)
+  {
+    pCache = alloc(sizeof(TPageMatchCache));
+    if (pCache == NULL)
+      return;  /* no memory, no highlighting */
+    ResetPageMatches(pCache, pFile, pstSearchContext);
+    *ppMatchCache = pCache;
+  }
+
+  if (pCache->nFileID != pFile->nID ||
+    pCache->nGeneration != pstSearchContext->nGeneration ||
+    pCache->bCaseSensitive != pstSearchContext->bCaseSensitive ||
+    pCache->bRegularExpr != pstSearchContext->bRegularExpr ||
+    (pCache->bCaseSensitive ?
+      strcmp(pCache->sPattern, pstSearchContext->sSearch) :
+      stricmp(pCache->sPattern, pstSearchContext->sSearch)) != 0)
+    ResetPageMatches(pCache, pFile, pstSearchContext);
+  pCache->pFile = pFile;
+
+  if (nWinHeight > MAX_PAGE_MATCH_LINES)
+    nWinHeight = MAX_PAGE_MATCH_LINES;
+  for (nLine = nTopLine; nLine < nTopLine + nWinHeight; ++nLine)
+  {
+    pSlot = &pCache->Lines[nLine % MAX_PAGE_MATCH_LINES];
+    if (pSlot->nLine == nLine && pSlot->nEditVersion == pFile->nEditVersion)
+      continue;
+    ScanLineMatches(pCache, nLine, pstSearchContext, pSlot);
+  }
+}
+
+/* ************************************************************************
+   Function: ApplyPageMatches
+   Description:
+     Puts the search match color on the occurrences in a line.
+     PreparePageMatches() should have been called for the page.
+*/
+void ApplyPageMatches(int nLine, const TSearchContext *pstSearchContext,
+  struct SynHInterf *pSynhInterf, void *pMatchCache)
+{
+  TPageMatchCache *pCache;
+  TPageMatchLine *pSlot;
+  int i;
+
+  pCache = pMatchCache;
+  if (pCache == NULL || pCache->pFile == NULL)
+    return;
+
+  pSlot = &pCache->Lines[nLine % MAX_PAGE_MATCH_LINES];
+  if (pSlot->nLine != nLine ||
+    pSlot->nEditVersion != pCache->pFile->nEditVersion)
+    ScanLineMatches(pCache, nLine, pstSearchContext, pSlot);
+
+  for (i = 0; i < pSlot->nNumMatches; ++i)
+    pSynhInterf->pfnPutAttr(COLOR_SEARCHMATCH,
+      pSlot->Matches[i].nStart, pSlot->Matches[i].nEnd, pSynhInterf);
+}
+
+/* ************************************************************************
+   Function: DisposePageMatches
+   Description:
+     Frees the match cache of a file view.
+*/
+void DisposePageMatches(void **ppMatchCache)
+{
+  ASSERT(ppMatchCache != NULL);
+
+  if (*ppMatchCache != NULL)
+    s_free(*ppMatchCache);
+  *ppMatchCache = NULL;
+}
+
 /* ************************************************************************
    Function: ExtractComponent
    Description:
@@ -77,6 +77,7 @@ typedef struct SearchContext
   char *psRegExprError;  /* Error message returned by the regular expression compiler */
   int nErrorOffset;  /* in sSearch[] */
   char nError;  /* only by Search, not by RegExprSearch() */
+  int nGeneration;  /* changes each time NewSearch() sets a pattern */
 } TSearchContext;
 
 #ifdef _DEBUG
@@ -99,6 +100,13 @@ void _CmdIncrementalSearch(TFile *pFile, int nDir, int nWidth,
 BOOLEAN Find(TFile *pFile, int nDir, int nWidth, TSearchContext *pstSearchContext);
 BOOLEAN Replace(TSearchContext *pstSearchCtx, TFile *pFile);
 
+struct SynHInterf;
+void PreparePageMatches(const TFile *pFile, int nTopLine, int nWinHeight,
+  const TSearchContext *pstSearchContext, void **ppMatchCache);
+void ApplyPageMatches(int nLine, const TSearchContext *pstSearchContext,
+  struct SynHInterf *pSynhInterf, void *pMatchCache);
+void DisposePageMatches(void **ppMatchCache);
+
 const char *ExtractComponent(const char *psPos, char *psDest, BOOLEAN *pbQuoted);
 int ParseSearchPattern(const char *sPattern, TSearchContext *pCtx);
 
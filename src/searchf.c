@@ -10,8 +10,10 @@ Descrition:
 */
 
 #include "global.h"
+#include <time.h>
 #include "disp.h"
 #include "l1def.h"
+#include "l1opt.h"
 #include "palette.h"
 #include "l2disp.h"
 #include "file.h"
@@ -24,7 +26,11 @@ Descrition:
 #include "wrkspace.h"
 #include "memory.h"
 #include "filenav.h"
+#include "ini.h"
+#include "dirwalk.h"
 #include "searchf.h"
+#include "trigram.h"
+#include "searchw.h"
 
 TBookmarksSet *pstFindInFiles;  /* Could be stFindInFiles1 or stFindInFiles2 */
 static char sDirectories[_MAX_PATH];  /* Comma separated directories and +files */
@@ -34,25 +40,56 @@ static BOOLEAN bRecursive;
 static BOOLEAN bIgnoreCase;
 static BOOLEAN bWindow2;
 static BOOLEAN bRegularExpr;
+static BOOLEAN bUseIndex;
 static TSearchContext stSearchContextFiles;
+static TFindFilesPool *pFindFilesPool;  /* search in progress in background */
+static time_t nSearchStartTime;
+static char sSearchProgress[80];  /* end-of-file message of pstFindInFiles */
+
+/*
+The files of a background search with bookmarks in pstFindInFiles, in
+the order of the command line components and then by file name. Every
+file holds a range of the pNext list, the workers complete the files in
+any order and every range is put in its place, after pstHeadMark.
+*/
+typedef struct FileHits
+{
+  int nRoot;
+  char *psFileName;
+  TMarkLocation *pFirst;
+  TMarkLocation *pLast;
+} TFileHits;
+
+static TArray(TFileHits) pFileHits;
+static TMarkLocation *pstHeadMark;  /* The last of the messages before the files */
 
 /* ************************************************************************
-   Function: DisplayOutput
+   Function: DisplayOutputPrim
    Description:
-     This function is called whenever new entry is added to pstFindInFiles.
-     Calls DisplayBookmarksFunc() and then updates the Viewer on
-     the screen.
+     Calls DisplayBookmarksFunc() for a new entry of pstFindInFiles
+     without updating the screen.
 */
-static BOOLEAN DisplayOutput(TMarkLocation *pMark, int nRow)
+static BOOLEAN DisplayOutputPrim(TMarkLocation *pMark, int nRow)
 {
   TDisplayBookmCtx stCtx;
-  disp_event_t ev;
 
   stCtx.pThisSet = pstFindInFiles;
   stCtx.nPreferredLine = 0;
   if (!DisplayBookmarksFunc(pMark, nRow, &stCtx))
     return FALSE;
   pstFindInFiles->bViewDirty = FALSE;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: UpdateOutput
+   Description:
+     Updates the Viewer of pstFindInFiles on the screen.
+*/
+static void UpdateOutput(void)
+{
+  disp_event_t ev;
+
   BookmarksInvalidate(pstFindInFiles);
 
   disp_event_clear(&ev);
@@ -60,6 +97,20 @@ static BOOLEAN DisplayOutput(TMarkLocation *pMark, int nRow)
   ev.t.user_msg_code = MSG_UPDATE_SCR;
   ev.data1 = 0;  /* TODO: wrkspace here! */
   ContainerHandleEvent(pstFindInFiles->stView.pContainer, &ev);
+}
+
+/* ************************************************************************
+   Function: DisplayOutput
+   Description:
+     This function is called whenever new entry is added to pstFindInFiles.
+     Calls DisplayBookmarksFunc() and then updates the Viewer on
+     the screen.
+*/
+static BOOLEAN DisplayOutput(TMarkLocation *pMark, int nRow)
+{
+  if (!DisplayOutputPrim(pMark, nRow))
+    return FALSE;
+  UpdateOutput();
   return TRUE;
 }
 
@@ -106,17 +157,23 @@ BOOLEAN MatchFile(const char *psFile, const char *psMasks)
    Description:
      For all the files in sPath calls pfnProcessFile().
      sPath is in format dir\*mask1;*mask2;*mask3
+     The directories of the version control systems, the entries
+     excluded by the ignore files and the binary files are skipped.
 */
 static BOOLEAN Global(dispc_t *disp, const char *sPath,
   BOOLEAN (*pfnProcessFile)(dispc_t *disp, const char *psFile), int nLevel,
-  BOOLEAN (*pfnShowDir)(dispc_t *disp, const char *psDir))
+  BOOLEAN (*pfnShowDir)(dispc_t *disp, const char *psDir),
+  const TDirIgnore *pParentIgnore)
 {
   char sPathOnly[_MAX_PATH];
   char sMasks[_MAX_PATH];  /* All the masks separated by ";" */
-  char sReadDirMask[_MAX_PATH];
   char sBuf[_MAX_PATH];
-  struct FF_DAT *ff_dat;
-  struct findfilestruct ff;
+  TDirWalk *pWalk;
+  TDirIgnore *pIgnore;
+  const TDirIgnore *pDirIgnore;
+  const char *psName;
+  BOOLEAN bDir;
+  BOOLEAN bResult;
 
   ASSERT(sPath != NULL);
   ASSERT(pfnProcessFile != NULL);
@@ -128,57 +185,70 @@ static BOOLEAN Global(dispc_t *disp, const char *sPath,
   if (!FSplit(sPath, sPathOnly, sMasks, sDirMask, TRUE, FALSE))
     return FALSE;
 
-  /*
-  Read the directories first
-  */
-  strcpy(sReadDirMask, sPathOnly);
   if (pfnShowDir != NULL)
-    if (!pfnShowDir(disp, sReadDirMask))
+    if (!pfnShowDir(disp, sPathOnly))
       return FALSE;
-  strcat(sReadDirMask, sAllMask);  /* "*.*" */
 
-  ff_dat = find_open(sReadDirMask, FFIND_DIRS);
-  if (ff_dat == NULL)
+  /*
+  Read the directories first
+  */
+  pWalk = DirWalkOpen(sPathOnly);
+  if (pWalk == NULL)
     return TRUE;
+  pIgnore = DirWalkLoadIgnore(pWalk, pParentIgnore);
+  pDirIgnore = pIgnore != NULL ? pIgnore : pParentIgnore;
 
-  while (find_file(ff_dat, &ff) == 0)
+  bResult = TRUE;
+  while (bResult && bRecursive && DirWalkNext(pWalk, &psName, &bDir))
   {
-    if (strcmp(ff.filename, ".") == 0)
-      continue;  /* Skip "." directory */
-    if (strcmp(ff.filename, "..") == 0)
-      continue;  /* Skip "." directory */
-
+    if (!bDir)
+      continue;
+    if (strlen(sPathOnly) + strlen(psName) + strlen(sMasks) + 2 > _MAX_PATH)
+      continue;
     strcpy(sBuf, sPathOnly);
-    strcat(sBuf, ff.filename);  /* Full path for this entry */
+    strcat(sBuf, psName);  /* Full path for this entry */
+    if (DirIgnoreMatch(pDirIgnore, sBuf, TRUE))
+      continue;
     AddTrailingSlash(sBuf);
     strcat(sBuf, sMasks);
-    if (bRecursive)
-      if (!Global(disp, sBuf, pfnProcessFile, nLevel + 1, pfnShowDir))
-        return FALSE;
+    bResult = Global(disp, sBuf, pfnProcessFile, nLevel + 1, pfnShowDir,
+      pDirIgnore);
   }
 
-  find_close(ff_dat);
+  DirWalkClose(pWalk);
+  if (!bResult)
+    goto _exit;
 
-  ff_dat = find_open(sReadDirMask, FFIND_FILES);
-  if (ff_dat == NULL)
-    return TRUE;
+  pWalk = DirWalkOpen(sPathOnly);
+  if (pWalk == NULL)
+    goto _exit;
 
-  while (find_file(ff_dat, &ff) == 0)
+  while (DirWalkNext(pWalk, &psName, &bDir))
   {
-    if (!MatchFile(ff.filename, sMasks))
+    if (bDir)
+      continue;
+    if (!MatchFile(psName, sMasks))
+      continue;
+    if (strlen(sPathOnly) + strlen(psName) + 1 > _MAX_PATH)
       continue;
     strcpy(sBuf, sPathOnly);
-    strcat(sBuf, ff.filename);
+    strcat(sBuf, psName);
+    if (DirIgnoreMatch(pDirIgnore, sBuf, FALSE))
+      continue;
+    if (IsBinaryFile(sBuf))
+      continue;
     if (!(pfnProcessFile(disp, sBuf)))
     {
       /* ESC has been pressed to cancel */
-      find_close(ff_dat);
-      return FALSE;
+      bResult = FALSE;
+      break;
     }
   }
 
-  find_close(ff_dat);
-  return TRUE;
+  DirWalkClose(pWalk);
+_exit:
+  DirIgnoreDispose(pIgnore);
+  return bResult;
 }
 
 static TMarkLocation *pstPrevMark;
@@ -201,6 +271,30 @@ static BOOLEAN GetAFile(TFile *pFile, void *pContext)
   return TRUE;
 }
 
+/* ************************************************************************
+   Function: ReportFileError
+   Description:
+     Adds a message about a file that can not be searched.
+*/
+static void ReportFileError(const char *psFileName, const char *psMsg)
+{
+  TMarkLocation *pstMark;
+  char sErrorMsg[_MAX_PATH * 2];
+  char sShortPath[_MAX_PATH];
+
+  strcpy(sErrorMsg, psMsg);
+  ShrinkPath(psFileName, sShortPath, 0, TRUE);
+  strcat(sErrorMsg, sShortPath);
+  BMListInsert(NULL, 1, 0, -1, sErrorMsg, NULL, 0,
+    pstFindInFiles, &pstMark, BOOKM_STATIC);
+  DisplayOutput(pstMark, 0);
+  if (pstPrevMark != NULL)
+  {
+    pstPrevMark->pNext = pstMark;
+  }
+  pstPrevMark = pstMark;
+}
+
 /* ************************************************************************
    Function: ProcessFile
    Description:
@@ -211,8 +305,6 @@ static BOOLEAN ProcessFile(dispc_t *disp, const char *psFile)
 {
   TMarkLocation *pstMark;
   char *psContent;
-  char sErrorMsg[_MAX_PATH];
-  char sShortPath[_MAX_PATH];
   TFile File;
   BOOLEAN bLoad;
   int nOldCol;
@@ -244,25 +336,14 @@ static BOOLEAN ProcessFile(dispc_t *disp, const char *psFile)
       case 2:  /* File doesn't exists */
         goto _dispose;
       case 3:  /* No memory */
-        strcpy(sErrorMsg, sNoMemoryForFile);
-_err_msg:
-        ShrinkPath(File.sFileName, sShortPath, 0, TRUE);
-        strcat(sErrorMsg, sShortPath);
-        BMListInsert(NULL, 1, 0, -1, sErrorMsg, NULL, 0,
-          pstFindInFiles, &pstMark, BOOKM_STATIC);
-        DisplayOutput(pstMark, 0);
-        if (pstPrevMark != NULL)
-        {
-          pstPrevMark->pNext = pstMark;
-        }
-        pstPrevMark = pstMark;
+        ReportFileError(File.sFileName, sNoMemoryForFile);
         goto _dispose;
       case 4:  /* Invalid path */
         /* TODO: generate a message */
         goto _dispose;
       case 5:  /* I/O error */
-        strcpy(sErrorMsg, sUnableToOpen);
-        goto _err_msg;
+        ReportFileError(File.sFileName, sUnableToOpen);
+        goto _dispose;
       default:  /* Invalid LoadFilePrim() output */
         ASSERT(0);
         goto _dispose;
@@ -272,11 +353,11 @@ _err_msg:
     bLoad = TRUE;
   }
 
+  disp_wnd_get_param(disp, &wnd_param);
   while (1)
   {
     nOldCol = _pFile->nCol;
     nOldRow = _pFile->nRow;
-    disp_wnd_get_param(disp, &wnd_param);
     if (!Find(_pFile, 1, wnd_param.width, &stSearchContextFiles))
       break;
 
@@ -309,6 +390,296 @@ _dispose:
   return TRUE;
 }
 
+/* ************************************************************************
+   Function: InsertFileHits
+   Description:
+     Generates bookmarks for the occurrences that the workers have
+     found in a file. A file that is loaded in the editor is searched
+     again in memory as its text may differ from the text on the disk.
+*/
+static void InsertFileHits(dispc_t *disp, const TFindFilesResult *pResult)
+{
+  const TFindFilesHit *pHit;
+  TMarkLocation *pstMark;
+  int i;
+
+  if (pResult->bMaybeInMemory)
+  {
+    if (SearchFileList(pFilesInMemoryList, pResult->psFileName, 0) != -1)
+    {
+      ProcessFile(disp, pResult->psFileName);
+      return;
+    }
+  }
+
+  switch (pResult->nError)
+  {
+    case 0:
+      break;
+    case 3:  /* No memory */
+      ReportFileError(pResult->psFileName, sNoMemoryForFile);
+      return;
+    default:  /* I/O error */
+      ReportFileError(pResult->psFileName, sUnableToOpen);
+      return;
+  }
+
+  pstMark = NULL;
+  for (i = 0; i < pResult->nNumHits; ++i)
+  {
+    pHit = &pResult->pHits[i];
+    BMListInsert(pResult->psFileName, pHit->nLine,
+      LineGetTabPos(pHit->psContent, pHit->nPos), -1,
+      pHit->psContent, NULL, 0, pstFindInFiles, &pstMark, BOOKM_STATIC);
+    DisplayOutputPrim(pstMark, pHit->nLine);
+    if (pstPrevMark != NULL)
+    {
+      pstPrevMark->pNext = pstMark;
+    }
+    pstPrevMark = pstMark;
+  }
+}
+
+/* ************************************************************************
+   Function: FindFileHitsPos
+   Description:
+     Finds where the range of a file goes in pFileHits, the same order
+     as by FindFilesPoolTakeResults().
+*/
+static int FindFileHitsPos(int nRoot, const char *psFileName)
+{
+  int nLow;
+  int nHigh;
+  int nMid;
+  int nCmp;
+
+  nLow = 0;
+  nHigh = pFileHits != NULL ? _TArrayCount(pFileHits) : 0;
+  while (nLow < nHigh)
+  {
+    nMid = (nLow + nHigh) / 2;
+    nCmp = nRoot - pFileHits[nMid].nRoot;
+    if (nCmp == 0)
+      nCmp = filestrcmp(psFileName, pFileHits[nMid].psFileName);
+    if (nCmp < 0)
+      nHigh = nMid;
+    else
+      nLow = nMid + 1;
+  }
+  return nLow;
+}
+
+/* ************************************************************************
+   Function: InsertFileHitsSorted
+   Description:
+     Generates the bookmarks of a file completed by the workers and puts
+     them in the place of the file among the files already in the list.
+   Returns:
+     FALSE -- the bookmarks were put before some of the rows already on
+     the screen, the Viewer is to be rendered again.
+*/
+static BOOLEAN InsertFileHitsSorted(dispc_t *disp, const TFindFilesResult *pResult)
+{
+  TMarkLocation stHead;
+  TMarkLocation *pstPrev;
+  TFileHits stFileHits;
+  BOOLEAN bAtEnd;
+  int nPos;
+
+  /* Collect the new bookmarks in a list of their own */
+  pstPrev = pstPrevMark;
+  stHead.pNext = NULL;
+  pstPrevMark = &stHead;
+  InsertFileHits(disp, pResult);
+  stFileHits.pFirst = stHead.pNext;
+  stFileHits.pLast = pstPrevMark;
+  pstPrevMark = pstPrev;
+  if (stFileHits.pFirst == NULL)
+    return TRUE;  /* Nothing found in this file */
+
+  /* Link the list after the files that go before this one */
+  nPos = FindFileHitsPos(pResult->nRoot, pResult->psFileName);
+  bAtEnd = pFileHits == NULL || nPos == _TArrayCount(pFileHits);
+  if (bAtEnd)
+    pstPrev = pstPrevMark;
+  else if (nPos == 0)
+    pstPrev = pstHeadMark;
+  else
+    pstPrev = pFileHits[nPos - 1].pLast;
+  if (pstPrev != NULL)
+  {
+    stFileHits.pLast->pNext = pstPrev->pNext;
+    pstPrev->pNext = stFileHits.pFirst;
+  }
+  if (bAtEnd)
+    pstPrevMark = stFileHits.pLast;
+
+  /* Without memory the file stays in the list but is not in pFileHits */
+  stFileHits.nRoot = pResult->nRoot;
+  if (pFileHits == NULL)
+    return bAtEnd;
+  stFileHits.psFileName = alloc(strlen(pResult->psFileName) + 1);
+  if (stFileHits.psFileName != NULL)
+  {
+    strcpy(stFileHits.psFileName, pResult->psFileName);
+    TArrayInsert(pFileHits, nPos, stFileHits);
+    if (!TArrayStatus(pFileHits))
+    {
+      TArrayClearStatus(pFileHits);
+      s_free(stFileHits.psFileName);
+    }
+  }
+  return bAtEnd;
+}
+
+/* ************************************************************************
+   Function: InsertResults
+   Description:
+     Generates bookmarks for the files completed by the workers since
+     the last call. The files are put in order among the files already
+     in the list. The screen is updated once for the entire batch.
+   Returns:
+     TRUE -- the workers have quit, these are the last results.
+*/
+static BOOLEAN InsertResults(dispc_t *disp)
+{
+  TFindFilesResult **pResults;
+  int nNumResults;
+  BOOLEAN bDone;
+  BOOLEAN bRender;
+  int nRow;
+  int i;
+
+  pResults = FindFilesPoolTakeResults(pFindFilesPool, &nNumResults, &bDone);
+  bRender = FALSE;
+  for (i = 0; i < nNumResults; ++i)
+    if (!InsertFileHitsSorted(disp, pResults[i]))
+      bRender = TRUE;
+  FindFilesPoolDisposeResults(pResults, nNumResults);
+  if (bRender)
+  {
+    /* The rows are not at the end, render the list again */
+    nRow = pstFindInFiles->Viewer.nRow;
+    pstFindInFiles->bViewDirty = TRUE;
+    RenderBookmarks(pstFindInFiles);
+    GotoColRow(&pstFindInFiles->Viewer, 0, nRow);
+  }
+  if (nNumResults > 0)
+    UpdateOutput();
+  return bDone;
+}
+
+/* ************************************************************************
+   Function: ShowProgress
+   Description:
+     Displays the progress of the search in the place of the
+     "no more messages" line of pstFindInFiles.
+*/
+static void ShowProgress(void)
+{
+  int nNumFiles;
+  long nNumBytes;
+  long nSeconds;
+
+  FindFilesPoolGetProgress(pFindFilesPool, &nNumFiles, &nNumBytes);
+  nSeconds = (long)(time(NULL) - nSearchStartTime);
+  if (nSeconds < 1)
+    nSeconds = 1;
+  sprintf(sSearchProgress, "%s %d files, %ld KB/s (Esc to cancel)",
+    sSearchInProgress, nNumFiles, nNumBytes / 1024 / nSeconds);
+  BMSetNewMsg(pstFindInFiles, sSearchProgress);
+  UpdateOutput();
+}
+
+/* ************************************************************************
+   Function: DoneFindInFiles
+   Description:
+     Disposes the search in progress, the workers must have quit.
+*/
+static void DoneFindInFiles(dispc_t *disp, BOOLEAN bCanceled)
+{
+  TMarkLocation *pstMark;
+  int i;
+
+  if (bCanceled)
+  {
+    /* here the row is 1, to maintain the sorted order of the messages
+    as we need the sText message to be before "Canceled" */
+    BMListInsert(NULL, 1, 0, -1, sCanceled, NULL, 0,
+      pstFindInFiles, &pstMark, BOOKM_STATIC);
+    DisplayOutputPrim(pstMark, 0);
+    if (pstPrevMark != NULL)
+    {
+      pstPrevMark->pNext = pstMark;
+    }
+    pstPrevMark = pstMark;
+  }
+
+  FindFilesPoolDispose(pFindFilesPool);
+  pFindFilesPool = NULL;
+  if (pFileHits != NULL)
+  {
+    for (i = 0; i < _TArrayCount(pFileHits); ++i)
+      s_free(pFileHits[i].psFileName);
+    TArrayDispose(pFileHits);
+  }
+  disp_set_tick(disp, 0);
+  BMSetNewMsg(pstFindInFiles, NULL);
+  DoneSearchContext(&stSearchContextFiles);
+  UpdateOutput();
+}
+
+/* ************************************************************************
+   Function: FindInFilesPoll
+   Description:
+     Called on EVENT_TIMER_TICK while a Find in Files is in progress.
+     Appends the newly found occurrences and shows the progress.
+*/
+void FindInFilesPoll(dispc_t *disp)
+{
+  if (pFindFilesPool == NULL)
+    return;
+
+  if (InsertResults(disp))
+  {
+    DoneFindInFiles(disp, FALSE);
+    return;
+  }
+  ShowProgress();
+}
+
+/* ************************************************************************
+   Function: FindInFilesCancel
+   Description:
+     Stops the Find in Files in progress. The occurrences found so far
+     remain in the list.
+   Returns:
+     FALSE -- there was no search in progress.
+*/
+BOOLEAN FindInFilesCancel(dispc_t *disp)
+{
+  if (pFindFilesPool == NULL)
+    return FALSE;
+
+  FindFilesPoolCancel(pFindFilesPool);
+  FindFilesPoolWait(pFindFilesPool);
+  InsertResults(disp);
+  DoneFindInFiles(disp, TRUE);
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: AddInMemoryName
+   Description:
+     A call-back function for FileListForEach(), passes the name of
+     a file in memory to the pool.
+*/
+static BOOLEAN AddInMemoryName(TFile *pFile, void *pContext)
+{
+  FindFilesPoolAddInMemory(pContext, pFile->sFileName);
+  return TRUE;
+}
+
 /* ************************************************************************
    Function: SeparateComponents
    Description:
@@ -318,6 +689,7 @@ _dispose:
      -i - ignore case
      -r - regular expression
      -2 - put results in FindInFiles2
+     -x - use (and update) a trigram index of the directories
 */
 static void SeparateComponents(const char *sText)
 {
@@ -339,6 +711,7 @@ static void SeparateComponents(const char *sText)
   bIgnoreCase = TRUE;
   bWindow2 = FALSE;
   bRegularExpr = FALSE;
+  bUseIndex = FALSE;
   sDirectories[0] = '\0';
   sMasks[0] = '\0';
   sPattern[0] = '\0';
@@ -387,7 +760,15 @@ static void SeparateComponents(const char *sText)
                     bRegularExpr = FALSE;
                 }
                 else
-                  ;  /* TODO: error */
+                  if (strncmp(p, "-x", 2) == 0)
+                  {
+                    if (*(p + 2) == '\0' || *(p + 2) == '+')
+                      bUseIndex = TRUE;
+                    else
+                      bUseIndex = FALSE;
+                  }
+                  else
+                    ;  /* TODO: error */
         goto _next_token;
       }  /* end of check for option character */
     }  /* end of not quoted */
@@ -497,15 +878,22 @@ void FindInFiles(dispc_t *disp, const char *sText, int *pnWindow)
   char *p;
   char sBuf[_MAX_PATH];
   char sADir[_MAX_PATH];
+  char sPathOnly[_MAX_PATH];
+  char sMaskOnly[_MAX_PATH];
+  char sIndexFile[_MAX_PATH];
   TMarkLocation *pstMark;
   BOOLEAN bMaskSpecified;
   BOOLEAN bFilesOnly;
   disp_event_t ev;
+  TFindFilesPool *pPool;
+  int nRoot;
 
   ASSERT(sText != NULL);
   ASSERT(pnWindow != NULL);
 
+  FindInFilesCancel(disp);  /* only one search at a time */
   InitSearchContext(&stSearchContextFiles);
+  pPool = NULL;
 #ifdef WIN32
   /* we need to temporarily gear the priority down to normal
   as this blocks the computer for long periods of time */
@@ -618,16 +1006,33 @@ void FindInFiles(dispc_t *disp, const char *sText, int *pnWindow)
       strcat(sBuf, ",.");
     p = strtok(sBuf, ",");
   }
+
+  /*
+  Single line patterns are searched by the worker threads
+  directly in the files on the disk
+  */
+  if (stSearchContextFiles.nNumLines == 0)
+    pPool = FindFilesPoolCreate(&stSearchContextFiles, bRecursive);
+  if (pPool != NULL)
+    FileListForEach(pFilesInMemoryList, AddInMemoryName, FALSE, pPool);
+
+  nRoot = 0;
   while (1)
   {
     if (p == NULL)
       break;
     strcpy(sADir, p);
+    ++nRoot;
     if (sADir[0] == '+')
     {
       /* this is a file */
       if (!bRecursive)  /* the file was moved in sMasks */
-        ProcessFile(disp, &sADir[1]);
+      {
+        if (pPool != NULL)
+          FindFilesPoolAddFile(pPool, &sADir[1], nRoot);
+        else
+          ProcessFile(disp, &sADir[1]);
+      }
       goto _next_token;
     }
     if (!HasWild(sADir))
@@ -635,7 +1040,22 @@ void FindInFiles(dispc_t *disp, const char *sText, int *pnWindow)
       AddTrailingSlash(sADir);
       strcat(sADir, sMasks);
     }
-    if (!Global(disp, sADir, ProcessFile, 0, ShowDir))
+    if (pPool != NULL)
+    {
+      if (FSplit(sADir, sPathOnly, sMaskOnly, sDirMask, TRUE, FALSE))
+      {
+        ShowDir(disp, sPathOnly);
+        if (bUseIndex)
+        {
+          TrigramIndexFileName(sINIFilePath, sPathOnly, sIndexFile);
+          FindFilesPoolAddDir(pPool, sPathOnly, sMaskOnly, sIndexFile, nRoot);
+        }
+        else
+          FindFilesPoolAddDir(pPool, sPathOnly, sMaskOnly, NULL, nRoot);
+      }
+      goto _next_token;
+    }
+    if (!Global(disp, sADir, ProcessFile, 0, ShowDir, NULL))
     {
       /* here the row is 1, to maintain the sorted order of the messages
       as we need the sText message to be before "Canceled" */
@@ -651,6 +1071,22 @@ void FindInFiles(dispc_t *disp, const char *sText, int *pnWindow)
 _next_token:
     p = strtok(NULL, ",");
   }
+
+  if (pPool != NULL)
+  {
+    /*
+    The workers continue in background, FindInFilesPoll() appends
+    the results and completes the search
+    */
+    pFindFilesPool = pPool;
+    pstHeadMark = pstPrevMark;
+    TArrayInit(pFileHits, 64, 64);
+    nSearchStartTime = time(NULL);
+    FindFilesPoolStart(pPool);
+    disp_set_tick(disp, 1);
+    FindInFilesPoll(disp);
+    return;
+  }
 _done_search:
   BMSetNewMsg(pstFindInFiles, NULL);
   DoneSearchContext(&stSearchContextFiles);
@@ -748,6 +1184,7 @@ void ApplyFuncBookmarksColors(const TFile *pFile, int bNewPage, int nLine,
     pCtx->pReserved2 =
       BMSetFindFirstBookmark(pBMSetFuncNames, NULL, 0, nLine, pBMFindCtx, &nRow);
     pCtx->nReserved1 = nLine;
+    pCtx->nMarksVersion = pBMSetFuncNames->nVersion;
     return;
   }
 
@@ -947,12 +1384,11 @@ _exit:
 }
 
 /* ************************************************************************
-   Function: ApplyFuncColors
+   Function: ApplyFuncNamesColors
    Description:
-     To be used within TExtraColorInterf to highlight function names
-     when displaying a page in the editor
+     Highlights function names when displaying a page in the editor
 */
-void ApplyFuncColors(const TFile *pFile, int bNewPage, int nLine,
+static void ApplyFuncNamesColors(const TFile *pFile, int bNewPage, int nLine,
   int nTopLine, int nWinHeight,
   TSynHInterf *pSynhInterf, struct ExtraColorInterf *pCtx)
 {
@@ -992,6 +1428,8 @@ void ApplyFuncColors(const TFile *pFile, int bNewPage, int nLine,
     pCtx->nReserved1 = nRow;
     if (pCtx->pReserved2 == NULL)
       pCtx->nReserved1 = -1;
+    /* Both only grow, the sum changes whenever any of them does */
+    pCtx->nMarksVersion = pBMSetFuncNames->nVersion + stUserBookmarks.nVersion;
     return;
   }
 
@@ -1043,6 +1481,33 @@ _next_bookmark:
   goto _next_bookmark;
 }
 
+/* ************************************************************************
+   Function: ApplyFuncColors
+   Description:
+     To be used within TExtraColorInterf to highlight function names
+     and the matches of the last search pattern
+     when displaying a page in the editor
+*/
+void ApplyFuncColors(const TFile *pFile, int bNewPage, int nLine,
+  int nTopLine, int nWinHeight,
+  TSynHInterf *pSynhInterf, struct ExtraColorInterf *pCtx)
+{
+  ApplyFuncNamesColors(pFile, bNewPage, nLine, nTopLine, nWinHeight,
+    pSynhInterf, pCtx);
+
+  if (!bHighlightSearchMatches || stSearchContext.sSearch[0] == '\0')
+    return;
+
+  if (bNewPage)
+  {
+    PreparePageMatches(pFile, nTopLine, nWinHeight,
+      &stSearchContext, &pCtx->pMatchCache);
+    return;
+  }
+
+  ApplyPageMatches(nLine, &stSearchContext, pSynhInterf, pCtx->pMatchCache);
+}
+
 /*
 This software is distributed under the conditions of the BSD style license.
 
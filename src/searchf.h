@@ -13,6 +13,8 @@ Descrition:
 #define SEARCHF_H
 
 void FindInFiles(dispc_t *disp, const char *sText, int *pnWindow);
+void FindInFilesPoll(dispc_t *disp);
+BOOLEAN FindInFilesCancel(dispc_t *disp);
 void PrepareFunctionNamesBookmarks(TFile *pFile);
 void ApplyFuncBookmarksColors(const TFile *pFile, int bNewPage, int nLine,
   int nTopLine, int nWinHeight,
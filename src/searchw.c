@@ -0,0 +1,1045 @@
+/*
+
+File: searchw.c
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Worker threads that walk directories and search files for
+  Find in Files.
+
+  The directories and the files to be searched are jobs in a single
+  queue. A worker that takes a directory job lists the directory and
+  queues a job for every subdirectory and for every file that matches
+  the masks. A worker that takes a file job reads the file in a buffer,
+  splits it into lines the way LoadFilePrim() does and collects
+  the occurrences of the pattern, no TFile is built.
+
+  The workers must not touch any editor data. The memory is taken
+  directly from malloc()/free() as the debug heap (heapg.c) is not
+  thread safe. The caller takes the results with FindFilesPoolTakeResults()
+  while the workers are still running and converts them to bookmarks.
+  FindFilesPoolCancel() makes the workers drop the jobs that are still
+  in the queue.
+
+  The directories are read by dirwalk.c: the directories of the
+  version control systems and the entries excluded by the ignore files
+  are skipped. The files found by walking a directory are checked for
+  binary contents before they are searched, the files given explicitly
+  are always searched. The rules of the ignore files are kept in the pool
+  until FindFilesPoolDispose() as the jobs of the subdirectories refer
+  to them.
+
+  A directory with a trigram index (trigram.c) is walked by a single
+  worker that updates the index and queues only the files that may
+  contain the pattern.
+
+  On platforms without threads the jobs are processed by the thread
+  that calls FindFilesPoolStart().
+
+*/
+
+#include "global.h"
+#include "wlimits.h"
+#include "file.h"
+#include "l1def.h"
+#include "path.h"
+#include "dirwalk.h"
+#include "search.h"
+#include "trigram.h"
+#include "searchw.h"
+
+#ifdef UNIX
+#include <pthread.h>
+#include <unistd.h>
+#define FINDFILES_THREADS
+#endif
+
+#define STATIC
+#include "pcre.h"  /* Perl regular expressions library */
+#undef STATIC
+
+extern BOOLEAN MatchFile(const char *psFile, const char *psMasks);
+
+typedef struct FindFilesJob
+{
+  struct FindFilesJob *pNext;
+  int nRoot;
+  int nLevel;
+  BOOLEAN bDir;
+  BOOLEAN bSkipBinary;  /* for files found by walking a directory */
+  const char *psMasks;  /* for directories, points in TFindFilesPool */
+  const TDirIgnore *pIgnore;  /* rules of the ignore files, or NULL */
+  const char *psIndexFile;  /* trigram index of the directory, or NULL */
+  char sPath[1];  /* the rest of the path is allocated past the structure */
+} TFindFilesJob;
+
+typedef struct FindFilesName
+{
+  struct FindFilesName *pNext;
+  char sName[1];
+} TFindFilesName;
+
+typedef struct FindFilesIgnore
+{
+  struct FindFilesIgnore *pNext;
+  TDirIgnore *pIgnore;
+} TFindFilesIgnore;
+
+struct FindFilesPool
+{
+  const TSearchContext *pstSearchContext;
+  BOOLEAN bRecursive;
+  char sPattern[MAX_SEARCH_STR];  /* lower case if !bCaseSensitive */
+  int nPatternLen;
+  TTrigramQuery stQuery;  /* for the directories with an index */
+
+  TFindFilesName *pInMemory;  /* names (no path) of the files in memory */
+  TFindFilesName *pMasks;  /* storage for the masks of the directory jobs */
+  TFindFilesIgnore *pIgnores;  /* the ignore files of the walked directories */
+
+  TFindFilesJob *pFirstJob;
+  TFindFilesJob *pLastJob;
+  int nBusy;  /* number of workers processing a job */
+  int nRunning;  /* number of workers that haven't quit yet */
+  BOOLEAN bCanceled;
+
+  TFindFilesResult **pResults;  /* not yet taken by the caller */
+  int nNumResults;
+  int nMaxResults;
+
+  int nNumFiles;  /* files searched so far */
+  long nNumBytes;  /* bytes read so far */
+
+  int nNumThreads;
+  #ifdef FINDFILES_THREADS
+  pthread_t Threads[MAX_FINDFILES_THREADS];
+  pthread_mutex_t Lock;
+  pthread_cond_t JobsReady;
+  #endif
+};
+
+#ifdef FINDFILES_THREADS
+#define LOCK_POOL(pPool)  pthread_mutex_lock(&(pPool)->Lock)
+#define UNLOCK_POOL(pPool)  pthread_mutex_unlock(&(pPool)->Lock)
+#else
+#define LOCK_POOL(pPool)
+#define UNLOCK_POOL(pPool)
+#endif
+
+/* ************************************************************************
+   Function: FindFilesPoolCreate
+   Description:
+     Prepares a pool to search for the pattern of pstSearchContext.
+     The search context should remain unchanged until
+     FindFilesPoolDispose().
+   Returns:
+     NULL -- no memory.
+*/
+TFindFilesPool *FindFilesPoolCreate(const TSearchContext *pstSearchContext,
+  BOOLEAN bRecursive)
+{
+  TFindFilesPool *pPool;
+
+  ASSERT(VALID_PSEARCHCTX(pstSearchContext));
+  ASSERT(pstSearchContext->nNumLines == 0);
+
+  pPool = malloc(sizeof(TFindFilesPool));
+  if (pPool == NULL)
+    return NULL;
+  memset(pPool, 0, sizeof(TFindFilesPool));
+
+  pPool->pstSearchContext = pstSearchContext;
+  pPool->bRecursive = bRecursive;
+  strcpy(pPool->sPattern, pstSearchContext->sSearch);
+  if (!pstSearchContext->bCaseSensitive)
+    strlwr(pPool->sPattern);
+  pPool->nPatternLen = strlen(pPool->sPattern);
+  TrigramQueryPrepare(&pPool->stQuery, pstSearchContext->sSearch,
+    pstSearchContext->bRegularExpr);
+
+  #ifdef FINDFILES_THREADS
+  pthread_mutex_init(&pPool->Lock, NULL);
+  pthread_cond_init(&pPool->JobsReady, NULL);
+  #endif
+
+  return pPool;
+}
+
+/* ************************************************************************
+   Function: AddName
+   Description:
+     Adds a string in a list of names.
+*/
+static const char *AddName(TFindFilesName **ppList, const char *psName)
+{
+  TFindFilesName *pName;
+
+  pName = malloc(sizeof(TFindFilesName) + strlen(psName));
+  if (pName == NULL)
+    return NULL;
+  strcpy(pName->sName, psName);
+  pName->pNext = *ppList;
+  *ppList = pName;
+  return pName->sName;
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolAddInMemory
+   Description:
+     Registers the name of a file loaded in the editor. The results
+     for any file with the same name are marked with bMaybeInMemory
+     so that the caller can search the text in memory instead.
+*/
+BOOLEAN FindFilesPoolAddInMemory(TFindFilesPool *pPool, const char *psFileName)
+{
+  const char *psName;
+
+  psName = strrchr(psFileName, PATH_SLASH_CHAR);
+  if (psName == NULL)
+    psName = psFileName;
+  else
+    ++psName;
+  return AddName(&pPool->pInMemory, psName) != NULL;
+}
+
+/* ************************************************************************
+   Function: IsNameInMemory
+   Description:
+*/
+static BOOLEAN IsNameInMemory(const TFindFilesPool *pPool, const char *psPath)
+{
+  const TFindFilesName *pName;
+  const char *psName;
+
+  psName = strrchr(psPath, PATH_SLASH_CHAR);
+  if (psName == NULL)
+    psName = psPath;
+  else
+    ++psName;
+
+  for (pName = pPool->pInMemory; pName != NULL; pName = pName->pNext)
+    if (filestrcmp(pName->sName, psName) == 0)
+      return TRUE;
+  return FALSE;
+}
+
+/* ************************************************************************
+   Function: QueueJob
+   Description:
+     Appends a job at the end of the queue and wakes up a worker.
+*/
+static BOOLEAN QueueJob(TFindFilesPool *pPool, const char *psPath,
+  const char *psMasks, const char *psIndexFile, const TDirIgnore *pIgnore,
+  int nRoot, int nLevel, BOOLEAN bDir, BOOLEAN bSkipBinary)
+{
+  TFindFilesJob *pJob;
+
+  pJob = malloc(sizeof(TFindFilesJob) + strlen(psPath));
+  if (pJob == NULL)
+    return FALSE;
+  pJob->pNext = NULL;
+  pJob->nRoot = nRoot;
+  pJob->nLevel = nLevel;
+  pJob->bDir = bDir;
+  pJob->bSkipBinary = bSkipBinary;
+  pJob->psMasks = psMasks;
+  pJob->pIgnore = pIgnore;
+  pJob->psIndexFile = psIndexFile;
+  strcpy(pJob->sPath, psPath);
+
+  LOCK_POOL(pPool);
+  if (pPool->pLastJob == NULL)
+    pPool->pFirstJob = pJob;
+  else
+    pPool->pLastJob->pNext = pJob;
+  pPool->pLastJob = pJob;
+  #ifdef FINDFILES_THREADS
+  pthread_cond_signal(&pPool->JobsReady);
+  #endif
+  UNLOCK_POOL(pPool);
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolAddDir
+   Description:
+     Queues a directory to be searched for files matching psMasks
+     (separated by ";"). psDir should end with a slash.
+     psIndexFile is the trigram index of the directory, NULL for
+     no index.
+*/
+BOOLEAN FindFilesPoolAddDir(TFindFilesPool *pPool, const char *psDir,
+  const char *psMasks, const char *psIndexFile, int nRoot)
+{
+  const char *psMasksCopy;
+  const char *psIndexFileCopy;
+
+  psMasksCopy = AddName(&pPool->pMasks, psMasks);
+  if (psMasksCopy == NULL)
+    return FALSE;
+  psIndexFileCopy = NULL;
+  if (psIndexFile != NULL)
+  {
+    psIndexFileCopy = AddName(&pPool->pMasks, psIndexFile);
+    if (psIndexFileCopy == NULL)
+      return FALSE;
+  }
+  return QueueJob(pPool, psDir, psMasksCopy, psIndexFileCopy, NULL,
+    nRoot, 0, TRUE, FALSE);
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolAddFile
+   Description:
+     Queues a single file to be searched.
+*/
+BOOLEAN FindFilesPoolAddFile(TFindFilesPool *pPool, const char *psFile,
+  int nRoot)
+{
+  return QueueJob(pPool, psFile, NULL, NULL, NULL, nRoot, 0, FALSE, FALSE);
+}
+
+/* ************************************************************************
+   Function: AddResult
+   Description:
+     Hands a result of a worker to the pool.
+*/
+static BOOLEAN AddResult(TFindFilesPool *pPool, TFindFilesResult *pResult)
+{
+  TFindFilesResult **pNewResults;
+  int nNewMax;
+  BOOLEAN bResult;
+
+  bResult = TRUE;
+  LOCK_POOL(pPool);
+  if (pPool->nNumResults == pPool->nMaxResults)
+  {
+    nNewMax = pPool->nMaxResults * 2 + 64;
+    pNewResults = realloc(pPool->pResults, nNewMax * sizeof(TFindFilesResult *));
+    if (pNewResults == NULL)
+    {
+      bResult = FALSE;
+      goto _exit;
+    }
+    pPool->pResults = pNewResults;
+    pPool->nMaxResults = nNewMax;
+  }
+  pPool->pResults[pPool->nNumResults++] = pResult;
+_exit:
+  UNLOCK_POOL(pPool);
+  return bResult;
+}
+
+/* ************************************************************************
+   Function: DisposeResult
+   Description:
+*/
+static void DisposeResult(TFindFilesResult *pResult)
+{
+  int i;
+
+  for (i = 0; i < pResult->nNumHits; ++i)
+    free(pResult->pHits[i].psContent);
+  free(pResult->pHits);
+  free(pResult);
+}
+
+/* ************************************************************************
+   Function: AddHit
+   Description:
+     Stores an occurrence in a file result. Keeps a copy of the line.
+*/
+static BOOLEAN AddHit(TFindFilesResult *pResult, int nLine, int nPos,
+  const char *pLine, int nLen)
+{
+  TFindFilesHit *pNewHits;
+  TFindFilesHit *pHit;
+  int nNewMax;
+
+  if (pResult->nNumHits == pResult->nMaxHits)
+  {
+    nNewMax = pResult->nMaxHits * 2 + 8;
+    pNewHits = realloc(pResult->pHits, nNewMax * sizeof(TFindFilesHit));
+    if (pNewHits == NULL)
+      return FALSE;
+    pResult->pHits = pNewHits;
+    pResult->nMaxHits = nNewMax;
+  }
+
+  pHit = &pResult->pHits[pResult->nNumHits];
+  pHit->psContent = malloc(nLen + 1);
+  if (pHit->psContent == NULL)
+    return FALSE;
+  memcpy(pHit->psContent, pLine, nLen);
+  pHit->psContent[nLen] = '\0';
+  pHit->nLine = nLine;
+  pHit->nPos = nPos;
+  ++pResult->nNumHits;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: SearchLine
+   Description:
+     Collects all the occurrences in a line. The positions are the same
+     that consecutive Find() calls would visit: a literal pattern is
+     searched again from the next character, a regular expression
+     from the end of the previous match.
+*/
+static BOOLEAN SearchLine(const TFindFilesPool *pPool, TFindFilesResult *pResult,
+  int nLine, const char *pLine, int nLen)
+{
+  const TSearchContext *pstSearchContext;
+  const char *p;
+  const char *d;
+  int nPos;
+  int nCount;
+  int Offsets[45];
+
+  pstSearchContext = pPool->pstSearchContext;
+
+  if (pstSearchContext->bRegularExpr)
+  {
+    nPos = 0;
+    while (nPos <= nLen)
+    {
+      nCount = pcre_exec(pstSearchContext->pstRegExprData, NULL,
+        pLine, nLen, nPos, 0, Offsets, _countof(Offsets));
+      if (nCount < 0)
+        break;
+      if (!AddHit(pResult, nLine, Offsets[0], pLine, nLen))
+        return FALSE;
+      nPos = Offsets[1];
+      if (Offsets[0] == Offsets[1])  /* position only match */
+        ++nPos;
+    }
+    return TRUE;
+  }
+
+  if (pPool->nPatternLen == 0)
+    return TRUE;
+
+  for (p = pLine; pLine + nLen - p >= pPool->nPatternLen; ++p)
+  {
+    d = pPool->sPattern;
+    nPos = 0;
+    if (pstSearchContext->bCaseSensitive)
+    {
+      while (d[nPos] != '\0' && p[nPos] == d[nPos])
+        ++nPos;
+    }
+    else
+    {
+      while (d[nPos] != '\0' && tolower((BYTE)p[nPos]) == (BYTE)d[nPos])
+        ++nPos;
+    }
+    if (d[nPos] != '\0')
+      continue;
+    if (!AddHit(pResult, nLine, p - pLine, pLine, nLen))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: SearchFile
+   Description:
+     Reads a file and searches all its lines. The end of a line is
+     any of CR, LF, CR/LF or a zero character (as in LoadFilePrim()).
+     With bSkipBinary a binary file is dropped after reading its start.
+*/
+static void SearchFile(TFindFilesPool *pPool, const char *psFile, int nRoot,
+  BOOLEAN bSkipBinary)
+{
+  TFindFilesResult *pResult;
+  FILE *f;
+  char *pBuf;
+  char *p;
+  char *pSentinel;
+  char *pEnd;
+  long nSize;
+  long nRead;
+  int nLine;
+
+  pResult = malloc(sizeof(TFindFilesResult) + strlen(psFile) + 1);
+  if (pResult == NULL)
+    return;
+  memset(pResult, 0, sizeof(TFindFilesResult));
+  pResult->psFileName = (char *)(pResult + 1);
+  strcpy(pResult->psFileName, psFile);
+  pResult->nRoot = nRoot;
+  pResult->bMaybeInMemory = IsNameInMemory(pPool, psFile);
+
+  pBuf = NULL;
+  f = fopen(psFile, READ_BINARY_FILE);
+  if (f == NULL)
+  {
+    if (errno == ENOENT)
+      goto _dispose;  /* file doesn't exist, nothing to report */
+    pResult->nError = 5;
+    goto _add_result;
+  }
+
+  nSize = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    nSize = ftell(f);
+  if (nSize < 0 || fseek(f, 0, SEEK_SET) != 0)
+  {
+    pResult->nError = 5;
+    goto _close;
+  }
+
+  pBuf = malloc(nSize + 1);
+  if (pBuf == NULL)
+  {
+    pResult->nError = 3;
+    goto _close;
+  }
+  nRead = 0;
+  if (bSkipBinary)
+  {
+    nRead = nSize < MAX_BINARY_SNIFF ? nSize : MAX_BINARY_SNIFF;
+    if ((long)fread(pBuf, 1, nRead, f) != nRead)
+    {
+      pResult->nError = 5;
+      goto _close;
+    }
+    if (IsBinaryText(pBuf, nRead))
+    {
+      fclose(f);
+      goto _dispose;
+    }
+  }
+  if ((long)fread(pBuf + nRead, 1, nSize - nRead, f) != nSize - nRead)
+  {
+    pResult->nError = 5;
+    goto _close;
+  }
+  pBuf[nSize] = '\0';
+
+  pEnd = pBuf + nSize;
+  pSentinel = pBuf;
+  nLine = 0;
+  for (p = pBuf; p <= pEnd; ++p)
+  {
+    if (p != pEnd && *p != '\0' && *p != '\r' && *p != '\n')
+      continue;
+    if (p == pEnd && p == pSentinel)
+      break;  /* no characters after the last end-of-line */
+    if (!SearchLine(pPool, pResult, nLine, pSentinel, p - pSentinel))
+    {
+      pResult->nError = 3;
+      break;
+    }
+    if (*p == '\r' && p + 1 != pEnd && *(p + 1) == '\n')
+      ++p;
+    pSentinel = p + 1;
+    ++nLine;
+  }
+
+_close:
+  fclose(f);
+  LOCK_POOL(pPool);
+  ++pPool->nNumFiles;
+  if (pBuf != NULL)
+    pPool->nNumBytes += nSize;
+  UNLOCK_POOL(pPool);
+_add_result:
+  if (pResult->nNumHits > 0 || pResult->nError != 0 || pResult->bMaybeInMemory)
+  {
+    if (AddResult(pPool, pResult))
+      pResult = NULL;
+  }
+_dispose:
+  if (pResult != NULL)
+    DisposeResult(pResult);
+  free(pBuf);
+}
+
+/* ************************************************************************
+   Function: KeepIgnore
+   Description:
+     Keeps the rules of the ignore files of a directory until
+     the pool is disposed.
+   Returns:
+     NULL -- no memory, the rules are disposed.
+*/
+static const TDirIgnore *KeepIgnore(TFindFilesPool *pPool, TDirIgnore *pIgnore)
+{
+  TFindFilesIgnore *pNode;
+
+  pNode = malloc(sizeof(TFindFilesIgnore));
+  if (pNode == NULL)
+  {
+    DirIgnoreDispose(pIgnore);
+    return NULL;
+  }
+  pNode->pIgnore = pIgnore;
+  LOCK_POOL(pPool);
+  pNode->pNext = pPool->pIgnores;
+  pPool->pIgnores = pNode;
+  UNLOCK_POOL(pPool);
+  return pIgnore;
+}
+
+/* ************************************************************************
+   Function: WalkDir
+   Description:
+     Queues jobs for the subdirectories and for the files
+     of a directory that match the masks.
+*/
+static void WalkDir(TFindFilesPool *pPool, const TFindFilesJob *pJob)
+{
+  char sBuf[_MAX_PATH];
+  TDirWalk *pWalk;
+  TDirIgnore *pNewIgnore;
+  const TDirIgnore *pIgnore;
+  const char *psName;
+  BOOLEAN bDir;
+
+  if (pJob->nLevel == 64)
+    return;
+
+  pWalk = DirWalkOpen(pJob->sPath);
+  if (pWalk == NULL)
+    return;
+
+  pIgnore = pJob->pIgnore;
+  pNewIgnore = DirWalkLoadIgnore(pWalk, pIgnore);
+  if (pNewIgnore != NULL)
+  {
+    pIgnore = KeepIgnore(pPool, pNewIgnore);
+    if (pIgnore == NULL)
+      pIgnore = pJob->pIgnore;
+  }
+
+  while (DirWalkNext(pWalk, &psName, &bDir))
+  {
+    if (bDir && !pPool->bRecursive)
+      continue;
+    if (!bDir && !MatchFile(psName, pJob->psMasks))
+      continue;
+    if (strlen(pJob->sPath) + strlen(psName) + 2 > _MAX_PATH)
+      continue;
+    strcpy(sBuf, pJob->sPath);
+    strcat(sBuf, psName);  /* Full path for this entry */
+    if (DirIgnoreMatch(pIgnore, sBuf, bDir))
+      continue;
+    if (bDir)
+    {
+      AddTrailingSlash(sBuf);
+      QueueJob(pPool, sBuf, pJob->psMasks, NULL, pIgnore,
+        pJob->nRoot, pJob->nLevel + 1, TRUE, FALSE);
+      continue;
+    }
+    QueueJob(pPool, sBuf, NULL, NULL, NULL,
+      pJob->nRoot, pJob->nLevel, FALSE, TRUE);
+  }
+
+  DirWalkClose(pWalk);
+}
+
+/* ************************************************************************
+   Function: UpdateIndexDir
+   Description:
+     Updates the index with the files of a directory that match
+     the masks, walks the subdirectories if the search is recursive.
+     psRelDir is relative to the root of the index.
+   Returns:
+     FALSE -- the search is canceled or no memory.
+*/
+static BOOLEAN UpdateIndexDir(TFindFilesPool *pPool, TTrigramIndex *pIndex,
+  const TFindFilesJob *pJob, const char *psRelDir, int nLevel,
+  const TDirIgnore *pParentIgnore)
+{
+  char sBuf[_MAX_PATH];
+  char sRelPath[_MAX_PATH];
+  TDirWalk *pWalk;
+  TDirIgnore *pIgnore;
+  const TDirIgnore *pDirIgnore;
+  const char *psName;
+  struct stat statbuf;
+  BOOLEAN bDir;
+  BOOLEAN bCanceled;
+  BOOLEAN bResult;
+
+  if (nLevel == 64)
+    return TRUE;
+
+  LOCK_POOL(pPool);
+  bCanceled = pPool->bCanceled;
+  UNLOCK_POOL(pPool);
+  if (bCanceled)
+    return FALSE;
+
+  if (strlen(pJob->sPath) + strlen(psRelDir) >= _MAX_PATH)
+    return TRUE;
+  strcpy(sBuf, pJob->sPath);
+  strcat(sBuf, psRelDir);
+  pWalk = DirWalkOpen(sBuf);
+  if (pWalk == NULL)
+    return TRUE;
+  pIgnore = DirWalkLoadIgnore(pWalk, pParentIgnore);
+  pDirIgnore = pIgnore != NULL ? pIgnore : pParentIgnore;
+
+  bResult = TRUE;
+  while (bResult && DirWalkNext(pWalk, &psName, &bDir))
+  {
+    if (bDir && !pPool->bRecursive)
+      continue;
+    if (!bDir && !MatchFile(psName, pJob->psMasks))
+      continue;
+    if (strlen(pJob->sPath) + strlen(psRelDir) + strlen(psName) + 2 > _MAX_PATH)
+      continue;
+    strcpy(sRelPath, psRelDir);
+    strcat(sRelPath, psName);
+    strcpy(sBuf, pJob->sPath);
+    strcat(sBuf, sRelPath);
+    if (DirIgnoreMatch(pDirIgnore, sBuf, bDir))
+      continue;
+    if (bDir)
+    {
+      AddTrailingSlash(sRelPath);
+      bResult = UpdateIndexDir(pPool, pIndex, pJob, sRelPath, nLevel + 1,
+        pDirIgnore);
+      continue;
+    }
+    if (!DirWalkStat(pWalk, psName, &statbuf))
+      continue;
+    bResult = TrigramIndexUpdateFile(pIndex, sRelPath, &statbuf);
+  }
+
+  DirWalkClose(pWalk);
+  DirIgnoreDispose(pIgnore);
+  return bResult;
+}
+
+/* ************************************************************************
+   Function: IndexDir
+   Description:
+     Brings the trigram index of a directory up to date and queues
+     jobs for the files that may contain the pattern.
+*/
+static void IndexDir(TFindFilesPool *pPool, const TFindFilesJob *pJob)
+{
+  char sBuf[_MAX_PATH];
+  TTrigramIndex *pIndex;
+  const char *psName;
+  BOOLEAN bComplete;
+  int nNumFiles;
+  int i;
+
+  pIndex = TrigramIndexLoad(pJob->psIndexFile, pJob->sPath);
+  if (pIndex == NULL)
+  {
+    WalkDir(pPool, pJob);  /* no memory for an index, search everything */
+    return;
+  }
+
+  bComplete = UpdateIndexDir(pPool, pIndex, pJob, "", 0, NULL);
+  TrigramIndexPurge(pIndex);
+  TrigramIndexStore(pIndex);
+
+  if (bComplete)
+  {
+    nNumFiles = TrigramIndexGetNumFiles(pIndex);
+    for (i = 0; i < nNumFiles; ++i)
+    {
+      psName = TrigramIndexMatch(pIndex, i, &pPool->stQuery);
+      if (psName == NULL)
+        continue;
+      if (strlen(pJob->sPath) + strlen(psName) >= _MAX_PATH)
+        continue;
+      strcpy(sBuf, pJob->sPath);
+      strcat(sBuf, psName);
+      QueueJob(pPool, sBuf, NULL, NULL, NULL, pJob->nRoot, 0, FALSE, TRUE);
+    }
+  }
+
+  TrigramIndexDispose(pIndex);
+}
+
+/* ************************************************************************
+   Function: FindFilesWorker
+   Description:
+     Takes jobs from the queue until the queue is empty and
+     no other worker can produce new jobs.
+*/
+static void *FindFilesWorker(void *pContext)
+{
+  TFindFilesPool *pPool;
+  TFindFilesJob *pJob;
+
+  pPool = pContext;
+
+  LOCK_POOL(pPool);
+  while (1)
+  {
+    #ifdef FINDFILES_THREADS
+    while (pPool->pFirstJob == NULL && pPool->nBusy > 0)
+      pthread_cond_wait(&pPool->JobsReady, &pPool->Lock);
+    #endif
+    pJob = pPool->pFirstJob;
+    if (pJob == NULL)
+      break;  /* No more jobs and nobody to produce any */
+    pPool->pFirstJob = pJob->pNext;
+    if (pPool->pFirstJob == NULL)
+      pPool->pLastJob = NULL;
+    if (pPool->bCanceled)
+    {
+      free(pJob);  /* drain the queue */
+      continue;
+    }
+    ++pPool->nBusy;
+    UNLOCK_POOL(pPool);
+
+    if (pJob->bDir && pJob->psIndexFile != NULL)
+      IndexDir(pPool, pJob);
+    else
+      if (pJob->bDir)
+        WalkDir(pPool, pJob);
+      else
+        SearchFile(pPool, pJob->sPath, pJob->nRoot, pJob->bSkipBinary);
+    free(pJob);
+
+    LOCK_POOL(pPool);
+    --pPool->nBusy;
+  }
+  --pPool->nRunning;
+  #ifdef FINDFILES_THREADS
+  pthread_cond_broadcast(&pPool->JobsReady);  /* wake up the rest to quit */
+  #endif
+  UNLOCK_POOL(pPool);
+  return NULL;
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolStart
+   Description:
+     Starts the workers on the queued directories and files.
+     Without threads the jobs are all processed before the return.
+*/
+void FindFilesPoolStart(TFindFilesPool *pPool)
+{
+  #ifdef FINDFILES_THREADS
+  long nCPUs;
+  int i;
+
+  nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nCPUs < 1)
+    nCPUs = 1;
+  if (nCPUs > MAX_FINDFILES_THREADS)
+    nCPUs = MAX_FINDFILES_THREADS;
+
+  pPool->nNumThreads = 0;
+  for (i = 0; i < nCPUs; ++i)
+  {
+    LOCK_POOL(pPool);
+    ++pPool->nRunning;
+    UNLOCK_POOL(pPool);
+    if (pthread_create(&pPool->Threads[i], NULL, FindFilesWorker, pPool) != 0)
+    {
+      LOCK_POOL(pPool);
+      --pPool->nRunning;
+      UNLOCK_POOL(pPool);
+      break;
+    }
+    ++pPool->nNumThreads;
+  }
+  if (pPool->nNumThreads > 0)
+    return;
+  #endif
+
+  ++pPool->nRunning;
+  FindFilesWorker(pPool);  /* no threads, do the job here */
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolCancel
+   Description:
+     Makes the workers drop the queued jobs. The files that are being
+     searched at the moment are completed.
+*/
+void FindFilesPoolCancel(TFindFilesPool *pPool)
+{
+  LOCK_POOL(pPool);
+  pPool->bCanceled = TRUE;
+  UNLOCK_POOL(pPool);
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolGetProgress
+   Description:
+     Returns the number of files and the number of bytes searched
+     so far.
+*/
+void FindFilesPoolGetProgress(TFindFilesPool *pPool,
+  int *pnNumFiles, long *pnNumBytes)
+{
+  LOCK_POOL(pPool);
+  *pnNumFiles = pPool->nNumFiles;
+  *pnNumBytes = pPool->nNumBytes;
+  UNLOCK_POOL(pPool);
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolWait
+   Description:
+     Waits for the workers to finish all the jobs.
+*/
+void FindFilesPoolWait(TFindFilesPool *pPool)
+{
+  #ifdef FINDFILES_THREADS
+  int i;
+
+  for (i = 0; i < pPool->nNumThreads; ++i)
+    pthread_join(pPool->Threads[i], NULL);
+  #endif
+  pPool->nNumThreads = 0;
+}
+
+/* ************************************************************************
+   Function: CompareResults
+   Description:
+     qsort() call-back. Orders the results by the order of the
+     command line components and then by file name.
+*/
+static int CompareResults(const void *p1, const void *p2)
+{
+  const TFindFilesResult *pResult1;
+  const TFindFilesResult *pResult2;
+
+  pResult1 = *(const TFindFilesResult **)p1;
+  pResult2 = *(const TFindFilesResult **)p2;
+  if (pResult1->nRoot != pResult2->nRoot)
+    return pResult1->nRoot - pResult2->nRoot;
+  return filestrcmp(pResult1->psFileName, pResult2->psFileName);
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolTakeResults
+   Description:
+     Takes the results that the workers have completed since
+     the previous call, sorted by file name. The workers may still be
+     running, *pbDone is set to TRUE when all of them have quit and
+     no more results are to come.
+     The caller disposes the results with FindFilesPoolDisposeResults().
+   Returns:
+     NULL -- no new results (*pnNumResults is 0).
+*/
+TFindFilesResult **FindFilesPoolTakeResults(TFindFilesPool *pPool,
+  int *pnNumResults, BOOLEAN *pbDone)
+{
+  TFindFilesResult **pResults;
+
+  LOCK_POOL(pPool);
+  pResults = pPool->pResults;
+  *pnNumResults = pPool->nNumResults;
+  *pbDone = pPool->nRunning == 0;
+  pPool->pResults = NULL;
+  pPool->nNumResults = 0;
+  pPool->nMaxResults = 0;
+  UNLOCK_POOL(pPool);
+
+  if (pResults != NULL)
+    qsort(pResults, *pnNumResults, sizeof(TFindFilesResult *), CompareResults);
+  return pResults;
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolDisposeResults
+   Description:
+     Disposes results taken by FindFilesPoolTakeResults().
+*/
+void FindFilesPoolDisposeResults(TFindFilesResult **pResults, int nNumResults)
+{
+  int i;
+
+  for (i = 0; i < nNumResults; ++i)
+    DisposeResult(pResults[i]);
+  free(pResults);
+}
+
+/* ************************************************************************
+   Function: FindFilesPoolDispose
+   Description:
+     Disposes the pool, any queued jobs and all the results.
+*/
+void FindFilesPoolDispose(TFindFilesPool *pPool)
+{
+  TFindFilesJob *pJob;
+  TFindFilesName *pName;
+  TFindFilesIgnore *pIgnore;
+
+  if (pPool == NULL)
+    return;
+
+  FindFilesPoolWait(pPool);
+
+  while (pPool->pFirstJob != NULL)
+  {
+    pJob = pPool->pFirstJob;
+    pPool->pFirstJob = pJob->pNext;
+    free(pJob);
+  }
+  while (pPool->pInMemory != NULL)
+  {
+    pName = pPool->pInMemory;
+    pPool->pInMemory = pName->pNext;
+    free(pName);
+  }
+  while (pPool->pMasks != NULL)
+  {
+    pName = pPool->pMasks;
+    pPool->pMasks = pName->pNext;
+    free(pName);
+  }
+  while (pPool->pIgnores != NULL)
+  {
+    pIgnore = pPool->pIgnores;
+    pPool->pIgnores = pIgnore->pNext;
+    DirIgnoreDispose(pIgnore->pIgnore);
+    free(pIgnore);
+  }
+  FindFilesPoolDisposeResults(pPool->pResults, pPool->nNumResults);
+
+  #ifdef FINDFILES_THREADS
+  pthread_mutex_destroy(&pPool->Lock);
+  pthread_cond_destroy(&pPool->JobsReady);
+  #endif
+  free(pPool);
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
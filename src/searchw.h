@@ -0,0 +1,92 @@
+/*
+
+File: searchw.h
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Worker threads that walk directories and search files for
+  Find in Files.
+
+*/
+
+#ifndef SEARCHW_H
+#define SEARCHW_H
+
+/*
+An occurrence of the pattern in a file
+*/
+typedef struct FindFilesHit
+{
+  int nLine;
+  int nPos;  /* character position in the line (not a column) */
+  char *psContent;  /* the text of the line */
+} TFindFilesHit;
+
+/*
+The occurrences found in a single file
+*/
+typedef struct FindFilesResult
+{
+  char *psFileName;
+  int nRoot;  /* index of the directory component of the command line */
+  int nError;  /* 0 -Ok, 3 -no memory, 5 -I/O error (as for LoadFilePrim()) */
+  BOOLEAN bMaybeInMemory;  /* same name as a file loaded in the editor */
+  int nNumHits;
+  int nMaxHits;
+  TFindFilesHit *pHits;
+} TFindFilesResult;
+
+typedef struct FindFilesPool TFindFilesPool;
+
+TFindFilesPool *FindFilesPoolCreate(const TSearchContext *pstSearchContext,
+  BOOLEAN bRecursive);
+BOOLEAN FindFilesPoolAddInMemory(TFindFilesPool *pPool, const char *psFileName);
+BOOLEAN FindFilesPoolAddDir(TFindFilesPool *pPool, const char *psDir,
+  const char *psMasks, const char *psIndexFile, int nRoot);
+BOOLEAN FindFilesPoolAddFile(TFindFilesPool *pPool, const char *psFile,
+  int nRoot);
+void FindFilesPoolStart(TFindFilesPool *pPool);
+void FindFilesPoolCancel(TFindFilesPool *pPool);
+void FindFilesPoolGetProgress(TFindFilesPool *pPool,
+  int *pnNumFiles, long *pnNumBytes);
+void FindFilesPoolWait(TFindFilesPool *pPool);
+TFindFilesResult **FindFilesPoolTakeResults(TFindFilesPool *pPool,
+  int *pnNumResults, BOOLEAN *pbDone);
+void FindFilesPoolDisposeResults(TFindFilesResult **pResults, int nNumResults);
+void FindFilesPoolDispose(TFindFilesPool *pPool);
+
+#endif  /* SEARCHW_H */
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
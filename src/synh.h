@@ -32,7 +32,8 @@ typedef enum Color_t
   COLOR_BPAIR,
   COLOR_TOOLTIP,
   COLOR_BLOCKCURSOR,
-  COLOR_BOOKMARK
+  COLOR_BOOKMARK,
+  COLOR_SEARCHMATCH
 } Color_t;
 
 /*
@@ -113,6 +114,8 @@ typedef struct ExtraColorInterf
   void *pReserved1;
   void *pReserved2;
   int  nReserved1;
+  void *pMatchCache;  /* search matches of the visible page, see search.c */
+  int nMarksVersion;  /* of the bookmarks the page colors come from */
 } TExtraColorInterf;
 
 /*
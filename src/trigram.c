@@ -0,0 +1,1010 @@
+/*
+
+File: trigram.c
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Persistent trigram index of the files of a directory tree, used
+  by Find in Files to skip the files that can not contain the pattern.
+
+  For every file of the tree the index keeps the time and the size
+  of the file and the set of all the trigrams (3 consecutive
+  characters, case folded) of its text. The set is kept sorted and
+  delta encoded, 7 bits per byte. A file is a candidate for a search
+  if it contains all the trigrams of the literal parts of the pattern.
+
+  The index is loaded from a file under the workspace directory, only
+  the files whose time or size has changed are scanned again and the
+  index is stored back if anything has changed.
+
+  The functions are called by the workers of searchw.c and use only
+  malloc()/free().
+
+*/
+
+#include "global.h"
+#include <time.h>
+#include "maxpath.h"
+#include "wlimits.h"
+#include "path.h"
+#include "dirwalk.h"
+#include "trigram.h"
+
+#define TRIGRAM_INDEX_MAGIC "WWTI"
+#define TRIGRAM_INDEX_VERSION 1
+
+#define TRIGRAM_KEY(a, b, c) \
+  (((DWORD)(a) << 16) | ((DWORD)(b) << 8) | (DWORD)(c))
+
+/* only the characters in the lines of a file make trigrams */
+#define IS_TRIGRAM_CHAR(c) ((c) != '\0' && (c) != '\r' && (c) != '\n')
+
+typedef struct TrigramFile
+{
+  char *psName;  /* relative to the root */
+  long nTime;
+  long nSize;
+  int nNumTrigrams;  /* -1 -- the file can't be read, always a candidate */
+  int nEncodedLen;
+  BYTE *pEncoded;
+  BOOLEAN bSeen;  /* the file is present in the tree */
+} TTrigramFile;
+
+struct TrigramIndex
+{
+  char sIndexFile[_MAX_PATH];
+  char sRoot[_MAX_PATH];  /* with a trailing slash */
+  TTrigramFile *pFiles;
+  int nNumFiles;
+  int nNumSorted;  /* pFiles[0..nNumSorted - 1] are sorted by name */
+  int nMaxFiles;
+  BOOLEAN bChanged;
+  time_t nLoadTime;
+
+  /* scratch space to collect the trigrams of a file */
+  BYTE *pBitmap;
+  DWORD *pList;
+  int nMaxList;
+};
+
+/* ************************************************************************
+   Function: CompareTrigrams
+   Description:
+     qsort() call-back.
+*/
+static int CompareTrigrams(const void *p1, const void *p2)
+{
+  DWORD n1;
+  DWORD n2;
+
+  n1 = *(const DWORD *)p1;
+  n2 = *(const DWORD *)p2;
+  if (n1 < n2)
+    return -1;
+  return n1 > n2;
+}
+
+/* ************************************************************************
+   Function: AddQueryRun
+   Description:
+     Adds the trigrams of a string that any matching text contains.
+*/
+static void AddQueryRun(TTrigramQuery *pQuery, const char *psRun, int nLen)
+{
+  const BYTE *p;
+  int i;
+
+  p = (const BYTE *)psRun;
+  for (i = 0; i + 2 < nLen; ++i)
+  {
+    if (!IS_TRIGRAM_CHAR(p[i]) || !IS_TRIGRAM_CHAR(p[i + 1]) ||
+      !IS_TRIGRAM_CHAR(p[i + 2]))
+      continue;
+    if (pQuery->nNumTrigrams == _countof(pQuery->Trigrams))
+      return;
+    pQuery->Trigrams[pQuery->nNumTrigrams++] =
+      TRIGRAM_KEY(tolower(p[i]), tolower(p[i + 1]), tolower(p[i + 2]));
+  }
+}
+
+/* ************************************************************************
+   Function: SkipClass
+   Description:
+     p points after the '[' of a character class of a regular expression.
+     Returns a pointer after the closing ']'.
+*/
+static const char *SkipClass(const char *p)
+{
+  if (*p == '^')
+    ++p;
+  if (*p == ']')
+    ++p;  /* the first ']' is a literal */
+  while (*p != '\0' && *p != ']')
+  {
+    if (*p == '[' && *(p + 1) == ':')  /* [:alpha:] */
+    {
+      p = strstr(p + 2, ":]");
+      if (p == NULL)
+        return "";
+      p += 2;
+      continue;
+    }
+    if (*p == '\\' && *(p + 1) != '\0')
+      ++p;
+    ++p;
+  }
+  if (*p == ']')
+    ++p;
+  return p;
+}
+
+/* ************************************************************************
+   Function: PrepareRegex
+   Description:
+     Collects the literal runs that every match of a regular expression
+     must contain. Anything that is not certain ends a run: groups,
+     classes, escapes other than a punctuation character and
+     a character under a quantifier. An alternative ('|') anywhere in
+     the expression disables the narrowing.
+*/
+static void PrepareRegex(TTrigramQuery *pQuery, const char *psRegex)
+{
+  char sRun[MAX_SEARCH_STR];
+  int nLen;
+  int nDepth;
+  char c;
+  const char *p;
+
+  for (p = psRegex; *p != '\0'; ++p)
+  {
+    if (*p == '\\' && *(p + 1) != '\0')
+      ++p;
+    else
+      if (*p == '|')
+        return;
+  }
+
+  #define END_RUN() (AddQueryRun(pQuery, sRun, nLen), nLen = 0)
+
+  nLen = 0;
+  p = psRegex;
+  while (*p != '\0')
+  {
+    switch (*p)
+    {
+      case '\\':
+        c = *(p + 1);
+        if (c == '\0')
+          goto _exit;
+        p += 2;
+        if (!isalnum((BYTE)c))
+        {
+          sRun[nLen++] = c;  /* escaped punctuation is a literal */
+          break;
+        }
+        END_RUN();
+        switch (c)
+        {
+          case 'Q':  /* literal up to \E */
+            while (*p != '\0' && !(*p == '\\' && *(p + 1) == 'E'))
+              sRun[nLen++] = *p++;
+            if (*p != '\0')
+              p += 2;
+            break;
+          case 'x':
+            if (*p == '{')
+            {
+              while (*p != '\0' && *p != '}')
+                ++p;
+              if (*p != '\0')
+                ++p;
+              break;
+            }
+            for (nDepth = 0; nDepth < 2 && isxdigit((BYTE)*p); ++nDepth)
+              ++p;
+            break;
+          case 'p':
+          case 'P':
+            if (*p == '{')
+            {
+              while (*p != '\0' && *p != '}')
+                ++p;
+              if (*p != '\0')
+                ++p;
+            }
+            else
+              if (*p != '\0')
+                ++p;
+            break;
+          case 'c':
+            if (*p != '\0')
+              ++p;
+            break;
+          default:
+            while (isdigit((BYTE)*p))  /* back reference or octal */
+              ++p;
+            break;
+        }
+        break;
+
+      case '[':
+        END_RUN();
+        p = SkipClass(p + 1);
+        break;
+
+      case '(':
+        END_RUN();
+        nDepth = 0;
+        while (*p != '\0')
+        {
+          if (*p == '\\' && *(p + 1) != '\0')
+            p += 2;
+          else
+            if (*p == '[')
+              p = SkipClass(p + 1);
+            else
+            {
+              if (*p == '(')
+                ++nDepth;
+              else
+                if (*p == ')' && --nDepth == 0)
+                {
+                  ++p;
+                  break;
+                }
+              ++p;
+            }
+        }
+        break;
+
+      case '*':
+      case '?':
+        if (nLen > 0)
+          --nLen;  /* the character may be missing */
+        END_RUN();
+        ++p;
+        break;
+
+      case '{':
+        if (!isdigit((BYTE)*(p + 1)))
+        {
+          sRun[nLen++] = *p++;  /* not a quantifier, a literal */
+          break;
+        }
+        if (nLen > 0)
+          --nLen;
+        END_RUN();
+        while (*p != '\0' && *p != '}')
+          ++p;
+        if (*p != '\0')
+          ++p;
+        break;
+
+      case '+':
+        /* the character is repeated, a new run starts with it */
+        c = nLen > 0 ? sRun[nLen - 1] : '\0';
+        END_RUN();
+        if (c != '\0')
+          sRun[nLen++] = c;
+        ++p;
+        break;
+
+      case '.':
+      case '^':
+      case '$':
+      case ')':
+        END_RUN();
+        ++p;
+        break;
+
+      default:
+        sRun[nLen++] = *p++;
+        break;
+    }
+  }
+
+_exit:
+  END_RUN();
+  #undef END_RUN
+}
+
+/* ************************************************************************
+   Function: TrigramQueryPrepare
+   Description:
+     Prepares the trigrams that a file must contain to have a match
+     of psPattern.
+*/
+void TrigramQueryPrepare(TTrigramQuery *pQuery, const char *psPattern,
+  BOOLEAN bRegularExpr)
+{
+  DWORD *pDest;
+  int i;
+
+  pQuery->nNumTrigrams = 0;
+  if (bRegularExpr)
+    PrepareRegex(pQuery, psPattern);
+  else
+    AddQueryRun(pQuery, psPattern, strlen(psPattern));
+
+  if (pQuery->nNumTrigrams == 0)
+    return;
+  qsort(pQuery->Trigrams, pQuery->nNumTrigrams, sizeof(DWORD),
+    CompareTrigrams);
+  pDest = pQuery->Trigrams;
+  for (i = 1; i < pQuery->nNumTrigrams; ++i)
+    if (pQuery->Trigrams[i] != *pDest)
+      *++pDest = pQuery->Trigrams[i];
+  pQuery->nNumTrigrams = pDest - pQuery->Trigrams + 1;
+}
+
+/* ************************************************************************
+   Function: GetCanonicalRoot
+   Description:
+     Resolves psRoot to an absolute path without symlinks and "./", "../"
+     components, ending with a slash. The same directory reached from
+     different working directories then gets the same index.
+     Falls back to psRoot if it can not be resolved.
+*/
+static void GetCanonicalRoot(const char *psRoot, char *psDest)
+{
+#ifdef WIN32
+  if (_fullpath(psDest, psRoot, _MAX_PATH) == NULL)
+    strcpy(psDest, psRoot);
+#else
+  char *psResolved;
+
+  psResolved = realpath(psRoot, NULL);
+  if (psResolved != NULL && strlen(psResolved) + 1 < _MAX_PATH)
+    strcpy(psDest, psResolved);
+  else
+    strcpy(psDest, psRoot);
+  free(psResolved);
+#endif
+  AddTrailingSlash(psDest);
+}
+
+/* ************************************************************************
+   Function: TrigramIndexFileName
+   Description:
+     Composes the name of the index file of the directory psRoot.
+*/
+void TrigramIndexFileName(const char *psWorkspaceDir, const char *psRoot,
+  char *psIndexFile)
+{
+  unsigned long nHash;
+  const char *p;
+  char sRoot[_MAX_PATH];
+  char sName[24];
+
+  GetCanonicalRoot(psRoot, sRoot);
+  nHash = 5381;
+  for (p = sRoot; *p != '\0'; ++p)
+    nHash = (nHash * 33 + (BYTE)*p) & 0xffffffffUL;
+  sprintf(sName, "wtrig%08lx.idx", nHash);
+
+  strcpy(psIndexFile, psWorkspaceDir);
+  AddTrailingSlash(psIndexFile);
+  ASSERT(strlen(psIndexFile) + strlen(sName) < _MAX_PATH);
+  strcat(psIndexFile, sName);
+}
+
+/* ************************************************************************
+   Function: CompareFiles
+   Description:
+     qsort() call-back.
+*/
+static int CompareFiles(const void *p1, const void *p2)
+{
+  return strcmp(((const TTrigramFile *)p1)->psName,
+    ((const TTrigramFile *)p2)->psName);
+}
+
+/* ************************************************************************
+   Function: DisposeFiles
+   Description:
+*/
+static void DisposeFiles(TTrigramIndex *pIndex)
+{
+  int i;
+
+  for (i = 0; i < pIndex->nNumFiles; ++i)
+  {
+    free(pIndex->pFiles[i].psName);
+    free(pIndex->pFiles[i].pEncoded);
+  }
+  free(pIndex->pFiles);
+  pIndex->pFiles = NULL;
+  pIndex->nNumFiles = 0;
+  pIndex->nNumSorted = 0;
+  pIndex->nMaxFiles = 0;
+}
+
+/* ************************************************************************
+   Function: AddFile
+   Description:
+     Appends an entry, takes the ownership of psName.
+   Returns:
+     -1 -- no memory.
+*/
+static int AddFile(TTrigramIndex *pIndex, char *psName)
+{
+  TTrigramFile *pNewFiles;
+  TTrigramFile *pFile;
+  int nNewMax;
+
+  if (pIndex->nNumFiles == pIndex->nMaxFiles)
+  {
+    nNewMax = pIndex->nMaxFiles * 2 + 256;
+    pNewFiles = realloc(pIndex->pFiles, nNewMax * sizeof(TTrigramFile));
+    if (pNewFiles == NULL)
+      return -1;
+    pIndex->pFiles = pNewFiles;
+    pIndex->nMaxFiles = nNewMax;
+  }
+  pFile = &pIndex->pFiles[pIndex->nNumFiles];
+  memset(pFile, 0, sizeof(TTrigramFile));
+  pFile->psName = psName;
+  pFile->nTime = -1;
+  pFile->nSize = -1;
+  return pIndex->nNumFiles++;
+}
+
+/* ************************************************************************
+   Function: LoadIndexFile
+   Description:
+*/
+static BOOLEAN LoadIndexFile(TTrigramIndex *pIndex, FILE *f)
+{
+  char sMagic[4];
+  DWORD nVersion;
+  DWORD nNumFiles;
+  DWORD nLen;
+  char sRoot[_MAX_PATH];
+  TTrigramFile *pFile;
+  char *psName;
+  int nFile;
+
+  if (fread(sMagic, 1, 4, f) != 4 || memcmp(sMagic, TRIGRAM_INDEX_MAGIC, 4) != 0)
+    return FALSE;
+  if (fread(&nVersion, sizeof(DWORD), 1, f) != 1 ||
+    nVersion != TRIGRAM_INDEX_VERSION)
+    return FALSE;
+  if (fread(&nLen, sizeof(DWORD), 1, f) != 1 || nLen >= _MAX_PATH)
+    return FALSE;
+  if (fread(sRoot, 1, nLen, f) != nLen)
+    return FALSE;
+  sRoot[nLen] = '\0';
+  if (filestrcmp(sRoot, pIndex->sRoot) != 0)
+    return FALSE;  /* a different directory with the same hash */
+  if (fread(&nNumFiles, sizeof(DWORD), 1, f) != 1)
+    return FALSE;
+
+  while (nNumFiles-- > 0)
+  {
+    if (fread(&nLen, sizeof(DWORD), 1, f) != 1 || nLen >= _MAX_PATH)
+      return FALSE;
+    psName = malloc(nLen + 1);
+    if (psName == NULL)
+      return FALSE;
+    if (fread(psName, 1, nLen, f) != nLen)
+    {
+      free(psName);
+      return FALSE;
+    }
+    psName[nLen] = '\0';
+    nFile = AddFile(pIndex, psName);
+    if (nFile == -1)
+    {
+      free(psName);
+      return FALSE;
+    }
+    pFile = &pIndex->pFiles[nFile];
+    if (fread(&pFile->nTime, sizeof(long), 1, f) != 1 ||
+      fread(&pFile->nSize, sizeof(long), 1, f) != 1 ||
+      fread(&pFile->nNumTrigrams, sizeof(int), 1, f) != 1 ||
+      fread(&pFile->nEncodedLen, sizeof(int), 1, f) != 1 ||
+      pFile->nEncodedLen < 0)
+      return FALSE;
+    if (pFile->nEncodedLen == 0)
+      continue;
+    pFile->pEncoded = malloc(pFile->nEncodedLen);
+    if (pFile->pEncoded == NULL)
+      return FALSE;
+    if (fread(pFile->pEncoded, 1, pFile->nEncodedLen, f) !=
+      (size_t)pFile->nEncodedLen)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: TrigramIndexLoad
+   Description:
+     Loads the index of directory psRoot (ending with a slash) from
+     psIndexFile. A missing or invalid index file gives an empty index.
+   Returns:
+     NULL -- no memory.
+*/
+TTrigramIndex *TrigramIndexLoad(const char *psIndexFile, const char *psRoot)
+{
+  TTrigramIndex *pIndex;
+  FILE *f;
+
+  pIndex = malloc(sizeof(TTrigramIndex));
+  if (pIndex == NULL)
+    return NULL;
+  memset(pIndex, 0, sizeof(TTrigramIndex));
+  strcpy(pIndex->sIndexFile, psIndexFile);
+  GetCanonicalRoot(psRoot, pIndex->sRoot);
+  pIndex->nLoadTime = time(NULL);
+
+  f = fopen(psIndexFile, READ_BINARY_FILE);
+  if (f == NULL)
+  {
+    pIndex->bChanged = TRUE;  /* a new index */
+    return pIndex;
+  }
+  if (!LoadIndexFile(pIndex, f))
+  {
+    DisposeFiles(pIndex);  /* start a new one */
+    pIndex->bChanged = TRUE;
+  }
+  fclose(f);
+
+  qsort(pIndex->pFiles, pIndex->nNumFiles, sizeof(TTrigramFile), CompareFiles);
+  pIndex->nNumSorted = pIndex->nNumFiles;
+  return pIndex;
+}
+
+/* ************************************************************************
+   Function: FindFile
+   Description:
+     Binary search among the entries loaded from the index file.
+*/
+static int FindFile(const TTrigramIndex *pIndex, const char *psName)
+{
+  int nLow;
+  int nHigh;
+  int nMid;
+  int nCmp;
+
+  nLow = 0;
+  nHigh = pIndex->nNumSorted - 1;
+  while (nLow <= nHigh)
+  {
+    nMid = (nLow + nHigh) / 2;
+    nCmp = strcmp(pIndex->pFiles[nMid].psName, psName);
+    if (nCmp == 0)
+      return nMid;
+    if (nCmp < 0)
+      nLow = nMid + 1;
+    else
+      nHigh = nMid - 1;
+  }
+  return -1;
+}
+
+/* ************************************************************************
+   Function: EncodeTrigrams
+   Description:
+     Stores the sorted trigrams of pIndex->pList in a file entry
+     as deltas, 7 bits per byte, the high bit marks a continuation.
+*/
+static BOOLEAN EncodeTrigrams(TTrigramFile *pFile, const DWORD *pList, int nNum)
+{
+  BYTE *p;
+  DWORD nPrev;
+  DWORD nDelta;
+  int i;
+
+  pFile->nNumTrigrams = nNum;
+  pFile->nEncodedLen = 0;
+  if (nNum == 0)
+    return TRUE;
+  pFile->pEncoded = malloc(nNum * 4);  /* 24 bits take 4 bytes at most */
+  if (pFile->pEncoded == NULL)
+    return FALSE;
+
+  p = pFile->pEncoded;
+  nPrev = 0;
+  for (i = 0; i < nNum; ++i)
+  {
+    nDelta = pList[i] - nPrev;
+    nPrev = pList[i];
+    while (nDelta >= 0x80)
+    {
+      *p++ = (BYTE)(nDelta | 0x80);
+      nDelta >>= 7;
+    }
+    *p++ = (BYTE)nDelta;
+  }
+  pFile->nEncodedLen = p - pFile->pEncoded;
+  p = realloc(pFile->pEncoded, pFile->nEncodedLen);
+  if (p != NULL)
+    pFile->pEncoded = p;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: ScanFile
+   Description:
+     Reads a file and collects all its trigrams. A binary file
+     is stored without trigrams.
+*/
+static BOOLEAN ScanFile(TTrigramIndex *pIndex, TTrigramFile *pFile)
+{
+  char sPath[_MAX_PATH];
+  FILE *f;
+  BYTE *pBuf;
+  DWORD *pNewList;
+  DWORD nKey;
+  long nSize;
+  long i;
+  int nNum;
+  int nNewMax;
+  BOOLEAN bResult;
+
+  free(pFile->pEncoded);
+  pFile->pEncoded = NULL;
+  pFile->nEncodedLen = 0;
+  pFile->nNumTrigrams = -1;  /* a candidate for any search */
+
+  if (strlen(pIndex->sRoot) + strlen(pFile->psName) >= _MAX_PATH)
+    return TRUE;
+  strcpy(sPath, pIndex->sRoot);
+  strcat(sPath, pFile->psName);
+
+  if (pIndex->pBitmap == NULL)
+  {
+    pIndex->pBitmap = calloc(1 << 21, 1);  /* a bit for all 24-bit keys */
+    if (pIndex->pBitmap == NULL)
+      return FALSE;
+  }
+
+  bResult = TRUE;
+  pBuf = NULL;
+  f = fopen(sPath, READ_BINARY_FILE);
+  if (f == NULL)
+    return TRUE;
+  nSize = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    nSize = ftell(f);
+  if (nSize < 0 || fseek(f, 0, SEEK_SET) != 0)
+    goto _close;
+  pBuf = malloc(nSize + 1);
+  if (pBuf == NULL)
+  {
+    bResult = FALSE;
+    goto _close;
+  }
+  if ((long)fread(pBuf, 1, nSize, f) != nSize)
+    goto _close;
+  if (IsBinaryText((char *)pBuf, nSize))
+  {
+    EncodeTrigrams(pFile, NULL, 0);  /* never searched */
+    goto _close;
+  }
+  for (i = 0; i < nSize; ++i)
+    pBuf[i] = tolower(pBuf[i]);
+
+  nNum = 0;
+  for (i = 0; i + 2 < nSize; ++i)
+  {
+    if (!IS_TRIGRAM_CHAR(pBuf[i + 2]))
+    {
+      i += 2;  /* no trigram can include this character */
+      continue;
+    }
+    if (!IS_TRIGRAM_CHAR(pBuf[i]) || !IS_TRIGRAM_CHAR(pBuf[i + 1]))
+      continue;
+    nKey = TRIGRAM_KEY(pBuf[i], pBuf[i + 1], pBuf[i + 2]);
+    if ((pIndex->pBitmap[nKey >> 3] & (1 << (nKey & 7))) != 0)
+      continue;
+    if (nNum == pIndex->nMaxList)
+    {
+      nNewMax = pIndex->nMaxList * 2 + 4096;
+      pNewList = realloc(pIndex->pList, nNewMax * sizeof(DWORD));
+      if (pNewList == NULL)
+      {
+        bResult = FALSE;
+        break;
+      }
+      pIndex->pList = pNewList;
+      pIndex->nMaxList = nNewMax;
+    }
+    pIndex->pBitmap[nKey >> 3] |= 1 << (nKey & 7);
+    pIndex->pList[nNum++] = nKey;
+  }
+
+  /* clear only the bits that were set */
+  for (i = 0; i < nNum; ++i)
+    pIndex->pBitmap[pIndex->pList[i] >> 3] = 0;
+
+  if (bResult)
+  {
+    qsort(pIndex->pList, nNum, sizeof(DWORD), CompareTrigrams);
+    bResult = EncodeTrigrams(pFile, pIndex->pList, nNum);
+    if (!bResult)
+      pFile->nNumTrigrams = -1;
+  }
+
+_close:
+  fclose(f);
+  free(pBuf);
+  return bResult;
+}
+
+/* ************************************************************************
+   Function: TrigramIndexUpdateFile
+   Description:
+     Marks a file as present in the tree. The file is scanned if it is
+     new or if its time or size differ from the ones in the index.
+     psName is relative to the root of the index.
+   Returns:
+     FALSE -- no memory.
+*/
+BOOLEAN TrigramIndexUpdateFile(TTrigramIndex *pIndex, const char *psName,
+  const struct stat *pStat)
+{
+  TTrigramFile *pFile;
+  char *psNameCopy;
+  int nFile;
+
+  nFile = FindFile(pIndex, psName);
+  if (nFile == -1)
+  {
+    psNameCopy = malloc(strlen(psName) + 1);
+    if (psNameCopy == NULL)
+      return FALSE;
+    strcpy(psNameCopy, psName);
+    nFile = AddFile(pIndex, psNameCopy);
+    if (nFile == -1)
+    {
+      free(psNameCopy);
+      return FALSE;
+    }
+  }
+
+  pFile = &pIndex->pFiles[nFile];
+  pFile->bSeen = TRUE;
+  if (pFile->nTime == (long)pStat->st_mtime &&
+    pFile->nSize == (long)pStat->st_size)
+    return TRUE;
+
+  pIndex->bChanged = TRUE;
+  pFile->nTime = (long)pStat->st_mtime;
+  pFile->nSize = (long)pStat->st_size;
+  /* a file modified in the last second could change again with
+  the same time and size, it will be scanned again next time */
+  if (pStat->st_mtime >= pIndex->nLoadTime - 1)
+    pFile->nTime = -1;
+  return ScanFile(pIndex, pFile);
+}
+
+/* ************************************************************************
+   Function: TrigramIndexPurge
+   Description:
+     Removes the entries of the files that no longer exist. To be
+     called after all the files of the tree are updated, sorts
+     the entries by name.
+*/
+void TrigramIndexPurge(TTrigramIndex *pIndex)
+{
+  char sPath[_MAX_PATH];
+  struct stat statbuf;
+  TTrigramFile *pFile;
+  int nDest;
+  int i;
+
+  nDest = 0;
+  for (i = 0; i < pIndex->nNumFiles; ++i)
+  {
+    pFile = &pIndex->pFiles[i];
+    if (!pFile->bSeen)
+    {
+      if (strlen(pIndex->sRoot) + strlen(pFile->psName) >= _MAX_PATH)
+        goto _remove;
+      strcpy(sPath, pIndex->sRoot);
+      strcat(sPath, pFile->psName);
+      if (stat(sPath, &statbuf) != 0)
+        goto _remove;
+    }
+    pIndex->pFiles[nDest++] = *pFile;
+    continue;
+_remove:
+    free(pFile->psName);
+    free(pFile->pEncoded);
+    pIndex->bChanged = TRUE;
+  }
+  pIndex->nNumFiles = nDest;
+
+  qsort(pIndex->pFiles, pIndex->nNumFiles, sizeof(TTrigramFile), CompareFiles);
+  pIndex->nNumSorted = pIndex->nNumFiles;
+}
+
+/* ************************************************************************
+   Function: TrigramIndexGetNumFiles
+   Description:
+*/
+int TrigramIndexGetNumFiles(const TTrigramIndex *pIndex)
+{
+  return pIndex->nNumFiles;
+}
+
+/* ************************************************************************
+   Function: TrigramIndexMatch
+   Description:
+     Checks whether a file present in the tree contains all
+     the trigrams of the query.
+   Returns:
+     The name of the file relative to the root, NULL -- the file can't
+     have a match.
+*/
+const char *TrigramIndexMatch(const TTrigramIndex *pIndex, int nFile,
+  const TTrigramQuery *pQuery)
+{
+  const TTrigramFile *pFile;
+  const BYTE *p;
+  const BYTE *pEnd;
+  DWORD nKey;
+  DWORD nDelta;
+  int nShift;
+  int q;
+
+  ASSERT(nFile >= 0 && nFile < pIndex->nNumFiles);
+
+  pFile = &pIndex->pFiles[nFile];
+  if (!pFile->bSeen)
+    return NULL;
+  if (pFile->nNumTrigrams < 0 || pQuery->nNumTrigrams == 0)
+    return pFile->psName;
+
+  p = pFile->pEncoded;
+  pEnd = p + pFile->nEncodedLen;
+  nKey = 0;
+  q = 0;
+  while (q < pQuery->nNumTrigrams)
+  {
+    if (p == pEnd)
+      return NULL;
+    nDelta = 0;
+    nShift = 0;
+    while (*p & 0x80)
+    {
+      nDelta |= (DWORD)(*p++ & 0x7f) << nShift;
+      nShift += 7;
+    }
+    nDelta |= (DWORD)*p++ << nShift;
+    nKey += nDelta;
+    if (nKey < pQuery->Trigrams[q])
+      continue;
+    if (nKey > pQuery->Trigrams[q])
+      return NULL;
+    ++q;
+  }
+  return pFile->psName;
+}
+
+/* ************************************************************************
+   Function: TrigramIndexStore
+   Description:
+     Stores the index if anything has changed. The index is written in
+     a temporary file first, so that an interrupted write doesn't
+     destroy the old index.
+*/
+BOOLEAN TrigramIndexStore(TTrigramIndex *pIndex)
+{
+  char sTempFile[_MAX_PATH + 8];
+  const TTrigramFile *pFile;
+  FILE *f;
+  DWORD nValue;
+  int i;
+  BOOLEAN bResult;
+
+  if (!pIndex->bChanged)
+    return TRUE;
+
+  strcpy(sTempFile, pIndex->sIndexFile);
+  strcat(sTempFile, ".tmp");
+  f = fopen(sTempFile, "wb");
+  if (f == NULL)
+    return FALSE;
+
+  bResult = FALSE;
+  nValue = TRIGRAM_INDEX_VERSION;
+  if (fwrite(TRIGRAM_INDEX_MAGIC, 1, 4, f) != 4 ||
+    fwrite(&nValue, sizeof(DWORD), 1, f) != 1)
+    goto _close;
+  nValue = strlen(pIndex->sRoot);
+  if (fwrite(&nValue, sizeof(DWORD), 1, f) != 1 ||
+    fwrite(pIndex->sRoot, 1, nValue, f) != nValue)
+    goto _close;
+  nValue = pIndex->nNumFiles;
+  if (fwrite(&nValue, sizeof(DWORD), 1, f) != 1)
+    goto _close;
+
+  for (i = 0; i < pIndex->nNumFiles; ++i)
+  {
+    pFile = &pIndex->pFiles[i];
+    nValue = strlen(pFile->psName);
+    if (fwrite(&nValue, sizeof(DWORD), 1, f) != 1 ||
+      fwrite(pFile->psName, 1, nValue, f) != nValue ||
+      fwrite(&pFile->nTime, sizeof(long), 1, f) != 1 ||
+      fwrite(&pFile->nSize, sizeof(long), 1, f) != 1 ||
+      fwrite(&pFile->nNumTrigrams, sizeof(int), 1, f) != 1 ||
+      fwrite(&pFile->nEncodedLen, sizeof(int), 1, f) != 1)
+      goto _close;
+    if (pFile->nEncodedLen > 0 &&
+      fwrite(pFile->pEncoded, 1, pFile->nEncodedLen, f) !=
+        (size_t)pFile->nEncodedLen)
+      goto _close;
+  }
+  bResult = TRUE;
+
+_close:
+  if (fclose(f) != 0)
+    bResult = FALSE;
+  if (!bResult)
+  {
+    remove(sTempFile);
+    return FALSE;
+  }
+  #ifndef UNIX
+  remove(pIndex->sIndexFile);  /* rename() doesn't replace files */
+  #endif
+  if (rename(sTempFile, pIndex->sIndexFile) != 0)
+  {
+    remove(sTempFile);
+    return FALSE;
+  }
+  pIndex->bChanged = FALSE;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: TrigramIndexDispose
+   Description:
+*/
+void TrigramIndexDispose(TTrigramIndex *pIndex)
+{
+  if (pIndex == NULL)
+    return;
+  DisposeFiles(pIndex);
+  free(pIndex->pBitmap);
+  free(pIndex->pList);
+  free(pIndex);
+}
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -0,0 +1,74 @@
+/*
+
+File: trigram.h
+COPYING: Full text of the copyrights statement at the bottom of the file
+Project: WW
+Started: 18th October, 2026
+Descrition:
+  Persistent trigram index of the files of a directory tree, used
+  by Find in Files to skip the files that can not contain the pattern.
+
+*/
+
+#ifndef TRIGRAM_H
+#define TRIGRAM_H
+
+/*
+The trigrams that a file must contain to match a search pattern
+*/
+typedef struct TrigramQuery
+{
+  int nNumTrigrams;  /* 0 -- any file is a candidate */
+  DWORD Trigrams[MAX_SEARCH_STR];  /* sorted, no duplicates */
+} TTrigramQuery;
+
+typedef struct TrigramIndex TTrigramIndex;
+
+void TrigramQueryPrepare(TTrigramQuery *pQuery, const char *psPattern,
+  BOOLEAN bRegularExpr);
+void TrigramIndexFileName(const char *psWorkspaceDir, const char *psRoot,
+  char *psIndexFile);
+TTrigramIndex *TrigramIndexLoad(const char *psIndexFile, const char *psRoot);
+BOOLEAN TrigramIndexUpdateFile(TTrigramIndex *pIndex, const char *psName,
+  const struct stat *pStat);
+void TrigramIndexPurge(TTrigramIndex *pIndex);
+int TrigramIndexGetNumFiles(const TTrigramIndex *pIndex);
+const char *TrigramIndexMatch(const TTrigramIndex *pIndex, int nFile,
+  const TTrigramQuery *pQuery);
+BOOLEAN TrigramIndexStore(TTrigramIndex *pIndex);
+void TrigramIndexDispose(TTrigramIndex *pIndex);
+
+#endif  /* TRIGRAM_H */
+
+/*
+This software is distributed under the conditions of the BSD style license.
+
+Copyright (c)
+1995-2002
+Petar Marinov
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the author may not be used to endorse or promote products
+   derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
@@ -7,6 +7,17 @@ Started: 6th August, 1999
 Descrition:
   Undo/Redo functions; Safe recovery file;
 
+  The data of the undo records of a file is kept within
+  nUndoMemoryLimit KB. Past the limit the data of the oldest records is
+  written to a temporary spill file and read back if Undo gets that far.
+
+  The file status before and after an action is packed in the record
+  as variable length numbers, the status after as differences. Small
+  single line data is kept in the record too, no block is allocated.
+
+  The recovery file is a journal of binary records, each with a CRC-32,
+  appended as the undo records are stored.
+
 */
 
 #include "global.h"
@@ -15,7 +26,8 @@ Descrition:
 #include "heapg.h"
 #include "memory.h"
 #include "block.h"
-#include "ini.h"  /* ValStr() */
+#include "tblocks.h"
+#include "recwrite.h"
 #include "undo.h"
 
 /* ************************************************************************
@@ -36,7 +48,13 @@ static void InitEmptyUndoRecord(TUndoRecord *pUndoRec)
 
   pUndoRec->bRecoveryStore = FALSE;
   pUndoRec->bUndone = FALSE;
+  pUndoRec->bInlineData = FALSE;
+  pUndoRec->bStatusOnHeap = FALSE;
+  pUndoRec->nStatusSize = 0;
+  pUndoRec->nInlineLen = 0;
   pUndoRec->pData = NULL;
+  pUndoRec->nDataSize = 0;
+  pUndoRec->nSpillPos = -1;
 }
 
 /* ************************************************************************
@@ -98,6 +116,242 @@ static void RestoreFileStatus(TFile *pFile, const TFileStatus *pStat)
   pFile->bUpdatePage = TRUE;
 }
 
+/* ************************************************************************
+   Function: PutPacked
+   Description:
+     Stores a number 7 bits per byte, the high bit marks that more
+     bytes follow. The sign is moved in the lowest bit so that small
+     negative numbers take a single byte too.
+*/
+static BYTE *PutPacked(BYTE *p, int n)
+{
+  unsigned int u;
+
+  u = ((unsigned int)n << 1) ^ (n < 0 ? ~0u : 0u);
+  while (u >= 0x80)
+  {
+    *p++ = (BYTE)(u | 0x80);
+    u >>= 7;
+  }
+  *p++ = (BYTE)u;
+  return p;
+}
+
+/* ************************************************************************
+   Function: GetPacked
+   Description:
+     Reads a number stored by PutPacked().
+*/
+static const BYTE *GetPacked(const BYTE *p, int *pn)
+{
+  unsigned int u;
+  int nShift;
+
+  u = 0;
+  nShift = 0;
+  do
+  {
+    u |= (unsigned int)(*p & 0x7f) << nShift;
+    nShift += 7;
+  }
+  while (*p++ & 0x80);
+  *pn = (int)((u >> 1) ^ (0u - (u & 1)));
+  return p;
+}
+
+#define UNDO_STATUS_FIELDS  11
+/* before: all the fields; after: mask of the changed fields and the changes */
+#define MAX_PACKED_STATUS  (2 * UNDO_STATUS_FIELDS * 5 + 2)
+
+/* ************************************************************************
+   Function: GetStatusFields
+   Description:
+     Puts the fields of a status in an array, the fields that change
+     with every action come first.
+*/
+static void GetStatusFields(const TFileStatus *pStat, int *pFields)
+{
+  pFields[0] = pStat->nCol;
+  pFields[1] = pStat->nRow;
+  pFields[2] = pStat->nNumberOfLines;
+  pFields[3] = (pStat->bChanged ? 1 : 0) | (pStat->bBlock ? 2 : 0);
+  pFields[4] = pStat->nTopLine;
+  pFields[5] = pStat->nWrtEdge;
+  pFields[6] = pStat->nStartLine;
+  pFields[7] = pStat->nEndLine;
+  pFields[8] = pStat->nStartPos;
+  pFields[9] = pStat->nEndPos;
+  pFields[10] = pStat->blockattr;
+}
+
+/* ************************************************************************
+   Function: SetStatusFields
+   Description:
+*/
+static void SetStatusFields(TFileStatus *pStat, const int *pFields)
+{
+  pStat->nCol = pFields[0];
+  pStat->nRow = pFields[1];
+  pStat->nNumberOfLines = pFields[2];
+  pStat->bChanged = (pFields[3] & 1) != 0;
+  pStat->bBlock = (pFields[3] & 2) != 0;
+  pStat->nTopLine = pFields[4];
+  pStat->nWrtEdge = pFields[5];
+  pStat->nStartLine = pFields[6];
+  pStat->nEndLine = pFields[7];
+  pStat->nStartPos = pFields[8];
+  pStat->nEndPos = pFields[9];
+  pStat->blockattr = (WORD)pFields[10];
+}
+
+/* ************************************************************************
+   Function: GetUndoStatusBuf
+   Description:
+     Returns where the packed status of a record is.
+*/
+static BYTE *GetUndoStatusBuf(const TUndoRecord *pUndoRec)
+{
+  BYTE *pBuf;
+
+  if (pUndoRec->bStatusOnHeap)
+  {
+    memcpy(&pBuf, pUndoRec->Packed, sizeof(pBuf));
+    return pBuf;
+  }
+  return (BYTE *)pUndoRec->Packed;
+}
+
+/* ************************************************************************
+   Function: GetUndoRecordStatus
+   Description:
+     Unpacks the status before and after the action of a record.
+     pBefore or pAfter can be NULL.
+*/
+void GetUndoRecordStatus(const TUndoRecord *pUndoRec,
+  TFileStatus *pBefore, TFileStatus *pAfter)
+{
+  int Before[UNDO_STATUS_FIELDS];
+  int After[UNDO_STATUS_FIELDS];
+  const BYTE *p;
+  int nMask;
+  int i;
+
+  ASSERT(VALID_PUNDOREC(pUndoRec));
+  ASSERT(pUndoRec->nStatusSize > 0);
+
+  p = GetUndoStatusBuf(pUndoRec);
+  for (i = 0; i < UNDO_STATUS_FIELDS; ++i)
+    p = GetPacked(p, &Before[i]);
+  p = GetPacked(p, &nMask);
+  for (i = 0; i < UNDO_STATUS_FIELDS; ++i)
+  {
+    After[i] = Before[i];
+    if (nMask & (1 << i))
+    {
+      p = GetPacked(p, &After[i]);
+      After[i] = (int)((unsigned int)After[i] + (unsigned int)Before[i]);
+    }
+  }
+
+  if (pBefore != NULL)
+    SetStatusFields(pBefore, Before);
+  if (pAfter != NULL)
+    SetStatusFields(pAfter, After);
+}
+
+/* ************************************************************************
+   Function: ReserveUndoStatus
+   Description:
+     Keeps a heap buffer ready for a status that doesn't fit in
+     TUndoRecord.Packed[]. This way updating the status after an
+     action already done can not fail.
+*/
+static BOOLEAN ReserveUndoStatus(TFile *pFile)
+{
+  if (pFile->pUndoStatusSpare == NULL)
+    pFile->pUndoStatusSpare = alloc(MAX_PACKED_STATUS);
+  return pFile->pUndoStatusSpare != NULL;
+}
+
+static BOOLEAN LoadUndoData(TFile *pFile, TUndoRecord *pUndoRec);
+
+/* ************************************************************************
+   Function: SetUndoRecordStatus
+   Description:
+     Packs the status before and after the action of a record.
+     Data kept in Packed[] is moved back in a block first.
+*/
+static BOOLEAN SetUndoRecordStatus(TFile *pFile, TUndoRecord *pUndoRec,
+  const TFileStatus *pBefore, const TFileStatus *pAfter)
+{
+  int Before[UNDO_STATUS_FIELDS];
+  int After[UNDO_STATUS_FIELDS];
+  BYTE Buf[MAX_PACKED_STATUS];
+  BYTE *pHeap;
+  BYTE *p;
+  int nMask;
+  int i;
+
+  ASSERT(VALID_PUNDOREC(pUndoRec));
+
+  if (pUndoRec->bInlineData)
+    if (!LoadUndoData(pFile, pUndoRec))
+      return FALSE;
+
+  GetStatusFields(pBefore, Before);
+  GetStatusFields(pAfter, After);
+
+  p = Buf;
+  nMask = 0;
+  for (i = 0; i < UNDO_STATUS_FIELDS; ++i)
+  {
+    p = PutPacked(p, Before[i]);
+    if (After[i] != Before[i])
+      nMask |= 1 << i;
+  }
+  p = PutPacked(p, nMask);
+  for (i = 0; i < UNDO_STATUS_FIELDS; ++i)
+    if (nMask & (1 << i))
+      p = PutPacked(p, (int)((unsigned int)After[i] - (unsigned int)Before[i]));
+  ASSERT(p - Buf <= MAX_PACKED_STATUS);
+
+  if (!pUndoRec->bStatusOnHeap && p - Buf > UNDO_PACKED_SIZE)
+  {
+    pHeap = pFile->pUndoStatusSpare;
+    pFile->pUndoStatusSpare = NULL;
+    if (pHeap == NULL)
+    {
+      pHeap = alloc(MAX_PACKED_STATUS);
+      if (pHeap == NULL)
+        return FALSE;
+    }
+    memcpy(pUndoRec->Packed, &pHeap, sizeof(pHeap));
+    pUndoRec->bStatusOnHeap = TRUE;
+  }
+
+  memcpy(GetUndoStatusBuf(pUndoRec), Buf, p - Buf);
+  pUndoRec->nStatusSize = p - Buf;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: RestoreUndoStatus
+   Description:
+     Restores the status of the file before or after the action
+     of a record.
+*/
+static void RestoreUndoStatus(TFile *pFile, const TUndoRecord *pUndoRec,
+  BOOLEAN bAfter)
+{
+  TFileStatus Stat;
+
+  if (bAfter)
+    GetUndoRecordStatus(pUndoRec, NULL, &Stat);
+  else
+    GetUndoRecordStatus(pUndoRec, &Stat, NULL);
+  RestoreFileStatus(pFile, &Stat);
+}
+
 /* ************************************************************************
    Function: GetLastRec
    Description:
@@ -112,28 +366,98 @@ static TUndoRecord *GetLastRec(const TFile *pFile)
   return &(pFile->pUndoIndex[pFile->nNumberOfRecords - 1]);
 }
 
+/* ************************************************************************
+   Function: GetLastDoneUndoID
+   Description:
+     Returns the ID of the last record that is not undone, -1 if
+     everything is undone. The records up to this ID describe the
+     present text of the file.
+*/
+int GetLastDoneUndoID(const TFile *pFile)
+{
+  int i;
+  const TUndoRecord *pUndoRec;
+
+  ASSERT(VALID_PFILE(pFile));
+
+  for (i = pFile->nNumberOfRecords - 1; i >= 0; --i)
+  {
+    pUndoRec = &pFile->pUndoIndex[i];
+    ASSERT(VALID_PUNDOREC(pUndoRec));
+    if (!pUndoRec->bUndone)
+      return pUndoRec->nUndoBlockID;
+  }
+  return -1;
+}
+
 /* ************************************************************************
    Function: PreOperation
    Description:
      Extract pre operation information from current file. The
      information is stored in the top undo record.
 */
-static void PreOperation(TFile *pFile, int nOperation)
+static BOOLEAN PreOperation(TFile *pFile, int nOperation)
 {
   TUndoRecord *pUndoRec;
+  TFileStatus Before;
 
   ASSERT(VALID_PFILE(pFile));
 
   pUndoRec = GetLastRec(pFile);
-  RecordFileStatus(pFile, &pUndoRec->before);
+  RecordFileStatus(pFile, &Before);
   pUndoRec->nOperation = nOperation;
+  return SetUndoRecordStatus(pFile, pUndoRec, &Before, &Before);
+}
+
+/* ************************************************************************
+   Function: CalcUndoDataSize
+   Description:
+     Calculates the memory taken by the data of an undo record.
+*/
+static int CalcUndoDataSize(const TUndoRecord *pUndoRec)
+{
+  const TBlock *pBlock;
+
+  if (pUndoRec->pData == NULL)
+    return 0;
+
+  switch (pUndoRec->nOperation)
+  {
+    case acINSERT:
+    case acDELETE:
+    case acREPLACE:
+      pBlock = pUndoRec->pData;
+      return sizeof(TBlock) + pBlock->nNumberOfLines * sizeof(TLine) +
+        (pBlock->pBlock != NULL ? GetTBlockSize(pBlock->pBlock) : 0);
+    case acREARRANGE:
+    case acREARRANGEBACK:
+      return (pUndoRec->nEnd - pUndoRec->nStart + 1) * sizeof(int);
+    default:
+      ASSERT(0);
+  }
+  return 0;
+}
+
+/* ************************************************************************
+   Function: UpdateUndoDataSize
+   Description:
+     Brings TFile.nUndoMemory up to date after the data of a record
+     was set or changed.
+*/
+static void UpdateUndoDataSize(TFile *pFile, TUndoRecord *pUndoRec)
+{
+  int nDataSize;
+
+  nDataSize = CalcUndoDataSize(pUndoRec);
+  pFile->nUndoMemory += nDataSize - pUndoRec->nDataSize;
+  pUndoRec->nDataSize = nDataSize;
 }
 
 /* ************************************************************************
    Function: DisposeUndoRecord
    Description:
 */
-static void DisposeUndoRecord(TUndoRecord *pUndoRec)
+static void DisposeUndoRecord(TFile *pFile, TUndoRecord *pUndoRec)
 {
   ASSERT(VALID_PUNDOREC(pUndoRec));
 
@@ -155,12 +479,381 @@ static void DisposeUndoRecord(TUndoRecord *pUndoRec)
         ASSERT(0);
     }
   }
+  pFile->nUndoMemory -= pUndoRec->nDataSize;
+  pUndoRec->nDataSize = 0;
+  if (pUndoRec->bStatusOnHeap)
+  {
+    s_free(GetUndoStatusBuf(pUndoRec));
+    pUndoRec->bStatusOnHeap = FALSE;
+  }
+  pUndoRec->bInlineData = FALSE;
+  pUndoRec->nStatusSize = 0;
 
   #ifdef _DEBUG
   pUndoRec->MagicByte = UNDOREC_MAGIC - 1;
   #endif
 }
 
+/* ************************************************************************
+   Function: WriteSpill
+   Description:
+*/
+static BOOLEAN WriteSpill(FILE *f, const void *pData, int nSize)
+{
+  return fwrite(pData, 1, nSize, f) == (size_t)nSize;
+}
+
+/* ************************************************************************
+   Function: ReadSpill
+   Description:
+*/
+static BOOLEAN ReadSpill(FILE *f, void *pData, int nSize)
+{
+  return fread(pData, 1, nSize, f) == (size_t)nSize;
+}
+
+/* ************************************************************************
+   Function: SpillUndoData
+   Description:
+     Moves the data of an undo record to the spill file of the file.
+     A block is stored as number of lines, EOL type, block attributes,
+     size of the text and then the length and the text of every line.
+     The data that is already in the spill file (it was read back but
+     not changed since) is only disposed.
+*/
+static BOOLEAN SpillUndoData(TFile *pFile, TUndoRecord *pUndoRec)
+{
+  FILE *f;
+  TBlock *pBlock;
+  TLine *pLine;
+  int Header[4];
+  int i;
+
+  ASSERT(VALID_PUNDOREC(pUndoRec));
+  ASSERT(pUndoRec->pData != NULL);
+
+  if (pUndoRec->nSpillPos != -1)
+    goto _dispose;
+
+  if (pFile->fUndoSpill == NULL)
+  {
+    pFile->fUndoSpill = tmpfile();
+    if (pFile->fUndoSpill == NULL)
+      return FALSE;
+  }
+  f = pFile->fUndoSpill;
+  if (fseek(f, pFile->nUndoSpillSize, SEEK_SET) != 0)
+    return FALSE;
+
+  switch (pUndoRec->nOperation)
+  {
+    case acINSERT:
+    case acDELETE:
+    case acREPLACE:
+      pBlock = pUndoRec->pData;
+      Header[0] = pBlock->nNumberOfLines;
+      Header[1] = pBlock->nEOLType;
+      Header[2] = pBlock->blockattr;
+      Header[3] = 0;
+      for (i = 0; i < pBlock->nNumberOfLines; ++i)
+        Header[3] += GetBlockLine(pBlock, i)->nLen + 1;
+      if (!WriteSpill(f, Header, sizeof(Header)))
+        return FALSE;
+      for (i = 0; i < pBlock->nNumberOfLines; ++i)
+      {
+        pLine = GetBlockLine(pBlock, i);
+        if (!WriteSpill(f, &pLine->nLen, sizeof(int)))
+          return FALSE;
+        if (!WriteSpill(f, pLine->pLine, pLine->nLen))
+          return FALSE;
+      }
+      break;
+    case acREARRANGE:
+    case acREARRANGEBACK:
+      if (!WriteSpill(f, pUndoRec->pData,
+        (pUndoRec->nEnd - pUndoRec->nStart + 1) * sizeof(int)))
+        return FALSE;
+      break;
+    default:
+      ASSERT(0);
+  }
+  if (fflush(f) != 0)
+    return FALSE;
+
+  pUndoRec->nSpillPos = pFile->nUndoSpillSize;
+  pFile->nUndoSpillSize = ftell(f);
+
+_dispose:
+  switch (pUndoRec->nOperation)
+  {
+    case acINSERT:
+    case acDELETE:
+    case acREPLACE:
+      DisposeABlock((TBlock **)&pUndoRec->pData);
+      break;
+    default:
+      s_free(pUndoRec->pData);
+      pUndoRec->pData = NULL;
+  }
+  UpdateUndoDataSize(pFile, pUndoRec);
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: AllocUndoBlock
+   Description:
+     Allocates a block of nNumberOfLines lines and nTextSize bytes
+     of text. The lines, the reference counter of the text and the
+     count of the index are to be set by the caller.
+*/
+static TBlock *AllocUndoBlock(int nNumberOfLines, int nTextSize)
+{
+  TBlock *pBlock;
+
+  pBlock = AllocTBlock();
+  if (pBlock == NULL)
+    return NULL;
+  pBlock->nNumberOfLines = nNumberOfLines;
+  pBlock->pBlock = AllocateTBlock(nTextSize);
+  if (pBlock->pBlock == NULL)
+  {
+_dispose_pBlock:
+    FreeTBlock(pBlock);
+    return NULL;
+  }
+  TArrayInit(pBlock->pIndex, nNumberOfLines, 1);
+  if (pBlock->pIndex == NULL)
+  {
+    DisposeBlock(pBlock->pBlock);
+    goto _dispose_pBlock;
+  }
+  return pBlock;
+}
+
+/* ************************************************************************
+   Function: ReadSpilledBlock
+   Description:
+     Reads a block stored by SpillUndoData().
+*/
+static TBlock *ReadSpilledBlock(FILE *f)
+{
+  TBlock *pBlock;
+  TLine *pLine;
+  char *p;
+  int Header[4];
+  int i;
+
+  if (!ReadSpill(f, Header, sizeof(Header)))
+    return NULL;
+
+  pBlock = AllocUndoBlock(Header[0], Header[3] + 1);
+  if (pBlock == NULL)
+    return NULL;
+  pBlock->nEOLType = Header[1];
+  pBlock->blockattr = (WORD)Header[2];
+
+  p = pBlock->pBlock;
+  for (i = 0; i < pBlock->nNumberOfLines; ++i)
+  {
+    pLine = &pBlock->pIndex[i];
+    if (!ReadSpill(f, &pLine->nLen, sizeof(int)) ||
+      pLine->nLen < 0 || p + pLine->nLen >= pBlock->pBlock + Header[3] + 1 ||
+      !ReadSpill(f, p, pLine->nLen))
+    {
+      TArrayDispose(pBlock->pIndex);
+      DisposeBlock(pBlock->pBlock);
+      FreeTBlock(pBlock);
+      return NULL;
+    }
+    p[pLine->nLen] = '\0';
+    pLine->pLine = p;
+    pLine->pFileBlock = pBlock->pBlock;
+    pLine->attr = 0;
+    p += pLine->nLen + 1;
+  }
+
+  if (pBlock->nNumberOfLines > 0)
+    IncRef(pBlock->pBlock, pBlock->nNumberOfLines);
+  TArraySetCount(pBlock->pIndex, pBlock->nNumberOfLines);
+  return pBlock;
+}
+
+/* ************************************************************************
+   Function: PackUndoData
+   Description:
+     Moves the text of a small single line character block in
+     Packed[] of the record, after the status, and disposes the block.
+     Packed[] keeps the EOL type of the block and the text.
+*/
+static void PackUndoData(TFile *pFile, TUndoRecord *pUndoRec)
+{
+  TBlock *pBlock;
+  TLine *pLine;
+  BYTE *p;
+
+  ASSERT(VALID_PUNDOREC(pUndoRec));
+
+  if (pUndoRec->pData == NULL || pUndoRec->nSpillPos != -1)
+    return;  /* No data or the data is in the spill file already */
+  if (pUndoRec->bStatusOnHeap)
+    return;
+  if (pUndoRec->nOperation != acINSERT &&
+    pUndoRec->nOperation != acDELETE &&
+    pUndoRec->nOperation != acREPLACE)
+    return;
+
+  pBlock = pUndoRec->pData;
+  if (pBlock->nNumberOfLines != 1 || pBlock->blockattr != 0)
+    return;
+  pLine = GetBlockLine(pBlock, 0);
+  if (pUndoRec->nStatusSize + 1 + pLine->nLen > UNDO_PACKED_SIZE)
+    return;
+
+  p = &pUndoRec->Packed[pUndoRec->nStatusSize];
+  *p++ = (BYTE)pBlock->nEOLType;
+  memcpy(p, pLine->pLine, pLine->nLen);
+  pUndoRec->nInlineLen = pLine->nLen;
+  pUndoRec->bInlineData = TRUE;
+  DisposeABlock((TBlock **)&pUndoRec->pData);
+  UpdateUndoDataSize(pFile, pUndoRec);
+}
+
+/* ************************************************************************
+   Function: UnpackUndoData
+   Description:
+     Makes a block of the text kept in Packed[] by PackUndoData().
+*/
+static TBlock *UnpackUndoData(const TUndoRecord *pUndoRec)
+{
+  TBlock *pBlock;
+  TLine *pLine;
+  const BYTE *p;
+
+  ASSERT(pUndoRec->bInlineData);
+
+  p = &pUndoRec->Packed[pUndoRec->nStatusSize];
+  pBlock = AllocUndoBlock(1, pUndoRec->nInlineLen + 1);
+  if (pBlock == NULL)
+    return NULL;
+  pBlock->nEOLType = (signed char)*p++;
+  pBlock->blockattr = 0;
+
+  memcpy(pBlock->pBlock, p, pUndoRec->nInlineLen);
+  pBlock->pBlock[pUndoRec->nInlineLen] = '\0';
+  pLine = &pBlock->pIndex[0];
+  pLine->pLine = pBlock->pBlock;
+  pLine->pFileBlock = pBlock->pBlock;
+  pLine->nLen = pUndoRec->nInlineLen;
+  pLine->attr = 0;
+
+  IncRef(pBlock->pBlock, 1);
+  TArraySetCount(pBlock->pIndex, 1);
+  return pBlock;
+}
+
+/* ************************************************************************
+   Function: LoadUndoData
+   Description:
+     Reads back the data of a record from the spill file or
+     makes a block of the data kept in the record.
+   Returns:
+     FALSE -- no memory or the spill file can not be read.
+*/
+static BOOLEAN LoadUndoData(TFile *pFile, TUndoRecord *pUndoRec)
+{
+  FILE *f;
+  int nSize;
+  int nRecord;
+
+  ASSERT(VALID_PUNDOREC(pUndoRec));
+
+  if (pUndoRec->bInlineData)
+  {
+    pUndoRec->pData = UnpackUndoData(pUndoRec);
+    if (pUndoRec->pData == NULL)
+      return FALSE;
+    pUndoRec->bInlineData = FALSE;
+    pUndoRec->nInlineLen = 0;
+    UpdateUndoDataSize(pFile, pUndoRec);
+    return TRUE;
+  }
+
+  if (!UNDO_DATA_SPILLED(pUndoRec))
+    return TRUE;
+
+  f = pFile->fUndoSpill;
+  ASSERT(f != NULL);
+  if (fseek(f, pUndoRec->nSpillPos, SEEK_SET) != 0)
+    return FALSE;
+
+  switch (pUndoRec->nOperation)
+  {
+    case acINSERT:
+    case acDELETE:
+    case acREPLACE:
+      pUndoRec->pData = ReadSpilledBlock(f);
+      break;
+    case acREARRANGE:
+    case acREARRANGEBACK:
+      nSize = (pUndoRec->nEnd - pUndoRec->nStart + 1) * sizeof(int);
+      pUndoRec->pData = alloc(nSize);
+      if (pUndoRec->pData == NULL)
+        break;
+      if (!ReadSpill(f, pUndoRec->pData, nSize))
+      {
+        s_free(pUndoRec->pData);
+        pUndoRec->pData = NULL;
+      }
+      break;
+    default:
+      ASSERT(0);
+  }
+  if (pUndoRec->pData == NULL)
+    return FALSE;
+
+  UpdateUndoDataSize(pFile, pUndoRec);
+  nRecord = pUndoRec - pFile->pUndoIndex;
+  if (nRecord < pFile->nUndoSpillStart)
+    pFile->nUndoSpillStart = nRecord;
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: LimitUndoMemory
+   Description:
+     Moves the data of the oldest records in the spill file until
+     the undo data of the file fits in nUndoMemoryLimit.
+     The last two records are kept for ConcatContinuous().
+*/
+static void LimitUndoMemory(TFile *pFile)
+{
+  TUndoRecord *pUndoRec;
+  long nLimit;
+  int i;
+
+  if (nUndoMemoryLimit == 0)
+    return;  /* No limit */
+  nLimit = (long)nUndoMemoryLimit * 1024;
+  if (pFile->nUndoMemory <= nLimit)
+    return;
+
+  if (pFile->nUndoSpillStart > pFile->nNumberOfRecords)
+    pFile->nUndoSpillStart = pFile->nNumberOfRecords;
+  i = pFile->nUndoSpillStart;
+  while (pFile->nUndoMemory > nLimit && i < pFile->nNumberOfRecords - 2)
+  {
+    pUndoRec = &pFile->pUndoIndex[i];
+    ASSERT(VALID_PUNDOREC(pUndoRec));
+    if (pUndoRec->bUndone)
+      break;
+    if (pUndoRec->pData != NULL)
+      if (!SpillUndoData(pFile, pUndoRec))
+        break;  /* Keep it in memory, will try again next time */
+    ++i;
+  }
+  pFile->nUndoSpillStart = i;
+}
+
 /* ************************************************************************
    Function: RemoveUndoneBlocks
    Description:
@@ -201,7 +894,7 @@ static void RemoveUndoneBlocks(TFile *pFile)
         bLoop2 = TRUE;
         break;
       }
-      DisposeUndoRecord(pUndoRec);
+      DisposeUndoRecord(pFile, pUndoRec);
     }
   }
   while (bUndone && i > 0);
@@ -238,7 +931,11 @@ static void RemoveUndoneBlocks(TFile *pFile)
     bUndone = pUndoRec->bUndone;  /* Will be necessary after the record is disposed */
     ASSERT(VALID_PUNDOREC(pUndoRec));
     if (bUndone)  /* Dispose the undone blocks */
-      DisposeUndoRecord(pUndoRec);
+    {
+      if (pUndoRec->nUndoBlockID <= pFile->nDiskUndoID)
+        pFile->nDiskUndoID = UNDO_DISK_LOST;  /* No way back to the disk text */
+      DisposeUndoRecord(pFile, pUndoRec);
+    }
   }
   while (bUndone && i > 0);
 
@@ -287,6 +984,9 @@ BOOLEAN AddUndoRecord(TFile *pFile, int nOperation, BOOLEAN bLoad)
   ASSERT(pFile->nUndoLevel > 0);
   ASSERT(pFile->nNumberOfRecords >= 0);
 
+  if (!ReserveUndoStatus(pFile))
+    return FALSE;
+
   if (!bLoad)
     RemoveUndoneBlocks(pFile);
 
@@ -305,7 +1005,24 @@ BOOLEAN AddUndoRecord(TFile *pFile, int nOperation, BOOLEAN bLoad)
 
   ++pFile->nNumberOfRecords;
 
-  PreOperation(pFile, nOperation);
+  /*
+  The status after the operation will need the heap if it doesn't
+  fit in the record, reserve it now when the operation can fail
+  */
+  if (!PreOperation(pFile, nOperation) || !ReserveUndoStatus(pFile))
+  {
+    DisposeUndoRecord(pFile, GetLastRec(pFile));
+    TArrayDeleteGroup(pFile->pUndoIndex, pFile->nNumberOfRecords - 1, 1);
+    --pFile->nNumberOfRecords;
+    return FALSE;
+  }
+
+  /*
+  The record below the previous can't be combined any more,
+  keep its data in the record if small enough
+  */
+  if (!bLoad && pFile->nNumberOfRecords >= 3)
+    PackUndoData(pFile, &pFile->pUndoIndex[pFile->nNumberOfRecords - 3]);
 
   return TRUE;
 }
@@ -332,26 +1049,90 @@ void RecordUndoData(TFile *pFile, void *pBlock,
   pUndoRec->nStartPos = nStartPos;
   pUndoRec->nEnd = nEndLine;
   pUndoRec->nEndPos = nEndPos;
+  UpdateUndoDataSize(pFile, pUndoRec);
+}
+
+/* ************************************************************************
+   Function: ExtendUndoText
+   Description:
+     Adds text at the start or at the end of the single line of
+     an undo block. The text of the block is reallocated with as much
+     free room again at the side that grows, so that continuous typing
+     of n characters takes O(n) time in total.
+     The block belongs only to the undo record and the line may
+     start anywhere inside the memory block.
+*/
+static BOOLEAN ExtendUndoText(TBlock *pBlock, const char *pText, int nLen,
+  BOOLEAN bAppend)
+{
+  TLine *pLine;
+  char *pNewText;
+  int nFront;
+  int nBack;
+  int nSize;
+
+  ASSERT(VALID_PBLOCK(pBlock));
+  ASSERT(pBlock->nNumberOfLines == 1);
+  ASSERT(nLen >= 0);
+
+  pLine = GetBlockLine(pBlock, 0);
+  ASSERT(pLine->pFileBlock == pBlock->pBlock);
+  nFront = pLine->pLine - pBlock->pBlock;
+  nBack = GetTBlockSize(pBlock->pBlock) - nFront - pLine->nLen - 1;
+  if ((bAppend && nBack < nLen) || (!bAppend && nFront < nLen))
+  {
+    nSize = (pLine->nLen + nLen) * 2 + 1;
+    pNewText = AllocateTBlock(nSize);
+    if (pNewText == NULL)
+      return FALSE;
+    if (bAppend)
+      nFront = 0;
+    else
+      nFront = nSize - pLine->nLen - 1;
+    memcpy(pNewText + nFront, pLine->pLine, pLine->nLen + 1);
+    DisposeBlock(pBlock->pBlock);
+    IncRef(pNewText, 1);
+    pBlock->pBlock = pNewText;
+    pLine->pLine = pNewText + nFront;
+    pLine->pFileBlock = pNewText;
+  }
+
+  if (bAppend)
+  {
+    memcpy(pLine->pLine + pLine->nLen, pText, nLen);
+    pLine->pLine[pLine->nLen + nLen] = '\0';
+  }
+  else
+  {
+    pLine->pLine -= nLen;
+    memcpy(pLine->pLine, pText, nLen);
+  }
+  pLine->nLen += nLen;
+  return TRUE;
 }
 
 /* ************************************************************************
    Function: CombineUndoBlocks
    Description:
      Combines the top two blocks in the undo index list:
-     1. Combines undo blocks data
+     1. Adds the text of the last block to the block of the previous
      2. Combines new block data coordinates (nStart, nStartPos, nEnd, nEndPos)
      3. Combines undo blocks 'before' and 'after' snapshots information.
-     4. Inserts	this new block in the undo block lists
-     5. Removes the old 2 blocks.
+     4. Removes the last block.
+     The previous record is updated in place, the text of its block
+     grows by ExtendUndoText().
 */
 static void CombineUndoBlocks(TFile *pFile, BOOLEAN bStright)
 {
-  TUndoRecord UndoRec;
-  TBlock *pBlock;
   TUndoRecord *pUndoLast;
   TUndoRecord *pUndoPrev;
-  TLine *pLine1;
   TLine *pLine2;
+  TFileStatus Before;
+  TFileStatus After;
+  int nStart;
+  int nStartPos;
+  int nEnd;
+  int nEndPos;
 
   ASSERT(VALID_PFILE(pFile));
 
@@ -364,40 +1145,33 @@ static void CombineUndoBlocks(TFile *pFile, BOOLEAN bStright)
   ASSERT(VALID_PUNDOREC(pUndoLast));
   ASSERT(VALID_PUNDOREC(pUndoPrev));
   ASSERT(!pUndoPrev->bUndone);  /* As all undone blocks are already removed */
+
+  if (!LoadUndoData(pFile, pUndoPrev) || !ReserveUndoStatus(pFile))
+    return;  /* No memory, keep the two records */
+  pUndoPrev->nSpillPos = -1;  /* The data changes */
+
   ASSERT(((TBlock *)pUndoLast->pData)->nNumberOfLines == 1);
   ASSERT(((TBlock *)pUndoPrev->pData)->nNumberOfLines == 1);
 
-  InitEmptyUndoRecord(&UndoRec);
-  UndoRec.nUndoBlockID = pFile->nUndoIDCounter++;
-
-  pLine1 = GetBlockLine((TBlock *)pUndoPrev->pData, 0);
   pLine2 = GetBlockLine((TBlock *)pUndoLast->pData, 0);
+  if (!ExtendUndoText((TBlock *)pUndoPrev->pData,
+    pLine2->pLine, pLine2->nLen, bStright))
+    return;  /* No memory, keep the two records */
+
   if (bStright)
   {
-    pBlock = DuplicateBlock((TBlock *)pUndoPrev->pData, pFile->nEOLType, 0,
-      pLine2->nLen, 0, NULL);
-    strcat(pBlock->pBlock, pLine2->pLine);
-    UndoRec.nStart = pUndoPrev->nStart;
-    UndoRec.nStartPos = pUndoPrev->nStartPos;
-    UndoRec.nEnd = pUndoLast->nEnd;
-    UndoRec.nEndPos = pUndoLast->nEndPos;
+    nStart = pUndoPrev->nStart;
+    nStartPos = pUndoPrev->nStartPos;
+    nEnd = pUndoLast->nEnd;
+    nEndPos = pUndoLast->nEndPos;
   }
   else
   {
-    pBlock = DuplicateBlock((TBlock *)pUndoLast->pData, pFile->nEOLType, 0,
-      pLine1->nLen, 0, NULL);
-    strcat(pBlock->pBlock, pLine1->pLine);
-    UndoRec.nStart = pUndoLast->nStart;
-    UndoRec.nStartPos = pUndoLast->nStartPos;
-    UndoRec.nEnd = pUndoPrev->nEnd;
-    UndoRec.nEndPos = pUndoPrev->nEndPos;
-  }
-  GetBlockLine(pBlock, 0)->nLen = strlen(pBlock->pBlock);
-  UndoRec.pData = pBlock;
-  UndoRec.nOperation = pUndoPrev->nOperation;
-  UndoRec.nUndoLevel = pUndoLast->nUndoLevel;
-  memcpy(&UndoRec.before, &pUndoPrev->before, sizeof(TFileStatus));
-  memcpy(&UndoRec.after, &pUndoLast->after, sizeof(TFileStatus));
+    nStart = pUndoLast->nStart;
+    nStartPos = pUndoLast->nStartPos;
+    nEnd = pUndoPrev->nEnd;
+    nEndPos = pUndoPrev->nEndPos;
+  }
   if (pUndoPrev->nStartPos == pUndoLast->nStartPos)
   {
     /*
@@ -406,30 +1180,28 @@ static void CombineUndoBlocks(TFile *pFile, BOOLEAN bStright)
     Make the range pUndo->nStartPos..pUndo->nEndPos to comprise the
     whole combined block!
     */
-    UndoRec.nEndPos = UndoRec.nEndPos +
+    nEndPos = nEndPos +
       (pUndoPrev->nEndPos - pUndoLast->nStartPos + 1)
       + (pUndoLast->nEndPos - pUndoLast->nStartPos);
   }
 
-  /*
-  Remove 2 undo entries from the top of undo list
-  */
-  DisposeUndoRecord(pUndoLast);
-  DisposeUndoRecord(pUndoPrev);
-  TArrayDeleteGroup(pFile->pUndoIndex, pFile->nNumberOfRecords - 2, 2);
-  pFile->nNumberOfRecords -= 2;
+  pUndoPrev->nUndoBlockID = pFile->nUndoIDCounter++;
+  pUndoPrev->nStart = nStart;
+  pUndoPrev->nStartPos = nStartPos;
+  pUndoPrev->nEnd = nEnd;
+  pUndoPrev->nEndPos = nEndPos;
+  pUndoPrev->nUndoLevel = pUndoLast->nUndoLevel;
+  GetUndoRecordStatus(pUndoPrev, &Before, NULL);
+  GetUndoRecordStatus(pUndoLast, NULL, &After);
+  SetUndoRecordStatus(pFile, pUndoPrev, &Before, &After);  /* Uses the reserve */
+  UpdateUndoDataSize(pFile, pUndoPrev);
 
   /*
-  Add the new record at the top of the undo list index
+  Remove the last entry from the top of undo list
   */
-  TArrayAdd(pFile->pUndoIndex, UndoRec);
-  if (!TArrayStatus(pFile->pUndoIndex))
-  {
-    TArrayClearStatus(pFile->pUndoIndex);
-    return;
-  }
-  ++pFile->nNumberOfRecords;
-  return;
+  DisposeUndoRecord(pFile, pUndoLast);
+  TArrayDeleteGroup(pFile->pUndoIndex, pFile->nNumberOfRecords - 1, 1);
+  --pFile->nNumberOfRecords;
 }
 
 /* ************************************************************************
@@ -458,6 +1230,10 @@ static void ConcatContinuous(TFile *pFile)
 
   if (pUndoPrev->bRecoveryStore)
     return;  /* Last block is already in the recovery file */
+  if (pFile->pSaveJob != NULL && pUndoPrev->nUndoBlockID <= pFile->nSaveUndoID)
+    return;  /* Last block is in the text being stored, see StoreFile() */
+  if (UNDO_DATA_SPILLED(pUndoPrev))
+    return;  /* In the spill file */
   if (pUndoLast->nEnd - pUndoLast->nStart != 0)
     return;  /* Combine only single line actions */
   if (pUndoPrev->nEnd - pUndoPrev->nStart != 0)
@@ -527,6 +1303,8 @@ static void ConcatContinuous(TFile *pFile)
 void PostOperation(TFile *pFile)
 {
   TUndoRecord *pUndoRec;
+  TFileStatus Before;
+  TFileStatus After;
 
   ASSERT(pFile->nUndoLevel > 0);
 
@@ -538,12 +1316,16 @@ void PostOperation(TFile *pFile)
       /*
       Operation failed. Remove last undo record entry.
       */
+      DisposeUndoRecord(pFile, pUndoRec);
       TArrayDeleteGroup(pFile->pUndoIndex, pFile->nNumberOfRecords - 1, 1);
+      --pFile->nNumberOfRecords;
       return;
     }
   }
 
-  RecordFileStatus(pFile, &pUndoRec->after);
+  GetUndoRecordStatus(pUndoRec, &Before, NULL);
+  RecordFileStatus(pFile, &After);
+  SetUndoRecordStatus(pFile, pUndoRec, &Before, &After);  /* Reserved by AddUndoRecord() */
   pUndoRec->nUndoLevel = pFile->nUndoLevel;  /* Start/End of atom marker if = 1 */
 
   /*
@@ -551,6 +1333,9 @@ void PostOperation(TFile *pFile)
   */
   if (bCombineUndo)
     ConcatContinuous(pFile);
+
+  if (pFile->nUndoLevel == 1)
+    LimitUndoMemory(pFile);
 }
 
 /* ************************************************************************
@@ -566,17 +1351,34 @@ void DisposeUndoIndexData(TFile *pFile)
 
   ASSERT(VALID_PFILE(pFile));
 
+  CloseRecoveryJournal(pFile);
+
   if (pFile->pUndoIndex == NULL)
     return;  /* Undo record in empty! */
 
   for (i = 0; i < pFile->nNumberOfRecords;  ++i)
   {
     pUndoRec = &pFile->pUndoIndex[i];
-    DisposeUndoRecord(pUndoRec);
+    DisposeUndoRecord(pFile, pUndoRec);
   }
   ASSERT(pFile->nNumberOfRecords == _TArrayCount(pFile->pUndoIndex));
+  ASSERT(pFile->nUndoMemory == 0);
 
   TArrayDispose(pFile->pUndoIndex);
+
+  if (pFile->fUndoSpill != NULL)
+  {
+    fclose(pFile->fUndoSpill);
+    pFile->fUndoSpill = NULL;
+  }
+  pFile->nUndoSpillSize = 0;
+  pFile->nUndoSpillStart = 0;
+
+  if (pFile->pUndoStatusSpare != NULL)
+  {
+    s_free(pFile->pUndoStatusSpare);
+    pFile->pUndoStatusSpare = NULL;
+  }
 }
 
 /* ************************************************************************
@@ -600,11 +1402,43 @@ void RemoveLastUndoRecord(TFile *pFile)
   if (pUndoRec->nUndoLevel < pFile->nUndoLevel)
     return;  /* No extra record added that is to be removed */
 
-  DisposeUndoRecord(pUndoRec);
+  DisposeUndoRecord(pFile, pUndoRec);
   TArrayDeleteGroup(pFile->pUndoIndex, pFile->nNumberOfRecords - 1, 1);
   --pFile->nNumberOfRecords;
 
-  ASSERT(pFile->nNumberOfRecords == _TArrayCount(pFile->pUndoIndex));
+  ASSERT(pFile->nNumberOfRecords == _TArrayCount(pFile->pUndoIndex));
+}
+
+/* ************************************************************************
+   Function: LoadAtomData
+   Description:
+     Loads the data of the records nFirst..nLast of an atom before
+     Undo() or Redo() applies any of them.
+   Returns:
+     FALSE -- no memory or the spill file can not be read, the records
+     are left as they were and the atom is not to be applied.
+*/
+static BOOLEAN LoadAtomData(TFile *pFile, int nFirst, int nLast)
+{
+  TUndoRecord *pUndoRec;
+  int i;
+
+  for (i = nFirst; i <= nLast; ++i)
+  {
+    if (!LoadUndoData(pFile, &pFile->pUndoIndex[i]))
+    {
+      while (--i >= nFirst)
+      {
+        pUndoRec = &pFile->pUndoIndex[i];
+        if (pUndoRec->nSpillPos != -1)
+          SpillUndoData(pFile, pUndoRec);  /* Only disposes the copy */
+        else
+          PackUndoData(pFile, pUndoRec);
+      }
+      return FALSE;
+    }
+  }
+  return TRUE;
 }
 
 /* ************************************************************************
@@ -622,8 +1456,10 @@ void RemoveLastUndoRecord(TFile *pFile)
 void Undo(TFile *pFile)
 {
   int i;
+  int nFirst;
   char *p;
   TUndoRecord *pUndoRec;
+  TFileStatus After;
   BOOLEAN bSplitAtom;
   BOOLEAN bResult;
 
@@ -645,15 +1481,26 @@ void Undo(TFile *pFile)
   /*
   Check whether we are at the exact position.
   */
-  if (pUndoRec->after.nCol != pFile->nCol ||
-    pUndoRec->after.nRow != pFile->nRow)
+  GetUndoRecordStatus(pUndoRec, NULL, &After);
+  if (After.nCol != pFile->nCol ||
+    After.nRow != pFile->nRow)
   {
-    RestoreFileStatus(pFile, &pUndoRec->after);
+    RestoreFileStatus(pFile, &After);
     return;
     /* This was the first step. Now the user have to invoke UNDO again in order
     to actualy undo the operation. */
   }
 
+  /*
+  Load the data of the whole atom first, a half undone atom
+  can not be brought back.
+  */
+  nFirst = i;
+  while (nFirst > 0 && pFile->pUndoIndex[nFirst - 1].nUndoLevel > 1)
+    --nFirst;
+  if (!LoadAtomData(pFile, nFirst, i))
+    return;  /* No memory or the spill file can't be read */
+
   /*
   Undo the atom operation stored in undo record index
   starting from the item pointed by pUndoRec.
@@ -661,6 +1508,7 @@ void Undo(TFile *pFile)
   bSplitAtom = FALSE;
   do
   {
+    pUndoRec->nSpillPos = -1;  /* Undo may change the data */
     ASSERT(pUndoRec->pData != NULL);
 
     switch (pUndoRec->nOperation)
@@ -699,7 +1547,7 @@ void Undo(TFile *pFile)
       case acREPLACE:  /* Revert replace operation -> replace back */
         ASSERT(((TBlock *)(pUndoRec->pData))->nNumberOfLines = 1);
         /* Replace operates at the same position in do/undo/redo */
-        RestoreFileStatus(pFile, &pUndoRec->before);
+        RestoreUndoStatus(pFile, pUndoRec, FALSE);
         p = GetBlockLineText((TBlock *)pUndoRec->pData, 0);
         ReplaceTextPrim(pFile, p, p);
         /* As a result of this operation in pUndoRec->pData
@@ -720,9 +1568,12 @@ void Undo(TFile *pFile)
         ASSERT(0);
     }
 
+    UpdateUndoDataSize(pFile, pUndoRec);
+    PackUndoData(pFile, pUndoRec);
+
     if (!bSplitAtom)  /* If Undo was successfull */
     {
-      RestoreFileStatus(pFile, &pUndoRec->before);
+      RestoreUndoStatus(pFile, pUndoRec, FALSE);
       pUndoRec->bUndone = TRUE;
     }
 
@@ -732,7 +1583,7 @@ void Undo(TFile *pFile)
 
     pUndoRec = &(pFile->pUndoIndex[i]);
     ASSERT(VALID_PUNDOREC(pUndoRec));
-    ASSERT(pUndoRec->pData != NULL);
+    ASSERT(UNDO_HAS_DATA(pUndoRec));
 
     if (bSplitAtom)
       pUndoRec->nUndoLevel = 1;
@@ -749,8 +1600,10 @@ void Undo(TFile *pFile)
 void Redo(TFile *pFile)
 {
   int i;
+  int nLast;
   char *p;
   TUndoRecord *pUndoRec;
+  TFileStatus Before;
   BOOLEAN bSplitAtom;
   BOOLEAN bResult;
 
@@ -779,15 +1632,26 @@ void Redo(TFile *pFile)
   */
   pUndoRec = &(pFile->pUndoIndex[i]);
   ASSERT(VALID_PUNDOREC(pUndoRec));
-  if (pUndoRec->before.nCol != pFile->nCol ||
-    pUndoRec->before.nRow != pFile->nRow)
+  GetUndoRecordStatus(pUndoRec, &Before, NULL);
+  if (Before.nCol != pFile->nCol ||
+    Before.nRow != pFile->nRow)
   {
-    RestoreFileStatus(pFile, &pUndoRec->before);
+    RestoreFileStatus(pFile, &Before);
     return;
     /* This was the first step. Now the user have to invoke REDO again in order
     to actualy redo the operation. */
   }
 
+  /*
+  Load the data of the whole atom first, see Undo()
+  */
+  nLast = i;
+  while (nLast < pFile->nNumberOfRecords - 1 &&
+    pFile->pUndoIndex[nLast].nUndoLevel != 1)
+    ++nLast;
+  if (!LoadAtomData(pFile, i, nLast))
+    return;  /* No memory or the spill file can't be read */
+
   /*
   redo the atom operation stored in undo record index
   starting from the item pointed by index _i_;
@@ -795,6 +1659,7 @@ void Redo(TFile *pFile)
   bSplitAtom = FALSE;
   while (1)
   {
+    pUndoRec->nSpillPos = -1;  /* Redo may change the data */
     ASSERT(pUndoRec->pData != NULL);
 
     switch (pUndoRec->nOperation)
@@ -853,9 +1718,12 @@ void Redo(TFile *pFile)
         ASSERT(0);
     }
 
+    UpdateUndoDataSize(pFile, pUndoRec);
+    PackUndoData(pFile, pUndoRec);
+
     if (!bSplitAtom)  /* If redo was successfull */
     {
-      RestoreFileStatus(pFile, &pUndoRec->after);
+      RestoreUndoStatus(pFile, pUndoRec, TRUE);
       pUndoRec->bUndone = FALSE;
     }
 
@@ -874,182 +1742,352 @@ void Redo(TFile *pFile)
 
     pUndoRec = &(pFile->pUndoIndex[i]);
     ASSERT(VALID_PUNDOREC(pUndoRec));
-    ASSERT(pUndoRec->pData != NULL);
+    ASSERT(UNDO_HAS_DATA(pUndoRec));
   }
 }
 
+/*
+The recovery journal starts with JOURNAL_MAGIC followed by records.
+Every record is the length and the CRC-32 of its payload and then the
+payload. The first record describes the file on the disk, the rest are
+the stored undo records. The numbers in a payload are stored by
+PutPacked(). Loading stops at the first incomplete or damaged record.
+*/
+#define JOURNAL_MAGIC  "WWRJ"
+#define JOURNAL_MAGIC_SIZE  4
+#define JOURNAL_HEADER_SIZE  (2 * sizeof(unsigned int))
+#define MAX_PACKED_INT  5
+
+/* Journal record types */
+#define jrFILE  1  /* Name, size and time of the file on the disk */
+#define jrACTION  2  /* An undo record */
+
+static unsigned int CrcTable[256];
+static BOOLEAN bCrcTableReady = FALSE;
+
 /* ************************************************************************
-   Function: ParseStatLine
+   Function: Crc32
    Description:
-     Parses a recovery file status line. Passed in sStat.
+     CRC-32 (IEEE 802.3) of a journal record payload.
 */
-static BOOLEAN ParseStatLine(char *sStat, char *_pFileName,
-  int *nFileSize, int *nMonth, int *nDay, int *nYear,
-  int *nHour, int *nMin, int *nSec)
+static unsigned int Crc32(const BYTE *p, int nLen)
+{
+  unsigned int c;
+  int i;
+  int j;
+
+  if (!bCrcTableReady)
+  {
+    for (i = 0; i < 256; ++i)
+    {
+      c = i;
+      for (j = 0; j < 8; ++j)
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      CrcTable[i] = c;
+    }
+    bCrcTableReady = TRUE;
+  }
+
+  c = 0xffffffffu;
+  while (nLen-- > 0)
+    c = CrcTable[(c ^ *p++) & 0xff] ^ (c >> 8);
+  return c ^ 0xffffffffu;
+}
+
+/* ************************************************************************
+   Function: JournalGet
+   Description:
+     Reads a number stored by PutPacked() from a journal record
+     without going past pEnd.
+*/
+static BOOLEAN JournalGet(const BYTE **pp, const BYTE *pEnd, int *pn)
+{
+  const BYTE *p;
+
+  for (p = *pp; p < pEnd && p - *pp < MAX_PACKED_INT; ++p)
+    if ((*p & 0x80) == 0)
+    {
+      *pp = GetPacked(*pp, pn);
+      return TRUE;
+    }
+  return FALSE;
+}
+
+/* ************************************************************************
+   Function: NextJournalRecord
+   Description:
+     Gets the payload of the journal record at *pp and moves *pp past
+     the record.
+   Returns:
+     FALSE -- the record is incomplete or its checksum doesn't match.
+*/
+static BOOLEAN NextJournalRecord(const BYTE **pp, const BYTE *pEnd,
+  const BYTE **ppPayload, const BYTE **ppPayloadEnd)
 {
-  char *pFileName;
-  char *pFileSize;
-  char *pMonth;
-  char *pDay;
-  char *pYear;
-  char *pHour;
-  char *pMin;
-  char *pSec;
-
-  if (sStat[0] != '*')
+  unsigned int Header[2];
+  const BYTE *p;
+
+  p = *pp;
+  if (pEnd - p < (long)JOURNAL_HEADER_SIZE)
     return FALSE;
-  pFileName = strtok(sStat, "*,");
-  if (pFileName == NULL)
+  memcpy(Header, p, sizeof(Header));
+  p += JOURNAL_HEADER_SIZE;
+  if (Header[0] > (unsigned long)(pEnd - p))
     return FALSE;
-  if (strlen(pFileName) >= _MAX_PATH)
+  if (Crc32(p, Header[0]) != Header[1])
     return FALSE;
-  strcpy(_pFileName, pFileName);
-  pFileSize = strtok(NULL, " ,");
-  if (pFileSize == NULL)
+
+  *ppPayload = p;
+  *ppPayloadEnd = p + Header[0];
+  *pp = p + Header[0];
+  return TRUE;
+}
+
+/* ************************************************************************
+   Function: ParseFileRecord
+   Description:
+     Parses the first record of a recovery journal.
+*/
+static BOOLEAN ParseFileRecord(const BYTE *p, const BYTE *pEnd,
+  char *_pFileName, int *nFileSize, int *nMonth, int *nDay, int *nYear,
+  int *nHour, int *nMin, int *nSec)
+{
+  int nType;
+  int nLen;
+
+  if (!JournalGet(&p, pEnd, &nType) || nType != jrFILE)
     return FALSE;
-  if (strcmp(pFileSize, sNewFileRec) == 0)
-  {
-    *nFileSize = -1;  /* Indicate new file */
-    return TRUE;
-  }
-  pMonth = strtok(NULL, " ,-");
-  pDay = strtok(NULL, "-");
-  pYear = strtok(NULL, "-,");
-  pHour = strtok(NULL, " :");
-  pMin = strtok(NULL, ":");
-  pSec = strtok(NULL, ":");
-
-  if (!ValStr(pFileSize, nFileSize, 10) ||
-    !ValStr(pMonth, nMonth, 10) ||
-    !ValStr(pDay, nDay, 10) ||
-    !ValStr(pYear, nYear, 10) ||
-    !ValStr(pHour, nHour, 10) ||
-    !ValStr(pMin, nMin, 10) ||
-    !ValStr(pSec, nSec, 10))
+  if (!JournalGet(&p, pEnd, nFileSize) ||
+    !JournalGet(&p, pEnd, nMonth) ||
+    !JournalGet(&p, pEnd, nDay) ||
+    !JournalGet(&p, pEnd, nYear) ||
+    !JournalGet(&p, pEnd, nHour) ||
+    !JournalGet(&p, pEnd, nMin) ||
+    !JournalGet(&p, pEnd, nSec) ||
+    !JournalGet(&p, pEnd, &nLen))
   {
     /* File corrupted */
     return FALSE;
   }
-
+  if (nLen < 0 || nLen >= _MAX_PATH || nLen > pEnd - p)
+    return FALSE;
+  memcpy(_pFileName, p, nLen);
+  _pFileName[nLen] = '\0';
   return TRUE;
 }
 
-
 /* ************************************************************************
    Function: GetStatLine
    Description:
-     Gets the status line data from a rec file.
+     Gets the file record from a recovery journal.
+     nFileSize is -1 for a new file.
 */
 BOOLEAN GetStatLine(TFile *pFile, char *_pFileName,
   int *nFileSize, int *nMonth, int *nDay, int *nYear,
   int *nHour, int *nMin, int *nSec)
 {
   FILE *f;
-#define MAX_LEN  _MAX_PATH + 100
-  char lnbuf[MAX_LEN];  /* +100 for other stats beside name */
-  BOOLEAN bResult;
-  char *p;
+  BYTE Buf[JOURNAL_MAGIC_SIZE + JOURNAL_HEADER_SIZE + 8 * MAX_PACKED_INT + _MAX_PATH];
+  const BYTE *p;
+  const BYTE *pPayload;
+  const BYTE *pPayloadEnd;
+  int nSize;
 
   ASSERT(VALID_PFILE(pFile));
   ASSERT(pFile->sRecoveryFileName[0] != '\0');
 
-  f = NULL;
-  if ((f = fopen(pFile->sRecoveryFileName, "rt")) == NULL)
+  if ((f = fopen(pFile->sRecoveryFileName, READ_BINARY_FILE)) == NULL)
+    return FALSE;
+  nSize = fread(Buf, 1, sizeof(Buf), f);
+  if (fclose(f) != 0)
     return FALSE;
 
-  /*
-  First line should be the file id line
-  */
-  if (fgets(lnbuf, MAX_LEN, f) == NULL)
-  {
-_exit3:
-    fclose (f);
+  if (nSize < JOURNAL_MAGIC_SIZE ||
+    memcmp(Buf, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != 0)
     return FALSE;
+  p = Buf + JOURNAL_MAGIC_SIZE;
+  if (!NextJournalRecord(&p, Buf + nSize, &pPayload, &pPayloadEnd))
+    return FALSE;
+
+  return ParseFileRecord(pPayload, pPayloadEnd, _pFileName, nFileSize,
+    nMonth, nDay, nYear, nHour, nMin, nSec);
+}
+
+/* ************************************************************************
+   Function: CloseRecoveryJournal
+   Description:
+     Waits for the records of the file to be written in the recovery
+     journal and closes the journal. To be called before the recovery
+     file is removed.
+*/
+void CloseRecoveryJournal(TFile *pFile)
+{
+  ASSERT(VALID_PFILE(pFile));
+
+  if (pFile->pRecoveryJournal != NULL)
+  {
+    RecoveryJournalClose(pFile->pRecoveryJournal);
+    pFile->pRecoveryJournal = NULL;
   }
+}
 
-  if ((p = strchr(lnbuf, '\n')) != NULL)
-    *p = '\0';  /* Cut the line at \n character */
+/*
+The records are composed in a buffer that goes to the recovery writer
+(recwrite.c), the memory of the buffer is from malloc().
+*/
+typedef struct JournalBuf
+{
+  BYTE *pData;
+  int nSize;
+  int nMaxSize;
+} TJournalBuf;
+
+/* ************************************************************************
+   Function: JournalReserve
+   Description:
+     Makes room for a record of up to nSize bytes of payload.
+   Returns:
+     Where the payload goes, NULL -- no memory.
+*/
+static BYTE *JournalReserve(TJournalBuf *pBuf, int nSize)
+{
+  BYTE *pNewData;
+  int nMaxSize;
 
-  if ((p = strchr(lnbuf, '\r')) != NULL)
-    *p = '\0';  /* Cut the line at \r character */
+  nSize += JOURNAL_HEADER_SIZE;
+  if (pBuf->nSize + nSize > pBuf->nMaxSize)
+  {
+    nMaxSize = pBuf->nMaxSize * 2;
+    if (nMaxSize < pBuf->nSize + nSize)
+      nMaxSize = pBuf->nSize + nSize;
+    pNewData = realloc(pBuf->pData, nMaxSize);
+    if (pNewData == NULL)
+      return NULL;
+    pBuf->pData = pNewData;
+    pBuf->nMaxSize = nMaxSize;
+  }
+  return pBuf->pData + pBuf->nSize + JOURNAL_HEADER_SIZE;
+}
 
-  if (lnbuf[0] != '*')
-    goto _exit3;
+/* ************************************************************************
+   Function: JournalCommit
+   Description:
+     Puts the header of the record composed after JournalReserve(),
+     the payload ends at pEnd.
+*/
+static void JournalCommit(TJournalBuf *pBuf, const BYTE *pEnd)
+{
+  unsigned int Header[2];
+  BYTE *pRec;
+
+  pRec = pBuf->pData + pBuf->nSize;
+  Header[0] = pEnd - pRec - JOURNAL_HEADER_SIZE;
+  Header[1] = Crc32(pRec + JOURNAL_HEADER_SIZE, Header[0]);
+  memcpy(pRec, Header, sizeof(Header));
+  pBuf->nSize = pEnd - pBuf->pData;
+  ASSERT(pBuf->nSize <= pBuf->nMaxSize);
+}
 
-  bResult = ParseStatLine(lnbuf, _pFileName, nFileSize, nMonth,
-    nDay, nYear, nHour, nMin, nSec);
+/* ************************************************************************
+   Function: StoreFileRecord
+   Description:
+     Stores file recognition record. Would be used to be checked
+     whether the file was changed from last editing.
+*/
+static BOOLEAN StoreFileRecord(TJournalBuf *pBuf, TFile *pFile)
+{
+  BYTE *p;
+  int nLen;
 
-  if (fclose(f) != 0)
+  nLen = strlen(pFile->sFileName);
+  p = JournalReserve(pBuf, 9 * MAX_PACKED_INT + nLen);
+  if (p == NULL)
     return FALSE;
+  p = PutPacked(p, jrFILE);
+  if (pFile->bNew)
+  {
+    p = PutPacked(p, -1);
+    p = PutPacked(p, 0);
+    p = PutPacked(p, 0);
+    p = PutPacked(p, 0);
+    p = PutPacked(p, 0);
+    p = PutPacked(p, 0);
+    p = PutPacked(p, 0);
+  }
+  else
+  {
+    p = PutPacked(p, pFile->nFileSize);
+    p = PutPacked(p, pFile->LastWriteTime.month);
+    p = PutPacked(p, pFile->LastWriteTime.day);
+    p = PutPacked(p, pFile->LastWriteTime.year);
+    p = PutPacked(p, pFile->LastWriteTime.hour);
+    p = PutPacked(p, pFile->LastWriteTime.min);
+    p = PutPacked(p, pFile->LastWriteTime.sec);
+  }
+  p = PutPacked(p, nLen);
+  memcpy(p, pFile->sFileName, nLen);
+  p += nLen;
 
-  return bResult;
+  JournalCommit(pBuf, p);
+  return TRUE;
 }
 
-static const char *sInsert = "INSERT";
-static const char *sDelete = "DELETE";
-static const char *sReplace = "REPLACE";
-static const char *sRearrange = "REARRANGE";
-static const char *sRearrangeBack = "REARRANGEBACK";
-static const char *sColumn = "col";
-static const char *sChar = "char";
-
 /* ************************************************************************
    Function: StoreUndoBlock
    Description:
-     Stores an undo record as a recovery file record.
-     Returns FALSE when disk operation fails.
+     Stores an undo record as a recovery journal record.
+     Returns FALSE when there's no memory.
 */
-static BOOLEAN StoreUndoBlock(FILE *f, TFile *pFile, const TUndoRecord *pUndoRec, BOOLEAN bReversed)
+static BOOLEAN StoreUndoBlock(TJournalBuf *pBuf, TFile *pFile,
+  const TUndoRecord *pUndoRec, BOOLEAN bReversed)
 {
-  const char *pOperation;
+  int nOperation;
   int i;
-  int nNumberOfLines;
-  char *pLine;
-  char c;
+  int nCount;
+  int nSize;
+  const TLine *pLine;
   const TFileStatus *pFileStatus;
+  TFileStatus Before;
+  TFileStatus After;
+  WORD blockattr;
+  BYTE *p;
 
   ASSERT(VALID_PUNDOREC(pUndoRec));
-  ASSERT(f != NULL);
 
   #ifdef _DEBUG
   if (bReversed)
     ASSERT(pUndoRec->bUndone);  /* Performed only for undone blocks! */
   #endif
 
-  pFileStatus = &pUndoRec->before;  /* Default: if operation is not reversed */
+  GetUndoRecordStatus(pUndoRec, &Before, &After);
+  pFileStatus = &Before;  /* Default: if operation is not reversed */
+  nOperation = pUndoRec->nOperation;
   switch (pUndoRec->nOperation)
   {
     case acINSERT:
       if (bReversed)
       {
-        pFileStatus = &pUndoRec->after;
-        pOperation = sDelete;
+        pFileStatus = &After;
+        nOperation = acDELETE;
       }
-      else
-        pOperation = sInsert;
       break;
 
     case acDELETE:
       if (bReversed)
       {
-        pFileStatus = &pUndoRec->after;
-        pOperation = sInsert;
+        pFileStatus = &After;
+        nOperation = acINSERT;
       }
-      else
-        pOperation = sDelete;
       break;
 
     case acREPLACE:
         /* Replace is self-inversed against the text of the file
         if performed twice. So now store replace again. */
-        pOperation = sReplace;
       break;
 
     case acREARRANGE:
       if (bReversed)
-        pOperation = sRearrangeBack;
-      else
-        pOperation = sRearrange;
+        nOperation = acREARRANGEBACK;
       break;
 
     default:
@@ -1057,60 +2095,85 @@ static BOOLEAN StoreUndoBlock(FILE *f, TFile *pFile, const TUndoRecord *pUndoRec
   }
 
   /*
-  Not all of the paramaters from pUndo->before are necessary
-  as those from	pUndo->after are reproducerable after doing the action
+  Calc the room for the record. The data is:
+  rearrange -- the line numbers;
+  replace -- what was overwritten, from the file;
+  delete of a character block -- nothing, will be copied from the file;
+  all other -- the lines of the block.
   */
-  if (fprintf(f, "%s: (%d, %d, %d, %d): (%d, %d, %d, %d, %d): %d: %s\n",
-    pOperation,
-    pUndoRec->nStart, pUndoRec->nStartPos, pUndoRec->nEnd, pUndoRec->nEndPos,
-    pFileStatus->nCol, pFileStatus->nRow, pFileStatus->nTopLine,
-    pFileStatus->nWrtEdge, pFileStatus->nNumberOfLines,
-    pUndoRec->nUndoLevel,
-    ((TBlock *)pUndoRec->pData)->blockattr & COLUMN_BLOCK ? sColumn : sChar) < 0)
-    return FALSE;
-
-  if (pOperation == sRearrange || pOperation == sRearrangeBack)
+  blockattr = 0;
+  nCount = 0;
+  nSize = 14 * MAX_PACKED_INT;
+  if (nOperation == acREARRANGE || nOperation == acREARRANGEBACK)
   {
-    nNumberOfLines = pUndoRec->nEnd - pUndoRec->nStart + 1;
-    for (i = 0; i < nNumberOfLines; ++i)
-      if (fprintf(f, ">%d\n", ((int *)pUndoRec->pData)[i]) < 0)
-        return FALSE;
-    return TRUE;
+    nCount = pUndoRec->nEnd - pUndoRec->nStart + 1;
+    nSize += nCount * MAX_PACKED_INT;
   }
-
-  if (pOperation == sReplace)
+  else
   {
-    if (bReversed)
-      goto _put_data;
-    else
+    blockattr = ((TBlock *)pUndoRec->pData)->blockattr;
+    if (nOperation == acREPLACE && !bReversed)
     {
-      /*
-      Get from the file what was overwritten
-      */
-      pLine = GetLineText(pFile, pUndoRec->nStart);
       ASSERT(GetLine(pFile, pUndoRec->nStart)->nLen > pUndoRec->nEndPos);
-      c = pLine[pUndoRec->nEndPos + 1];  /* Remember what at the place of eol marker */
-      pLine[pUndoRec->nEndPos + 1] = '\0';  /* Put an End-Of-Line marker at the end of region */
-      if (fprintf(f, ">%s\n", &pLine[pUndoRec->nStartPos]) < 0)
+      nCount = 1;
+      nSize += MAX_PACKED_INT + pUndoRec->nEndPos - pUndoRec->nStartPos + 1;
+    }
+    else
+      if (nOperation != acDELETE || (blockattr & COLUMN_BLOCK) != 0)
       {
-        pLine[pUndoRec->nEndPos + 1] = c;
-        return FALSE;
+        nCount = ((TBlock *)pUndoRec->pData)->nNumberOfLines;
+        for (i = 0; i < nCount; ++i)
+          nSize += MAX_PACKED_INT + GetBlockLine((TBlock *)pUndoRec->pData, i)->nLen;
       }
-      pLine[pUndoRec->nEndPos + 1] = c;  /* Restore the text at the end of region */
-      return TRUE;
-    }
   }
 
-  if (pOperation == sDelete)
-    if ((((TBlock *)pUndoRec->pData)->blockattr & COLUMN_BLOCK) == 0)
-      return TRUE;
+  p = JournalReserve(pBuf, nSize);
+  if (p == NULL)
+    return FALSE;
 
-  /* We can skip storing what is deleted when deleting stream character blocks */
-_put_data:
-  for (i = 0; i < ((TBlock *)pUndoRec->pData)->nNumberOfLines; ++i)
-    if (fprintf(f, ">%s\n", GetBlockLineText((TBlock *)pUndoRec->pData, i)) < 0)
-      return FALSE;
+  /*
+  Not all of the paramaters from the status before are necessary
+  as those from the status after are reproducerable after doing the action
+  */
+  p = PutPacked(p, jrACTION);
+  p = PutPacked(p, nOperation);
+  p = PutPacked(p, pUndoRec->nStart);
+  p = PutPacked(p, pUndoRec->nStartPos);
+  p = PutPacked(p, pUndoRec->nEnd);
+  p = PutPacked(p, pUndoRec->nEndPos);
+  p = PutPacked(p, pFileStatus->nCol);
+  p = PutPacked(p, pFileStatus->nRow);
+  p = PutPacked(p, pFileStatus->nTopLine);
+  p = PutPacked(p, pFileStatus->nWrtEdge);
+  p = PutPacked(p, pFileStatus->nNumberOfLines);
+  p = PutPacked(p, pUndoRec->nUndoLevel);
+  p = PutPacked(p, blockattr & COLUMN_BLOCK);
+  p = PutPacked(p, nCount);
+
+  if (nOperation == acREARRANGE || nOperation == acREARRANGEBACK)
+    for (i = 0; i < nCount; ++i)
+      p = PutPacked(p, ((int *)pUndoRec->pData)[i]);
+  else
+    if (nOperation == acREPLACE && !bReversed)
+    {
+      /*
+      Get from the file what was overwritten
+      */
+      p = PutPacked(p, pUndoRec->nEndPos - pUndoRec->nStartPos + 1);
+      memcpy(p, GetLineText(pFile, pUndoRec->nStart) + pUndoRec->nStartPos,
+        pUndoRec->nEndPos - pUndoRec->nStartPos + 1);
+      p += pUndoRec->nEndPos - pUndoRec->nStartPos + 1;
+    }
+    else
+      for (i = 0; i < nCount; ++i)
+      {
+        pLine = GetBlockLine((TBlock *)pUndoRec->pData, i);
+        p = PutPacked(p, pLine->nLen);
+        memcpy(p, pLine->pLine, pLine->nLen);
+        p += pLine->nLen;
+      }
 
+  JournalCommit(pBuf, p);
   return TRUE;
 }
 
@@ -1122,6 +2185,8 @@ _put_data:
 void CheckValidUndoList(TFile *pFile)
 {
   TUndoRecord *pUndoRec;
+  TFileStatus Before;
+  TFileStatus After;
   int i;
   int nLines;
   int nChange;
@@ -1134,7 +2199,8 @@ void CheckValidUndoList(TFile *pFile)
     return;
 
   pUndoRec = &(pFile->pUndoIndex[0]);
-  nLines = pUndoRec->before.nNumberOfLines;
+  GetUndoRecordStatus(pUndoRec, &Before, NULL);
+  nLines = Before.nNumberOfLines;
 
   while (i > 0)
   {
@@ -1142,6 +2208,8 @@ void CheckValidUndoList(TFile *pFile)
     pUndoRec = &(pFile->pUndoIndex[i]);
     ASSERT(VALID_PUNDOREC(pUndoRec));
 
+    if (UNDO_DATA_SPILLED(pUndoRec) || pUndoRec->bInlineData)
+      goto _count_lines;
     switch (pUndoRec->nOperation)
     {
       case acINSERT:  /* Block of text is inserted */
@@ -1163,7 +2231,9 @@ void CheckValidUndoList(TFile *pFile)
       default:
         ASSERT(0);
     }
-    nChange = pUndoRec->after.nNumberOfLines - pUndoRec->before.nNumberOfLines;
+_count_lines:
+    GetUndoRecordStatus(pUndoRec, &Before, &After);
+    nChange = After.nNumberOfLines - Before.nNumberOfLines;
     if (!pUndoRec->bUndone)
       nLines += nChange;
   }
@@ -1178,7 +2248,8 @@ void CheckValidUndoList(TFile *pFile)
      This functions stores all user actions in the relevant recovery
      file (pFile->sRecFileName). The action are	stored from the bottom
      to the top of undo record list. The stored blocks were marked with
-     bRecoveryStore flag set.
+     bRecoveryStore flag set. The records are composed here and are
+     written to the disk by the recovery writer (recwrite.c).
 
      Special considerations:
      1. bFileNameChanged - set by CmdFileSaveAs when a new name
@@ -1195,15 +2266,18 @@ void CheckValidUndoList(TFile *pFile)
      exit.
    Returns:
      TRUE is there was a recovery store.
-     FALSE nothing was stored, errno message should be displayed.
+     FALSE nothing was stored, errno message should be displayed,
+     errno is 0 if there was nothing to store.
 */
 BOOLEAN StoreRecoveryRecord(TFile *pFile)
 {
-  FILE *f;
   TUndoRecord *pUndoRec;
-  const char *pOpenMode;  /* "at" or "wt" */
+  TJournalBuf stBuf;
   BOOLEAN bStoreFileStat;
   BOOLEAN bUnlink;  /* If nothing stored */
+  BOOLEAN bSpilled;
+  BOOLEAN bInline;
+  BOOLEAN bResult;
   int i;
 
   ASSERT(VALID_PFILE(pFile));
@@ -1211,51 +2285,59 @@ BOOLEAN StoreRecoveryRecord(TFile *pFile)
   pFile->bRecoveryStored = FALSE;  /* Assume unsuccessfull recovery record */
 
   if (pFile->nNumberOfRecords == 0)
-    return FALSE;  /* No action necessary */
-
-  pOpenMode = "at";  /* Append the last actions to the recovery file */
-  bStoreFileStat = FALSE;
-  bUnlink = FALSE;
-  if (pFile->bFileNameChanged || pFile->bForceNewRecoveryFile)
   {
-    pOpenMode = "wt";  /* New file should be created */
-    bStoreFileStat = TRUE;  /* Store filename, date, time and size */
-    pFile->bFileNameChanged = FALSE;
-    pFile->bForceNewRecoveryFile = FALSE;
-    bUnlink = TRUE;
+    errno = 0;
+    return FALSE;  /* No action necessary */
   }
 
+  bStoreFileStat = pFile->bFileNameChanged || pFile->bForceNewRecoveryFile;
+  bUnlink = bStoreFileStat;
+
   ASSERT(pFile->sRecoveryFileName[0] != '\0');
 
-  if ((f = fopen(pFile->sRecoveryFileName, pOpenMode)) == NULL)
-    return FALSE;  /* Examine errno */
+  if (!bStoreFileStat && pFile->pRecoveryJournal != NULL)
+  {
+    /*
+    A failed write leaves the journal without the records after it,
+    no more records can be added until a new journal is started.
+    */
+    errno = RecoveryJournalGetError(pFile->pRecoveryJournal);
+    if (errno != 0)
+    {
+      /*
+      The records stored after the failure are lost, the next call
+      starts the journal over from the text on the disk.
+      */
+      if (pFile->nDiskUndoID != UNDO_DISK_LOST)
+      {
+        for (i = 0; i < pFile->nNumberOfRecords; ++i)
+        {
+          pUndoRec = &(pFile->pUndoIndex[i]);
+          pUndoRec->bRecoveryStore = pUndoRec->nUndoBlockID <= pFile->nDiskUndoID;
+        }
+        pFile->bForceNewRecoveryFile = TRUE;
+      }
+      return FALSE;  /* Examine errno */
+    }
+  }
+
+  stBuf.pData = NULL;
+  stBuf.nSize = 0;
+  stBuf.nMaxSize = 0;
 
   if (bStoreFileStat)
   {
+    if (JournalReserve(&stBuf, JOURNAL_MAGIC_SIZE) == NULL)
+      goto _no_memory;
+    memcpy(stBuf.pData, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE);
+    stBuf.nSize = JOURNAL_MAGIC_SIZE;
+
     /*
-    Store file recognition line. Would be used to be checked
-    whether the file was changed from last editing.
-    So if the file is changed with another editor the
+    If the file is changed with another editor the
     recovering will be disabled after the crash.
     */
-    if (pFile->bNew)
-    {
-      if (fprintf(f, "*%s, %s\n", pFile->sFileName, sNewFileRec) < 0)
-        return FALSE;
-    }
-    else
-    {
-      if (fprintf(f, "*%s, %u, %d-%d-%d, %d:%d:%d\n",
-        pFile->sFileName,
-        pFile->nFileSize,
-        pFile->LastWriteTime.month,
-        pFile->LastWriteTime.day,
-        pFile->LastWriteTime.year,
-        pFile->LastWriteTime.hour,
-        pFile->LastWriteTime.min,
-        pFile->LastWriteTime.sec) < 0)
-        return FALSE;
-    }
+    if (!StoreFileRecord(&stBuf, pFile))
+      goto _no_memory;
   }
 
   /*
@@ -1275,8 +2357,16 @@ BOOLEAN StoreRecoveryRecord(TFile *pFile)
 
     if (pUndoRec->bRecoveryStore)
     {
-      pUndoRec->bRecoveryStore = FALSE;
-      StoreUndoBlock(f, pFile, pUndoRec, TRUE);  /* Store the inversed action */
+      ASSERT(!UNDO_DATA_SPILLED(pUndoRec));  /* Undo has read it back */
+      bInline = pUndoRec->bInlineData;
+      if (!LoadUndoData(pFile, pUndoRec))
+        goto _no_memory;
+      bResult = StoreUndoBlock(&stBuf, pFile, pUndoRec, TRUE);  /* Store the inversed action */
+      if (bInline)
+        PackUndoData(pFile, pUndoRec);
+      if (!bResult)
+        goto _no_memory;
+      bUnlink = FALSE;  /* The text differs from the disk file */
     }
   }
 
@@ -1295,14 +2385,21 @@ BOOLEAN StoreRecoveryRecord(TFile *pFile)
 
     if (!pUndoRec->bRecoveryStore)
     {
-      pUndoRec->bRecoveryStore = TRUE;
-      StoreUndoBlock(f, pFile, pUndoRec, FALSE);
+      bSpilled = UNDO_DATA_SPILLED(pUndoRec);
+      bInline = pUndoRec->bInlineData;
+      if (!LoadUndoData(pFile, pUndoRec))
+        goto _no_memory;
+      bResult = StoreUndoBlock(&stBuf, pFile, pUndoRec, FALSE);
+      if (bSpilled)
+        SpillUndoData(pFile, pUndoRec);  /* Only disposes the copy */
+      if (bInline)
+        PackUndoData(pFile, pUndoRec);
+      if (!bResult)
+        goto _no_memory;
       bUnlink = FALSE;
     }
     ++i;
   }
-  if (fclose(f) != 0)
-    return FALSE;  /* Examine errno */
 
   if (bUnlink)
   {
@@ -1311,20 +2408,71 @@ BOOLEAN StoreRecoveryRecord(TFile *pFile)
     and there's still nothing new in the undo list, creating
     new file may result to a zero lenght size
     */
+    free(stBuf.pData);
+    if (pFile->pRecoveryJournal == NULL && pFile->bFileNameChanged)
+      pFile->pRecoveryJournal = RecoveryJournalCreate(pFile->sRecoveryFileName);
+    if (pFile->pRecoveryJournal != NULL)
+    {
+      RecoveryJournalRelease(pFile->pRecoveryJournal, TRUE);
+      pFile->pRecoveryJournal = NULL;
+    }
+    pFile->bFileNameChanged = FALSE;
     pFile->bForceNewRecoveryFile = TRUE;
-    if (unlink(pFile->sRecoveryFileName) != 0)
-      return FALSE;
     return TRUE;
   }
 
+  if (bStoreFileStat && pFile->pRecoveryJournal != NULL)
+  {
+    /* The file name might have changed */
+    RecoveryJournalRelease(pFile->pRecoveryJournal, FALSE);
+    pFile->pRecoveryJournal = NULL;
+  }
+  if (pFile->pRecoveryJournal == NULL && stBuf.nSize > 0)
+  {
+    pFile->pRecoveryJournal = RecoveryJournalCreate(pFile->sRecoveryFileName);
+    if (pFile->pRecoveryJournal == NULL)
+      goto _no_memory;
+  }
+
+  /*
+  All the records are composed, now mark them as stored
+  */
+  for (i = pFile->nNumberOfRecords - 1; i >= 0; --i)
+  {
+    pUndoRec = &(pFile->pUndoIndex[i]);
+    if (!pUndoRec->bUndone)
+      break;
+    pUndoRec->bRecoveryStore = FALSE;
+  }
+  for (i = 0; i < pFile->nNumberOfRecords; ++i)
+  {
+    pUndoRec = &(pFile->pUndoIndex[i]);
+    if (pUndoRec->bUndone)
+      break;
+    pUndoRec->bRecoveryStore = TRUE;
+  }
+
+  if (stBuf.nSize > 0)
+    RecoveryJournalWrite(pFile->pRecoveryJournal, bStoreFileStat,
+      stBuf.pData, stBuf.nSize);
+  else
+    free(stBuf.pData);
+
+  pFile->bFileNameChanged = FALSE;
+  pFile->bForceNewRecoveryFile = FALSE;
   pFile->bRecoveryStored = TRUE;
   return TRUE;
+
+_no_memory:
+  free(stBuf.pData);
+  errno = ENOMEM;
+  return FALSE;
 }
 
 /* ************************************************************************
    Function: LoadRecoveryFile
    Description:
-     Loads the recovery file for a specific text file.
+     Loads the recovery journal for a specific text file.
    Returns:
      0 - load OK.
      1 - errno error.
@@ -1335,7 +2483,14 @@ BOOLEAN StoreRecoveryRecord(TFile *pFile)
 */
 int LoadRecoveryFile(TFile *pFile)
 {
-  TFile RecoveryFile;
+  FILE *f;
+  struct stat statbuf;
+  BYTE *pJournal;
+  const BYTE *pJournalEnd;
+  const BYTE *pNext;
+  const BYTE *pRec;
+  const BYTE *pRecEnd;
+  const BYTE *pText;
   char sFileName[_MAX_PATH];
   int nFileSize;
   int nMonth;
@@ -1346,19 +2501,7 @@ int LoadRecoveryFile(TFile *pFile)
   int nSec;
   int nExitCode;
   int i;
-  int j;
-  char *pOperation;
-  char *pBStart;
-  char *pBStartPos;
-  char *pBEnd;
-  char *pBEndPos;
-  char *pCol;
-  char *pRow;
-  char *pTopLine;
-  char *pWrtEdge;
-  char *pNumberOfLines;
-  char *pUndoLevel;
-  char *pBlockType;
+  int nType;
   int nOperation;
   int nStart;
   int nStartPos;
@@ -1371,12 +2514,16 @@ int LoadRecoveryFile(TFile *pFile)
   int nNumberOfLines;
   int nUndoLevel;
   int nBlockType;
+  int nCount;
   TUndoRecord *pUndoRec;
+  TFileStatus Before;
   TLine *pLine;
   TBlock *pBlock;
   char *p;
   int nEOLSize;
   int nBlockSize;
+  int nTextSize;
+  int nLen;
   int *pLineArray;
   int nMax;
   int nItem;
@@ -1384,39 +2531,43 @@ int LoadRecoveryFile(TFile *pFile)
   ASSERT(VALID_PFILE(pFile));
   ASSERT(pFile->sRecoveryFileName[0] != 0);
 
-  InitEmptyFile(&RecoveryFile);
-  strcpy(RecoveryFile.sFileName, pFile->sRecoveryFileName);
-
-  switch (LoadFilePrim(&RecoveryFile))
+  if ((f = fopen(pFile->sRecoveryFileName, READ_BINARY_FILE)) == NULL)
+    return 1;
+  if (fstat(fileno(f), &statbuf) != 0)
   {
-    case 0:
-      /* Load OK */
-      break;
-    case 2:
-      /* File doesn't exist */
-      return 1;
-    case 3:
-      /* No memory for the file */
-      return 2;
-    case 4:
-      return 1;
-    case 5:
-      return 1;
-    default:
-      ASSERT(0);
+    fclose(f);
+    return 1;
+  }
+  pJournal = alloc(statbuf.st_size + 1);
+  if (pJournal == NULL)
+  {
+    fclose(f);
+    return 2;
   }
+  nLen = fread(pJournal, 1, statbuf.st_size, f);
+  if (ferror(f))
+  {
+    fclose(f);
+    s_free(pJournal);
+    return 1;
+  }
+  fclose(f);
+  pJournalEnd = pJournal + nLen;
 
-  if (RecoveryFile.nNumberOfLines == 0)
+  pNext = pJournal + JOURNAL_MAGIC_SIZE;
+  if (nLen < JOURNAL_MAGIC_SIZE ||
+    memcmp(pJournal, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != 0 ||
+    !NextJournalRecord(&pNext, pJournalEnd, &pRec, &pRecEnd))
   {
 _file_corrupted:
     nExitCode = 3;  /* Recovery file corrupted */
 _exit:
-    DisposeFile(&RecoveryFile);
+    s_free(pJournal);
     pFile->nUndoLevel = 0;
     return nExitCode;
   }
 
-  if (!ParseStatLine(GetLineText(&RecoveryFile, 0), sFileName, &nFileSize,
+  if (!ParseFileRecord(pRec, pRecEnd, sFileName, &nFileSize,
     &nMonth, &nDay, &nYear, &nHour, &nMin, &nSec))
     goto _file_corrupted;
 
@@ -1435,8 +2586,7 @@ _exit:
     }
   }
   else
-    if (filestrcmp(pFile->sFileName, sFileName) != 0 ||
-      nFileSize != pFile->nFileSize ||
+    if (nFileSize != pFile->nFileSize ||
       nMonth != pFile->LastWriteTime.month ||
       nDay != pFile->LastWriteTime.day ||
       nYear != pFile->LastWriteTime.year ||
@@ -1448,37 +2598,30 @@ _exit:
       goto _exit;
     }
 
-  for (i = 1; i < RecoveryFile.nNumberOfLines; ++i)
+  while (pNext < pJournalEnd)
   {
     /*
-    This must be a description line
-    Parse the description line
+    Decode the description of the action. A record that was written
+    only partly ends the journal.
     */
-    pOperation = strtok(GetLineText(&RecoveryFile, i), ":( ");
-    pBStart = strtok(NULL, "(, ");
-    pBStartPos = strtok(NULL, ", ");
-    pBEnd = strtok(NULL, ", ");
-    pBEndPos = strtok(NULL, ",): (");
-    pCol = strtok(NULL,	":(, ");
-    pRow = strtok(NULL, ", ");
-    pTopLine = strtok(NULL, ", ");
-    pWrtEdge = strtok(NULL, ", ");
-    pNumberOfLines = strtok(NULL, ",) ");
-    pUndoLevel = strtok(NULL, ") :");
-    pBlockType = strtok(NULL, " :");
-
-    if (pOperation == NULL ||
-      pBStart == NULL ||
-      pBStartPos == NULL ||
-      pBEnd == NULL ||
-      pBEndPos == NULL ||
-      pCol == NULL ||
-      pRow == NULL ||
-      pTopLine == NULL ||
-      pWrtEdge == NULL ||
-      pNumberOfLines == NULL ||
-      pUndoLevel == NULL ||
-      pBlockType == NULL)
+    if (!NextJournalRecord(&pNext, pJournalEnd, &pRec, &pRecEnd) ||
+      !JournalGet(&pRec, pRecEnd, &nType) || nType != jrACTION ||
+      !JournalGet(&pRec, pRecEnd, &nOperation) ||
+      !JournalGet(&pRec, pRecEnd, &nStart) ||
+      !JournalGet(&pRec, pRecEnd, &nStartPos) ||
+      !JournalGet(&pRec, pRecEnd, &nEnd) ||
+      !JournalGet(&pRec, pRecEnd, &nEndPos) ||
+      !JournalGet(&pRec, pRecEnd, &nCol) ||
+      !JournalGet(&pRec, pRecEnd, &nRow) ||
+      !JournalGet(&pRec, pRecEnd, &nTopLine) ||
+      !JournalGet(&pRec, pRecEnd, &nWrtEdge) ||
+      !JournalGet(&pRec, pRecEnd, &nNumberOfLines) ||
+      !JournalGet(&pRec, pRecEnd, &nUndoLevel) ||
+      !JournalGet(&pRec, pRecEnd, &nBlockType) ||
+      !JournalGet(&pRec, pRecEnd, &nCount) ||
+      nOperation < acINSERT || nOperation > acREARRANGEBACK ||
+      (nBlockType & ~COLUMN_BLOCK) != 0 ||
+      nCount < 0 || nCount > pRecEnd - pRec)
     {
 _check_for_partial_data:
       if (pFile->nNumberOfRecords == 0)
@@ -1492,43 +2635,6 @@ _split_the_atom:
       goto _exit;
     }
 
-    if (strcmp(pOperation, sInsert) == 0)
-      nOperation = acINSERT;
-    else
-      if (strcmp(pOperation, sDelete) == 0)
-        nOperation = acDELETE;
-      else
-        if (strcmp(pOperation, sReplace) == 0)
-          nOperation = acREPLACE;
-        else
-          if (strcmp(pOperation, sRearrange) == 0)
-            nOperation = acREARRANGE;
-          else
-            if (strcmp(pOperation, sRearrangeBack) == 0)
-              nOperation = acREARRANGEBACK;
-            else
-              goto _check_for_partial_data;
-
-    if (!ValStr(pBStart, &nStart, 10) ||
-      !ValStr(pBStartPos, &nStartPos, 10) ||
-      !ValStr(pBEnd, &nEnd, 10) ||
-      !ValStr(pBEndPos, &nEndPos, 10) ||
-      !ValStr(pCol, &nCol, 10) ||
-      !ValStr(pRow, &nRow, 10) ||
-      !ValStr(pTopLine, &nTopLine, 10) ||
-      !ValStr(pWrtEdge, &nWrtEdge, 10) ||
-      !ValStr(pNumberOfLines, &nNumberOfLines, 10) ||
-      !ValStr(pUndoLevel, &nUndoLevel, 10))
-      goto _check_for_partial_data;
-
-    if (strcmp(pBlockType, sColumn) == 0)
-      nBlockType = COLUMN_BLOCK;
-    else
-      if (strcmp(pBlockType, sChar) == 0)
-        nBlockType = 0;
-      else
-        goto _check_for_partial_data;
-
     pFile->nUndoLevel = nUndoLevel;
 
     if (!AddUndoRecord(pFile, nOperation, TRUE))
@@ -1542,11 +2648,13 @@ _fail_collecting:
 
     /* Put the undo record information as read from the recovery file */
     pUndoRec = GetLastRec(pFile);
-    pUndoRec->before.nRow = nRow;
-    pUndoRec->before.nCol = nCol;
-    pUndoRec->before.nTopLine = nTopLine;
-    pUndoRec->before.nWrtEdge = nWrtEdge;
-    pUndoRec->before.nNumberOfLines = nNumberOfLines;
+    GetUndoRecordStatus(pUndoRec, &Before, NULL);
+    Before.nRow = nRow;
+    Before.nCol = nCol;
+    Before.nTopLine = nTopLine;
+    Before.nWrtEdge = nWrtEdge;
+    Before.nNumberOfLines = nNumberOfLines;
+    SetUndoRecordStatus(pFile, pUndoRec, &Before, &Before);  /* Reserved by AddUndoRecord() */
     pUndoRec->nUndoLevel = nUndoLevel;
 
     pUndoRec->nStart = nStart;
@@ -1565,15 +2673,13 @@ _fail_collecting:
     {
       /*
       Read the rearrange line numbers.
-      First count the number of lines.
       */
-      for (j = 1; j + i < RecoveryFile.nNumberOfLines; ++j)
+      if (nCount == 0)
       {
-        pLine = GetLine(&RecoveryFile, i + j);
-        if (pLine->pLine[0] != '>')
-          break;
+        RemoveLastUndoRecord(pFile);
+        goto _check_for_partial_data;
       }
-      pLineArray = alloc(sizeof(int *) * (j - 1));
+      pLineArray = alloc(sizeof(int) * nCount);
       if (pLineArray == NULL)
       {
         RemoveLastUndoRecord(pFile);
@@ -1582,12 +2688,9 @@ _fail_collecting:
 
       nMin = INT_MAX;
       nMax = 0;
-      for (j = 1; j + i < RecoveryFile.nNumberOfLines; ++j)
+      for (i = 0; i < nCount; ++i)
       {
-        pLine = GetLine(&RecoveryFile, i + j);
-        if (pLine->pLine[0] != '>')
-          break;
-        if (!ValStr(pLine->pLine + 1, &nItem, 10))
+        if (!JournalGet(&pRec, pRecEnd, &nItem))
         {
 _dispose_pArray:
           RemoveLastUndoRecord(pFile);
@@ -1598,7 +2701,7 @@ _dispose_pArray:
           nMin = nItem;
         if (nItem > nMax)
           nMax = nItem;
-        pLineArray[j - 1] = nItem;
+        pLineArray[i] = nItem;
       }
 
       /*
@@ -1606,84 +2709,72 @@ _dispose_pArray:
       */
       if (pUndoRec->nEnd - pUndoRec->nStart != nMax - nMin)
         goto _dispose_pArray;
-      if (nMax - nMin + 1 != j - 1)
+      if (nMax - nMin + 1 != nCount)
         goto _dispose_pArray;
 
       pUndoRec->pData = pLineArray;
-
-      i += j - 1;
       continue;
     }
 
     /*
-    Compose the data block
+    Check the lines of the data block and calc its size
     */
-    nBlockSize = 0;
-    nEOLSize = pFile->nEOLType == CRLFtype ? 2 : 1;
-    for (j = 1; j + i < RecoveryFile.nNumberOfLines; ++j)
+    nTextSize = 0;
+    pText = pRec;
+    for (i = 0; i < nCount; ++i)
     {
-      pLine = GetLine(&RecoveryFile, i + j);
-      if (pLine->pLine[0] == '>')
-        nBlockSize += pLine->nLen - 1 + nEOLSize;
-      else
-        break;
+      if (!JournalGet(&pRec, pRecEnd, &nLen) ||
+        nLen < 0 || nLen > pRecEnd - pRec)
+      {
+        RemoveLastUndoRecord(pFile);
+        goto _check_for_partial_data;
+      }
+      pRec += nLen;
+      nTextSize += nLen;
     }
+    nEOLSize = pFile->nEOLType == CRLFtype ? 2 : 1;
+    nBlockSize = nTextSize + nCount * nEOLSize;
 
-    pBlock = AllocTBlock();
+    /*
+    Compose the data block
+    */
+    pBlock = AllocUndoBlock(nCount, nBlockSize);
     if (pBlock == NULL)
     {
       RemoveLastUndoRecord(pFile);
       goto _fail_collecting;
     }
-
-    pBlock->pBlock = AllocateTBlock(nBlockSize);
-    if (pBlock->pBlock == NULL)
-    {
-_dispose_pBlock:
-      FreeTBlock(pBlock);
-      RemoveLastUndoRecord(pFile);
-      goto _fail_collecting;
-    }
-
     pBlock->blockattr = nBlockType;
-    pBlock->nNumberOfLines = j - 1;
     pBlock->nEOLType = pFile->nEOLType;
 
-    TArrayInit(pBlock->pIndex, pBlock->nNumberOfLines, 1);
-    if (pBlock->pIndex == NULL)
-    {
-      DisposeBlock(pBlock->pBlock);
-      goto _dispose_pBlock;
-    }
     pLine = pBlock->pIndex;
     p = pBlock->pBlock;
-
-    for (j = 1; j <= pBlock->nNumberOfLines; ++j)
+    pRec = pText;
+    for (i = 0; i < nCount; ++i)
     {
-      strcpy(p, &GetLineText(&RecoveryFile, i + j)[1]);  /* Skip the leading ">" */
+      JournalGet(&pRec, pRecEnd, &nLen);
+      memcpy(p, pRec, nLen);
+      p[nLen] = '\0';
+      pRec += nLen;
 
       pLine->pLine = p;
       pLine->pFileBlock = pBlock->pBlock;
       pLine->attr = 0;
-
-      p = strchr(p, '\0');  /* Search for end of line already marked with '\0' */
-      pLine->nLen = p - pLine->pLine;  /* Calc the line length */
-      p += nEOLSize;
+      pLine->nLen = nLen;
+      p += nLen + nEOLSize;
 
       ++pLine;
-      ASSERT(p != NULL);
     }
     ASSERT(p - pBlock->pBlock == nBlockSize);
 
-    IncRef(pBlock->pBlock, pBlock->nNumberOfLines);  /* Update the file block reference counter */
-    TArraySetCount(pBlock->pIndex, pBlock->nNumberOfLines);
+    if (nCount > 0)
+      IncRef(pBlock->pBlock, nCount);  /* Update the file block reference counter */
+    TArraySetCount(pBlock->pIndex, nCount);
 
     pUndoRec->pData = pBlock;
-
-    i += j - 1;
   }
 
-  DisposeFile(&RecoveryFile);
+  s_free(pJournal);
   pFile->nUndoLevel = 0;
   return 0;
 }
@@ -1712,6 +2803,8 @@ _dispose_pBlock:
 BOOLEAN RecoverFile(TFile *pFile)
 {
   TUndoRecord *pUndoRec;
+  TFileStatus Before;
+  TFileStatus After;
   char *p;
   BOOLEAN bSplitAtom;
   BOOLEAN bResult;
@@ -1729,11 +2822,18 @@ BOOLEAN RecoverFile(TFile *pFile)
       ASSERT(pUndoRec->pData != NULL);
     #endif
 
-    if (pUndoRec->before.nCol != pFile->nCol ||
-      pUndoRec->before.nRow != pFile->nRow)
+    if (!ReserveUndoStatus(pFile))
+    {
+      bSplitAtom = TRUE;  /* No memory for the status after the operation */
+      goto _split_atom;
+    }
+
+    GetUndoRecordStatus(pUndoRec, &Before, NULL);
+    if (Before.nCol != pFile->nCol ||
+      Before.nRow != pFile->nRow)
     {
       /* Restore the exact position of the operation */
-      RestoreFileStatus(pFile, &pUndoRec->before);
+      RestoreFileStatus(pFile, &Before);
     }
 
     switch (pUndoRec->nOperation)
@@ -1810,6 +2910,7 @@ BOOLEAN RecoverFile(TFile *pFile)
         ASSERT(0);
     }
 
+_split_atom:
     if (bSplitAtom)
     {
       /*
@@ -1829,7 +2930,7 @@ BOOLEAN RecoverFile(TFile *pFile)
       for (j = i; j < pFile->nNumberOfRecords; ++j)
       {
         pUndoRec = &pFile->pUndoIndex[j];
-        DisposeUndoRecord(pUndoRec);
+        DisposeUndoRecord(pFile, pUndoRec);
       }
 
       /*
@@ -1841,11 +2942,14 @@ BOOLEAN RecoverFile(TFile *pFile)
     }
 
     pFile->bChanged = TRUE;  /* We have at least one change */
-    /* To have a complete undo block we need pUndoRec->after to be filled */
-    RecordFileStatus(pFile, &pUndoRec->after);
-    pUndoRec->bRecoveryStore = TRUE;  /* This block exists on the disk */
+    /* To have a complete undo block we need the status after to be filled */
+    RecordFileStatus(pFile, &After);
     if (i > 0)
-      pUndoRec->before.bChanged = TRUE;
+      Before.bChanged = TRUE;
+    SetUndoRecordStatus(pFile, pUndoRec, &Before, &After);  /* Uses the reserve */
+    UpdateUndoDataSize(pFile, pUndoRec);
+    PackUndoData(pFile, pUndoRec);
+    pUndoRec->bRecoveryStore = TRUE;  /* This block exists on the disk */
 
     ++i;
   }
@@ -39,6 +39,9 @@ void RecordUndoData(TFile *pFile, void *pBlock,
 void PostOperation(TFile *pFile);
 void DisposeUndoIndexData(TFile *pFile);
 void RemoveLastUndoRecord(TFile *pFile);
+int GetLastDoneUndoID(const TFile *pFile);
+void GetUndoRecordStatus(const TUndoRecord *pUndoRec,
+  TFileStatus *pBefore, TFileStatus *pAfter);
 
 void Undo(TFile *pFile);
 void Redo(TFile *pFile);
@@ -47,6 +50,7 @@ BOOLEAN GetStatLine(TFile *pFile, char *_pFileName,
   int *nFileSize, int *nMonth, int *nDay, int *nYear,
   int *nHour, int *nMin, int *nSec);
 
+void CloseRecoveryJournal(TFile *pFile);
 BOOLEAN StoreRecoveryRecord(TFile *pFile);
 int LoadRecoveryFile(TFile *pFile);
 BOOLEAN RecoverFile(TFile *pFile);
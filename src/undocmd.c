@@ -11,6 +11,8 @@ Descrition:
 
 #include "global.h"
 #include "undo.h"
+#include "file2.h"
+#include "wrkspace.h"
 #include "cmdc.h"
 
 /* ************************************************************************
@@ -19,7 +21,17 @@ Descrition:
 */
 void CmdEditUndo(void *pCtx)
 {
-  Undo(CMDC_PFILE(pCtx));
+  TFile *pFile;
+
+  pFile = CMDC_PFILE(pCtx);
+
+  /*
+  The undo records in the text being stored get their recovery
+  status when the store completes, see StoreFileDone().
+  */
+  if (pFile->pSaveJob != NULL && GetLastDoneUndoID(pFile) <= pFile->nSaveUndoID)
+    StoreFileWait(pFile, wrkspace_get_disp(CMDC_WRKSPACE(pCtx)));
+  Undo(pFile);
 }
 
 /* ************************************************************************
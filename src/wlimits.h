@@ -14,6 +14,7 @@ Descrition:
 
 #define FILE_DELTA  200         /* Index array grow up size */
 #define UNDOINDEX_DELTA  50     /* UndoIndex array grow up size */
+#define UNDO_PACKED_SIZE  40    /* Packed status and inline data of an undo record */
 #define MAX_KEY_SEQ  3          /* Max keys allowed to be in a single key sequence */
 #define MAX_KEYS  255           /* Max number of keys allowed in a key set */
 #define MAX_WIN_WIDTH  255      /* Max output window width (2 * buffer in stack!) */
@@ -40,6 +41,11 @@ Descrition:
 #define MAX_CLIP_HIST 5  /* How much clipboards to keep in history */
 #define MAX_CLIP_HIST_WIN_WIDTH 25  /* The width of the selection window */
 #define MAX_CONTAINERS 24  /* Number of simultaneously displayed containers */
+#define MAX_PAGE_MATCH_LINES 128  /* Lines of search matches cached per file view */
+#define MAX_LINE_MATCHES 16  /* Highlighted search matches per line */
+#define MAX_FINDFILES_THREADS 16  /* Worker threads for Find in Files */
+#define MAX_BINARY_SNIFF 8192  /* Bytes checked for a zero to skip binary files */
+#define MAX_IGNORE_FILE_SIZE 65536  /* Larger .gitignore files are not read */
 
 #ifdef UNIX
 #define CASE_SENSITIVE_FILENAMES 1  /* BOOLEAN */
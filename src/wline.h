@@ -33,7 +33,8 @@ enum SyntaxAttr
   attrPair,
   attrTooltip,
   attrBlockCursor,
-  attrBookmark
+  attrBookmark,
+  attrSearchMatch
 };
 
 typedef struct LineOutput
@@ -51,7 +51,8 @@ int WINAPI WinMain(
 
 #endif
 
-#ifdef DISP_NCURSES
+#if defined(DISP_NCURSES) || defined(DISP_VT) || defined(DISP_HEADLESS) || \
+  defined(DISP_SELECT)
 
 void OutOfMemory(void)
 {